@@ -2,6 +2,7 @@
 ||
 || @author         Brett Hagman <bhagman@wiring.org.co>
 || @url            http://wiring.org.co/
+|| @contribution   Camilo Reyes <creyes@wiring.org.co>
 ||
 || @description
 || | Analog input and output methods.
@@ -21,7 +22,16 @@
  *************************************************************/
 
 uint8_t analog_reference = DEFAULT;
+uint8_t analog_profile = ADC_STANDARD;
 uint8_t adcFirstTime = true;
+// the ADC_QUIET conversion, set by adcQuietInit() (WAnalogInterrupt.c)
+voidFuncPtr adcSleepHook;
+
+// ADPS values: ck/128 for full 10 bit accuracy (125 kHz at 16 MHz), ck/16
+// for 8 bits (1 MHz at 16 MHz, well past the 200 kHz the datasheet asks
+// for 10 bits, but the top 8 bits hold).
+#define ADC_PRESCALER_STANDARD ((1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0))
+#define ADC_PRESCALER_FAST     (1 << ADPS2)
 
 
 /*************************************************************
@@ -36,7 +46,7 @@ void adcInit()
   ADMUX = (1 << REFS0);
   // Set ADC Control:
   // ADC Enabled, Prescalar = ck/128
-  ADCSRA = (1 << ADEN) | (1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0);
+  ADCSRA = (1 << ADEN) | ADC_PRESCALER_STANDARD;
 
   // ADCSRA = _BV(ADEN)|_BV(ADSC)|_BV(ADATE)|_BV(ADPS2)|_BV(ADPS1)|_BV(ADPS0);
   // ADCSRB &= ~(_BV(ADTS2)|_BV(ADTS1)|_BV(ADTS0));
@@ -50,10 +60,18 @@ void analogReference(uint8_t mode)
   analog_reference = mode;
 }
 
-int16_t analogRead(uint8_t pin)
+// Select the sampling profile used by analogRead().
+void _analogProfile(uint8_t profile)
+{
+  analog_profile = profile;
+}
+
+// One conversion of pin, on the 0 to 1023 scale.
+static int adcConvert(uint8_t pin, uint8_t profile)
 {
 #if defined(ADCSRA)
   uint8_t low, high;
+  uint8_t prescaler = (profile == ADC_FAST) ? ADC_PRESCALER_FAST : ADC_PRESCALER_STANDARD;
 
   if (adcFirstTime == true)
   {
@@ -70,15 +88,27 @@ int16_t analogRead(uint8_t pin)
 #endif
 
   // set the analog reference (high two bits of ADMUX) and select the
-  // single ended input channel (low 3 bits).
+  // single ended input channel (low 3 bits).  The fast profile left
+  // adjusts the result, so its 8 bits are all in ADCH.
 
-  ADMUX = (analog_reference << 6) | (pin & 0x07);
+  ADMUX = (analog_reference << 6) | ((profile == ADC_FAST) ? (1 << ADLAR) : 0) | (pin & 0x07);
 
-  // start the conversion
-  ADCSRA |= (1 << ADSC);
+  if ((ADCSRA & 0x07) != prescaler)
+    ADCSRA = (ADCSRA & ~0x07) | prescaler;
 
-  // ADSC is cleared when the conversion finishes
-  while (ADCSRA & (1 << ADSC));
+  if (profile == ADC_QUIET && adcSleepHook)
+    adcSleepHook();
+  else
+  {
+    // start the conversion
+    ADCSRA |= (1 << ADSC);
+
+    // ADSC is cleared when the conversion finishes
+    while (ADCSRA & (1 << ADSC));
+  }
+
+  if (profile == ADC_FAST)
+    return ADCH << 2;
 
   // we have to read ADCL first; doing so locks both ADCL
   // and ADCH until ADCH is read.  reading ADCL second would
@@ -94,3 +124,40 @@ int16_t analogRead(uint8_t pin)
   return 0;
 #endif
 }
+
+int analogRead(uint8_t pin)
+{
+  return adcConvert(pin, analog_profile);
+}
+
+// One conversion with the given profile, whatever analogProfile() is.
+int _analogReadProfile(uint8_t pin, uint8_t profile)
+{
+  return adcConvert(pin, profile);
+}
+
+// Oversampling and decimation: the sum of 4^n 10 bit conversions,
+// shifted right by n, gives 10 + n bits (0 to 2^bits - 1, for bits from
+// 11 to 15).  It only works if there is at least 1 LSB of noise on the
+// input, and takes 4^n conversions: 1.7 ms for 12 bits at 16 MHz.
+int analogReadOversampled(uint8_t pin, uint8_t bits)
+{
+  uint32_t sum = 0;
+  uint16_t samples;
+  uint8_t n;
+
+  if (bits <= 10)
+    return adcConvert(pin, ADC_STANDARD);
+  if (bits > 15)
+    bits = 15;
+
+  n = bits - 10;
+  samples = 1 << (2 * n);
+
+  do
+  {
+    sum += adcConvert(pin, ADC_STANDARD);
+  } while (--samples);
+
+  return sum >> n;
+}
@@ -2,6 +2,7 @@
 ||
 || @author         Brett Hagman <bhagman@wiring.org.co>
 || @url            http://wiring.org.co/
+|| @contribution   Camilo Reyes <creyes@wiring.org.co>
 ||
 || @description
 || | Analog input and output methods.
@@ -30,10 +31,66 @@
 #define INTERNAL2V56 3
 #define INTERNAL     3
 
+// Sampling profiles for analogRead()
+//  ADC_STANDARD: 10 bits, ADC clock ck/128 (104 us per conversion at 16 MHz)
+//  ADC_FAST:     8 bits (ADLAR), ADC clock ck/16 (13 us at 16 MHz, ~77 kSPS)
+//  ADC_QUIET:    10 bits, converted in ADC noise reduction sleep
+// Every profile returns a value on the same 0 to 1023 scale.
+
+#define ADC_STANDARD 0
+#define ADC_FAST     1
+#define ADC_QUIET    2
+
 // Prototypes
 
 int analogRead(uint8_t);
+int _analogReadProfile(uint8_t, uint8_t);
+int analogReadOversampled(uint8_t, uint8_t);
 void analogReference(uint8_t);
+void _analogProfile(uint8_t);
+
+// WAnalogInterrupt.c, which holds the ADC vector
+void attachInterruptADC(void (*)(void));
+void detachInterruptADC(void);
+void adcQuietInit(void);
+
+// ADC_QUIET conversions sleep until the ADC interrupt wakes the CPU.
+// The vector is linked in through adcQuietInit(), which is only called
+// when the profile may be ADC_QUIET: for a constant profile, the test is
+// folded away, so analogRead() and the other profiles leave ADC_vect free
+// for the sketch.
+
+static inline int analogReadProfile(uint8_t pin, uint8_t profile)
+{
+  if (profile == ADC_QUIET)
+    adcQuietInit();
+  return _analogReadProfile(pin, profile);
+}
+
+static inline void analogProfile(uint8_t profile)
+{
+  if (profile == ADC_QUIET)
+    adcQuietInit();
+  _analogProfile(profile);
+}
+
+// ADC interrupt handler.
+//
+// The ADC vector is a bare jump to its handler, which the core defines
+// weakly, calling the function given to attachInterruptADC().  A sketch
+// or library that owns the ADC defines the handler itself (instead of
+// ISR(ADC_vect), which would clash with the core's vector once it is
+// linked):
+//
+//   ADC_ISR()
+//   {
+//     ...
+//   }
+//
+// ADC_QUIET conversions wake the CPU through the same handler.
+#define ADC_HANDLER ADC_vect_handler
+
+#define ADC_ISR() ISR(ADC_HANDLER)
 
 
 #endif
@@ -0,0 +1,99 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | ADC conversion complete interrupt and noise reduction sleep.
+|| | Atmel AVR 8 bit microcontroller series core.
+|| |
+|| | Kept apart from WAnalog.c, so that the ADC vector is only linked
+|| | into sketches that call attachInterruptADC() or use ADC_QUIET, and
+|| | analogRead() can be used with a sketch's own ISR(ADC_vect).
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#include <Wiring.h>
+
+/*************************************************************
+ * Globals
+ *************************************************************/
+
+static volatile voidFuncPtr adcIntFunc;
+
+// set by adcQuietInit(), run by the ADC_QUIET conversions of WAnalog.c
+extern voidFuncPtr adcSleepHook;
+
+
+/*************************************************************
+ * ADC Interrupt
+ *************************************************************/
+
+// Attach a function to the ADC conversion complete interrupt, for
+// libraries that drive the ADC themselves (AnalogSampler).  Without one,
+// the interrupt only wakes the CPU from ADC noise reduction sleep.
+void attachInterruptADC(void (*userFunc)(void))
+{
+  adcIntFunc = userFunc;
+}
+
+void detachInterruptADC(void)
+{
+  adcIntFunc = NULL;
+}
+
+#if defined(ADCSRA)
+// The core's ADC interrupt handler, weak so that it can be replaced
+// (see ADC_ISR() in WAnalog.h), and the vector jumping to it.
+ISR(ADC_HANDLER, __attribute__((weak)))
+{
+  PROFILE_ENTER();
+  if (adcIntFunc)
+    adcIntFunc();
+  PROFILE_EXIT(PROFILE_ADC);
+}
+
+ISR_ALIAS(ADC_vect, ADC_HANDLER)
+
+// Run the conversion set up in ADMUX in ADC noise reduction mode, where
+// the CPU and clkIO are halted: entering the mode starts the conversion.
+// Another interrupt may wake the CPU first, so sleep again until it is
+// done.  Timer 0 is stopped too, so millis() does not count the time
+// spent asleep.
+static void adcSleep(void)
+{
+  uint8_t oldSREG = SREG;
+  uint8_t oldSMCR = SMCR;
+
+  cli();
+  // writing ADCSRA back clears a stale ADIF
+  ADCSRA |= (1 << ADIE);
+  set_sleep_mode(SLEEP_MODE_ADC);
+  sleep_enable();
+
+  do
+  {
+    sei();
+    sleep_cpu();
+    cli();
+  } while (ADCSRA & (1 << ADSC));
+
+  ADCSRA &= ~(1 << ADIE);
+  SMCR = oldSMCR;
+  SREG = oldSREG;
+}
+#endif
+
+// Called by the ADC_QUIET paths of WAnalog.h before their first
+// conversion; linking it in links the vector the sleep wakes through.
+void adcQuietInit(void)
+{
+#if defined(ADCSRA)
+  adcSleepHook = adcSleep;
+#endif
+}
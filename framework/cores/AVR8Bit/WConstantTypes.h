@@ -4,6 +4,7 @@
 || @url            http://wiring.org.co/
 || @contribution   Mikal Hart
 || @contribution   Alexander Brevig <abrevig@wiring.org.co>
+|| @contribution   Camilo Reyes <creyes@wiring.org.co>
 ||
 || @description
 || | Introduces a new ConstantType datatype, to help compilers understand
@@ -56,7 +57,7 @@ class ConstantString : public Printable
 };
 
 /* For inline/auto creation of ConstantStrings */
-#define Constant(str) reinterpret_cast<__ConstantStringHelper *>(PSTR(str))
+#define Constant(str) reinterpret_cast<const __ConstantStringHelper *>(PSTR(str))
 
 /* For global/static creation of ConstantStrings */
 #define ConstantString(name, value) \
@@ -3,6 +3,7 @@
 || @author         Brett Hagman <bhagman@wiring.org.co>
 || @url            http://wiring.org.co/
 || @contribution   Hernando Barragan <b@wiring.org.co>
+|| @contribution   Camilo Reyes <creyes@wiring.org.co>
 ||
 || @description
 || | Delay and timing control.
@@ -25,6 +26,11 @@
 // Notes
 // -----
 // Variables: F_CPU (cpu clock), Timer 0 prescalar
+//
+// Timer 0 overflows every TIMER0PRESCALEFACTOR * 256 cycles.  millis() and
+// micros() are kept as whole milliseconds / microseconds, plus the
+// fraction left over, by the overflow interrupt, so they work for any
+// F_CPU (e.g. 14.7456 MHz) with integer arithmetic only.
 
 // Version to accomodate F_CPU frequencies not multiples of 1E6: 
 // (but requires 32 bit operations for the fractional calculation)
@@ -56,6 +62,39 @@ volatile uint8_t timer0_fract = 0;
 
 #endif // F_CPU a multiple of 1E6
 
+// Microseconds per overflow: (TIMER0PRESCALEFACTOR * 256 * 1E6) / F_CPU,
+// as MICROS_INC whole microseconds and MICROS_FRACT_INC / F_CPU.
+#define MICROS_INC       ((uint32_t)((TIMER0PRESCALEFACTOR * 256ULL * 1000000ULL) / F_CPU))
+#define MICROS_FRACT_INC ((uint32_t)((TIMER0PRESCALEFACTOR * 256ULL * 1000000ULL) % F_CPU))
+#define MICROS_FRACT_MAX ((uint32_t)F_CPU)
+
+#if (((TIMER0PRESCALEFACTOR * 256ULL * 1000000ULL) % F_CPU) != 0)
+#define MICROS_FRACTION
+#endif
+
+// Microseconds per Timer 0 tick, in 16.16 fixed point (rounded), for the
+// part of micros() still in TCNT0.  255 ticks fall short of a whole
+// overflow by more than the rounding, so micros() never goes back.
+#if (((TIMER0PRESCALEFACTOR * 1000000ULL) % F_CPU) == 0)
+#define TICKS_TO_MICROS(t) ((uint32_t)(t) * (uint32_t)((TIMER0PRESCALEFACTOR * 1000000ULL) / F_CPU))
+#else
+#define MICROS_PER_TICK_Q16 \
+            ((uint32_t)((TIMER0PRESCALEFACTOR * 1000000ULL * 65536ULL + F_CPU / 2) / F_CPU))
+#define TICKS_TO_MICROS(t) (((uint32_t)(t) * MICROS_PER_TICK_Q16) >> 16)
+#endif
+
+volatile uint32_t timer0_micros = 0;
+volatile uint32_t timer0_micros_high = 0;  // times timer0_micros wrapped
+#ifdef MICROS_FRACTION
+volatile uint32_t timer0_micros_fract = 0;
+#endif
+
+#ifdef TIFR0
+#define TIMER0_OVERFLOW_PENDING() (TIFR0 & _BV(TOV0))
+#else
+#define TIMER0_OVERFLOW_PENDING() (TIFR & _BV(TOV0))
+#endif
+
 //ISR(TIMER0_OVF_vect)
 void Wiring_Delay_Timer0_overflow(void)
 {
@@ -67,6 +106,11 @@ void Wiring_Delay_Timer0_overflow(void)
 #else
   uint8_t f = timer0_fract;
 #endif
+  uint32_t u0 = timer0_micros;
+  uint32_t u = u0 + MICROS_INC;
+#ifdef MICROS_FRACTION
+  uint32_t uf = timer0_micros_fract + MICROS_FRACT_INC;
+#endif
 
   m += MILLIS_INC;
   f += FRACT_INC;
@@ -76,13 +120,74 @@ void Wiring_Delay_Timer0_overflow(void)
     m += 1;
   }
 
+#ifdef MICROS_FRACTION
+  if (uf >= MICROS_FRACT_MAX)
+  {
+    uf -= MICROS_FRACT_MAX;
+    u += 1;
+  }
+  timer0_micros_fract = uf;
+#endif
+  if (u < u0)
+    timer0_micros_high++;
+
   timer0_fract = f;
   timer0_millis = m;
+  timer0_micros = u;
   timer0_overflow_count++;
 }
 
 
-uint32_t millis()
+// Account for Timer 0 overflows that did not happen, because Timer 0 was
+// stopped (asleep with clkIO halted), as if they had.
+void Wiring_Delay_Timer0_advance(uint32_t overflows)
+{
+  uint32_t m, f, n, u;
+  uint32_t rest = overflows % FRACT_MAX;
+  uint8_t oldSREG = SREG;
+
+  cli();
+  // FRACT_MAX overflows add exactly FRACT_INC whole milliseconds
+  m = timer0_millis + overflows * MILLIS_INC + (overflows / FRACT_MAX) * FRACT_INC;
+  f = timer0_fract;
+  // the rest in steps small enough for n * FRACT_INC to fit in 32 bits
+  while (rest)
+  {
+    n = (rest > 40000) ? 40000 : rest;
+    f += n * FRACT_INC;
+    m += f / FRACT_MAX;
+    f %= FRACT_MAX;
+    rest -= n;
+  }
+  timer0_fract = f;
+  timer0_millis = m;
+
+  // the same for micros(), in steps small enough for n * MICROS_FRACT_INC
+  u = timer0_micros + overflows * MICROS_INC;
+#ifdef MICROS_FRACTION
+  f = timer0_micros_fract;
+  rest = overflows;
+  while (rest)
+  {
+    n = (rest > 0xFFFFFFFFUL / MICROS_FRACT_MAX - 1) ? 0xFFFFFFFFUL / MICROS_FRACT_MAX - 1 : rest;
+    f += n * MICROS_FRACT_INC;
+    u += f / MICROS_FRACT_MAX;
+    f %= MICROS_FRACT_MAX;
+    rest -= n;
+  }
+  timer0_micros_fract = f;
+#endif
+  // less than 2^32 microseconds (71 minutes) at a time
+  if (u < timer0_micros)
+    timer0_micros_high++;
+  timer0_micros = u;
+
+  timer0_overflow_count += overflows;
+  SREG = oldSREG;
+}
+
+
+unsigned long millis()
 {
   uint32_t m;
   uint8_t oldSREG = SREG;
@@ -97,47 +202,85 @@ uint32_t millis()
 }
 
 
-// micros() gets the number of Timer 0 overflows (timer0_overflow_count) x 256
-// (which is the the overflow max for Timer 0)
-// plus what the current Timer 0 counter holds,
-// and returns the number of microseconds calculated from that value.
-
-// BH: ***FAIL*** This fails miserably for CPU clock frequencies which
-// are not multiples of 1E6.
-// It is NOT recommended to use micros() on systems with clock frequencies
-// that are not multiples of 1E6, since the floating point calculation will
-// take 120+ !! bytes of code (and obviously a lot of time), not including the
-// floating point functions that will need to be linked in.
+// micros() is the microseconds counted by the overflow interrupt, plus
+// what the current Timer 0 counter holds.  An overflow that is pending
+// (the interrupt has not run yet) is counted as well.
 
 unsigned long micros()
 {
   uint32_t m;
   uint8_t t;
   uint8_t oldSREG = SREG;
-        
-  cli();  
-  // get the number of overflows
-  m = timer0_overflow_count;
-  // get the current counter value
+
+  cli();
+  m = timer0_micros;
   t = TCNT0;
-  
-#ifdef TIFR0
-  if ((TIFR0 & _BV(TOV0)) && (t < 255))
-    m++;
-#else
-  if ((TIFR & _BV(TOV0)) && (t < 255))
-    m++;
+
+  if (TIMER0_OVERFLOW_PENDING() && (t < 255))
+  {
+    m += MICROS_INC;
+#ifdef MICROS_FRACTION
+    if (timer0_micros_fract + MICROS_FRACT_INC >= MICROS_FRACT_MAX)
+      m++;
 #endif
+  }
 
   SREG = oldSREG;
-  
-  // (m * 256 + t) * the number of microseconds/timer tick
-  // (i.e. each timer tick = 1E6 / (F_CPU/PRESCALAR) microseconds)
-#if ((F_CPU % 1000000) == 0)
-  return ((m * 256 + t) * (TIMER0PRESCALEFACTOR / (F_CPU / 1000000UL)));
-#else
-  return (unsigned long) (1.0 * (m * 256 + t) * TIMER0PRESCALEFACTOR / (F_CPU / 1E6));
+
+  return m + TICKS_TO_MICROS(t);
+}
+
+
+// micros() that does not wrap around (for half a million years).
+
+uint64_t micros64()
+{
+  uint32_t m, h;
+  uint8_t t;
+  uint8_t oldSREG = SREG;
+
+  cli();
+  m = timer0_micros;
+  h = timer0_micros_high;
+  t = TCNT0;
+
+  if (TIMER0_OVERFLOW_PENDING() && (t < 255))
+  {
+    m += MICROS_INC;
+#ifdef MICROS_FRACTION
+    if (timer0_micros_fract + MICROS_FRACT_INC >= MICROS_FRACT_MAX)
+      m++;
 #endif
+    if (m < timer0_micros)
+      h++;
+  }
+
+  SREG = oldSREG;
+
+  return (((uint64_t)h << 32) | m) + TICKS_TO_MICROS(t);
+}
+
+
+// CPU clock cycles, counted in steps of TIMER0PRESCALEFACTOR cycles (the
+// Timer 0 clock).  Wraps around every 2^32 cycles (268 s at 16 MHz), so
+// use it for the difference between two close timestamps, for profiling.
+
+uint32_t clockCycles()
+{
+  uint32_t m;
+  uint8_t t;
+  uint8_t oldSREG = SREG;
+
+  cli();
+  m = timer0_overflow_count;
+  t = TCNT0;
+
+  if (TIMER0_OVERFLOW_PENDING() && (t < 255))
+    m++;
+
+  SREG = oldSREG;
+
+  return ((m << 8) + t) * TIMER0PRESCALEFACTOR;
 }
 
 
@@ -148,7 +291,7 @@ unsigned long micros()
 //             ----------
 //             0x00000022 (unsigned, carry dropped)
 
-void delay(uint32_t ms)
+void delay(unsigned long ms)
 {
 /* older method using micros()
   uint16_t start = (uint16_t)micros();
@@ -205,11 +348,15 @@ void delayMicroseconds(uint16_t count)
   count = count / (uint16_t)(4000000UL / F_CPU);
 #endif
   // one loop takes 4 cpu cycles 
+#if defined(WIRING_HOST)
+  _hostDelayCycles(4UL * count);
+#else
    __asm__ volatile (
      "1: sbiw %0,1" "\n\t"
      "brne 1b"
      : "=w" (count)
      : "0" (count) );
+#endif
 }
 
 
@@ -3,6 +3,7 @@
 || @author         Brett Hagman <bhagman@wiring.org.co>
 || @url            http://wiring.org.co/
 || @contribution   Hernando Barragan <b@wiring.org.co>
+|| @contribution   Camilo Reyes <creyes@wiring.org.co>
 ||
 || @description
 || | Delay and timing control.
@@ -21,6 +22,7 @@
 // Prototypes
 
 void Wiring_Delay_Timer0_overflow(void);
+void Wiring_Delay_Timer0_advance(uint32_t);
 void delay(unsigned long);
 #define delayMilliseconds(ms) delay(ms)
 
@@ -39,6 +41,8 @@ void delayMicroseconds(unsigned long);
 void delayMicroseconds(uint16_t);
 unsigned long millis(void);
 unsigned long micros(void);
+uint64_t micros64(void);
+uint32_t clockCycles(void);
 
 
 #endif
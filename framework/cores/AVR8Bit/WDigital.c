@@ -3,6 +3,7 @@
 || @author         Brett Hagman <bhagman@wiring.org.co>
 || @url            http://wiring.org.co/
 || @contribution   Hernando Barragan <b@wiring.org.co>
+|| @contribution   Camilo Reyes <creyes@wiring.org.co>
 ||
 || @description
 || | Digital pin/port control for
@@ -88,6 +89,11 @@ const uint8_t PROGMEM pin_type_PGM[] =
 //#endif
 //};
 
+// PINx, DDRx and PORTx stand-in for DigitalPin objects on a pin that
+// does not exist (WPin.h).
+volatile uint8_t _noPortRegisters[3];
+
+
 void _pinMode(uint8_t pin, uint8_t mode)
 {
   uint8_t bitmask = digitalPinToBitMask(pin);
@@ -200,3 +206,63 @@ void _portWrite(uint8_t port, uint8_t val)
   SREG = oldSREG;
 }
 
+
+void _portModeMasked(uint8_t port, uint8_t mode, uint8_t mask)
+{
+  volatile uint8_t *moderegister;
+
+  moderegister = portModeRegister(port);
+
+  if (moderegister == NOT_A_REG) return;
+
+  uint8_t oldSREG = SREG;
+  cli();
+
+  if (mode == OUTPUT)
+    *moderegister |= mask;
+  else
+    *moderegister &= ~mask;
+
+  SREG = oldSREG;
+}
+
+
+// Only the bits in mask change, in a single write to the port.
+void _portWriteMasked(uint8_t port, uint8_t val, uint8_t mask)
+{
+  volatile uint8_t *portregister;
+
+  portregister = portOutputRegister(port);
+
+  if (portregister == NOT_A_REG) return;
+
+#if defined(PORT_TOGGLE_BY_PIN)
+  // Toggle the bits that differ: no read-modify-write of PORTx, so no
+  // need to disable interrupts.
+  *portInputRegister(port) = (*portregister ^ val) & mask;
+#else
+  uint8_t oldSREG = SREG;
+  cli();
+  *portregister = (*portregister & ~mask) | (val & mask);
+  SREG = oldSREG;
+#endif
+}
+
+
+void _portToggle(uint8_t port, uint8_t mask)
+{
+  volatile uint8_t *portregister;
+
+  portregister = portOutputRegister(port);
+
+  if (portregister == NOT_A_REG) return;
+
+#if defined(PORT_TOGGLE_BY_PIN)
+  *portInputRegister(port) = mask;
+#else
+  uint8_t oldSREG = SREG;
+  cli();
+  *portregister ^= mask;
+  SREG = oldSREG;
+#endif
+}
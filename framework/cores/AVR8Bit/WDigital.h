@@ -3,6 +3,7 @@
 || @author         Brett Hagman <bhagman@wiring.org.co>
 || @url            http://wiring.org.co/
 || @contribution   Hernando Barragan <b@wiring.org.co>
+|| @contribution   Camilo Reyes <creyes@wiring.org.co>
 ||
 || @description
 || | Digital pin/port control for
@@ -29,16 +30,67 @@ void _pinWrite(uint8_t, uint8_t);
 void _portMode(uint8_t, uint8_t);
 uint8_t _portRead(uint8_t);
 void _portWrite(uint8_t, uint8_t);
+void _portModeMasked(uint8_t, uint8_t, uint8_t);
+void _portWriteMasked(uint8_t, uint8_t, uint8_t);
+void _portToggle(uint8_t, uint8_t);
+
+// Writing ones to PINx toggles those PORTx bits, except on the older
+// parts.
+#if !defined(__AVR_ATmega8__) && !defined(__AVR_ATmega8535__) && \
+    !defined(__AVR_ATmega16__) && !defined(__AVR_ATmega32__) && \
+    !defined(__AVR_ATmega64__) && !defined(__AVR_ATmega128__) && \
+    !defined(__AVR_ATmega162__)
+#define PORT_TOGGLE_BY_PIN
+#endif
+
+// A constant |= or &= ~ of MASK on the register is a single sbi/cbi
+// instruction: MASK is one bit, and the register in the lower 32 I/O
+// registers.
+#define _SBI_CBI_P(REG, MASK) \
+  (((MASK) & ((MASK) - 1)) == 0 && _SFR_MEM_ADDR(*(REG)) < 0x20 + __SFR_OFFSET)
+
+// Set or clear the bits in MASK of a register.  With constants, this is
+// a single sbi/cbi where it can be; otherwise (PORTF/PORTG and the DDRs
+// of the extended I/O space, or more than one bit) the read-modify-write
+// is done with interrupts disabled, so that it cannot undo a change an
+// interrupt handler makes to the other bits.
+static inline void _regSet(volatile uint8_t *, uint8_t) __attribute__((always_inline, unused));
+static inline void _regSet(volatile uint8_t *REG, uint8_t MASK)
+{
+  if (_SBI_CBI_P(REG, MASK))
+    *REG |= MASK;
+  else
+  {
+    uint8_t oldSREG = SREG;
+    cli();
+    *REG |= MASK;
+    SREG = oldSREG;
+  }
+}
+
+static inline void _regClear(volatile uint8_t *, uint8_t) __attribute__((always_inline, unused));
+static inline void _regClear(volatile uint8_t *REG, uint8_t MASK)
+{
+  if (_SBI_CBI_P(REG, MASK))
+    *REG &= ~MASK;
+  else
+  {
+    uint8_t oldSREG = SREG;
+    cli();
+    *REG &= ~MASK;
+    SREG = oldSREG;
+  }
+}
 
 static inline void pinMode(uint8_t, uint8_t) __attribute__((always_inline, unused));
 static inline void pinMode(uint8_t PIN, uint8_t MODE)
 {
-  if (__builtin_constant_p(PIN) && __builtin_constant_p(MODE))
+  if (__builtin_constant_p(PIN))
   {
     if (MODE)
-      *(portModeRegister(digitalPinToPort(PIN))) |= digitalPinToBitMask(PIN);
+      _regSet(portModeRegister(digitalPinToPort(PIN)), digitalPinToBitMask(PIN));
     else
-      *(portModeRegister(digitalPinToPort(PIN))) &= ~digitalPinToBitMask(PIN);  
+      _regClear(portModeRegister(digitalPinToPort(PIN)), digitalPinToBitMask(PIN));
   }
   else
     _pinMode(PIN, MODE);
@@ -58,25 +110,18 @@ static inline uint8_t pinRead(uint8_t PIN)
 // BH: We don't need to turn off interrupts for the
 // single instruction expansion macro. (i.e. this static inline
 // will be optimized to a single instruction if constants are used)
+// A constant pin with a variable value becomes a test and an sbi or cbi.
+// Pins outside the lower 32 I/O registers are written with interrupts
+// disabled (_regSet()).
 static inline void pinWrite(uint8_t, uint8_t) __attribute__((always_inline, unused));
 static inline void pinWrite(uint8_t PIN, uint8_t VALUE)
 {
-  if (__builtin_constant_p(PIN) && __builtin_constant_p(VALUE))
+  if (__builtin_constant_p(PIN))
   {
     if (VALUE)
-    {
-//      uint8_t oldSREG = SREG;
-//      cli();
-      *(digitalPinToPortReg(PIN)) |= digitalPinToBitMask(PIN);
-//      SREG = oldSREG;
-    }
+      _regSet(digitalPinToPortReg(PIN), digitalPinToBitMask(PIN));
     else
-    {
-//      uint8_t oldSREG = SREG;
-//      cli();
-      *(digitalPinToPortReg(PIN)) &= ~digitalPinToBitMask(PIN);  
-//      SREG = oldSREG;
-    }
+      _regClear(digitalPinToPortReg(PIN), digitalPinToBitMask(PIN));
   }
   else
     _pinWrite(PIN, VALUE);
@@ -112,5 +157,46 @@ static inline void portWrite(uint8_t PORT, uint8_t VALUE)
     _portWrite(PORT, VALUE);
 }
 
+// Set the mode of only the pins in MASK.  Inline, only a single sbi/cbi
+// is done as it is; otherwise the read-modify-write of DDRx is done with
+// interrupts disabled, as _portModeMasked() does.
+static inline void portModeMasked(uint8_t, uint8_t, uint8_t) __attribute__((always_inline, unused));
+static inline void portModeMasked(uint8_t PORT, uint8_t MODE, uint8_t MASK)
+{
+  if (__builtin_constant_p(PORT) && __builtin_constant_p(MODE) && __builtin_constant_p(MASK))
+  {
+    if (MODE == OUTPUT)
+      _regSet(portModeRegister(PORT), MASK);
+    else
+      _regClear(portModeRegister(PORT), MASK);
+  }
+  else
+    _portModeMasked(PORT, MODE, MASK);
+}
+
+// Write only the pins in MASK, leaving the rest of the port alone.
+static inline void portWriteMasked(uint8_t, uint8_t, uint8_t) __attribute__((always_inline, unused));
+static inline void portWriteMasked(uint8_t PORT, uint8_t VALUE, uint8_t MASK)
+{
+#if defined(PORT_TOGGLE_BY_PIN)
+  if (__builtin_constant_p(PORT))
+    *(portInputRegister(PORT)) = (*(portOutputRegister(PORT)) ^ VALUE) & MASK;
+  else
+#endif
+    _portWriteMasked(PORT, VALUE, MASK);
+}
+
+// Toggle the pins in MASK.
+static inline void portToggle(uint8_t, uint8_t) __attribute__((always_inline, unused));
+static inline void portToggle(uint8_t PORT, uint8_t MASK)
+{
+#if defined(PORT_TOGGLE_BY_PIN)
+  if (__builtin_constant_p(PORT))
+    *(portInputRegister(PORT)) = MASK;
+  else
+#endif
+    _portToggle(PORT, MASK);
+}
+
 #endif
 // WDIGITAL_H
@@ -6,6 +6,7 @@
 || @contribution   gabebear
 || @contribution   Hernando Barragan <b@wiring.org.co>
 || @contribution   Nicholas Zambetti
+|| @contribution   Camilo Reyes <creyes@wiring.org.co>
 ||
 || @description
 || | Hardware Serial class for
@@ -15,7 +16,8 @@
 || #
 ||
 || @notes
-|| | Utilizes modified FIFO class by Alexander Brevig (2010).
+|| | Buffers are lock-free single producer / single consumer rings
+|| | (RingBuffer.h); the ISRs and the main program never block each other.
 || | U2X and frame format code by gabebear (2010).
 || | Interface by Hernando Barragan and Nicholas Zambetti (2006).
 || #
@@ -24,9 +26,10 @@
 ||
 */
 
+#include <Wiring.h>
 #include <avr/io.h>
 #include <stdlib.h>
-#include <FIFO.h>
+#include <RingBuffer.h>
 #include "WHardwareSerial.h"
 
 // Now, provide the class only if the hardware has at least one serial port.
@@ -57,67 +60,95 @@
 */
 #endif
 
+// Receive ISR body.
+inline void HardwareSerial::receive(void)
+{
+  if (rxHandler)
+    rxHandler(rxContext);
+  else
+    rxfifo.enqueue(*_udr);
+}
+
+
+// Transmit ISR body: a send() in progress goes first, then the buffer.
+inline void HardwareSerial::transmit(void)
+{
+  uint8_t c;
+
+  if (txRemaining)
+  {
+    *_udr = *txData++;
+    if (--txRemaining == 0)
+      sendNext();
+  }
+  else if (txfifo.dequeue(c))
+    *_udr = c;
+
+  if (txRemaining == 0 && txfifo.isEmpty())
+    *_ucsrb = (1 << RXEN) | (1 << TXEN) | (1 << RXCIE);
+}
+
 #if !defined(SINGLEUSART1)
 ISR(Serial_RX_vect)
 {
-  Serial.rxfifo.enqueue(*Serial._udr);
+  PROFILE_ENTER();
+  Serial.receive();
+  PROFILE_EXIT(PROFILE_SERIAL_RX);
 }
 
 ISR(Serial_TX_vect)
 {
-  if (Serial.txfifo.count() > 0)
-    *Serial._udr = Serial.txfifo.dequeue();
-
-  if (Serial.txfifo.count() == 0)
-    *Serial._ucsrb = (1 << RXEN) | (1 << TXEN) | (1 << RXCIE);
+  PROFILE_ENTER();
+  Serial.transmit();
+  PROFILE_EXIT(PROFILE_SERIAL_TX);
 }
 #endif
 
 #if SERIALPORTS > 1 || defined(SINGLEUSART1)
 ISR(Serial1_RX_vect)
 {
-  Serial1.rxfifo.enqueue(*Serial1._udr);
+  PROFILE_ENTER();
+  Serial1.receive();
+  PROFILE_EXIT(PROFILE_SERIAL1_RX);
 }
 
 ISR(Serial1_TX_vect)
 {
-  if (Serial1.txfifo.count() > 0)
-    *Serial1._udr = Serial1.txfifo.dequeue();
-
-  if (Serial1.txfifo.count() == 0)
-    *Serial1._ucsrb = (1 << RXEN) | (1 << TXEN) | (1 << RXCIE);
+  PROFILE_ENTER();
+  Serial1.transmit();
+  PROFILE_EXIT(PROFILE_SERIAL1_TX);
 }
 #endif
 
 #if SERIALPORTS > 2
 ISR(Serial2_RX_vect)
 {
-  Serial2.rxfifo.enqueue(*Serial2._udr);
+  PROFILE_ENTER();
+  Serial2.receive();
+  PROFILE_EXIT(PROFILE_SERIAL2_RX);
 }
 
 ISR(Serial2_TX_vect)
 {
-  if (Serial2.txfifo.count() > 0)
-    *Serial2._udr = Serial2.txfifo.dequeue();
-
-  if (Serial2.txfifo.count() == 0)
-    *Serial2._ucsrb = (1 << RXEN) | (1 << TXEN) | (1 << RXCIE);
+  PROFILE_ENTER();
+  Serial2.transmit();
+  PROFILE_EXIT(PROFILE_SERIAL2_TX);
 }
 #endif
 
 #if SERIALPORTS > 3
 ISR(Serial3_RX_vect)
 {
-  Serial3.rxfifo.enqueue(*Serial3._udr);
+  PROFILE_ENTER();
+  Serial3.receive();
+  PROFILE_EXIT(PROFILE_SERIAL3_RX);
 }
 
 ISR(Serial3_TX_vect)
 {
-  if (Serial3.txfifo.count() > 0)
-    *Serial3._udr = Serial3.txfifo.dequeue();
-
-  if (Serial3.txfifo.count() == 0)
-    *Serial3._ucsrb = (1 << RXEN) | (1 << TXEN) | (1 << RXCIE);
+  PROFILE_ENTER();
+  Serial3.transmit();
+  PROFILE_EXIT(PROFILE_SERIAL3_TX);
 }
 #endif
 
@@ -126,6 +157,13 @@ ISR(Serial3_TX_vect)
 
 HardwareSerial::HardwareSerial(uint8_t serialPortNumber)
 {
+  txSending = false;
+  txRemaining = 0;
+  txNext = 0;
+  txDone = 0;
+  rxHandler = 0;
+  rxContext = 0;
+
   switch (serialPortNumber)
   {
     // We do not take into consideration older AVRs with a single UART,
@@ -207,7 +245,7 @@ void HardwareSerial::begin(const uint32_t baud,
   calcBaud = F_CPU/16/calcUBRR;
   calcBaudU2X = F_CPU/8/calcUBRRU2X;
 
-  if (abs(calcBaudU2X - baud) < abs(calcBaud - baud))
+  if (abs((int32_t)(calcBaudU2X - baud)) < abs((int32_t)(calcBaud - baud)))
   {
     *_ucsra = 1 << U2X;
     ubrrValue = calcUBRRU2X - 1;
@@ -259,6 +297,7 @@ void HardwareSerial::begin(const uint32_t baud,
   }
 
   *_ucsrc = frame_format;
+  rxHandler = 0;  // a serial port again, if it was a WSerialSPI
 
   // assign the baud_setting, a.k.a. ubbr (USART Baud Rate Register)
   *_ubrrh = ubrrValue >> 8;
@@ -279,21 +318,33 @@ int HardwareSerial::available(void)
 }
 
 
-int HardwareSerial::read(void)
+int HardwareSerial::availableForWrite(void)
 {
-  uint8_t c;
+  return txfifo.room();
+}
 
-  if (rxfifo.count())
-  {
-    uint8_t oldSREG = SREG;
-    cli();
 
-    c = rxfifo.dequeue();
+// Received bytes dropped because the receive buffer was full.
+uint16_t HardwareSerial::overflows(void)
+{
+  uint16_t n;
+  uint8_t oldSREG = SREG;
+  cli();
+
+  n = rxfifo.overflows();
 
-    SREG = oldSREG;
+  SREG = oldSREG;
+
+  return n;
+}
 
+
+int HardwareSerial::read(void)
+{
+  uint8_t c;
+
+  if (rxfifo.dequeue(c))
     return c;
-  }
   else
     return -1;
 }
@@ -301,7 +352,7 @@ int HardwareSerial::read(void)
 
 int HardwareSerial::peek(void)
 {
-  if (rxfifo.count())
+  if (!rxfifo.isEmpty())
     return rxfifo.peek();
   else
     return -1;
@@ -314,15 +365,100 @@ void HardwareSerial::flush()
 }
 
 
-size_t HardwareSerial::write(uint8_t c)
+// Called while waiting on the transmitter.  With interrupts disabled
+// (e.g. printing from an ISR) the transmit ISR cannot empty it, so feed
+// the data register from here instead of blocking forever.
+void HardwareSerial::txPoll(void)
+{
+  if (!(SREG & (1 << SREG_I)) && (*_ucsra & (1 << UDRE)))
+    transmit();
+}
+
+
+// Load the next segment of a send(), skipping empty ones, or finish it.
+// Called with interrupts disabled.
+void HardwareSerial::sendNext(void)
+{
+  while (txNext && txRemaining == 0)
+  {
+    txData = txNext->data;
+    txRemaining = txNext->length;
+    txNext = txNext->next;
+  }
+
+  if (txRemaining == 0)
+  {
+    txSending = false;
+    if (txDone)
+      txDone();
+  }
+}
+
+
+// Transmit a chain of caller owned segments straight from memory, after
+// whatever is already in the transmit buffer.  Returns false if a send()
+// is still in progress.  The segments must stay untouched until done()
+// is called (from the transmit ISR) or sending() returns false.
+bool HardwareSerial::send(const SerialSegment *chain, void (*done)(void))
 {
-  // We will block here until we have some space free in the FIFO
-  while (txfifo.count() >= TX_BUFFER_SIZE);
+  if (txSending)
+    return false;
+
+  // Keep the order: let the buffer drain first
+  while (!txfifo.isEmpty())
+    txPoll();
 
   uint8_t oldSREG = SREG;
   cli();
 
+  txSending = true;
+  txDone = done;
+  txData = 0;
+  txRemaining = 0;
+  txNext = chain;
+  sendNext();
+  if (txSending)
+    *_ucsrb |= (1 << UDRIE);
+
+  SREG = oldSREG;
+
+  return true;
+}
+
+
+bool HardwareSerial::send(const uint8_t *buffer, uint16_t length, void (*done)(void))
+{
+  if (txSending)
+    return false;
+
+  txSegment.data = buffer;
+  txSegment.length = length;
+  txSegment.next = 0;
+
+  return send(&txSegment, done);
+}
+
+
+bool HardwareSerial::sending(void)
+{
+  txPoll();
+
+  return txSending;
+}
+
+
+size_t HardwareSerial::write(uint8_t c)
+{
+  // We will block here until we have some space free in the buffer
+  while (txfifo.isFull())
+    txPoll();
+
   txfifo.enqueue(c);
+
+  // UCSRB is also written by the transmit ISR
+  uint8_t oldSREG = SREG;
+  cli();
+
   *_ucsrb |= (1 << UDRIE);
 
   SREG = oldSREG;
@@ -331,6 +467,36 @@ size_t HardwareSerial::write(uint8_t c)
 }
 
 
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+  size_t remaining = size;
+  uint8_t n;
+
+  while (remaining)
+  {
+    // Copy as much as fits, blocking here until there is some space free
+    n = txfifo.enqueue(buffer, remaining > 255 ? 255 : remaining);
+    if (n == 0)
+    {
+      txPoll();
+      continue;
+    }
+
+    buffer += n;
+    remaining -= n;
+
+    uint8_t oldSREG = SREG;
+    cli();
+
+    *_ucsrb |= (1 << UDRIE);
+
+    SREG = oldSREG;
+  }
+
+  return size;
+}
+
+
 // Preinstantiate Objects
 
 
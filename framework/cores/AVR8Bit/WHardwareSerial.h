@@ -6,6 +6,7 @@
 || @contribution   gabebear
 || @contribution   Hernando Barragan <b@wiring.org.co>
 || @contribution   Nicholas Zambetti
+|| @contribution   Camilo Reyes <creyes@wiring.org.co>
 ||
 || @description
 || | Hardware Serial class for
@@ -24,10 +25,15 @@
 #include <inttypes.h>
 #include <avr/interrupt.h>
 #include <Stream.h>
-#include <FIFO.h>
+#include <RingBuffer.h>
 
+// Buffer sizes must be powers of two, at most 128.
+#ifndef RX_BUFFER_SIZE
 #define RX_BUFFER_SIZE 32
+#endif
+#ifndef TX_BUFFER_SIZE
 #define TX_BUFFER_SIZE 16
+#endif
 
 #define SERIALPORTS 0
 
@@ -97,8 +103,18 @@ ISR(Serial3_RX_vect);
 ISR(Serial3_TX_vect);
 #endif
 
+// One piece of a zero copy transmission, see HardwareSerial::send().
+struct SerialSegment
+{
+  const uint8_t *data;
+  uint16_t length;
+  const SerialSegment *next;
+};
+
 class HardwareSerial : public Stream
 {
+  friend class WSerialSPI;
+
 #if !defined(SINGLEUSART1)
   friend void Serial_RX_vect();
   friend void Serial_TX_vect();
@@ -117,14 +133,29 @@ class HardwareSerial : public Stream
 #endif
 
   private:
-    FIFO<uint8_t,RX_BUFFER_SIZE> rxfifo;
-    FIFO<uint8_t,TX_BUFFER_SIZE> txfifo;
+    RingBuffer<uint8_t,RX_BUFFER_SIZE> rxfifo;
+    RingBuffer<uint8_t,TX_BUFFER_SIZE> txfifo;
     volatile uint8_t *_ubrrh;
     volatile uint8_t *_ubrrl;
     volatile uint8_t *_ucsra;
     volatile uint8_t *_ucsrb;
     volatile uint8_t *_ucsrc;
     volatile uint8_t *_udr;
+    // send() state, owned by the transmit ISR while txSending is set
+    const uint8_t *txData;
+    volatile uint16_t txRemaining;
+    const SerialSegment *txNext;
+    void (*txDone)(void);
+    volatile bool txSending;
+    SerialSegment txSegment;
+    // While set (a WSerialSPI has the USART), the receive ISR calls this
+    // instead of buffering; it reads UDRn itself.
+    void (*rxHandler)(void *context);
+    void *rxContext;
+    inline void receive(void);
+    inline void transmit(void);
+    void txPoll(void);
+    void sendNext(void);
   public:
     HardwareSerial(uint8_t SerialPortNumber);
     void begin(const uint32_t baud = 9600,
@@ -133,10 +164,17 @@ class HardwareSerial : public Stream
                const uint8_t parity = 0);
     void end();
     int available(void);
+    int availableForWrite(void);
+    uint16_t overflows(void);
     int read(void);
     int peek(void);
     void flush(void);
     size_t write(uint8_t);
+    size_t write(const uint8_t *buffer, size_t size);
+    using Print::write;
+    bool send(const uint8_t *buffer, uint16_t length, void (*done)(void) = 0);
+    bool send(const SerialSegment *chain, void (*done)(void) = 0);
+    bool sending(void);
 };
 
 #if !defined(SINGLEUSART1)
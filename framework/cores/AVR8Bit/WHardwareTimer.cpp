@@ -3,6 +3,7 @@
 || @author         Brett Hagman <bhagman@wiring.org.co>
 || @url            http://wiring.org.co/
 || @contribution   Hernando Barragan <b@wiring.org.co>
+|| @contribution   Camilo Reyes <creyes@wiring.org.co>
 ||
 || @description
 || | Hardware Timer class for Atmel AVR 8 bit microcontroller series core.
@@ -43,6 +44,7 @@
 ||
 */
 
+#include <Wiring.h>
 #include "WHardwareTimer.h"
 
 
@@ -66,167 +68,67 @@
 #define ICIEn  5
 
 
+// The core's timer interrupt handlers, weak so that a library can
+// replace them (see TIMER_ISR() in WHardwareTimer.h), and the vectors
+// jumping to them.
+#define TIMER_VECTOR(vector, timer, interrupt, entry) \
+  ISR(TIMER_HANDLER(vector), __attribute__((weak))) \
+  { \
+    PROFILE_ENTER(); \
+    timer.dispatch(interrupt); \
+    PROFILE_EXIT(entry); \
+  } \
+  ISR_ALIAS(vector, TIMER_HANDLER(vector))
+
 #if defined (TIMER0_COMP_vect)
 // only a single COMP vector
-ISR(TIMER0_COMP_vect)
-{
-  if (Timer0.compareMatchAFunction != NULL)
-    Timer0.compareMatchAFunction();
-}
+TIMER_VECTOR(TIMER0_COMP_vect, Timer0, INTERRUPT_COMPARE_MATCH_A, PROFILE_TIMER0_COMPA)
 #else
-ISR(TIMER0_COMPA_vect)
-{
-  if (Timer0.compareMatchAFunction != NULL)
-    Timer0.compareMatchAFunction();
-}
-ISR(TIMER0_COMPB_vect)
-{
-  if (Timer0.compareMatchBFunction != NULL)
-    Timer0.compareMatchBFunction();
-}
+TIMER_VECTOR(TIMER0_COMPA_vect, Timer0, INTERRUPT_COMPARE_MATCH_A, PROFILE_TIMER0_COMPA)
+TIMER_VECTOR(TIMER0_COMPB_vect, Timer0, INTERRUPT_COMPARE_MATCH_B, PROFILE_TIMER0_COMPB)
 #endif
-ISR(TIMER0_OVF_vect)
-{
-  if (Timer0.overflowFunction != NULL)
-    Timer0.overflowFunction();
-}
+TIMER_VECTOR(TIMER0_OVF_vect, Timer0, INTERRUPT_OVERFLOW, PROFILE_TIMER0_OVF)
 
 #if (NUM_8BIT_TIMERS == 2)
 #if defined (TIMER2_COMP_vect)
 // only a single COMP vector
-ISR(TIMER2_COMP_vect)
-{
-  if (Timer2.compareMatchAFunction != NULL)
-    Timer2.compareMatchAFunction();
-}
+TIMER_VECTOR(TIMER2_COMP_vect, Timer2, INTERRUPT_COMPARE_MATCH_A, PROFILE_TIMER2_COMPA)
 #else
-ISR(TIMER2_COMPA_vect)
-{
-  if (Timer2.compareMatchAFunction != NULL)
-    Timer2.compareMatchAFunction();
-}
-ISR(TIMER2_COMPB_vect)
-{
-  if (Timer2.compareMatchBFunction != NULL)
-    Timer2.compareMatchBFunction();
-}
+TIMER_VECTOR(TIMER2_COMPA_vect, Timer2, INTERRUPT_COMPARE_MATCH_A, PROFILE_TIMER2_COMPA)
+TIMER_VECTOR(TIMER2_COMPB_vect, Timer2, INTERRUPT_COMPARE_MATCH_B, PROFILE_TIMER2_COMPB)
 #endif
-ISR(TIMER2_OVF_vect)
-{
-  if (Timer2.overflowFunction != NULL)
-    Timer2.overflowFunction();
-}
+TIMER_VECTOR(TIMER2_OVF_vect, Timer2, INTERRUPT_OVERFLOW, PROFILE_TIMER2_OVF)
 #endif
 
-ISR(TIMER1_COMPA_vect)
-{
-  if (Timer1.compareMatchAFunction != NULL)
-    Timer1.compareMatchAFunction();
-}
-ISR(TIMER1_COMPB_vect)
-{
-  if (Timer1.compareMatchBFunction != NULL)
-    Timer1.compareMatchBFunction();
-}
+TIMER_VECTOR(TIMER1_COMPA_vect, Timer1, INTERRUPT_COMPARE_MATCH_A, PROFILE_TIMER1_COMPA)
+TIMER_VECTOR(TIMER1_COMPB_vect, Timer1, INTERRUPT_COMPARE_MATCH_B, PROFILE_TIMER1_COMPB)
 // Most controllers don't have a third compare match on Timer 1
 #if defined (TIMER1_COMPC_vect)
-ISR(TIMER1_COMPC_vect)
-{
-  if (Timer1.compareMatchCFunction != NULL)
-    Timer1.compareMatchCFunction();
-}
+TIMER_VECTOR(TIMER1_COMPC_vect, Timer1, INTERRUPT_COMPARE_MATCH_C, PROFILE_TIMER1_COMPC)
 #endif
-ISR(TIMER1_OVF_vect)
-{
-  if (Timer1.overflowFunction != NULL)
-    Timer1.overflowFunction();
-}
-ISR(TIMER1_CAPT_vect)
-{
-  if (Timer1.captureEventFunction != NULL)
-    Timer1.captureEventFunction();
-}
+TIMER_VECTOR(TIMER1_OVF_vect, Timer1, INTERRUPT_OVERFLOW, PROFILE_TIMER1_OVF)
+TIMER_VECTOR(TIMER1_CAPT_vect, Timer1, INTERRUPT_CAPTURE_EVENT, PROFILE_TIMER1_CAPT)
 
 #if (NUM_16BIT_TIMERS > 1)
-ISR(TIMER3_COMPA_vect)
-{
-  if (Timer3.compareMatchAFunction != NULL)
-    Timer3.compareMatchAFunction();
-}
-ISR(TIMER3_COMPB_vect)
-{
-  if (Timer3.compareMatchBFunction != NULL)
-    Timer3.compareMatchBFunction();
-}
-ISR(TIMER3_COMPC_vect)
-{
-  if (Timer3.compareMatchCFunction != NULL)
-    Timer3.compareMatchCFunction();
-}
-ISR(TIMER3_OVF_vect)
-{
-  if (Timer3.overflowFunction != NULL)
-    Timer3.overflowFunction();
-}
-ISR(TIMER3_CAPT_vect)
-{
-  if (Timer3.captureEventFunction != NULL)
-    Timer3.captureEventFunction();
-}
+TIMER_VECTOR(TIMER3_COMPA_vect, Timer3, INTERRUPT_COMPARE_MATCH_A, PROFILE_TIMER3_COMPA)
+TIMER_VECTOR(TIMER3_COMPB_vect, Timer3, INTERRUPT_COMPARE_MATCH_B, PROFILE_TIMER3_COMPB)
+TIMER_VECTOR(TIMER3_COMPC_vect, Timer3, INTERRUPT_COMPARE_MATCH_C, PROFILE_TIMER3_COMPC)
+TIMER_VECTOR(TIMER3_OVF_vect, Timer3, INTERRUPT_OVERFLOW, PROFILE_TIMER3_OVF)
+TIMER_VECTOR(TIMER3_CAPT_vect, Timer3, INTERRUPT_CAPTURE_EVENT, PROFILE_TIMER3_CAPT)
 #endif
 
 #if (NUM_16BIT_TIMERS > 2)
-ISR(TIMER4_COMPA_vect)
-{
-  if (Timer4.compareMatchAFunction != NULL)
-    Timer4.compareMatchAFunction();
-}
-ISR(TIMER4_COMPB_vect)
-{
-  if (Timer4.compareMatchBFunction != NULL)
-    Timer4.compareMatchBFunction();
-}
-ISR(TIMER4_COMPC_vect)
-{
-  if (Timer4.compareMatchCFunction != NULL)
-    Timer4.compareMatchCFunction();
-}
-ISR(TIMER4_OVF_vect)
-{
-  if (Timer4.overflowFunction != NULL)
-    Timer4.overflowFunction();
-}
-ISR(TIMER4_CAPT_vect)
-{
-  if (Timer4.captureEventFunction != NULL)
-    Timer4.captureEventFunction();
-}
-
-ISR(TIMER5_COMPA_vect)
-{
-  if (Timer5.compareMatchAFunction != NULL)
-    Timer5.compareMatchAFunction();
-}
-ISR(TIMER5_COMPB_vect)
-{
-  if (Timer5.compareMatchBFunction != NULL)
-    Timer5.compareMatchBFunction();
-}
-ISR(TIMER5_COMPC_vect)
-{
-  if (Timer5.compareMatchCFunction != NULL)
-    Timer5.compareMatchCFunction();
-}
-ISR(TIMER5_OVF_vect)
-{
-  if (Timer5.overflowFunction != NULL)
-    Timer5.overflowFunction();
-}
-ISR(TIMER5_CAPT_vect)
-{
-  if (Timer5.captureEventFunction != NULL)
-    Timer5.captureEventFunction();
-}
+TIMER_VECTOR(TIMER4_COMPA_vect, Timer4, INTERRUPT_COMPARE_MATCH_A, PROFILE_TIMER4_COMPA)
+TIMER_VECTOR(TIMER4_COMPB_vect, Timer4, INTERRUPT_COMPARE_MATCH_B, PROFILE_TIMER4_COMPB)
+TIMER_VECTOR(TIMER4_COMPC_vect, Timer4, INTERRUPT_COMPARE_MATCH_C, PROFILE_TIMER4_COMPC)
+TIMER_VECTOR(TIMER4_OVF_vect, Timer4, INTERRUPT_OVERFLOW, PROFILE_TIMER4_OVF)
+TIMER_VECTOR(TIMER4_CAPT_vect, Timer4, INTERRUPT_CAPTURE_EVENT, PROFILE_TIMER4_CAPT)
+
+TIMER_VECTOR(TIMER5_COMPA_vect, Timer5, INTERRUPT_COMPARE_MATCH_A, PROFILE_TIMER5_COMPA)
+TIMER_VECTOR(TIMER5_COMPB_vect, Timer5, INTERRUPT_COMPARE_MATCH_B, PROFILE_TIMER5_COMPB)
+TIMER_VECTOR(TIMER5_COMPC_vect, Timer5, INTERRUPT_COMPARE_MATCH_C, PROFILE_TIMER5_COMPC)
+TIMER_VECTOR(TIMER5_OVF_vect, Timer5, INTERRUPT_OVERFLOW, PROFILE_TIMER5_OVF)
+TIMER_VECTOR(TIMER5_CAPT_vect, Timer5, INTERRUPT_CAPTURE_EVENT, PROFILE_TIMER5_CAPT)
 #endif
 
 // Constructor
@@ -3,6 +3,7 @@
 || @author         Brett Hagman <bhagman@wiring.org.co>
 || @url            http://wiring.org.co/
 || @contribution   Hernando Barragan <b@wiring.org.co>
+|| @contribution   Camilo Reyes <creyes@wiring.org.co>
 ||
 || @description
 || | Hardware Timer class for Atmel AVR 8 bit microcontroller series core.
@@ -61,104 +62,28 @@
 #define NUM_8BIT_TIMERS 1
 #endif
 
-#if defined (TIMER0_COMP_vect)
-// only a single COMP vector
-ISR(TIMER0_COMP_vect);
-#else
-ISR(TIMER0_COMPA_vect);
-ISR(TIMER0_COMPB_vect);
-#endif
-ISR(TIMER0_OVF_vect);
-
-#if (NUM_8BIT_TIMERS == 2)
-#if defined (TIMER2_COMP_vect)
-// only a single COMP vector
-ISR(TIMER2_COMP_vect);
-#else
-ISR(TIMER2_COMPA_vect);
-ISR(TIMER2_COMPB_vect);
-#endif
-ISR(TIMER2_OVF_vect);
-#endif
-
-ISR(TIMER1_COMPA_vect);
-ISR(TIMER1_COMPB_vect);
-ISR(TIMER1_COMPC_vect);
-ISR(TIMER1_OVF_vect);
-ISR(TIMER1_CAPT_vect);
-
-#if (NUM_16BIT_TIMERS > 1)
-ISR(TIMER3_COMPA_vect);
-ISR(TIMER3_COMPB_vect);
-ISR(TIMER3_COMPC_vect);
-ISR(TIMER3_OVF_vect);
-ISR(TIMER3_CAPT_vect);
-#endif
-
-#if (NUM_16BIT_TIMERS > 2)
-ISR(TIMER4_COMPA_vect);
-ISR(TIMER4_COMPB_vect);
-ISR(TIMER4_COMPC_vect);
-ISR(TIMER4_OVF_vect);
-ISR(TIMER4_CAPT_vect);
-
-ISR(TIMER5_COMPA_vect);
-ISR(TIMER5_COMPB_vect);
-ISR(TIMER5_COMPC_vect);
-ISR(TIMER5_OVF_vect);
-ISR(TIMER5_CAPT_vect);
-#endif
+// Timer interrupt handlers.
+//
+// Each timer vector is a bare jump to its handler.  The core defines
+// the handlers weakly, calling the function given to attachInterrupt().
+// A library that owns a vector defines the handler itself:
+//
+//   TIMER_ISR(TIMER1_COMPA_vect)
+//   {
+//     ...
+//   }
+//
+// which replaces the core's at link time, so its code runs straight
+// from the vector, with one register save, instead of being called
+// through the function pointer.  Functions attached to that interrupt
+// are then only called if the handler calls dispatch().
+#define TIMER_HANDLER(vector) _TIMER_HANDLER(vector)
+#define _TIMER_HANDLER(vector) vector ## _handler
+
+#define TIMER_ISR(vector) ISR(TIMER_HANDLER(vector))
 
 class HardwareTimer
 {
-#if defined (TIMER0_COMP_vect)
-// only a single COMP vector
-  friend void TIMER0_COMP_vect();
-#else
-  friend void TIMER0_COMPA_vect();
-  friend void TIMER0_COMPB_vect();
-#endif
-  friend void TIMER0_OVF_vect();
-
-  #if (NUM_8BIT_TIMERS == 2)
-#if defined (TIMER2_COMP_vect)
-// only a single COMP vector
-  friend void TIMER2_COMP_vect();
-#else
-  friend void TIMER2_COMPA_vect();
-  friend void TIMER2_COMPB_vect();
-#endif
-  friend void TIMER2_OVF_vect();
-  #endif
-
-  friend void TIMER1_COMPA_vect();
-  friend void TIMER1_COMPB_vect();
-  friend void TIMER1_COMPC_vect();
-  friend void TIMER1_OVF_vect();
-  friend void TIMER1_CAPT_vect();
-
-  #if (NUM_16BIT_TIMERS > 1)
-  friend void TIMER3_COMPA_vect();
-  friend void TIMER3_COMPB_vect();
-  friend void TIMER3_COMPC_vect();
-  friend void TIMER3_OVF_vect();
-  friend void TIMER3_CAPT_vect();
-  #endif
-
-  #if (NUM_16BIT_TIMERS > 2)
-  friend void TIMER4_COMPA_vect();
-  friend void TIMER4_COMPB_vect();
-  friend void TIMER4_COMPC_vect();
-  friend void TIMER4_OVF_vect();
-  friend void TIMER4_CAPT_vect();
-
-  friend void TIMER5_COMPA_vect();
-  friend void TIMER5_COMPB_vect();
-  friend void TIMER5_COMPC_vect();
-  friend void TIMER5_OVF_vect();
-  friend void TIMER5_CAPT_vect();
-  #endif
-
   private:
     uint8_t _timerNumber;
     uint8_t _channelCount;
@@ -197,6 +122,34 @@ class HardwareTimer
     void setOCR(uint8_t channel, uint16_t value);
     void setCounter(uint16_t value);
     uint16_t getCounter(void);
+
+    // Calls the function attached to the interrupt, if any.
+    inline void dispatch(uint8_t interrupt)
+    {
+      void (*function)(void) = NULL;
+
+      switch (interrupt)
+      {
+        case INTERRUPT_OVERFLOW:
+          function = overflowFunction;
+          break;
+        case INTERRUPT_COMPARE_MATCH_A:
+          function = compareMatchAFunction;
+          break;
+        case INTERRUPT_COMPARE_MATCH_B:
+          function = compareMatchBFunction;
+          break;
+        case INTERRUPT_COMPARE_MATCH_C:
+          function = compareMatchCFunction;
+          break;
+        case INTERRUPT_CAPTURE_EVENT:
+          function = captureEventFunction;
+          break;
+      }
+
+      if (function != NULL)
+        function();
+    }
 };
 
 extern HardwareTimer Timer0;
@@ -3,6 +3,7 @@
 || @author         Brett Hagman <bhagman@wiring.org.co>
 || @url            http://wiring.org.co/
 || @contribution   Hernando Barragan <b@wiring.org.co>
+|| @contribution   Camilo Reyes <creyes@wiring.org.co>
 ||
 || @description
 || | Hardware interrupt control methods for
@@ -195,71 +196,89 @@ void attachInterruptTwi(void (*userFunc)(void) ) {
 
 ISR(INT0_vect)
 {
+  PROFILE_ENTER();
   if (intFunc[0])
     intFunc[0]();
+  PROFILE_EXIT(PROFILE_INT0);
 }
 
 #if NUM_EXTERNAL_INTERRUPTS > 1
 ISR(INT1_vect)
 {
+  PROFILE_ENTER();
   if (intFunc[1])
     intFunc[1]();
+  PROFILE_EXIT(PROFILE_INT1);
 }
 #endif
 
 #if NUM_EXTERNAL_INTERRUPTS > 2
 ISR(INT2_vect)
 {
+  PROFILE_ENTER();
   if (intFunc[2])
     intFunc[2]();
+  PROFILE_EXIT(PROFILE_INT2);
 }
 #endif
 
 #if NUM_EXTERNAL_INTERRUPTS > 3
 ISR(INT3_vect)
 {
+  PROFILE_ENTER();
   if (intFunc[3])
     intFunc[3]();
+  PROFILE_EXIT(PROFILE_INT3);
 }
 #endif
 
 #if NUM_EXTERNAL_INTERRUPTS > 4
 ISR(INT4_vect)
 {
+  PROFILE_ENTER();
   if (intFunc[4])
     intFunc[4]();
+  PROFILE_EXIT(PROFILE_INT4);
 }
 #endif
 
 #if NUM_EXTERNAL_INTERRUPTS > 5
 ISR(INT5_vect)
 {
+  PROFILE_ENTER();
   if (intFunc[5])
     intFunc[5]();
+  PROFILE_EXIT(PROFILE_INT5);
 }
 #endif
 
 #if NUM_EXTERNAL_INTERRUPTS > 6
 ISR(INT6_vect)
 {
+  PROFILE_ENTER();
   if (intFunc[6])
     intFunc[6]();
+  PROFILE_EXIT(PROFILE_INT6);
 }
 #endif
 
 #if NUM_EXTERNAL_INTERRUPTS > 7
 ISR(INT7_vect)
 {
+  PROFILE_ENTER();
   if (intFunc[7])
     intFunc[7]();
+  PROFILE_EXIT(PROFILE_INT7);
 }
 #endif
 
 #if defined(SPI_STC_vect)
 ISR(SPI_STC_vect)
 {
+  PROFILE_ENTER();
   if (spiIntFunc)
     spiIntFunc();
+  PROFILE_EXIT(PROFILE_SPI);
 }
 #endif
 
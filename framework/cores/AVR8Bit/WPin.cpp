@@ -0,0 +1,142 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Pin objects for
+|| | Atmel AVR 8 bit microcontroller series core.
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#include <Wiring.h>
+
+#define NO_SHIFT 0xff
+
+
+PinGroup::PinGroup(const uint8_t *pins, uint8_t count)
+{
+  uint8_t i;
+  uint8_t p;
+
+  if (count > 8)
+    count = 8;
+
+  this->count = count;
+  ports = 0;
+
+  for (i = 0; i < count; i++)
+  {
+    uint8_t pinport = digitalPinToPort(pins[i]);
+
+    for (p = 0; p < ports && port[p] != pinport; p++)
+      ;
+    if (p == ports)
+    {
+      port[ports] = pinport;
+      portMask[ports] = 0;
+      ports++;
+    }
+
+    pinPort[i] = p;
+    pinMask[i] = digitalPinToBitMask(pins[i]);
+    portMask[p] |= pinMask[i];
+  }
+
+  // The usual parallel bus: one port, pins in ascending bit order
+  shift = NO_SHIFT;
+  if (ports == 1)
+  {
+    shift = digitalPinToBit(pins[0]);
+    for (i = 1; i < count; i++)
+      if (pinMask[i] != (pinMask[0] << i))
+        shift = NO_SHIFT;
+  }
+}
+
+
+// Work out the bits to write to each port for a value.
+void PinGroup::spread(uint8_t value, uint8_t *bits)
+{
+  uint8_t i;
+
+  if (shift != NO_SHIFT)
+  {
+    bits[0] = value << shift;
+    return;
+  }
+
+  for (i = 0; i < ports; i++)
+    bits[i] = 0;
+
+  for (i = 0; i < count; i++, value >>= 1)
+    if (value & 1)
+      bits[pinPort[i]] |= pinMask[i];
+}
+
+
+void PinGroup::mode(uint8_t MODE)
+{
+  uint8_t i;
+
+  for (i = 0; i < ports; i++)
+    _portModeMasked(port[i], MODE, portMask[i]);
+}
+
+
+void PinGroup::write(uint8_t value)
+{
+  uint8_t bits[8];
+  uint8_t i;
+
+  spread(value, bits);
+
+  for (i = 0; i < ports; i++)
+    _portWriteMasked(port[i], bits[i], portMask[i]);
+}
+
+
+// Toggle the pins whose bits are set in value.
+void PinGroup::toggle(uint8_t value)
+{
+  uint8_t bits[8];
+  uint8_t i;
+
+  spread(value, bits);
+
+  for (i = 0; i < ports; i++)
+    if (bits[i])
+      _portToggle(port[i], bits[i] & portMask[i]);
+}
+
+
+uint8_t PinGroup::read(void)
+{
+  uint8_t inputs[8];
+  uint8_t value = 0;
+  uint8_t i;
+
+  // sample every port first, as close together as possible
+  for (i = 0; i < ports; i++)
+  {
+    volatile uint8_t *inputregister = portInputRegister(port[i]);
+    inputs[i] = (inputregister != NOT_A_REG) ? *inputregister : 0;
+  }
+
+  if (shift != NO_SHIFT)
+    return (inputs[0] & portMask[0]) >> shift;
+
+  for (i = count; i > 0; i--)
+  {
+    value <<= 1;
+    if (inputs[pinPort[i - 1]] & pinMask[i - 1])
+      value |= 1;
+  }
+
+  return value;
+}
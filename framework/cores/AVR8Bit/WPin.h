@@ -0,0 +1,210 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Pin objects for
+|| | Atmel AVR 8 bit microcontroller series core.
+|| |
+|| | Pin<N> is a pin known at compile time: the board pin mapping is
+|| | resolved by the compiler, and each call is a single sbi/cbi/sbis
+|| | instruction on pins in the lower 32 I/O registers.  The others
+|| | (PORTF/PORTG on the ATmega128) are written with interrupts disabled.
+|| |
+|| |   Pin<WLED> led;
+|| |   led.mode(OUTPUT);
+|| |   led.high();
+|| |
+|| | DigitalPin is the fallback for pins only known at run time: the pin
+|| | mapping is looked up once, when the pin is attached, instead of on
+|| | every digitalWrite()/digitalRead().
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#ifndef WPIN_H
+#define WPIN_H
+
+#include <inttypes.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "WConstants.h"
+#include "BoardDefs.h"
+#include "WDigital.h"
+
+// Stands in for the registers of a pin that does not exist (WDigital.c)
+extern "C" volatile uint8_t _noPortRegisters[3];
+
+template<uint8_t PIN>
+class Pin
+{
+  private:
+    typedef char pinCheck[(PIN < TOTAL_PINS) ? 1 : -1];
+
+  public:
+    static inline void mode(uint8_t) __attribute__((always_inline));
+    static inline void high(void) __attribute__((always_inline));
+    static inline void low(void) __attribute__((always_inline));
+    static inline void write(uint8_t) __attribute__((always_inline));
+    static inline uint8_t read(void) __attribute__((always_inline));
+    static inline uint8_t number(void) { return PIN; }
+};
+
+template<uint8_t PIN>
+inline void Pin<PIN>::mode(uint8_t MODE)
+{
+  if (MODE == INPUT)
+    _regClear(portModeRegister(digitalPinToPort(PIN)), digitalPinToBitMask(PIN));
+  else
+    _regSet(portModeRegister(digitalPinToPort(PIN)), digitalPinToBitMask(PIN));
+}
+
+template<uint8_t PIN>
+inline void Pin<PIN>::high(void)
+{
+  _regSet(digitalPinToPortReg(PIN), digitalPinToBitMask(PIN));
+}
+
+template<uint8_t PIN>
+inline void Pin<PIN>::low(void)
+{
+  _regClear(digitalPinToPortReg(PIN), digitalPinToBitMask(PIN));
+}
+
+template<uint8_t PIN>
+inline void Pin<PIN>::write(uint8_t VALUE)
+{
+  if (VALUE == LOW)
+    low();
+  else
+    high();
+}
+
+template<uint8_t PIN>
+inline uint8_t Pin<PIN>::read(void)
+{
+  return (*(portInputRegister(digitalPinToPort(PIN))) & digitalPinToBitMask(PIN)) ? HIGH : LOW;
+}
+
+
+// The three registers of the pin are looked up, not worked out from
+// PORTx: they are not always laid out PINx, DDRx, PORTx (PORTF on the
+// ATmega64/128 is not).  Writes are read-modify-write of a register an
+// interrupt handler may also change, so they are done with interrupts
+// disabled, like _pinWrite() does.
+class DigitalPin
+{
+  public:
+    DigitalPin() : port(_noPortRegisters + 2), ddr(_noPortRegisters + 1),
+                   in(_noPortRegisters), mask(0) {}
+    DigitalPin(uint8_t pin) { attach(pin); }
+
+    void attach(uint8_t pin)
+    {
+      uint8_t pinport = digitalPinToPort(pin);
+      volatile uint8_t *portregister = portOutputRegister(pinport);
+
+      if (portregister == NOT_A_REG)
+      {
+        port = _noPortRegisters + 2;
+        ddr = _noPortRegisters + 1;
+        in = _noPortRegisters;
+        mask = 0;
+        return;
+      }
+
+      port = portregister;
+      ddr = portModeRegister(pinport);
+      in = portInputRegister(pinport);
+      mask = digitalPinToBitMask(pin);
+    }
+
+    void mode(uint8_t MODE)
+    {
+      uint8_t oldSREG = SREG;
+      cli();
+
+      if (MODE == INPUT)
+        *ddr &= ~mask;
+      else
+        *ddr |= mask;
+
+      SREG = oldSREG;
+    }
+
+    inline void high(void)
+    {
+      uint8_t oldSREG = SREG;
+      cli();
+      *port |= mask;
+      SREG = oldSREG;
+    }
+
+    inline void low(void)
+    {
+      uint8_t oldSREG = SREG;
+      cli();
+      *port &= ~mask;
+      SREG = oldSREG;
+    }
+
+    inline void write(uint8_t VALUE)
+    {
+      if (VALUE == LOW)
+        low();
+      else
+        high();
+    }
+
+    inline uint8_t read(void)
+    {
+      return (*in & mask) ? HIGH : LOW;
+    }
+
+  private:
+    volatile uint8_t *port;
+    volatile uint8_t *ddr;
+    volatile uint8_t *in;
+    uint8_t mask;
+};
+
+
+// A group of up to 8 pins, on any ports, written and read together as
+// one value (bit 0 is the first pin).  The per-port masks are worked out
+// once, so write() is at most one write per port involved: a parallel
+// bus on a single port is a single glitch free port update.
+//
+//   const uint8_t bus[] = { 16, 17, 18, 19, 20, 21, 22, 23 };
+//   PinGroup data(bus, 8);
+//   data.mode(OUTPUT);
+//   data.write(0xA5);
+class PinGroup
+{
+  public:
+    PinGroup(const uint8_t *pins, uint8_t count);
+
+    void mode(uint8_t MODE);
+    void write(uint8_t value);
+    void toggle(uint8_t value);
+    uint8_t read(void);
+    uint8_t size(void) { return count; }
+
+  private:
+    uint8_t count;
+    uint8_t ports;              // number of different ports
+    uint8_t shift;              // one port with consecutive pins: value << shift
+    uint8_t port[8];            // Wiring port number, per port
+    uint8_t portMask[8];        // pins of the group, per port
+    uint8_t pinPort[8];         // index into port[], per pin
+    uint8_t pinMask[8];         // bit within that port, per pin
+
+    void spread(uint8_t value, uint8_t *bits);
+};
+
+#endif
+// WPIN_H
@@ -0,0 +1,126 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Interrupt and code profiling.
+|| | Atmel AVR 8 bit microcontroller series core.
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#include <Wiring.h>
+
+#if defined(WIRING_PROFILE)
+
+#if PROFILE_TIMER == 5
+#define PROFILE_TCCRA TCCR5A
+#define PROFILE_TCCRB TCCR5B
+#elif PROFILE_TIMER == 4
+#define PROFILE_TCCRA TCCR4A
+#define PROFILE_TCCRB TCCR4B
+#elif PROFILE_TIMER == 3
+#define PROFILE_TCCRA TCCR3A
+#define PROFILE_TCCRB TCCR3B
+#else
+#define PROFILE_TCCRA TCCR1A
+#define PROFILE_TCCRB TCCR1B
+#endif
+
+profile_entry profileTable[PROFILE_ENTRIES];
+
+static uint32_t profileStart;
+
+
+// Run the profiling timer free, at the CPU clock (normal mode, no
+// prescaler).  Its PWM outputs and interrupts are not usable meanwhile.
+void profileBegin(void)
+{
+  PROFILE_TCCRB = 0;
+  PROFILE_TCCRA = 0;
+  PROFILE_TCCRB = _BV(CS10);
+  profileReset();
+}
+
+
+void profileReset(void)
+{
+  uint8_t oldSREG = SREG;
+  uint8_t i;
+
+  cli();
+  for (i = 0; i < PROFILE_ENTRIES; i++)
+  {
+    profileTable[i].calls = 0;
+    profileTable[i].total = 0;
+    profileTable[i].max = 0;
+  }
+  profileStart = millis();
+  SREG = oldSREG;
+}
+
+
+// A consistent copy of an entry, which interrupt handlers may be updating.
+void profileRead(uint8_t id, profile_entry *entry)
+{
+  uint8_t oldSREG = SREG;
+
+  cli();
+  *entry = profileTable[id];
+  SREG = oldSREG;
+}
+
+
+static uint8_t dumpValue(Print &out, uint32_t value, uint8_t size)
+{
+  uint8_t sum = 0;
+  uint8_t b;
+
+  while (size--)
+  {
+    b = value & 0xFF;
+    out.write(b);
+    sum += b;
+    value >>= 8;
+  }
+
+  return sum;
+}
+
+
+// Write the table in the dump format (see WProfile.h), skipping the
+// entries that were never called.
+void profileDump(Print &out)
+{
+  profile_entry entry;
+  uint8_t sum = 0;
+  uint8_t i;
+
+  sum += dumpValue(out, 'W', 1);
+  sum += dumpValue(out, 'P', 1);
+  sum += dumpValue(out, PROFILE_VERSION, 1);
+  sum += dumpValue(out, PROFILE_ENTRIES, 1);
+  sum += dumpValue(out, F_CPU, 4);
+  sum += dumpValue(out, millis() - profileStart, 4);
+
+  for (i = 0; i < PROFILE_ENTRIES; i++)
+  {
+    profileRead(i, &entry);
+    if (entry.calls == 0)
+      continue;
+    sum += dumpValue(out, i, 1);
+    sum += dumpValue(out, entry.calls, 4);
+    sum += dumpValue(out, entry.total, 4);
+    sum += dumpValue(out, entry.max, 2);
+  }
+
+  sum += dumpValue(out, PROFILE_END, 1);
+  dumpValue(out, (uint8_t)-sum, 1);
+}
+
+#endif
@@ -0,0 +1,175 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Interrupt and code profiling.
+|| | Atmel AVR 8 bit microcontroller series core.
+|| |
+|| | Built in only when WIRING_PROFILE is defined (e.g. -DWIRING_PROFILE
+|| | for the core and the sketch); otherwise the markers are empty and
+|| | nothing is linked in.
+|| |
+|| | Every interrupt handler of the core (serial, timers, external
+|| | interrupts, SPI, ADC, TWI) is timed, and sketches can time their own
+|| | code with PROFILE_SCOPE(PROFILE_USER(n)) (C++) or
+|| | PROFILE_ENTER()/PROFILE_EXIT(PROFILE_USER(n)).  For each entry the
+|| | number of calls, and the total and longest time in CPU cycles are
+|| | kept.  Times come from a 16 bit timer running at the CPU clock
+|| | (PROFILE_TIMER, Timer 5 or Timer 1, set up by profileBegin()), so a
+|| | section must be shorter than 65536 cycles, and the time of
+|| | interrupts that ran in between is counted in.  The interrupt entry
+|| | and exit code (register saving) is not.
+|| |
+|| | profileDump() writes the table in binary, for the ProfileReport tool
+|| | of the Host core (cores/Host/tools), which prints it sorted.
+|| |
+|| | Dump format (multi byte values little endian):
+|| |   'W' 'P' version(1) entries(1) F_CPU(4) elapsed ms(4)
+|| |   { id(1) calls(4) total cycles(4) max cycles(2) } for each entry
+|| |     that was called
+|| |   PROFILE_END(1) checksum(1)
+|| | The checksum makes the sum of all the bytes of the dump 0 (mod 256).
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#ifndef WPROFILE_H
+#define WPROFILE_H
+
+#include <stdint.h>
+
+#define PROFILE_VERSION 1
+#define PROFILE_END 0xFF
+
+// Sketch entries
+#ifndef PROFILE_USER_ENTRIES
+#define PROFILE_USER_ENTRIES 8
+#endif
+
+// Entries of the core, in id order
+#define PROFILE_CORE_ENTRIES(P) \
+  P(SERIAL_RX) P(SERIAL_TX) P(SERIAL1_RX) P(SERIAL1_TX) \
+  P(SERIAL2_RX) P(SERIAL2_TX) P(SERIAL3_RX) P(SERIAL3_TX) \
+  P(TIMER0_COMPA) P(TIMER0_COMPB) P(TIMER0_OVF) \
+  P(TIMER1_COMPA) P(TIMER1_COMPB) P(TIMER1_COMPC) P(TIMER1_OVF) P(TIMER1_CAPT) \
+  P(TIMER2_COMPA) P(TIMER2_COMPB) P(TIMER2_OVF) \
+  P(TIMER3_COMPA) P(TIMER3_COMPB) P(TIMER3_COMPC) P(TIMER3_OVF) P(TIMER3_CAPT) \
+  P(TIMER4_COMPA) P(TIMER4_COMPB) P(TIMER4_COMPC) P(TIMER4_OVF) P(TIMER4_CAPT) \
+  P(TIMER5_COMPA) P(TIMER5_COMPB) P(TIMER5_COMPC) P(TIMER5_OVF) P(TIMER5_CAPT) \
+  P(INT0) P(INT1) P(INT2) P(INT3) P(INT4) P(INT5) P(INT6) P(INT7) \
+  P(SPI) P(ADC) P(TWI)
+
+#define PROFILE_ID(name) PROFILE_ ## name,
+enum
+{
+  PROFILE_CORE_ENTRIES(PROFILE_ID)
+  PROFILE_USER_FIRST
+};
+#undef PROFILE_ID
+
+#define PROFILE_USER(n) (PROFILE_USER_FIRST + (n))
+#define PROFILE_ENTRIES (PROFILE_USER_FIRST + PROFILE_USER_ENTRIES)
+
+
+#if defined(WIRING_PROFILE) && defined(WIRING_CORE_ATMEL_AVR_8_BIT)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if !defined(PROFILE_TIMER)
+#if defined(TCNT5)
+#define PROFILE_TIMER 5
+#else
+#define PROFILE_TIMER 1
+#endif
+#endif
+
+#if PROFILE_TIMER == 5
+#define PROFILE_TCNT TCNT5
+#elif PROFILE_TIMER == 4
+#define PROFILE_TCNT TCNT4
+#elif PROFILE_TIMER == 3
+#define PROFILE_TCNT TCNT3
+#else
+#define PROFILE_TCNT TCNT1
+#endif
+
+typedef struct
+{
+  uint32_t calls;
+  uint32_t total;  // cycles
+  uint16_t max;    // cycles
+} profile_entry;
+
+extern profile_entry profileTable[PROFILE_ENTRIES];
+
+void profileBegin(void);
+void profileReset(void);
+void profileRead(uint8_t id, profile_entry *entry);
+
+// Reading a 16 bit timer is not atomic: an interrupt handler reading
+// one in between would change the high byte.
+static inline uint16_t profileTime(void)
+{
+  uint8_t oldSREG = SREG;
+  uint16_t t;
+
+  cli();
+  t = PROFILE_TCNT;
+  SREG = oldSREG;
+
+  return t;
+}
+
+static inline void profileRecord(uint8_t id, uint16_t cycles)
+{
+  profile_entry *e = &profileTable[id];
+
+  e->calls++;
+  e->total += cycles;
+  if (cycles > e->max)
+    e->max = cycles;
+}
+
+#define PROFILE_ENTER() uint16_t _profileStart = profileTime()
+#define PROFILE_EXIT(id) profileRecord((id), profileTime() - _profileStart)
+
+#ifdef __cplusplus
+} // extern "C"
+
+class Print;
+
+void profileDump(Print &out);
+
+// Times the rest of the enclosing block.
+class ProfileScope
+{
+  public:
+    ProfileScope(uint8_t id) : id(id), start(profileTime()) { }
+    ~ProfileScope() { profileRecord(id, profileTime() - start); }
+
+  private:
+    uint8_t id;
+    uint16_t start;
+};
+
+#define PROFILE_SCOPE(id) ProfileScope _profileScope(id)
+#endif
+
+#else
+
+#define PROFILE_ENTER()
+#define PROFILE_EXIT(id)
+#define PROFILE_SCOPE(id)
+
+#endif
+
+#endif
+// WPROFILE_H
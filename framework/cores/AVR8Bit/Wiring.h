@@ -4,6 +4,7 @@
 || @url            http://wiring.org.co/
 || @contribution   Brett Hagman <bhagman@wiring.org.co>
 || @contribution   Alexander Brevig <abrevig@wiring.org.co>
+|| @contribution   Camilo Reyes <creyes@wiring.org.co>
 ||
 || @description
 || | Wiring core prototype definitions.
@@ -157,6 +158,12 @@ static inline void noPullup(uint8_t PIN) { pinWrite(PIN, LOW); }
 }
 #endif
 
+/*************************************************************
+ * Profiling
+ *************************************************************/
+
+#include "WProfile.h"
+
 
 
 /*************************************************************
@@ -171,7 +178,10 @@ static inline void noPullup(uint8_t PIN) { pinWrite(PIN, LOW); }
 #include "WShift.h"
 #include "WMath.h"
 #include "WHardwareSerial.h"
+#include "StringBuilder.h"
+#include "StreamParser.h"
 #include "WConstantTypes.h"
+#include "WPin.h"
 
 /*************************************************************
  * Timers
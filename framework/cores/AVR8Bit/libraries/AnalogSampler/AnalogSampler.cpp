@@ -0,0 +1,185 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Interrupt driven ADC sampling.
+|| |
+|| | Wiring Core Library
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#include "AnalogSampler.h"
+
+extern uint8_t analog_reference;
+
+
+// In free running mode the next conversion starts (and latches ADMUX) as
+// soon as one completes, so when this runs the conversion after the one
+// that just finished is already under way: ADMUX is set up for the one
+// after that.
+void WAnalogSampler::interrupt(void)
+{
+  uint8_t low = ADCL;
+  uint16_t value = (ADCH << 8) | low;
+  uint8_t i = AnalogSampler.converting;
+
+  // The first interrupt may be a flag left over from analogRead().  The
+  // first two conversions are both of the first channel, so skipping it
+  // loses nothing.
+  if (!AnalogSampler.started)
+  {
+    AnalogSampler.started = true;
+    return;
+  }
+
+  AnalogSampler.last[i] = value;
+  AnalogSampler.samples[i].enqueue(value);
+
+  AnalogSampler.converting = AnalogSampler.queued;
+  if (++AnalogSampler.queued >= AnalogSampler.count)
+    AnalogSampler.queued = 0;
+  AnalogSampler.select(AnalogSampler.queued);
+}
+
+
+void WAnalogSampler::select(uint8_t index)
+{
+  uint8_t pin = channel[index];
+
+#if defined(MUX5)
+  ADCSRB = (ADCSRB & ~(1 << MUX5)) | (((pin >> 3) & 0x01) << MUX5);
+#endif
+  ADMUX = (analog_reference << 6) | (pin & 0x07);
+}
+
+
+void WAnalogSampler::begin(const uint8_t *channels, uint8_t count, uint8_t prescaler)
+{
+  uint8_t adps = 1;
+  uint8_t i;
+
+  end();
+
+  if (count > ANALOGSAMPLER_CHANNELS)
+    count = ANALOGSAMPLER_CHANNELS;
+  if (count == 0)
+    return;
+
+  this->count = count;
+  for (i = 0; i < count; i++)
+  {
+    channel[i] = channels[i];
+    last[i] = 0;
+    samples[i].flush();
+    samples[i].clearOverflows();
+  }
+
+  // ADPS: division factor 2^adps, 2 to 128
+  while (adps < 7 && (2 << adps) <= prescaler)
+    adps++;
+
+  // The channel may only be changed once the first conversion is under
+  // way, so the first two conversions are both of the first channel.
+  converting = 0;
+  queued = 0;
+  started = false;
+  select(0);
+
+#if defined(ADCSRB)
+  ADCSRB &= ~((1 << ADTS2) | (1 << ADTS1) | (1 << ADTS0));  // free running
+#endif
+  attachInterruptADC(interrupt);
+  ADCSRA = (1 << ADEN) | (1 << ADSC) | (1 << ADATE) | (1 << ADIF) | (1 << ADIE) | adps;
+
+  active = true;
+}
+
+
+void WAnalogSampler::end(void)
+{
+  if (!active)
+    return;
+
+  // back to single conversions for analogRead(), ck/128, once the
+  // conversion in progress is over
+  ADCSRA = (1 << ADEN) | (1 << ADIF) | (1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0);
+  while (ADCSRA & (1 << ADSC));
+  detachInterruptADC();
+
+  active = false;
+}
+
+
+// Most recent sample of a channel (0 before the first one).
+int WAnalogSampler::latest(uint8_t index)
+{
+  uint16_t value;
+
+  if (index >= count)
+    return -1;
+
+  uint8_t oldSREG = SREG;
+  cli();
+  value = last[index];
+  SREG = oldSREG;
+
+  return value;
+}
+
+
+uint8_t WAnalogSampler::available(uint8_t index)
+{
+  if (index >= count)
+    return 0;
+
+  return samples[index].count();
+}
+
+
+// Oldest buffered sample of a channel, -1 if there is none.
+int WAnalogSampler::read(uint8_t index)
+{
+  uint16_t value;
+
+  if (index >= count || !samples[index].dequeue(value))
+    return -1;
+
+  return value;
+}
+
+
+// Up to length of the oldest buffered samples, returns how many.
+uint8_t WAnalogSampler::read(uint8_t index, uint16_t *buffer, uint8_t length)
+{
+  if (index >= count)
+    return 0;
+
+  return samples[index].dequeue(buffer, length);
+}
+
+
+// Samples dropped because the main program did not read them in time.
+uint16_t WAnalogSampler::overflows(uint8_t index)
+{
+  uint16_t n;
+
+  if (index >= count)
+    return 0;
+
+  uint8_t oldSREG = SREG;
+  cli();
+  n = samples[index].overflows();
+  SREG = oldSREG;
+
+  return n;
+}
+
+
+// Preinstantiate Objects
+
+WAnalogSampler AnalogSampler;
@@ -0,0 +1,81 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Interrupt driven ADC sampling.
+|| |
+|| | The ADC runs free running, and the ADC interrupt scans a list of
+|| | channels, writing each result into the ring buffer of its channel.
+|| | The main program reads the latest value of a channel, or blocks of
+|| | samples, without ever waiting on a conversion.
+|| |
+|| | A conversion takes 13 ADC clocks, so the total rate is
+|| | F_CPU / prescaler / 13, shared between the channels: 19.2 kHz at
+|| | 16 MHz with a prescaler of 64 (2.4 kHz each on 8 channels).
+|| | Prescalers under 64 (ADC clock over 200 kHz) trade resolution for
+|| | speed.
+|| |
+|| | The sampler runs from the core's ADC interrupt handler
+|| | (attachInterruptADC()), so it cannot be used with an ADC_ISR() of
+|| | the sketch.
+|| | analogRead() must not be used while it is running.
+|| |
+|| | Wiring Core Library
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#ifndef ANALOGSAMPLER_H
+#define ANALOGSAMPLER_H
+
+#include <Wiring.h>
+#include <RingBuffer.h>
+
+// Most channels in a scan
+#ifndef ANALOGSAMPLER_CHANNELS
+#define ANALOGSAMPLER_CHANNELS 8
+#endif
+
+// Samples buffered per channel (a power of two)
+#ifndef ANALOGSAMPLER_BUFFER_SIZE
+#define ANALOGSAMPLER_BUFFER_SIZE 8
+#endif
+
+class WAnalogSampler
+{
+  public:
+    void begin(const uint8_t *channels, uint8_t count, uint8_t prescaler = 64);
+    void end(void);
+    bool running(void) { return active; }
+
+    // Channels are given by their position in the scan list.
+    int latest(uint8_t index);
+    uint8_t available(uint8_t index);
+    int read(uint8_t index);
+    uint8_t read(uint8_t index, uint16_t *buffer, uint8_t length);
+    uint16_t overflows(uint8_t index);
+
+  private:
+    volatile bool active;
+    uint8_t count;
+    uint8_t channel[ANALOGSAMPLER_CHANNELS];
+    volatile uint16_t last[ANALOGSAMPLER_CHANNELS];
+    RingBuffer<uint16_t, ANALOGSAMPLER_BUFFER_SIZE> samples[ANALOGSAMPLER_CHANNELS];
+
+    // Scan position: the conversion in progress and the one queued in ADMUX
+    uint8_t converting;
+    uint8_t queued;
+    bool started;
+
+    void select(uint8_t index);
+    static void interrupt(void);
+};
+
+extern WAnalogSampler AnalogSampler;
+
+#endif
+// ANALOGSAMPLER_H
@@ -0,0 +1,36 @@
+/**
+ * Scan Channels
+ * by Camilo Reyes <creyes@wiring.org.co>
+ *
+ * Samples analog inputs 0 to 7 in the background, about 2.4 kHz each,
+ * and prints the average of the latest block of each, while the main
+ * loop stays free.
+ */
+
+#include <AnalogSampler.h>
+
+const uint8_t channels[] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+uint16_t block[8];
+
+void setup()
+{
+  Serial.begin(115200);
+  AnalogSampler.begin(channels, 8, 64);
+}
+
+void loop()
+{
+  for (uint8_t i = 0; i < 8; i++)
+  {
+    uint8_t n = AnalogSampler.read(i, block, 8);
+    uint32_t sum = 0;
+
+    for (uint8_t j = 0; j < n; j++)
+      sum += block[j];
+
+    if (n)
+      Serial.print(sum / n);
+    Serial.print(i < 7 ? "\t" : "\r\n");
+  }
+  delay(100);
+}
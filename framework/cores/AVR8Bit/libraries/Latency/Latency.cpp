@@ -0,0 +1,307 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Interrupt latency and jitter benchmarks.
+|| |
+|| | Wiring Core Library
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#include "Latency.h"
+
+// How long to wait for an event before giving up
+#define TIMEOUT_MS 1000
+
+// Cycles from setting a compare match up to the match
+#define TIMER_LEAD 100
+
+WLatency Latency;
+
+static volatile uint16_t eventTime;
+static volatile bool eventSeen;
+static volatile uint16_t loadCycles;
+
+
+// The handler under test.  The time base is read first thing, and the
+// handlers only run with interrupts off, so the 16 bit read needs no
+// protection here.
+static void stamp(void)
+{
+  eventTime = TCNT1;
+  eventSeen = true;
+}
+
+
+// The background load: busy for loadCycles.
+static void load(void)
+{
+  uint16_t start = TCNT1;
+
+  while ((uint16_t)(TCNT1 - start) < loadCycles);
+}
+
+
+// The main program reads the time base with interrupts off, since the
+// handlers read it too (through the shared TEMP register).
+static uint16_t now(void)
+{
+  uint8_t oldSREG = SREG;
+  uint16_t t;
+
+  cli();
+  t = TCNT1;
+  SREG = oldSREG;
+
+  return t;
+}
+
+
+// Waits for the handler to run at or after the given time.  A run
+// before it was set off by an event left pending from before (a stale
+// interrupt flag), and is ignored.
+static bool waitForEvent(uint16_t after)
+{
+  unsigned long start = millis();
+  uint8_t oldSREG = SREG;
+
+  while (true)
+  {
+    if (eventSeen)
+    {
+      cli();
+      if ((int16_t)(eventTime - after) >= 0)
+      {
+        SREG = oldSREG;
+        return true;
+      }
+      eventSeen = false;
+      SREG = oldSREG;
+    }
+
+    if (millis() - start > TIMEOUT_MS)
+      return false;
+  }
+}
+
+
+// CPU cycles per bit at the rate HardwareSerial::begin() sets for baud
+// (the nearest UBRR, with or without U2X).
+static uint32_t bitCycles(uint32_t baud)
+{
+  uint16_t ubrr = (F_CPU / 2 / baud + 4) / 8;
+  uint16_t ubrrU2X = (F_CPU / baud + 4) / 8;
+  uint32_t actual = F_CPU / 16 / ubrr;
+  uint32_t actualU2X = F_CPU / 8 / ubrrU2X;
+
+  if (abs((int32_t)(actualU2X - baud)) < abs((int32_t)(actual - baud)))
+    return 8UL * ubrrU2X;
+  else
+    return 16UL * ubrr;
+}
+
+
+WLatency::WLatency()
+{
+  overhead = 0;
+}
+
+
+void WLatency::begin(void)
+{
+  uint8_t oldSREG = SREG;
+  uint16_t a, b;
+  uint8_t i;
+
+  Timer1.setClockSource(CLOCK_STOP);
+  Timer1.setMode(0);                      // normal, counting up to 0xFFFF
+  Timer1.attachInterrupt(INTERRUPT_COMPARE_MATCH_A, stamp, 0);
+  Timer1.setClockSource(CLOCK_NO_PRESCALE);
+
+  overhead = 0xFFFF;
+  for (i = 0; i < 8; i++)
+  {
+    cli();
+    a = TCNT1;
+    b = TCNT1;
+    SREG = oldSREG;
+    if ((uint16_t)(b - a) < overhead)
+      overhead = b - a;
+  }
+}
+
+
+void WLatency::end(void)
+{
+  setLoad(0, 0);
+  Timer1.detachInterrupt(INTERRUPT_COMPARE_MATCH_A);
+  Timer1.stop();
+}
+
+
+void WLatency::setLoad(uint16_t perSecond, uint16_t cycles)
+{
+  const uint8_t sources[] = { CLOCK_PRESCALE_64, CLOCK_PRESCALE_256, CLOCK_PRESCALE_1024 };
+  const uint16_t factors[] = { 64, 256, 1024 };
+  uint32_t top = 0;
+  uint8_t i;
+
+  Timer2.stop();
+  if (perSecond == 0)
+  {
+    Timer2.detachInterrupt(INTERRUPT_COMPARE_MATCH_A);
+    return;
+  }
+
+  // the smallest prescaler that reaches down to the rate
+  for (i = 0; i < 3; i++)
+  {
+    top = F_CPU / factors[i] / perSecond;
+    if (top <= 256)
+      break;
+  }
+  if (i == 3)
+    i = 2;
+  top = constrain(top, 1, 256);
+
+  loadCycles = cycles;
+  Timer2.setMode(0b010);                  // CTC, TOP = OCR2A
+  Timer2.setOCR(CHANNEL_A, top - 1);
+  Timer2.setCounter(0);
+  Timer2.attachInterrupt(INTERRUPT_COMPARE_MATCH_A, load);
+  Timer2.setClockSource(sources[i]);
+}
+
+
+// From the port write that makes the rising edge.
+bool WLatency::externalInterrupt(uint8_t pin, LatencyHistogram &histogram,
+                                 uint16_t samples)
+{
+  int8_t interrupt = pinToInterrupt(pin);
+  volatile uint8_t *out = digitalPinToPortReg(pin);
+  uint8_t mask = digitalPinToBitMask(pin);
+  uint8_t oldSREG = SREG;
+  uint16_t start;
+  bool done = true;
+
+  if (interrupt < 0)
+    return false;
+
+  pinMode(pin, OUTPUT);
+  pinWrite(pin, LOW);
+  attachInterrupt(interrupt, stamp, RISING);
+#if defined(EIFR)
+  EIFR = (1 << interrupt);
+#endif
+
+  while (samples--)
+  {
+    eventSeen = false;
+
+    cli();
+    start = TCNT1;
+    *out |= mask;
+    SREG = oldSREG;
+
+    if (!waitForEvent(start))
+    {
+      done = false;
+      break;
+    }
+    histogram.add(eventTime - start - overhead);
+
+    *out &= ~mask;
+  }
+
+  detachInterrupt(interrupt);
+  pinWrite(pin, LOW);
+  pinMode(pin, INPUT);
+
+  return done;
+}
+
+
+// From the compare match.
+bool WLatency::timer(LatencyHistogram &histogram, uint16_t samples)
+{
+  uint8_t oldSREG = SREG;
+  uint16_t match;
+  bool done = true;
+
+  Timer1.enableInterrupt(INTERRUPT_COMPARE_MATCH_A);
+
+  while (samples--)
+  {
+    eventSeen = false;
+
+    cli();
+    match = TCNT1 + TIMER_LEAD;
+    OCR1A = match;
+    SREG = oldSREG;
+
+    if (!waitForEvent(match))
+    {
+      done = false;
+      break;
+    }
+    histogram.add(eventTime - match);
+  }
+
+  Timer1.disableInterrupt(INTERRUPT_COMPARE_MATCH_A);
+
+  return done;
+}
+
+
+// From the stop bit of the byte, that is one frame (start, 8 data and
+// stop bit) after it was sent.  Looped back, that includes the transmit
+// interrupt moving the byte into UDRn.
+bool WLatency::serial(HardwareSerial &port, uint32_t baud,
+                      LatencyHistogram &histogram, uint16_t samples,
+                      void (*send)(uint8_t))
+{
+  uint32_t frame = 10 * bitCycles(baud);
+  uint16_t elapsed;
+  unsigned long start;
+  uint16_t sent;
+  uint8_t c = 0;
+
+  // the frame has to fit the 16 bit time base
+  if (frame > 0xF000)
+    return false;
+
+  port.flush();
+
+  while (samples--)
+  {
+    sent = now();
+    if (send)
+      send(c);
+    else
+      port.write(c);
+
+    start = millis();
+    while (port.available() == 0)
+    {
+      if (millis() - start > TIMEOUT_MS)
+        return false;
+    }
+    elapsed = now() - sent;
+
+    if (port.read() != c)
+      return false;
+    c++;
+
+    if (elapsed > frame + overhead)
+      histogram.add(elapsed - frame - overhead);
+    else
+      histogram.add(0);
+  }
+
+  return true;
+}
@@ -0,0 +1,126 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Interrupt latency and jitter benchmarks.
+|| |
+|| | Measures, in CPU cycles, how long the core takes to get from an
+|| | event to the user function that handles it:
+|| |
+|| |   externalInterrupt()  a pin edge to the attachInterrupt() function
+|| |   timer()              a Timer 1 compare match to the
+|| |                        Timer1.attachInterrupt() function
+|| |   serial()             the end of a received byte to read()
+|| |                        returning it in the main program
+|| |
+|| | Each sample goes into a LatencyHistogram, which keeps the minimum,
+|| | mean and maximum (the spread between them is the jitter) and prints
+|| | a histogram.
+|| |
+|| | Timer 1 runs free at the CPU clock as the time base, so it is not
+|| | available for anything else while the benchmarks run; Timer 0
+|| | (millis()) keeps running and is part of what is measured.
+|| | setLoad() adds a background interrupt load on Timer 2, to see how
+|| | the latencies degrade under other interrupts.
+|| |
+|| | externalInterrupt() drives the pin as an output to make the edges.
+|| | serial() on real hardware needs the TX pin of the port wired to its
+|| | RX pin; on the Host core, a send function injects the byte instead
+|| | (see cores/Host/benchmarks).
+|| |
+|| | Wiring Core Library
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <Wiring.h>
+
+// Histogram bins; the last one also holds everything above the range.
+#define LATENCY_BINS 16
+
+// Samples per benchmark, by default
+#define LATENCY_SAMPLES 256
+
+class LatencyHistogram
+{
+  public:
+    LatencyHistogram(uint16_t binWidth = 8);
+
+    void clear(void);
+    // Fixes the range: bin n starts at origin + n * binWidth.  Without
+    // it, the range starts at the smallest of the first LATENCY_BINS
+    // samples.
+    void setRange(uint16_t origin, uint16_t binWidth);
+    void add(uint16_t cycles);
+
+    uint16_t samples(void) { return count; }
+    uint16_t minimum(void) { return low; }
+    uint16_t maximum(void) { return high; }
+    uint16_t mean(void);
+    uint16_t jitter(void) { return count ? high - low : 0; }
+    // Upper bound of the bin holding the given percentile
+    uint16_t percentile(uint8_t percent);
+
+    uint16_t binStart(uint8_t bin);
+    uint16_t binCount(uint8_t bin);
+
+    void print(Print &out, const __ConstantStringHelper *title);
+
+  private:
+    // Until the range is set, bins[] holds the first samples as they are.
+    bool ranged;
+    uint16_t origin;
+    uint16_t width;
+    uint16_t bins[LATENCY_BINS];
+    uint16_t count;
+    uint16_t low;
+    uint16_t high;
+    uint32_t sum;
+
+    void settle(void);
+    void place(uint16_t cycles);
+};
+
+
+class WLatency
+{
+  public:
+    WLatency();
+
+    void begin(void);
+    void end(void);
+
+    // Interrupts per second on Timer 2, each spending about the given
+    // number of cycles in its handler.  0 interrupts per second stops it.
+    void setLoad(uint16_t perSecond, uint16_t cycles);
+
+    // Each returns false if an event never arrived (no interrupt on the
+    // pin, the port not looped back), after about a second.
+    bool externalInterrupt(uint8_t pin, LatencyHistogram &histogram,
+                           uint16_t samples = LATENCY_SAMPLES);
+    bool timer(LatencyHistogram &histogram,
+               uint16_t samples = LATENCY_SAMPLES);
+    bool serial(HardwareSerial &port, uint32_t baud,
+                LatencyHistogram &histogram,
+                uint16_t samples = LATENCY_SAMPLES,
+                void (*send)(uint8_t) = NULL);
+
+    // Cycles between two back to back time base reads, taken off the
+    // latencies measured from the main program.
+    uint16_t readOverhead(void) { return overhead; }
+
+  private:
+    uint16_t overhead;
+};
+
+extern WLatency Latency;
+
+#endif
+// LATENCY_H
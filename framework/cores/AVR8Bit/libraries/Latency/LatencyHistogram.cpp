@@ -0,0 +1,242 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Latency histogram.
+|| |
+|| | Wiring Core Library
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#include "Latency.h"
+
+// Longest bar printed
+#define BAR_WIDTH 40
+
+
+LatencyHistogram::LatencyHistogram(uint16_t binWidth)
+{
+  width = binWidth ? binWidth : 1;
+  ranged = false;
+  origin = 0;
+  clear();
+}
+
+
+void LatencyHistogram::clear(void)
+{
+  uint8_t i;
+
+  for (i = 0; i < LATENCY_BINS; i++)
+    bins[i] = 0;
+  count = 0;
+  low = 0xFFFF;
+  high = 0;
+  sum = 0;
+}
+
+
+void LatencyHistogram::setRange(uint16_t origin, uint16_t binWidth)
+{
+  uint16_t staged[LATENCY_BINS];
+  uint8_t n = 0;
+  uint8_t i;
+
+  // samples taken before are placed again in the new range
+  if (!ranged)
+  {
+    n = count;
+    for (i = 0; i < n; i++)
+      staged[i] = bins[i];
+  }
+
+  this->origin = origin;
+  width = binWidth ? binWidth : 1;
+  ranged = true;
+
+  for (i = 0; i < LATENCY_BINS; i++)
+    bins[i] = 0;
+  for (i = 0; i < n; i++)
+    place(staged[i]);
+}
+
+
+void LatencyHistogram::add(uint16_t cycles)
+{
+  if (cycles < low)
+    low = cycles;
+  if (cycles > high)
+    high = cycles;
+  sum += cycles;
+
+  if (!ranged)
+  {
+    bins[count++] = cycles;
+    if (count == LATENCY_BINS)
+      settle();
+    return;
+  }
+
+  place(cycles);
+  if (count < 0xFFFF)
+    count++;
+}
+
+
+// The range starts at the smallest of the samples so far, on a bin
+// boundary.
+void LatencyHistogram::settle(void)
+{
+  if (ranged)
+    return;
+
+  if (count == 0)
+    setRange(0, width);
+  else
+    setRange(low - low % width, width);
+}
+
+
+void LatencyHistogram::place(uint16_t cycles)
+{
+  uint16_t bin = 0;
+
+  if (cycles >= origin)
+    bin = (cycles - origin) / width;
+  if (bin >= LATENCY_BINS)
+    bin = LATENCY_BINS - 1;
+
+  if (bins[bin] < 0xFFFF)
+    bins[bin]++;
+}
+
+
+uint16_t LatencyHistogram::mean(void)
+{
+  if (count == 0)
+    return 0;
+
+  return (sum + count / 2) / count;
+}
+
+
+uint16_t LatencyHistogram::percentile(uint8_t percent)
+{
+  uint32_t needed;
+  uint32_t seen = 0;
+  uint16_t upper;
+  uint8_t i;
+
+  if (count == 0)
+    return 0;
+  settle();
+
+  needed = ((uint32_t)count * percent + 99) / 100;
+  if (needed == 0)
+    needed = 1;
+
+  for (i = 0; i < LATENCY_BINS - 1; i++)
+  {
+    seen += bins[i];
+    if (seen >= needed)
+    {
+      upper = origin + (i + 1) * width - 1;
+      if (upper > high)
+        return high;
+      if (upper < low)
+        return low;
+      return upper;
+    }
+  }
+
+  return high;
+}
+
+
+uint16_t LatencyHistogram::binStart(uint8_t bin)
+{
+  settle();
+
+  return origin + bin * width;
+}
+
+
+uint16_t LatencyHistogram::binCount(uint8_t bin)
+{
+  settle();
+
+  return bin < LATENCY_BINS ? bins[bin] : 0;
+}
+
+
+static void printRight(Print &out, uint16_t value, uint8_t digits)
+{
+  uint16_t limit = 1;
+
+  while (--digits)
+  {
+    limit *= 10;
+    if (value < limit)
+      out.print(' ');
+  }
+  out.print(value);
+}
+
+
+// <title>: <n> samples, min <a> mean <b> max <c> jitter <d> 99% <e> cycles
+//     72 | ######################################## 250
+//     80 | # 3
+//    192+| # 1
+void LatencyHistogram::print(Print &out, const __ConstantStringHelper *title)
+{
+  uint16_t most = 0;
+  uint8_t first = LATENCY_BINS;
+  uint8_t last = 0;
+  uint8_t bar;
+  uint8_t i;
+
+  settle();
+
+  out.print(title);
+  out.print(Constant(": "));
+  out.print(count);
+  out.print(Constant(" samples, min "));
+  out.print(minimum());
+  out.print(Constant(" mean "));
+  out.print(mean());
+  out.print(Constant(" max "));
+  out.print(maximum());
+  out.print(Constant(" jitter "));
+  out.print(jitter());
+  out.print(Constant(" 99% "));
+  out.print(percentile(99));
+  out.println(Constant(" cycles"));
+
+  for (i = 0; i < LATENCY_BINS; i++)
+  {
+    if (bins[i] == 0)
+      continue;
+    if (first == LATENCY_BINS)
+      first = i;
+    last = i;
+    if (bins[i] > most)
+      most = bins[i];
+  }
+
+  for (i = first; i <= last && i < LATENCY_BINS; i++)
+  {
+    printRight(out, origin + i * width, 7);
+    out.print(i == LATENCY_BINS - 1 ? Constant("+| ") : Constant(" | "));
+    bar = ((uint32_t)bins[i] * BAR_WIDTH + most - 1) / most;
+    while (bar--)
+      out.print('#');
+    if (bins[i])
+      out.print(' ');
+    out.println(bins[i]);
+  }
+}
@@ -0,0 +1,48 @@
+/**
+ * Interrupt Latency
+ * by Camilo Reyes <creyes@wiring.org.co>
+ *
+ * Measures how long the core takes from an external interrupt edge,
+ * a timer compare match and a received byte to the code handling
+ * them, without and then with a background interrupt load, and
+ * prints the histograms.
+ *
+ * Pin 0 (INT0) is driven as an output to make the edges.  Wire the
+ * TX pin of Serial1 to its RX pin for the serial measurement.
+ */
+
+#include <Latency.h>
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial1.begin(115200);
+  Latency.begin();
+
+  Serial.println(Constant("No load"));
+  run();
+
+  Serial.println(Constant("2000 interrupts/s of 400 cycles"));
+  Latency.setLoad(2000, 400);
+  run();
+
+  Latency.end();
+}
+
+void loop()
+{
+}
+
+void run()
+{
+  LatencyHistogram interrupt, timer, serial;
+
+  if (Latency.externalInterrupt(0, interrupt))
+    interrupt.print(Serial, Constant("INT0"));
+  if (Latency.timer(timer))
+    timer.print(Serial, Constant("Timer 1"));
+  if (Latency.serial(Serial1, 115200, serial))
+    serial.print(Serial, Constant("Serial1"));
+  else
+    Serial.println(Constant("Serial1: nothing received, TX not wired to RX?"));
+}
@@ -3,6 +3,7 @@
 || @author         John Raines <raine001 at tc dot umn dot edu>
 || @url            http://wiring.org.co/
 || @contribution   Brett Hagman <bhagman@wiring.org.co>
+|| @contribution   Camilo Reyes <creyes@wiring.org.co>
 ||
 || @description
 || | Liquid Crystal Display (LCD) Hardware Abstraction Library.
@@ -111,6 +112,14 @@ void LiquidCrystal::init(uint8_t rs, uint8_t rw, uint8_t enable, uint8_t en2,
   _data_pins[2] = d2;
   _data_pins[3] = d3;
 
+  // look the pins up once; send() runs on every character
+  _rs.attach(rs);
+  _rw.attach(rw);
+  _en[0].attach(enable);
+  _en[1].attach(en2);
+  for (uint8_t i = 0; i < 4; i++)
+    _data[i].attach(_data_pins[i]);
+
   pinMode(d0, OUTPUT); //set data pin modes
   pinMode(d1, OUTPUT);
   pinMode(d2, OUTPUT);
@@ -423,7 +432,7 @@ void LiquidCrystal::commandBoth(uint8_t value)
 }
 
 //print calls  this to send characters to the LCD
-void LiquidCrystal::write(uint8_t value)
+size_t LiquidCrystal::write(uint8_t value)
 {
   // first we call setCursor and send the character
   if ((_scroll_count != 0) || (_setCursFlag != 0)) setCursor(_x, _y);
@@ -460,6 +469,8 @@ void LiquidCrystal::write(uint8_t value)
 
   //wrap last line up to line 0
   if (_y >= _numlines) _y = 0;
+
+  return 1;
 }
 
 /************ low level data pushing commands **********/
@@ -467,8 +478,7 @@ void LiquidCrystal::write(uint8_t value)
 // write either command or data, with automatic 4/8-bit selection
 void LiquidCrystal::send(uint8_t value, uint8_t mode)
 {
-  uint8_t en = _enable_pin;
-  if ((_en2 != 255) && (_chip)) en = _en2;
+  DigitalPin &en = _en[(_en2 != 255) && (_chip)];
   if (_rw_pin == 255)
   {
     {
@@ -478,59 +488,60 @@ void LiquidCrystal::send(uint8_t value, uint8_t mode)
   }
   else
   {
-    uint8_t *pinptr = _data_pins;
-    pinMode(_data_pins[0], INPUT);
-    pinMode(_data_pins[1], INPUT);
-    pinMode(_data_pins[2], INPUT);
-    pinMode(_data_pins[3], INPUT);
-    digitalWrite(_rw_pin, HIGH);
-    digitalWrite(_rs_pin, LOW);
+    _data[0].mode(INPUT);
+    _data[1].mode(INPUT);
+    _data[2].mode(INPUT);
+    _data[3].mode(INPUT);
+    _rw.high();
+    _rs.low();
     uint8_t busy;
     do
     {
-      digitalWrite(en, HIGH);
-      busy = digitalRead(_data_pins[3]);
-      digitalWrite(en, LOW);
-      digitalWrite(en, HIGH);
-      digitalWrite(en, LOW);
+      en.high();
+      delayMicroseconds(1);
+      busy = _data[3].read();
+      en.low();
+      en.high();
+      delayMicroseconds(1);
+      en.low();
     }
     while (busy == HIGH);
-    pinMode(_data_pins[0], OUTPUT);
-    pinMode(_data_pins[1], OUTPUT);
-    pinMode(_data_pins[2], OUTPUT);
-    pinMode(_data_pins[3], OUTPUT);
-    digitalWrite(_rw_pin, LOW);
+    _data[0].mode(OUTPUT);
+    _data[1].mode(OUTPUT);
+    _data[2].mode(OUTPUT);
+    _data[3].mode(OUTPUT);
+    _rw.low();
   }
-  digitalWrite(_rs_pin, mode);
-
-  digitalWrite(_data_pins[0], value & 0x10);
-  digitalWrite(_data_pins[1], value & 0x20);
-  digitalWrite(_data_pins[2], value & 0x40);
-  digitalWrite(_data_pins[3], value & 0x80);
-  digitalWrite(en, HIGH);   // enable pulse must be >450ns
-  digitalWrite(en, LOW);
-
-  digitalWrite(_data_pins[0], value & 0x01);
-  digitalWrite(_data_pins[1], value & 0x02);
-  digitalWrite(_data_pins[2], value & 0x04);
-  digitalWrite(_data_pins[3], value & 0x08);
-  digitalWrite(en, HIGH);   // enable pulse must be >450ns
-  digitalWrite(en, LOW);
+  _rs.write(mode);
+
+  _data[0].write(value & 0x10);
+  _data[1].write(value & 0x20);
+  _data[2].write(value & 0x40);
+  _data[3].write(value & 0x80);
+  en.high();   // enable pulse must be >450ns
+  delayMicroseconds(1);
+  en.low();
+
+  _data[0].write(value & 0x01);
+  _data[1].write(value & 0x02);
+  _data[2].write(value & 0x04);
+  _data[3].write(value & 0x08);
+  en.high();   // enable pulse must be >450ns
+  delayMicroseconds(1);
+  en.low();
 }
 
 void LiquidCrystal::write4bits(uint8_t value)    // still used during init
 {
-  register uint8_t v = value;
-  uint8_t *pinptr = _data_pins;
-  digitalWrite(*pinptr++, v & 01);
-  digitalWrite(*pinptr++, (v >>= 1) & 01);
-  digitalWrite(*pinptr++, (v >>= 1) & 01);
-  digitalWrite(*pinptr++, (v >>= 1) & 01);
-  byte en = _enable_pin;
+  _data[0].write(value & 0x01);
+  _data[1].write(value & 0x02);
+  _data[2].write(value & 0x04);
+  _data[3].write(value & 0x08);
   // 4x40 LCD with 2 controller chips with separate enable lines if we called
   // w 2 enable pins and are on lines 2 or 3 enable chip 2
-  if ((_en2 != 255) && (_chip)) en = _en2;
-  digitalWrite(en, HIGH);   // enable pulse must be >450ns
-  digitalWrite(en, LOW);
+  DigitalPin &en = _en[(_en2 != 255) && (_chip)];
+  en.high();   // enable pulse must be >450ns
+  delayMicroseconds(1);
+  en.low();
 }
 
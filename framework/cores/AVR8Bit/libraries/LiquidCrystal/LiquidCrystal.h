@@ -3,6 +3,7 @@
 || @author         John Raines <raine001 at tc dot umn dot edu>
 || @url            http://wiring.org.co/
 || @contribution   Brett Hagman <bhagman@wiring.org.co>
+|| @contribution   Camilo Reyes <creyes@wiring.org.co>
 ||
 || @description
 || | Liquid Crystal Display (LCD) Hardware Abstraction Library.
@@ -107,7 +108,7 @@ class LiquidCrystal : public Print
 
     void createChar(uint8_t, uint8_t[]);
     void setCursor(uint8_t, uint8_t);
-    void write(uint8_t);
+    size_t write(uint8_t);
     void command(uint8_t);
     void commandBoth(uint8_t);
     inline LiquidCrystal& operator()(uint8_t x, uint8_t y)
@@ -137,6 +138,10 @@ class LiquidCrystal : public Print
 
     uint8_t _busyPin; // for reading the busy flag on the LCD synonmymous w last pin number specified to constructor
     uint8_t _data_pins[4];
+    DigitalPin _rs;
+    DigitalPin _rw;
+    DigitalPin _en[2];
+    DigitalPin _data[4];
     uint8_t _numcols;
     uint8_t _numlines;
     uint8_t row_offsets[4];
@@ -5,6 +5,7 @@
 || @contribution   Hernando Barragan <b@wiring.org.co>
 || @contribution   Alexander Brevig <abrevig@wiring.org.co>
 || @contribution   Brett Hagman <bhagman@wiring.org.co>
+|| @contribution   Camilo Reyes <creyes@wiring.org.co>
 ||
 || @description
 || | Max7219 LED Matrix Library.
@@ -52,14 +53,14 @@
 Matrix::Matrix(byte data, byte clock, byte load, byte screens /* = 1 */)
 {
   // record pins for sw spi
-  dataPin = data;
-  clockPin = clock;
-  loadPin = load;
+  dataPin.attach(data);
+  clockPin.attach(clock);
+  loadPin.attach(load);
 
   // set ddr for sw spi pins
-  pinMode(clockPin, OUTPUT);
-  pinMode(dataPin, OUTPUT);
-  pinMode(loadPin, OUTPUT);
+  clockPin.mode(OUTPUT);
+  dataPin.mode(OUTPUT);
+  loadPin.mode(OUTPUT);
 
   // allocate screenbuffers
   numberOfScreens = numberOfScreens;
@@ -150,16 +151,16 @@ void Matrix::putByte(byte data)
   while(i > 0) 
   {
     mask = 0x01 << (i - 1);         // get bitmask
-    digitalWrite(clockPin, LOW);   // tick
+    clockPin.low();  // tick
     if (data & mask)
     {               // choose bit
-      digitalWrite(dataPin, HIGH); // set 1
+      dataPin.high();  // set 1
     }
     else
     {
-      digitalWrite(dataPin, LOW);  // set 0
+      dataPin.low();   // set 0
     }
-    digitalWrite(clockPin, HIGH);  // tock
+    clockPin.high(); // tock
     --i;                            // move to lesser bit
   }
 }
@@ -167,14 +168,14 @@ void Matrix::putByte(byte data)
 // sets register to a byte value for all numberOfScreens
 void Matrix::setRegister(byte reg, byte data)
 {
-  digitalWrite(loadPin, HIGH); // begin
+  loadPin.high();  // begin
   for(byte i = 0; i < numberOfScreens; ++i)
   {
     putByte(reg);  // specify register
     putByte(data); // send data
   }
-  digitalWrite(loadPin, LOW);  // latch in data
-  digitalWrite(loadPin, HIGH); // end
+  loadPin.low();   // latch in data
+  loadPin.high();  // end
 }
 
 // syncs row of display with buffer
@@ -182,14 +183,14 @@ void Matrix::syncRow(int row)
 {
   if (!buf) return;
   if (row < 0 || row >= 8) return;
-  digitalWrite(loadPin, HIGH); // begin
+  loadPin.high();  // begin
   for(byte i = 0; i < numberOfScreens; ++i)
   {
     putByte(8 - row);                // specify register
     putByte(buf[row + (8 * i)]); // send data
   }
-  digitalWrite(loadPin, LOW);  // latch in data
-  digitalWrite(loadPin, HIGH); // end
+  loadPin.low();   // latch in data
+  loadPin.high();  // end
 }
 
 // sets how many digits are displayed
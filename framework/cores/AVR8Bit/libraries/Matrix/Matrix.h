@@ -5,6 +5,7 @@
 || @contribution   Hernando Barragan <b@wiring.org.co>
 || @contribution   Alexander Brevig <abrevig@wiring.org.co>
 || @contribution   Brett Hagman <bhagman@wiring.org.co>
+|| @contribution   Camilo Reyes <creyes@wiring.org.co>
 ||
 || @description
 || | Max7219 LED Matrix Library.
@@ -44,9 +45,9 @@ class Matrix
 
     void buffer(int, int, byte);
     
-    byte dataPin;
-    byte clockPin;
-    byte loadPin;
+    DigitalPin dataPin;
+    DigitalPin clockPin;
+    DigitalPin loadPin;
 
     byte* buf;
     byte numberOfScreens;
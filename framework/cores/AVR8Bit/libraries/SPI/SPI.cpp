@@ -4,6 +4,7 @@
 || @url            http://wiring.org.co/
 || @contribution   Brett Hagman <bhagman@wiring.org.co>
 || @contribution   Alexander Brevig <abrevig@wiring.org.co>
+|| @contribution   Camilo Reyes <creyes@wiring.org.co>
 ||
 || @description
 || | SPI Library.
@@ -19,6 +20,65 @@
 #include "SPI.h"
 
 
+typedef struct
+{
+  const uint8_t *tx;
+  uint8_t *rx;
+  uint16_t length;        // bytes left, including the one shifting
+  void (*done)(void);
+} SPIStream;
+
+// Background transfers: the one going out, and the next
+static SPIStream current;
+static SPIStream next;
+static volatile uint8_t queued;
+
+
+/************ static functions common to all instances ***********************/
+
+static inline void start(void)
+{
+  SPDR = current.tx ? *current.tx++ : 0xFF;
+}
+
+
+// SPI interrupt of the background transfers: a byte is in.
+static void stream(void)
+{
+  void (*done)(void);
+  uint8_t in;
+
+  if (current.length > 1)
+  {
+    // the next byte goes out first, then this one is stored
+    SPDR = current.tx ? *current.tx++ : 0xFF;
+    in = SPDR;
+    if (current.rx)
+      *current.rx++ = in;
+    current.length--;
+    return;
+  }
+
+  in = SPDR;
+  if (current.rx)
+    *current.rx = in;
+  done = current.done;
+
+  if (--queued)
+  {
+    current = next;
+    start();
+  }
+  else
+    SPCR &= ~_BV(SPIE);
+
+  if (done)
+    done();
+}
+
+/****************** end of static functions ******************************/
+
+
 // default is MASTER
 void WSPI::begin() 
 {
@@ -56,6 +116,15 @@ void WSPI::begin(uint8_t mode, uint8_t bitOrder, uint8_t dataMode, uint8_t clock
 
 
 void WSPI::end() {
+  uint8_t oldSREG = SREG;
+
+  cli();
+  if (queued)
+  {
+    SPCR &= ~_BV(SPIE);
+    queued = 0;
+  }
+  SREG = oldSREG;
   SPCR &= ~_BV(SPE);
 }
 
@@ -63,12 +132,101 @@ void WSPI::end() {
 // send and receive
 uint8_t WSPI::transfer(uint8_t data)
 {
-  SPDR =  data;
+  SPDR = data;
   while(!(SPSR & _BV(SPIF)));
   return SPDR;
 }
 
 
+void WSPI::transfer(uint8_t *buffer, uint16_t length)
+{
+  uint8_t out;
+
+  if (length == 0)
+    return;
+
+  // The receive buffer holds a byte until the next one is in, so as soon
+  // as SPIF is set the next byte goes out, and the one received is
+  // stored while it shifts.
+  SPDR = *buffer;
+  while (--length)
+  {
+    out = buffer[1];
+    while(!(SPSR & _BV(SPIF)));
+    SPDR = out;
+    *buffer++ = SPDR;
+  }
+  while(!(SPSR & _BV(SPIF)));
+  *buffer = SPDR;
+}
+
+
+void WSPI::transfer(const uint8_t *txBuffer, uint8_t *rxBuffer, uint16_t length)
+{
+  uint8_t out;
+  uint8_t in;
+
+  if (length == 0)
+    return;
+
+  // as above
+  SPDR = txBuffer ? *txBuffer++ : 0xFF;
+  while (--length)
+  {
+    out = txBuffer ? *txBuffer++ : 0xFF;
+    while(!(SPSR & _BV(SPIF)));
+    SPDR = out;
+    in = SPDR;
+    if (rxBuffer)
+      *rxBuffer++ = in;
+  }
+  while(!(SPSR & _BV(SPIF)));
+  in = SPDR;
+  if (rxBuffer)
+    *rxBuffer = in;
+}
+
+
+bool WSPI::transferAsync(const uint8_t *txBuffer, uint8_t *rxBuffer,
+                         uint16_t length, void (*done)(void))
+{
+  SPIStream *s;
+  uint8_t oldSREG = SREG;
+
+  if (length == 0)
+    return false;
+
+  cli();
+  if (queued == 2)
+  {
+    SREG = oldSREG;
+    return false;
+  }
+
+  s = queued ? &next : &current;
+  s->tx = txBuffer;
+  s->rx = rxBuffer;
+  s->length = length;
+  s->done = done;
+
+  if (queued++ == 0)
+  {
+    attachInterruptSPI(stream);
+    start();
+    SPCR |= _BV(SPIE);
+  }
+  SREG = oldSREG;
+
+  return true;
+}
+
+
+bool WSPI::busy(void)
+{
+  return queued != 0;
+}
+
+
 void WSPI::setBitOrder(uint8_t bitOrder) {
   if(bitOrder == LSBFIRST) {
     SPCR |= _BV(DORD);
@@ -4,10 +4,19 @@
 || @url            http://wiring.org.co/
 || @contribution   Brett Hagman <bhagman@wiring.org.co>
 || @contribution   Alexander Brevig <abrevig@wiring.org.co>
+|| @contribution   Camilo Reyes <creyes@wiring.org.co>
 ||
 || @description
 || | SPI Library.
 || |
+|| | Besides single bytes, transfers whole buffers: blocking, with the
+|| | next byte loaded while the current one shifts so they go out nearly
+|| | back to back (close to 8 Mbit/s at SPI_CLOCK_DIV2 and 16 MHz), or
+|| | in the background from the SPI interrupt, one buffer after another.
+|| | The interrupt costs more than a byte takes at SPI_CLOCK_DIV2 or
+|| | DIV4, so the background transfers pay off at the slower clocks, or
+|| | when the CPU has other work to do meanwhile.
+|| |
 || | Wiring Core Library
 || #
 ||
@@ -54,6 +63,20 @@ class WSPI
     void begin(uint8_t mode, uint8_t bitOrder=MSBFIRST, uint8_t dataMode=SPI_MODE3, uint8_t clockRate=SPI_CLOCK_DIV4);
     static void end();
     uint8_t transfer(uint8_t);
+    // In place: the bytes received replace the bytes sent.
+    void transfer(uint8_t *buffer, uint16_t length);
+    // A NULL txBuffer sends 0xFF, a NULL rxBuffer drops what is received.
+    void transfer(const uint8_t *txBuffer, uint8_t *rxBuffer, uint16_t length);
+    // In the background (master mode), from the SPI interrupt: one
+    // buffer transfers while the next waits, so the second can be filled
+    // while the first goes out, and follows it without a gap.  done (if
+    // any) is called from the interrupt as each one finishes.  Returns
+    // false if two are already waiting.  The buffers must stay untouched
+    // until then, and other transfers must wait until busy() is false.
+    // Takes over the function attached with attachInterrupt().
+    bool transferAsync(const uint8_t *txBuffer, uint8_t *rxBuffer,
+                       uint16_t length, void (*done)(void) = NULL);
+    static bool busy(void);
     static void setBitOrder(uint8_t);
     static void setDataMode(uint8_t);
     static void setClockDivider(uint8_t);
@@ -0,0 +1,62 @@
+/**
+ * SPI Double Buffered
+ * by Camilo Reyes <creyes@wiring.org.co>
+ * 
+ * Streams lines of pixels to an SPI display in the background:
+ * while one line goes out from the SPI interrupt, the next one is
+ * drawn into the other buffer, and queued to follow it without a
+ * gap.  The display's chip select is on pin 8.
+ */
+
+#include <SPI.h>
+
+#define CS_PIN 8
+#define LINE_BYTES 128
+#define LINES 64
+
+uint8_t lines[2][LINE_BYTES];
+volatile uint8_t linesOut = 0;  // queued and not sent yet
+uint8_t frame = 0;
+
+void lineSent()
+{
+  linesOut--;
+}
+
+void draw(uint8_t *line, uint8_t y)
+{
+  for (uint8_t x = 0; x < LINE_BYTES; x++)
+    line[x] = x + y + frame;
+}
+
+void setup()
+{
+  pinMode(CS_PIN, OUTPUT);
+  digitalWrite(CS_PIN, HIGH);
+  SPI.begin(SPI_MASTER, MSBFIRST, SPI_MODE0, SPI_CLOCK_DIV8);
+}
+
+void loop()
+{
+  uint8_t which = 0;
+
+  digitalWrite(CS_PIN, LOW);
+  for (uint8_t y = 0; y < LINES; y++)
+  {
+    // the buffer drawn into must be done going out
+    while (linesOut == 2)
+      ;
+    draw(lines[which], y);
+
+    noInterrupts();
+    linesOut++;
+    interrupts();
+    SPI.transferAsync(lines[which], NULL, LINE_BYTES, lineSent);
+    which ^= 1;
+  }
+  while (SPI.busy())
+    ;
+  digitalWrite(CS_PIN, HIGH);
+
+  frame++;
+}
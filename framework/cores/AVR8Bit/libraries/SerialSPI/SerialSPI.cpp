@@ -0,0 +1,297 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | SPI master on a USART (Master SPI Mode).
+|| |
+|| | Wiring Core Library
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+|| @notes
+|| | The transmitter holds a byte in UDRn while another shifts, and the
+|| | receiver two bytes, so the transfers keep at most two bytes sent and
+|| | not yet read back: the next byte is always waiting before the bus
+|| | needs it, and nothing received is ever overrun.  With no more than
+|| | one outstanding byte, the transmit buffer is empty, so UDREn need
+|| | not be polled.
+|| #
+*/
+
+#include "SerialSPI.h"
+
+#if defined(UMSEL01) || defined(UMSEL11)
+
+// UCSRnC in Master SPI Mode (the same bits on every USART)
+#ifndef UCPHA0
+#define UCPHA0 1
+#endif
+#ifndef UDORD0
+#define UDORD0 2
+#endif
+#define MSPIM (_BV(UMSEL01) | _BV(UMSEL00))
+
+// XCKn, the clock output
+#if defined(__AVR_ATmega1281__) || defined(__AVR_ATmega2561__) || \
+    defined(__AVR_ATmega640__) || defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
+#define XCK0_DDR DDRE
+#define XCK0_BIT PE2
+#define XCK1_DDR DDRD
+#define XCK1_BIT PD5
+#elif defined(__AVR_ATmega164P__) || defined(__AVR_ATmega324P__) || \
+      defined(__AVR_ATmega644P__) || defined(__AVR_ATmega1284P__)
+#define XCK0_DDR DDRB
+#define XCK0_BIT PB0
+#define XCK1_DDR DDRD
+#define XCK1_BIT PD4
+#elif defined(__AVR_ATmega168__) || defined(__AVR_ATmega328P__)
+#define XCK0_DDR DDRD
+#define XCK0_BIT PD4
+#endif
+
+
+WSerialSPI::WSerialSPI(HardwareSerial &port)
+{
+  serial = &port;
+  queued = 0;
+  inFlight = 0;
+}
+
+
+void WSerialSPI::begin(uint8_t bitOrder, uint8_t dataMode, uint8_t clockRate)
+{
+  end();
+
+  // The baud rate register must be 0 when the transmitter is enabled
+  *serial->_ubrrh = 0;
+  *serial->_ubrrl = 0;
+
+#if defined(XCK0_DDR)
+  if (serial->_udr == &UDR0)
+    XCK0_DDR |= _BV(XCK0_BIT);
+#endif
+#if defined(XCK1_DDR)
+  if (serial->_udr == &UDR1)
+    XCK1_DDR |= _BV(XCK1_BIT);
+#endif
+
+  *serial->_ucsrc = MSPIM;
+  setBitOrder(bitOrder);
+  setDataMode(dataMode);
+  *serial->_ucsrb = _BV(RXEN0) | _BV(TXEN0);
+  setClockDivider(clockRate);
+
+  serial->rxContext = this;
+  serial->rxHandler = receivedFrom;
+}
+
+
+// Back to a plain (disabled) USART, 8N1.
+void WSerialSPI::end(void)
+{
+  uint8_t oldSREG = SREG;
+
+  cli();
+  queued = 0;
+  inFlight = 0;
+  if (serial->rxHandler == receivedFrom)
+  {
+    *serial->_ucsrb = 0;
+    *serial->_ucsrc = _BV(UCSZ01) | _BV(UCSZ00);
+    serial->rxHandler = 0;
+  }
+  SREG = oldSREG;
+}
+
+
+uint8_t WSerialSPI::transfer(uint8_t data)
+{
+  volatile uint8_t *ucsra = serial->_ucsra;
+
+  *serial->_udr = data;
+  while (!(*ucsra & _BV(RXC0)));
+  return *serial->_udr;
+}
+
+
+void WSerialSPI::transfer(uint8_t *buffer, uint16_t length)
+{
+  // each byte is read back after it is sent
+  transfer(buffer, buffer, length);
+}
+
+
+void WSerialSPI::transfer(const uint8_t *txBuffer, uint8_t *rxBuffer, uint16_t length)
+{
+  volatile uint8_t *ucsra = serial->_ucsra;
+  volatile uint8_t *udr = serial->_udr;
+  uint16_t sent = 0;
+  uint16_t got = 0;
+  uint8_t in;
+
+  while (got < length)
+  {
+    if (sent < length && sent - got < 2)
+    {
+      *udr = txBuffer ? txBuffer[sent] : 0xFF;
+      sent++;
+    }
+    if (*ucsra & _BV(RXC0))
+    {
+      in = *udr;
+      if (rxBuffer)
+        rxBuffer[got] = in;
+      got++;
+    }
+  }
+}
+
+
+// Sends the next byte of the background transfers, if there is one and
+// room for it.  Called with interrupts disabled.
+bool WSerialSPI::feed(void)
+{
+  SerialSPIStream *s = &current;
+
+  if (inFlight == 2)
+    return false;
+  if (s->toSend == 0)
+  {
+    s = &next;
+    if (queued < 2 || s->toSend == 0)
+      return false;
+  }
+
+  *serial->_udr = s->tx ? *s->tx++ : 0xFF;
+  s->toSend--;
+  inFlight++;
+
+  return true;
+}
+
+
+// Receive interrupt of the background transfers: a byte is in.
+void WSerialSPI::received(void)
+{
+  void (*done)(void) = NULL;
+  uint8_t in = *serial->_udr;
+
+  if (queued == 0)
+    return;
+
+  inFlight--;
+  if (current.rx)
+    *current.rx++ = in;
+
+  if (--current.toReceive == 0)
+  {
+    done = current.done;
+    if (--queued)
+      current = next;
+    else
+      *serial->_ucsrb &= ~_BV(RXCIE0);
+  }
+
+  feed();
+
+  if (done)
+    done();
+}
+
+
+void WSerialSPI::receivedFrom(void *context)
+{
+  ((WSerialSPI *)context)->received();
+}
+
+
+bool WSerialSPI::transferAsync(const uint8_t *txBuffer, uint8_t *rxBuffer,
+                               uint16_t length, void (*done)(void))
+{
+  SerialSPIStream *s;
+  uint8_t oldSREG = SREG;
+
+  if (length == 0)
+    return false;
+
+  cli();
+  if (queued == 2)
+  {
+    SREG = oldSREG;
+    return false;
+  }
+
+  s = queued ? &next : &current;
+  s->tx = txBuffer;
+  s->rx = rxBuffer;
+  s->toSend = length;
+  s->toReceive = length;
+  s->done = done;
+
+  if (queued++ == 0)
+    *serial->_ucsrb |= _BV(RXCIE0);
+  while (feed());
+  SREG = oldSREG;
+
+  return true;
+}
+
+
+bool WSerialSPI::busy(void)
+{
+  return queued != 0;
+}
+
+
+void WSerialSPI::setBitOrder(uint8_t bitOrder)
+{
+  if (bitOrder == LSBFIRST)
+    *serial->_ucsrc |= _BV(UDORD0);
+  else
+    *serial->_ucsrc &= ~_BV(UDORD0);
+}
+
+
+// SPI_MODEn carries CPOL and CPHA as in SPCR (bits 3 and 2).
+void WSerialSPI::setDataMode(uint8_t mode)
+{
+  uint8_t bits = 0;
+
+  if (mode & 0x08)
+    bits |= _BV(UCPOL0);
+  if (mode & 0x04)
+    bits |= _BV(UCPHA0);
+
+  *serial->_ucsrc = (*serial->_ucsrc & ~(_BV(UCPOL0) | _BV(UCPHA0))) | bits;
+}
+
+
+void WSerialSPI::setClockDivider(uint8_t rate)
+{
+  static const uint8_t dividers[] = { 4, 16, 64, 128, 2, 8, 32, 64 };
+
+  setClock(F_CPU / dividers[rate & 0x07]);
+}
+
+
+// F_CPU / (2 * (UBRRn + 1))
+uint32_t WSerialSPI::setClock(uint32_t frequency)
+{
+  uint32_t ubrr;
+
+  if (frequency == 0)
+    frequency = 1;
+  ubrr = (F_CPU / 2 + frequency - 1) / frequency - 1;
+  if (ubrr > 0x0FFF)
+    ubrr = 0x0FFF;
+
+  *serial->_ubrrh = ubrr >> 8;
+  *serial->_ubrrl = ubrr;
+
+  return F_CPU / 2 / (ubrr + 1);
+}
+
+#endif
@@ -0,0 +1,90 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | SPI master on a USART (Master SPI Mode).
+|| |
+|| | A second SPI bus, with the same transfers as the SPI library: XCKn
+|| | is the clock, TXDn the data out (MOSI) and RXDn the data in (MISO);
+|| | select lines are up to the sketch.  The USART's transmit buffer lets
+|| | the next byte wait while one shifts, so buffer transfers go out back
+|| | to back at up to F_CPU / 2, where the SPI has a gap between bytes.
+|| |
+|| |   WSerialSPI SPI1(Serial1);
+|| |   SPI1.begin(MSBFIRST, SPI_MODE0, SPI_CLOCK_DIV2);
+|| |
+|| | While it runs, the USART is not a serial port: Serial1 is back after
+|| | end() and Serial1.begin().  Not on the ATmega128, whose USARTs have
+|| | no Master SPI Mode.
+|| |
+|| | Wiring Core Library
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#ifndef SERIALSPI_H
+#define SERIALSPI_H
+
+#include <Wiring.h>
+#include <SPI.h>
+
+#if defined(UMSEL01) || defined(UMSEL11)
+
+typedef struct
+{
+  const uint8_t *tx;
+  uint8_t *rx;
+  uint16_t toSend;
+  uint16_t toReceive;
+  void (*done)(void);
+} SerialSPIStream;
+
+class WSerialSPI
+{
+  public:
+    WSerialSPI(HardwareSerial &port);
+
+    // clockRate is one of SPI_CLOCK_DIVn, as for the SPI.
+    void begin(uint8_t bitOrder = MSBFIRST, uint8_t dataMode = SPI_MODE0,
+               uint8_t clockRate = SPI_CLOCK_DIV2);
+    void end(void);
+    uint8_t transfer(uint8_t data);
+    // In place: the bytes received replace the bytes sent.
+    void transfer(uint8_t *buffer, uint16_t length);
+    // A NULL txBuffer sends 0xFF, a NULL rxBuffer drops what is received.
+    void transfer(const uint8_t *txBuffer, uint8_t *rxBuffer, uint16_t length);
+    // In the background, from the receive interrupt, as
+    // WSPI::transferAsync(): one buffer transfers while the next waits,
+    // and the next follows without a gap.  Returns false if two are
+    // already waiting.
+    bool transferAsync(const uint8_t *txBuffer, uint8_t *rxBuffer,
+                       uint16_t length, void (*done)(void) = NULL);
+    bool busy(void);
+    void setBitOrder(uint8_t bitOrder);
+    void setDataMode(uint8_t mode);
+    void setClockDivider(uint8_t rate);
+    // Any clock from F_CPU / 8192 to F_CPU / 2; returns the one set,
+    // the nearest at or below.
+    uint32_t setClock(uint32_t frequency);
+
+  private:
+    HardwareSerial *serial;
+    // Background transfers: the one receiving, and the next
+    SerialSPIStream current;
+    SerialSPIStream next;
+    volatile uint8_t queued;
+    uint8_t inFlight;       // bytes sent and not yet read back
+
+    bool feed(void);
+    void received(void);
+    static void receivedFrom(void *context);
+};
+
+#endif
+
+#endif
+// SERIALSPI_H
@@ -0,0 +1,57 @@
+/**
+ * SerialSPI Two Buses
+ * by Camilo Reyes <creyes@wiring.org.co>
+ * 
+ * A display on the SPI and an SD card on USART1 in Master SPI Mode
+ * (XCK1 clock, TXD1 data out, RXD1 data in): a line of pixels goes
+ * out to the display in the background while a block is read from the
+ * card, each on its own bus.  The display's chip select is on pin 8,
+ * the card's on pin 9 (the card is assumed to be set up already).
+ */
+
+#include <SPI.h>
+#include <SerialSPI.h>
+
+#define DISPLAY_CS 8
+#define CARD_CS 9
+#define LINE_BYTES 128
+
+WSerialSPI SPI1(Serial1);
+
+uint8_t line[LINE_BYTES];
+uint8_t block[512];
+uint8_t readBlock[6] = { 0x51, 0, 0, 0, 0, 0xFF };  // CMD17, block 0
+
+void setup()
+{
+  pinMode(DISPLAY_CS, OUTPUT);
+  digitalWrite(DISPLAY_CS, HIGH);
+  pinMode(CARD_CS, OUTPUT);
+  digitalWrite(CARD_CS, HIGH);
+
+  SPI.begin(SPI_MASTER, MSBFIRST, SPI_MODE0, SPI_CLOCK_DIV8);
+  SPI1.begin(MSBFIRST, SPI_MODE0, SPI_CLOCK_DIV2);
+}
+
+void loop()
+{
+  for (uint8_t x = 0; x < LINE_BYTES; x++)
+    line[x]++;
+
+  // the display line goes out from the SPI interrupt...
+  digitalWrite(DISPLAY_CS, LOW);
+  SPI.transferAsync(line, NULL, LINE_BYTES);
+
+  // ...while the card is read, back to back at 8 MHz
+  digitalWrite(CARD_CS, LOW);
+  SPI1.transfer(readBlock, NULL, sizeof(readBlock));
+  while (SPI1.transfer(0xFF) != 0xFE)   // data token
+    ;
+  SPI1.transfer(NULL, block, sizeof(block));
+  SPI1.transfer(NULL, NULL, 2);         // CRC
+  digitalWrite(CARD_CS, HIGH);
+
+  while (SPI.busy())
+    ;
+  digitalWrite(DISPLAY_CS, HIGH);
+}
@@ -3,6 +3,7 @@
 || @author         Brett Hagman <bhagman@roguerobotics.com>
 || @url            http://wiring.org.co/
 || @contribution   Michael Margolis
+|| @contribution   Camilo Reyes <creyes@wiring.org.co>
 ||
 || @description
 || | Interrupt driven Servo library using 16 bit timers.
@@ -30,6 +31,9 @@
 || | attach(pin, min, max) - Attaches to a pin setting min and max values in
 || |                         microseconds
 || | default min is 544, max is 2400
+|| | attachHardware(pin) - Attaches to the output compare pin (OCnA/B/C) of a
+|| |               16 bit timer, which then makes the pulses itself.
+|| | attachHardware(pin, min, max) - As above, setting min and max values.
 || |
 || | write()     - Sets the servo angle in degrees.
 || |               (invalid angle that is valid as pulse in microseconds is
@@ -57,6 +61,21 @@
 || |  width (approx. 2.5ms), then it would take 30 ms to service the pulses, then
 || |  another 20 ms for "refresh", totalling 50 ms per cycle, or 20 cycles per
 || |  second (i.e. 20 Hz).
+|| |
+|| |  The interrupt sets and clears the pins through their port registers,
+|| |  looked up once by attach(), and skips detached channels, so each
+|| |  channel costs a handful of instructions and the edges move only with
+|| |  the interrupt latency.
+|| |
+|| |  attachHardware() takes a timer whose output compare pins carry the
+|| |  servos instead: it runs in fast PWM mode with TOP (ICRn) at the
+|| |  refresh interval, and each pin is set at BOTTOM and cleared at its
+|| |  compare match.  No interrupts are involved, so the pulses have no
+|| |  jitter at all, up to three servos per timer.  A timer is used one way
+|| |  or the other: attachHardware() fails on a timer pulsing servos from
+|| |  its interrupt, and attach() fails (returns INVALID_SERVO) for a servo
+|| |  whose channel falls on a timer in hardware mode.  Other PWM on the
+|| |  timer runs at the refresh rate, too.
 || #
 */
 
@@ -66,12 +85,13 @@
 #include "Servo.h"
 
 // converts microseconds to tick (assumes prescale of 8)
-#define usToTicks(_us)    ((clockCyclesPerMicrosecond()* _us) / 8)
+#define usToTicks(_us)    ((clockCyclesPerMicrosecond() * (_us)) / 8)
 // converts from ticks back to microseconds
-#define ticksToUs(_ticks) (((uint16_t)_ticks * 8) / clockCyclesPerMicrosecond())
+#define ticksToUs(_ticks) (((uint16_t)(_ticks) * 8) / clockCyclesPerMicrosecond())
 
 
-// compensation ticks to trim adjust for digitalWrite delays
+// compensation in microseconds for the interrupt latency ahead of the end
+// of the pulse
 #define TRIM_DURATION       2
 
 // static array of servo structures
@@ -82,6 +102,17 @@ static volatile int8_t Channel[_Nbr_16timers];
 // the total number of attached servos
 uint8_t ServoCount = 0;
 
+#if defined(SERVO_NEW_TIMER_CONTROL)
+// The timers driving servos.  Servo owns the compare match A vector of
+// each timer it can use (TIMER_ISR()), so handle_interrupts() runs
+// straight from the vector; on a timer not driving servos the interrupt
+// goes to the function attached to it instead (e.g. by tone()).
+static volatile uint8_t timersSeized;
+
+// The output compare channels of each timer driving hardware servos.
+static uint8_t hardwareChannels[_Nbr_16timers];
+#endif
+
 
 // convenience macros
 
@@ -105,77 +136,120 @@ static inline void handle_interrupts(timer16_Sequence_t timer,
                                      volatile uint16_t *TCNTn,
                                      volatile uint16_t *OCRnA)
 {
-  if (Channel[timer] < 0)
+  int8_t channel = Channel[timer];
+  servo_t *servo;
+  uint16_t now;
+
+  if (channel < 0)
     *TCNTn = 0; // channel set to -1 indicated that refresh interval completed so reset the timer
   else
-    if (SERVO_INDEX(timer,Channel[timer]) < ServoCount && SERVO(timer,Channel[timer]).Pin.isActive == true)
-      digitalWrite(SERVO(timer,Channel[timer]).Pin.nbr,LOW);  // pulse this channel low if activated
-
-  Channel[timer]++;    // increment to the next channel
-  if (SERVO_INDEX(timer,Channel[timer]) < ServoCount && Channel[timer] < SERVOS_PER_TIMER)
   {
-    *OCRnA = *TCNTn + SERVO(timer,Channel[timer]).ticks;
-    if (SERVO(timer,Channel[timer]).Pin.isActive == true)     // check if activated
-      digitalWrite(SERVO(timer,Channel[timer]).Pin.nbr,HIGH); // its an active channel so pulse it high
+    servo = &SERVO(timer,channel);
+    if (servo->mask)
+      *servo->port &= ~servo->mask;  // end the pulse of this channel
   }
-  else
+
+  // move on to the next channel pulsed, skipping detached ones
+  while (++channel < SERVOS_PER_TIMER && SERVO_INDEX(timer,channel) < ServoCount)
   {
-    // finished all channels so wait for the refresh period
-    // to expire before starting over.
-    // (allow a few ticks to ensure the next OCR1A not missed)
-    if ((uint16_t)*TCNTn < (usToTicks(REFRESH_INTERVAL) + 4))
-      *OCRnA = (uint16_t)usToTicks(REFRESH_INTERVAL);
-    else
-      *OCRnA = *TCNTn + 4;  // at least REFRESH_INTERVAL has elapsed
-    Channel[timer] = -1;    // this will get incremented at the end of the
-                            // refresh period to start again at the first channel
+    servo = &SERVO(timer,channel);
+    if (servo->mask)
+    {
+      now = *TCNTn;
+      *servo->port |= servo->mask;
+      *OCRnA = now + servo->ticks;
+      Channel[timer] = channel;
+      return;
+    }
   }
+
+  // finished all channels so wait for the refresh period
+  // to expire before starting over.
+  // (allow a few ticks to ensure the next OCR1A not missed)
+  if ((uint16_t)*TCNTn < (usToTicks(REFRESH_INTERVAL) + 4))
+    *OCRnA = (uint16_t)usToTicks(REFRESH_INTERVAL);
+  else
+    *OCRnA = *TCNTn + 4;  // at least REFRESH_INTERVAL has elapsed
+  Channel[timer] = -1;    // this will get incremented at the end of the
+                          // refresh period to start again at the first channel
 }
 
 
 #if defined(_useTimer1)
 #if defined(SERVO_NEW_TIMER_CONTROL)
-void Timer1Service()
+TIMER_ISR(TIMER1_COMPA_vect)
+{
+  PROFILE_ENTER();
+  if (timersSeized & (1 << _timer1))
+    handle_interrupts(_timer1, &TCNT1, &OCR1A);
+  else
+    Timer1.dispatch(INTERRUPT_COMPARE_MATCH_A);
+  PROFILE_EXIT(PROFILE_TIMER1_COMPA);
+}
 #else
 ISR(TIMER1_COMPA_vect)
-#endif
 {
   handle_interrupts(_timer1, &TCNT1, &OCR1A);
 }
 #endif
+#endif
 
 #if defined(_useTimer3)
 #if defined(SERVO_NEW_TIMER_CONTROL)
-void Timer3Service()
+TIMER_ISR(TIMER3_COMPA_vect)
+{
+  PROFILE_ENTER();
+  if (timersSeized & (1 << _timer3))
+    handle_interrupts(_timer3, &TCNT3, &OCR3A);
+  else
+    Timer3.dispatch(INTERRUPT_COMPARE_MATCH_A);
+  PROFILE_EXIT(PROFILE_TIMER3_COMPA);
+}
 #else
 ISR(TIMER3_COMPA_vect)
-#endif
 {
   handle_interrupts(_timer3, &TCNT3, &OCR3A);
 }
 #endif
+#endif
 
 #if defined(_useTimer4)
 #if defined(SERVO_NEW_TIMER_CONTROL)
-void Timer4Service()
+TIMER_ISR(TIMER4_COMPA_vect)
+{
+  PROFILE_ENTER();
+  if (timersSeized & (1 << _timer4))
+    handle_interrupts(_timer4, &TCNT4, &OCR4A);
+  else
+    Timer4.dispatch(INTERRUPT_COMPARE_MATCH_A);
+  PROFILE_EXIT(PROFILE_TIMER4_COMPA);
+}
 #else
 ISR(TIMER4_COMPA_vect)
-#endif
 {
   handle_interrupts(_timer4, &TCNT4, &OCR4A);
 }
 #endif
+#endif
 
 #if defined(_useTimer5)
 #if defined(SERVO_NEW_TIMER_CONTROL)
-void Timer5Service()
+TIMER_ISR(TIMER5_COMPA_vect)
+{
+  PROFILE_ENTER();
+  if (timersSeized & (1 << _timer5))
+    handle_interrupts(_timer5, &TCNT5, &OCR5A);
+  else
+    Timer5.dispatch(INTERRUPT_COMPARE_MATCH_A);
+  PROFILE_EXIT(PROFILE_TIMER5_COMPA);
+}
 #else
 ISR(TIMER5_COMPA_vect)
-#endif
 {
   handle_interrupts(_timer5, &TCNT5, &OCR5A);
 }
 #endif
+#endif
 
 
 static void initISR(timer16_Sequence_t timer)
@@ -198,7 +272,8 @@ static void initISR(timer16_Sequence_t timer)
 #endif
 
 #if defined(SERVO_NEW_TIMER_CONTROL)
-    Timer1.attachInterrupt(INTERRUPT_COMPARE_MATCH_A, Timer1Service);
+    timersSeized |= (1 << _timer1);
+    Timer1.enableInterrupt(INTERRUPT_COMPARE_MATCH_A);
 #else
 #if defined(TIMSK)
     TIMSK |= (1 << OCIE1A);   // enable the output compare interrupt
@@ -228,7 +303,8 @@ static void initISR(timer16_Sequence_t timer)
 #endif
 
 #if defined(SERVO_NEW_TIMER_CONTROL)
-    Timer3.attachInterrupt(INTERRUPT_COMPARE_MATCH_A, Timer3Service);
+    timersSeized |= (1 << _timer3);
+    Timer3.enableInterrupt(INTERRUPT_COMPARE_MATCH_A);
 #else
 #if defined(ETIMSK)
     ETIMSK |= (1 << OCIE3A);   // enable the output compare interrupt
@@ -258,7 +334,8 @@ static void initISR(timer16_Sequence_t timer)
 #endif
 
 #if defined(SERVO_NEW_TIMER_CONTROL)
-    Timer4.attachInterrupt(INTERRUPT_COMPARE_MATCH_A, Timer4Service);
+    timersSeized |= (1 << _timer4);
+    Timer4.enableInterrupt(INTERRUPT_COMPARE_MATCH_A);
 #else
 #if defined(ETIMSK)
     ETIMSK |= (1 << OCIE4A);   // enable the output compare interrupt
@@ -288,7 +365,8 @@ static void initISR(timer16_Sequence_t timer)
 #endif
 
 #if defined(SERVO_NEW_TIMER_CONTROL)
-    Timer5.attachInterrupt(INTERRUPT_COMPARE_MATCH_A, Timer5Service);
+    timersSeized |= (1 << _timer5);
+    Timer5.enableInterrupt(INTERRUPT_COMPARE_MATCH_A);
 #else
 #if defined(ETIMSK)
     ETIMSK |= (1 << OCIE5A);   // enable the output compare interrupt
@@ -308,7 +386,8 @@ static void finISR(timer16_Sequence_t timer)
   if (timer == _timer1)
   {
 #if defined(SERVO_NEW_TIMER_CONTROL)
-    Timer1.detachInterrupt(INTERRUPT_COMPARE_MATCH_A);
+    Timer1.disableInterrupt(INTERRUPT_COMPARE_MATCH_A);
+    timersSeized &= ~(1 << _timer1);
 #else
 #if defined(TIMSK)
     TIMSK &= ~(1 << OCIE1A);
@@ -323,7 +402,8 @@ static void finISR(timer16_Sequence_t timer)
   if (timer == _timer3)
   {
 #if defined(SERVO_NEW_TIMER_CONTROL)
-    Timer3.detachInterrupt(INTERRUPT_COMPARE_MATCH_A);
+    Timer3.disableInterrupt(INTERRUPT_COMPARE_MATCH_A);
+    timersSeized &= ~(1 << _timer3);
 #else
 #if defined(ETIMSK)
     ETIMSK &= ~(1 << OCIE3A);
@@ -338,7 +418,8 @@ static void finISR(timer16_Sequence_t timer)
   if (timer == _timer4)
   {
 #if defined(SERVO_NEW_TIMER_CONTROL)
-    Timer4.detachInterrupt(INTERRUPT_COMPARE_MATCH_A);
+    Timer4.disableInterrupt(INTERRUPT_COMPARE_MATCH_A);
+    timersSeized &= ~(1 << _timer4);
 #else
 #if defined(ETIMSK)
     ETIMSK &= ~(1 << OCIE4A);
@@ -353,7 +434,8 @@ static void finISR(timer16_Sequence_t timer)
   if (timer == _timer5)
   {
 #if defined(SERVO_NEW_TIMER_CONTROL)
-    Timer5.detachInterrupt(INTERRUPT_COMPARE_MATCH_A);
+    Timer5.disableInterrupt(INTERRUPT_COMPARE_MATCH_A);
+    timersSeized &= ~(1 << _timer5);
 #else
 #if defined(ETIMSK)
     ETIMSK &= ~(1 << OCIE5A);
@@ -366,11 +448,140 @@ static void finISR(timer16_Sequence_t timer)
 
 }
 
+#if defined(SERVO_NEW_TIMER_CONTROL)
+// The timer and output compare channel behind a pin, if it is one of the
+// 16 bit timers Servo uses.
+static bool outputCompareOf(uint8_t pin, timer16_Sequence_t *timer, uint8_t *channel)
+{
+  uint8_t pinTimer = digitalPinToTimer(pin);
+
+  switch (pinTimer)
+  {
+#if defined(_useTimer1)
+    case TIMER1A:
+    case TIMER1B:
+    case TIMER1C:
+      *timer = _timer1;
+      *channel = pinTimer - TIMER1A;
+      return true;
+#endif
+#if defined(_useTimer3)
+    case TIMER3A:
+    case TIMER3B:
+    case TIMER3C:
+      *timer = _timer3;
+      *channel = pinTimer - TIMER3A;
+      return true;
+#endif
+#if defined(_useTimer4)
+    case TIMER4A:
+    case TIMER4B:
+    case TIMER4C:
+      *timer = _timer4;
+      *channel = pinTimer - TIMER4A;
+      return true;
+#endif
+#if defined(_useTimer5)
+    case TIMER5A:
+    case TIMER5B:
+    case TIMER5C:
+      *timer = _timer5;
+      *channel = pinTimer - TIMER5A;
+      return true;
+#endif
+    default:
+      return false;
+  }
+}
+
+
+// The timer with its ICRn and OCRnA (OCRnB and OCRnC follow it).
+static HardwareTimer *hardwareTimer(timer16_Sequence_t timer,
+                                    volatile uint16_t **ICRn,
+                                    volatile uint16_t **OCRnA)
+{
+#if defined(_useTimer1)
+  if (timer == _timer1)
+  {
+    *ICRn = &ICR1;
+    *OCRnA = &OCR1A;
+    return &Timer1;
+  }
+#endif
+#if defined(_useTimer3)
+  if (timer == _timer3)
+  {
+    *ICRn = &ICR3;
+    *OCRnA = &OCR3A;
+    return &Timer3;
+  }
+#endif
+#if defined(_useTimer4)
+  if (timer == _timer4)
+  {
+    *ICRn = &ICR4;
+    *OCRnA = &OCR4A;
+    return &Timer4;
+  }
+#endif
+#if defined(_useTimer5)
+  if (timer == _timer5)
+  {
+    *ICRn = &ICR5;
+    *OCRnA = &OCR5A;
+    return &Timer5;
+  }
+#endif
+  return NULL;
+}
+
+
+// Hands the output compare pin of the channel to the timer, starting
+// the timer with its first channel.  Returns the OCRnx of the channel.
+static volatile uint16_t *initHardware(timer16_Sequence_t timer, uint8_t channel)
+{
+  volatile uint16_t *ICRn, *OCRnA;
+  HardwareTimer *t = hardwareTimer(timer, &ICRn, &OCRnA);
+  uint8_t oldSREG;
+
+  if (hardwareChannels[timer] == 0)
+  {
+    t->stop();
+    t->setMode(0b1110);       // fast PWM, TOP = ICRn
+    oldSREG = SREG;
+    cli();
+    *ICRn = usToTicks(REFRESH_INTERVAL) - 1;
+    SREG = oldSREG;
+    t->setCounter(0);
+    t->setClockSource(CLOCK_PRESCALE_8);
+  }
+
+  hardwareChannels[timer] |= (1 << channel);
+  t->setOutputMode(channel, 0b10);  // set at BOTTOM, cleared on compare match
+
+  return OCRnA + channel;
+}
+
+
+static void finHardware(timer16_Sequence_t timer, uint8_t channel)
+{
+  volatile uint16_t *ICRn, *OCRnA;
+  HardwareTimer *t = hardwareTimer(timer, &ICRn, &OCRnA);
+
+  t->setOutputMode(channel, 0);     // the pin goes back to its port
+  hardwareChannels[timer] &= ~(1 << channel);
+
+  if (hardwareChannels[timer] == 0)
+    t->stop();
+}
+#endif
+
+
 static uint8_t isTimerActive(timer16_Sequence_t timer)
 {
-  // returns true if any servo is active on this timer
+  // returns true if any servo is pulsed by the interrupt of this timer
   for (uint8_t channel = 0; channel < SERVOS_PER_TIMER; channel++)
-    if (SERVO(timer,channel).Pin.isActive == true)
+    if (SERVO(timer,channel).mask != 0)
       return true;
 
   return false;
@@ -386,7 +597,7 @@ Servo::Servo()
     // assign a servo index to this instance
     this->servoIndex = ServoCount++;
     // store default values
-    servos[this->servoIndex].ticks = usToTicks(DEFAULT_PULSE_WIDTH);
+    servos[this->servoIndex].ticks = usToTicks(DEFAULT_PULSE_WIDTH - TRIM_DURATION);
   }
   else
     this->servoIndex = INVALID_SERVO ;  // too many servos
@@ -401,28 +612,116 @@ uint8_t Servo::attach(uint8_t pin, uint16_t min, uint16_t max)
 {
   if (this->servoIndex < MAX_SERVOS )
   {
+    servo_t *servo = &servos[this->servoIndex];
+    timer16_Sequence_t timer = SERVO_INDEX_TO_TIMER(servoIndex);
+
+    this->detach();
+#if defined(SERVO_NEW_TIMER_CONTROL)
+    // the timer is making hardware pulses
+    if (hardwareChannels[timer] != 0)
+      return INVALID_SERVO;
+#endif
+    if (digitalPinToPortReg(pin) == NOT_A_REG)
+      return INVALID_SERVO;
+
     // set servo pin to output
     pinMode(pin, OUTPUT);
-    servos[this->servoIndex].Pin.nbr = pin;
+    servo->Pin.nbr = pin;
 
     // todo min/max check: abs(min - MIN_PULSE_WIDTH) /4 < 128
     this->min = (MIN_PULSE_WIDTH - min) / 4; //resolution of min/max is 4 uS
     this->max = (MAX_PULSE_WIDTH - max) / 4;
 
     // initialize the timer if it has not already been initialized
-    timer16_Sequence_t timer = SERVO_INDEX_TO_TIMER(servoIndex);
     if (isTimerActive(timer) == false)
       initISR(timer);
 
     // this must be set after the check for isTimerActive
-    servos[this->servoIndex].Pin.isActive = true;
+    uint8_t oldSREG = SREG;
+    cli();
+    servo->port = digitalPinToPortReg(pin);
+    servo->mask = digitalPinToBitMask(pin);
+    servo->Pin.isActive = true;
+    SREG = oldSREG;
   }
   return this->servoIndex;
 }
 
+uint8_t Servo::attachHardware(uint8_t pin)
+{
+  return this->attachHardware(pin, MIN_PULSE_WIDTH, MAX_PULSE_WIDTH);
+}
+
+uint8_t Servo::attachHardware(uint8_t pin, uint16_t min, uint16_t max)
+{
+#if defined(SERVO_NEW_TIMER_CONTROL)
+  timer16_Sequence_t timer;
+  uint8_t channel;
+  servo_t *servo;
+
+  if (this->servoIndex >= MAX_SERVOS)
+    return INVALID_SERVO;
+
+  servo = &servos[this->servoIndex];
+  this->detach();
+
+  // not an output compare pin, its timer is pulsing servos from its
+  // interrupt, or another servo has the pin
+  if (!outputCompareOf(pin, &timer, &channel) ||
+      (timersSeized & (1 << timer)) ||
+      (hardwareChannels[timer] & (1 << channel)))
+    return INVALID_SERVO;
+
+  pinWrite(pin, LOW);
+  pinMode(pin, OUTPUT);
+  servo->Pin.nbr = pin;
+
+  this->min = (MIN_PULSE_WIDTH - min) / 4;
+  this->max = (MAX_PULSE_WIDTH - max) / 4;
+
+  servo->ocr = initHardware(timer, channel);
+  servo->Pin.isHardware = true;
+  servo->Pin.isActive = true;
+  this->writeMicroseconds(this->readMicroseconds());
+
+  return this->servoIndex;
+#else
+  return INVALID_SERVO;
+#endif
+}
+
 void Servo::detach()
 {
-  servos[this->servoIndex].Pin.isActive = false;
+  servo_t *servo;
+  uint8_t oldSREG = SREG;
+
+  if (this->servoIndex >= MAX_SERVOS || servos[this->servoIndex].Pin.isActive == false)
+    return;
+
+  servo = &servos[this->servoIndex];
+
+  cli();
+  servo->Pin.isActive = false;
+  if (servo->mask)
+  {
+    *servo->port &= ~servo->mask;   // in case it is in the middle of a pulse
+    servo->mask = 0;
+  }
+  SREG = oldSREG;
+
+#if defined(SERVO_NEW_TIMER_CONTROL)
+  if (servo->Pin.isHardware)
+  {
+    timer16_Sequence_t timer;
+    uint8_t channel;
+
+    servo->Pin.isHardware = false;
+    if (outputCompareOf(servo->Pin.nbr, &timer, &channel))
+      finHardware(timer, channel);
+    return;
+  }
+#endif
+
   timer16_Sequence_t timer = SERVO_INDEX_TO_TIMER(servoIndex);
 
   if (isTimerActive(timer) == false)
@@ -463,6 +762,10 @@ void Servo::writeMicroseconds(uint16_t value)
     uint8_t oldSREG = SREG;
     cli();
     servos[channel].ticks = value;
+    // in hardware mode the pin is high from BOTTOM through the match, and
+    // the new OCRnx takes effect from the next period
+    if (servos[channel].Pin.isHardware)
+      *servos[channel].ocr = value + usToTicks(TRIM_DURATION) - 1;
     SREG = oldSREG;
   }
 }
@@ -3,6 +3,7 @@
 || @author         Brett Hagman <bhagman@roguerobotics.com>
 || @url            http://wiring.org.co/
 || @contribution   Michael Margolis
+|| @contribution   Camilo Reyes <creyes@wiring.org.co>
 ||
 || @description
 || | Interrupt driven Servo library using 16 bit timers.
@@ -34,11 +35,17 @@
 typedef struct  {
   uint8_t nbr        :6 ;             // a pin number from 0 to 63
   uint8_t isActive   :1 ;             // true if this channel is enabled, pin not pulsed if false
+  uint8_t isHardware :1 ;             // true if the pin is pulsed by its timer's output compare
 } ServoPin_t   ;
 
 typedef struct {
   ServoPin_t Pin;
   uint16_t ticks;
+  union {
+    volatile uint8_t *port;           // output register of the pin, pulsed by the interrupt
+    volatile uint16_t *ocr;           // OCRnx of the pin, for a hardware servo
+  };
+  uint8_t mask;                       // bit of the pin in port, 0 if not pulsed by the interrupt
 } servo_t;
 
 class Servo
@@ -47,6 +54,8 @@ class Servo
     Servo();
     uint8_t attach(uint8_t pin);       // attach the given pin to the next free channel, sets pinMode, returns channel number or 0 if failure
     uint8_t attach(uint8_t pin, uint16_t min, uint16_t max); // as above but also sets min and max values for writes.
+    uint8_t attachHardware(uint8_t pin); // attach to an output compare pin, pulsed by the timer itself, returns INVALID_SERVO if failure
+    uint8_t attachHardware(uint8_t pin, uint16_t min, uint16_t max); // as above but also sets min and max values for writes.
     void detach();
     void write(uint16_t value);        // if value is < 200 its treated as an angle, otherwise as pulse width in microseconds
     void writeMicroseconds(uint16_t value); // Write pulse width in microseconds
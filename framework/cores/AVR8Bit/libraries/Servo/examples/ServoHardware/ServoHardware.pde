@@ -0,0 +1,31 @@
+/**
+ * Hardware servos
+ * by Camilo Reyes <creyes@wiring.org.co>
+ *
+ * Drives two servo motors from the output compare pins of Timer 1
+ * (pins 29 and 30 on Wiring v1.1), so the timer makes the pulses itself
+ * and they stay steady whatever interrupts the sketch uses.  It sweeps
+ * them in opposite directions.
+ */
+
+#include <Servo.h>
+
+Servo myservo0;  // create servo object to control a servo
+Servo myservo1;  // create another servo object to control another servo
+
+int angle = 0;
+
+void setup()
+{
+  myservo0.attachHardware(29);  // OC1A
+  myservo1.attachHardware(30);  // OC1B
+}
+
+
+void loop()
+{
+  myservo0.write(angle);
+  myservo1.write(180 - angle);
+  angle = (angle + 1) % 181;
+  delay(15);            // wait for the servos to get there
+}
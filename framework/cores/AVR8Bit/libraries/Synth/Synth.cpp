@@ -0,0 +1,425 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Wavetable synthesizer.
+|| |
+|| | Wiring Core Library
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+|| @notes
+|| | Each voice steps a 16 bit phase through its wavetable (the top 8
+|| | bits index it), so the frequency resolution is the sample rate /
+|| | 65536 (under 0.5 Hz at 31.25 kHz).  A sample costs a table read and
+|| | an 8 x 8 bit multiply per sounding voice (silent voices are
+|| | skipped), and two more to scale the mix to the PWM duty.
+|| |
+|| | The timer runs fast PWM with TOP = ICRn, and its overflow interrupt
+|| | (at TOP) writes the next sample into OCRnx, which the timer takes up
+|| | at BOTTOM, so every period carries exactly one sample.  The
+|| | synthesizer replaces the overflow handlers of the 16 bit timers
+|| | (TIMER_ISR()); on the timers it isn't using, they call the functions
+|| | attached to them as usual.
+|| #
+*/
+
+#include "Synth.h"
+
+WSynth Synth;
+
+static SynthVoice voices[SYNTH_VOICES];
+
+// The timer (its number, 0 when stopped) and channel driving the pin
+static volatile uint8_t owner;
+static HardwareTimer *timer;
+static uint8_t channel;
+
+static volatile uint16_t *output;     // OCRnx of the pin
+static uint8_t scaleHigh;             // TOP + 1, the full scale duty,
+static uint8_t scaleLow;              // in bytes
+static uint8_t controlSamples;        // samples per control step (1 ms)
+static uint8_t controlCount;
+
+
+/************ static functions common to all instances ***********************/
+
+// One control step of the envelope of a voice.
+static inline void envelope(SynthVoice *v)
+{
+  uint16_t target;
+
+  switch (v->stage)
+  {
+    case SYNTH_ATTACK:
+      if (v->level >= 0xFFFF - v->attack)
+      {
+        v->level = 0xFFFF;
+        v->stage = SYNTH_DECAY;
+      }
+      else
+        v->level += v->attack;
+      break;
+
+    case SYNTH_DECAY:
+      target = v->sustain * 257;
+      if ((uint16_t)(v->level - target) <= v->decay)
+      {
+        v->level = target;
+        v->stage = SYNTH_SUSTAIN;
+      }
+      else
+        v->level -= v->decay;
+      break;
+
+    case SYNTH_RELEASE:
+      if (v->level <= v->release)
+      {
+        v->level = 0;
+        v->stage = SYNTH_IDLE;
+      }
+      else
+        v->level -= v->release;
+      break;
+  }
+
+  v->amplitude = ((v->level >> 8) * (v->volume + 1)) >> 8;
+}
+
+
+static inline void mix(void)
+{
+  SynthVoice *v = voices;
+  int16_t sum = 0;
+  uint8_t sample;
+  uint8_t i;
+
+  for (i = 0; i < SYNTH_VOICES; i++, v++)
+  {
+    if (v->amplitude == 0)
+      continue;
+    v->phase += v->step;
+    sum += ((int8_t)pgm_read_byte(v->wave + (v->phase >> 8)) * v->amplitude) >> 8;
+  }
+
+  sum >>= SYNTH_HEADROOM;
+  if (sum > 127)
+    sum = 127;
+  else if (sum < -128)
+    sum = -128;
+  // sample * (TOP + 1) / 256, in two 8 x 8 bit multiplies
+  sample = sum + 128;
+  *output = (uint16_t)sample * scaleHigh + (((uint16_t)sample * scaleLow) >> 8);
+
+  if (--controlCount == 0)
+  {
+    controlCount = controlSamples;
+    for (i = 0; i < SYNTH_VOICES; i++)
+      envelope(&voices[i]);
+  }
+}
+
+
+TIMER_ISR(TIMER1_OVF_vect)
+{
+  PROFILE_ENTER();
+  if (owner == 1)
+    mix();
+  else
+    Timer1.dispatch(INTERRUPT_OVERFLOW);
+  PROFILE_EXIT(PROFILE_TIMER1_OVF);
+}
+
+#if (NUM_16BIT_TIMERS > 1)
+TIMER_ISR(TIMER3_OVF_vect)
+{
+  PROFILE_ENTER();
+  if (owner == 3)
+    mix();
+  else
+    Timer3.dispatch(INTERRUPT_OVERFLOW);
+  PROFILE_EXIT(PROFILE_TIMER3_OVF);
+}
+#endif
+
+#if (NUM_16BIT_TIMERS > 2)
+TIMER_ISR(TIMER4_OVF_vect)
+{
+  PROFILE_ENTER();
+  if (owner == 4)
+    mix();
+  else
+    Timer4.dispatch(INTERRUPT_OVERFLOW);
+  PROFILE_EXIT(PROFILE_TIMER4_OVF);
+}
+
+TIMER_ISR(TIMER5_OVF_vect)
+{
+  PROFILE_ENTER();
+  if (owner == 5)
+    mix();
+  else
+    Timer5.dispatch(INTERRUPT_OVERFLOW);
+  PROFILE_EXIT(PROFILE_TIMER5_OVF);
+}
+#endif
+
+
+// Level change per control step to cover the whole range in ms.
+static uint16_t stepFor(uint16_t range, uint16_t ms)
+{
+  if (ms == 0)
+    return range ? range : 1;
+
+  return range / ms ? range / ms : 1;
+}
+
+
+/****************** end of static functions ******************************/
+
+WSynth::WSynth()
+{
+  uint8_t i;
+
+  rate = SYNTH_SAMPLE_RATE;
+  for (i = 0; i < SYNTH_VOICES; i++)
+  {
+    setWave(i, synthSine);
+    setVolume(i, 255);
+    setEnvelope(i, 0, 0, 255, 0);
+  }
+}
+
+
+bool WSynth::begin(uint8_t pin, uint16_t sampleRate)
+{
+  uint8_t pinTimer = digitalPinToTimer(pin);
+  volatile uint16_t *ICRn;
+  volatile uint16_t *OCRnA;
+  uint8_t number;
+  uint32_t top;
+  uint8_t oldSREG;
+
+  if (sampleRate == 0)
+    return false;
+  top = F_CPU / sampleRate - 1;
+  if (top < 255 || top > 0xFFFE)
+    return false;
+
+  switch (pinTimer)
+  {
+    case TIMER1A:
+    case TIMER1B:
+    case TIMER1C:
+      end();
+      timer = &Timer1;
+      number = 1;
+      ICRn = &ICR1;
+      OCRnA = &OCR1A;
+      channel = pinTimer - TIMER1A;
+      break;
+#if (NUM_16BIT_TIMERS > 1)
+    case TIMER3A:
+    case TIMER3B:
+    case TIMER3C:
+      end();
+      timer = &Timer3;
+      number = 3;
+      ICRn = &ICR3;
+      OCRnA = &OCR3A;
+      channel = pinTimer - TIMER3A;
+      break;
+#endif
+#if (NUM_16BIT_TIMERS > 2)
+    case TIMER4A:
+    case TIMER4B:
+    case TIMER4C:
+      end();
+      timer = &Timer4;
+      number = 4;
+      ICRn = &ICR4;
+      OCRnA = &OCR4A;
+      channel = pinTimer - TIMER4A;
+      break;
+    case TIMER5A:
+    case TIMER5B:
+    case TIMER5C:
+      end();
+      timer = &Timer5;
+      number = 5;
+      ICRn = &ICR5;
+      OCRnA = &OCR5A;
+      channel = pinTimer - TIMER5A;
+      break;
+#endif
+    default:
+      return false;
+  }
+
+  rate = sampleRate;
+  scaleHigh = (top + 1) >> 8;
+  scaleLow = top + 1;
+  controlSamples = (sampleRate + 500) / 1000;
+  controlCount = controlSamples;
+  output = OCRnA + channel;
+
+  pinWrite(pin, LOW);
+  pinMode(pin, OUTPUT);
+
+  timer->stop();
+  timer->setMode(0b1110);               // fast PWM, TOP = ICRn
+  oldSREG = SREG;
+  cli();
+  *ICRn = top;
+  *output = (top + 1) / 2;              // silence
+  SREG = oldSREG;
+  timer->setCounter(0);
+  timer->setOutputMode(channel, 0b10);  // set at BOTTOM, cleared on compare match
+
+  owner = number;
+  timer->enableInterrupt(INTERRUPT_OVERFLOW);
+  timer->setClockSource(CLOCK_NO_PRESCALE);
+
+  return true;
+}
+
+
+void WSynth::end(void)
+{
+  if (owner == 0)
+    return;
+
+  timer->disableInterrupt(INTERRUPT_OVERFLOW);
+  timer->setOutputMode(channel, 0);
+  timer->stop();
+  owner = 0;
+}
+
+
+void WSynth::setWave(uint8_t voice, const int8_t *wave)
+{
+  uint8_t oldSREG = SREG;
+
+  if (voice >= SYNTH_VOICES)
+    return;
+
+  cli();
+  voices[voice].wave = wave;
+  SREG = oldSREG;
+}
+
+
+void WSynth::setEnvelope(uint8_t voice, uint16_t attack, uint16_t decay,
+                         uint8_t sustain, uint16_t release)
+{
+  SynthVoice *v;
+  uint8_t oldSREG = SREG;
+
+  if (voice >= SYNTH_VOICES)
+    return;
+
+  v = &voices[voice];
+  cli();
+  v->attack = stepFor(0xFFFF, attack);
+  v->decay = stepFor(0xFFFF - sustain * 257, decay);
+  v->sustain = sustain;
+  v->release = stepFor(0xFFFF, release);
+  SREG = oldSREG;
+}
+
+
+void WSynth::setVolume(uint8_t voice, uint8_t volume)
+{
+  uint8_t oldSREG = SREG;
+
+  if (voice >= SYNTH_VOICES)
+    return;
+
+  cli();
+  voices[voice].volume = volume;
+  SREG = oldSREG;
+}
+
+
+void WSynth::noteOn(uint8_t voice, uint16_t frequency)
+{
+  SynthVoice *v;
+  uint16_t step;
+  uint8_t oldSREG = SREG;
+
+  if (voice >= SYNTH_VOICES)
+    return;
+
+  v = &voices[voice];
+  step = ((uint32_t)frequency << 16) / rate;
+
+  // from the level it is at, if it is still sounding
+  cli();
+  v->step = step;
+  v->stage = SYNTH_ATTACK;
+  envelope(v);
+  SREG = oldSREG;
+}
+
+
+void WSynth::noteOff(uint8_t voice)
+{
+  uint8_t oldSREG = SREG;
+
+  if (voice >= SYNTH_VOICES)
+    return;
+
+  cli();
+  if (voices[voice].stage != SYNTH_IDLE)
+    voices[voice].stage = SYNTH_RELEASE;
+  SREG = oldSREG;
+}
+
+
+int8_t WSynth::play(uint16_t frequency)
+{
+  int8_t voice = -1;
+  uint16_t quietest = 0xFFFF;
+  uint8_t oldSREG = SREG;
+  uint8_t i;
+
+  cli();
+  for (i = 0; i < SYNTH_VOICES; i++)
+  {
+    if (voices[i].stage == SYNTH_IDLE)
+    {
+      voice = i;
+      break;
+    }
+    if (voices[i].stage == SYNTH_RELEASE && voices[i].level <= quietest)
+    {
+      voice = i;
+      quietest = voices[i].level;
+    }
+  }
+  SREG = oldSREG;
+
+  if (voice >= 0)
+    noteOn(voice, frequency);
+
+  return voice;
+}
+
+
+bool WSynth::playing(uint8_t voice)
+{
+  uint8_t oldSREG = SREG;
+  bool sounding;
+
+  if (voice >= SYNTH_VOICES)
+    return false;
+
+  cli();
+  sounding = (voices[voice].stage != SYNTH_IDLE);
+  SREG = oldSREG;
+
+  return sounding;
+}
@@ -0,0 +1,117 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Wavetable synthesizer.
+|| |
+|| | Mixes SYNTH_VOICES voices, each playing a wavetable from program
+|| | memory at its own frequency, through its own envelope (attack,
+|| | decay, sustain, release) and volume.  The mix goes out as the duty
+|| | cycle of a fast PWM pin, one sample per PWM period, so a single
+|| | timer interrupt at the sample rate does all the work, however many
+|| | voices play.  A low pass filter on the pin (e.g. 1k and 10nF) turns
+|| | it into audio.
+|| |
+|| | The pin must be an output compare pin (OCnA/B/C) of a 16 bit timer;
+|| | the timer runs at the CPU clock with TOP (ICRn) setting the sample
+|| | rate, so it is not available for anything else (tone(), Servo or
+|| | other PWM on it) while the synthesizer runs.  The sample rate can be
+|| | anything up to F_CPU / 256 (62.5 kHz at 16 MHz), which keeps at
+|| | least 8 bits of PWM resolution.
+|| |
+|| | Frequencies are in Hz, envelope times in milliseconds.  The
+|| | envelopes and volumes are applied once a millisecond (the control
+|| | rate), not every sample.
+|| |
+|| | Wiring Core Library
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#ifndef SYNTH_H
+#define SYNTH_H
+
+#include <avr/pgmspace.h>
+#include <Wiring.h>
+
+// Voices mixed
+#ifndef SYNTH_VOICES
+#define SYNTH_VOICES 4
+#endif
+
+// Bits the mix is shifted down by: with 1, two voices at full volume
+// fit without clipping.  Louder mixes are clipped.
+#ifndef SYNTH_HEADROOM
+#define SYNTH_HEADROOM 1
+#endif
+
+#define SYNTH_SAMPLE_RATE 31250
+
+// Samples in a wavetable (one period, signed 8 bit)
+#define SYNTH_WAVE_SIZE 256
+
+extern const int8_t synthSine[SYNTH_WAVE_SIZE] PROGMEM;
+extern const int8_t synthTriangle[SYNTH_WAVE_SIZE] PROGMEM;
+extern const int8_t synthSawtooth[SYNTH_WAVE_SIZE] PROGMEM;
+extern const int8_t synthSquare[SYNTH_WAVE_SIZE] PROGMEM;
+
+// Envelope stages
+#define SYNTH_IDLE    0
+#define SYNTH_ATTACK  1
+#define SYNTH_DECAY   2
+#define SYNTH_SUSTAIN 3
+#define SYNTH_RELEASE 4
+
+typedef struct
+{
+  const int8_t *wave;
+  uint16_t phase;
+  uint16_t step;       // phase advance per sample
+  uint8_t amplitude;   // envelope times volume, 0 when silent
+  uint8_t volume;
+  uint8_t stage;
+  uint16_t level;      // envelope, full scale 0xFFFF
+  // level change per control step
+  uint16_t attack;
+  uint16_t decay;
+  uint16_t release;
+  uint8_t sustain;
+} SynthVoice;
+
+class WSynth
+{
+  public:
+    WSynth();
+
+    // Returns false if the pin is not an output compare pin of a 16 bit
+    // timer, or the sample rate is out of range.
+    bool begin(uint8_t pin, uint16_t sampleRate = SYNTH_SAMPLE_RATE);
+    void end(void);
+
+    // The wavetable (SYNTH_WAVE_SIZE samples in program memory), the
+    // envelope and the volume (0-255) of a voice.  By default, a sine
+    // at full volume, starting and stopping at once.
+    void setWave(uint8_t voice, const int8_t *wave);
+    void setEnvelope(uint8_t voice, uint16_t attack, uint16_t decay,
+                     uint8_t sustain, uint16_t release);
+    void setVolume(uint8_t voice, uint8_t volume);
+
+    void noteOn(uint8_t voice, uint16_t frequency);
+    void noteOff(uint8_t voice);
+    // Plays the frequency on an idle voice (or the quietest releasing
+    // one), returning the voice, or -1 if all are busy.
+    int8_t play(uint16_t frequency);
+    bool playing(uint8_t voice);
+
+  private:
+    uint16_t rate;
+};
+
+extern WSynth Synth;
+
+#endif
+// SYNTH_H
@@ -0,0 +1,50 @@
+/**
+ * Chords
+ * by Camilo Reyes <creyes@wiring.org.co>
+ *
+ * Plays a progression of three note chords on the synthesizer, each
+ * note a triangle wave fading in and out.  The sound comes out of
+ * pin 29 (OC1A on Wiring v1.1): put a 1k resistor and a 10nF
+ * capacitor to ground on it as a filter, and an amplifier after that.
+ */
+
+#include <Synth.h>
+
+// C major, A minor, F major, G major (Hz)
+uint16_t chords[][3] =
+{
+  { 262, 330, 392 },
+  { 220, 262, 330 },
+  { 175, 220, 262 },
+  { 196, 247, 294 }
+};
+
+uint8_t chord = 0;
+
+void setup()
+{
+  uint8_t i;
+
+  Synth.begin(29);
+  for (i = 0; i < 3; i++)
+  {
+    Synth.setWave(i, synthTriangle);
+    Synth.setEnvelope(i, 20, 200, 160, 300);  // attack, decay, sustain, release
+  }
+}
+
+
+void loop()
+{
+  uint8_t i;
+
+  for (i = 0; i < 3; i++)
+    Synth.noteOn(i, chords[chord][i]);
+  delay(800);
+
+  for (i = 0; i < 3; i++)
+    Synth.noteOff(i);
+  delay(400);
+
+  chord = (chord + 1) % 4;
+}
@@ -0,0 +1,290 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Tickless idle.
+|| |
+|| | Wiring Core Library
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#include "Tickless.h"
+
+// Parts with an asynchronous Timer 2.  On the ATmega128 (Wiring V1) the
+// asynchronous timer is Timer 0, which keeps millis(): sleep() can only
+// idle there.
+#if defined(ASSR) && defined(AS2) && defined(TCCR2A) && defined(TIMSK2)
+#define TICKLESS_TIMER2
+#else
+#warning "Tickless: no asynchronous Timer 2 on this part, sleep() only idles"
+#endif
+
+#if defined(TICKLESS_TIMER2)
+#define TIMER0_OVERFLOW_CYCLES (TIMER0PRESCALEFACTOR * 256UL)
+
+// CPU cycles per Timer 2 tick (whole cycles)
+#define TICK_CYCLES (F_CPU >> 10)
+#endif
+
+
+WTickless::WTickless()
+{
+  deepest = SLEEP_POWER_SAVE;
+}
+
+
+bool WTickless::begin(void)
+{
+#if defined(TICKLESS_TIMER2)
+  uint8_t oldSREG = SREG;
+
+  // Timer 2 driving a PWM output (analogWrite() on its pins) is left
+  // alone.
+  if (!active && (TCCR2A & ((1 << COM2A1) | (1 << COM2A0) | (1 << COM2B1) | (1 << COM2B0))))
+    return false;
+
+  // Switching Timer 2 to the crystal may corrupt its registers, so they
+  // are all set up again, and the interrupts only enabled once the
+  // updates have gone through.
+  cli();
+  TIMSK2 = 0;
+  ASSR |= (1 << AS2);
+  TCNT2 = 0;
+  OCR2A = 0xFF;
+  TCCR2A = 0;                             // normal mode
+  TCCR2B = (1 << CS21) | (1 << CS20);     // 32768 Hz / 32
+  while (ASSR & ((1 << TCN2UB) | (1 << OCR2AUB) | (1 << TCR2AUB) | (1 << TCR2BUB)));
+  TIFR2 = (1 << OCF2B) | (1 << OCF2A) | (1 << TOV2);
+  SREG = oldSREG;
+
+  // The compare match interrupt only has to wake the CPU up.
+  Timer2.enableInterrupt(INTERRUPT_COMPARE_MATCH_A);
+  active = true;
+
+  cli();
+  referenceTicks = TCNT2;
+  referenceCycles = clockCycles();
+  SREG = oldSREG;
+#endif
+
+  fraction = 0;
+  resetStatistics();
+  return active;
+}
+
+
+void WTickless::end(void)
+{
+#if defined(TICKLESS_TIMER2)
+  if (!active)
+    return;
+
+  Timer2.disableInterrupt(INTERRUPT_COMPARE_MATCH_A);
+  ASSR &= ~(1 << AS2);
+  active = false;
+#endif
+}
+
+
+// Sleep until ms have passed, or an interrupt.  The sleep may end a
+// little early (the deadline is rounded down to Timer 2 ticks), and is
+// at most 248 ms, so the caller works out how long is left, and sleeps
+// again.
+void WTickless::sleep(unsigned long ms)
+{
+  uint8_t mode = deepest;
+  uint8_t ticks = 0;
+#if defined(TICKLESS_TIMER2)
+  uint8_t first = 0;
+  uint8_t now;
+#endif
+
+  if (ms == 0)
+    return;
+
+#if defined(TICKLESS_TIMER2)
+  // 1024 ticks per 1000 ms; the counter could move on before a compare
+  // value 1 tick ahead takes effect, so shorter sleeps are left to idle
+  // mode, which the Timer 0 interrupt ends every millisecond.
+  if (active)
+    ticks = (ms >= 248) ? 254 : (uint8_t)((ms * 128) / 125);
+#endif
+
+  if (mode != SLEEP_IDLE && clkIONeeded())
+    mode = SLEEP_IDLE;
+
+  cli();
+#if defined(TICKLESS_TIMER2)
+  if (active)
+  {
+    first = TCNT2;
+    // Timer 2 wraps around every 250 ms: after a long time awake, start
+    // over from here, and in any case wake up before it wraps around
+    // from the reference point.
+    if ((int32_t)(clockCycles() - referenceCycles) >= (int32_t)(128 * TICK_CYCLES))
+    {
+      referenceTicks = first;
+      referenceCycles = clockCycles();
+    }
+    if (ticks > 250 - (uint8_t)(first - referenceTicks))
+      ticks = 250 - (uint8_t)(first - referenceTicks);
+    if (ticks >= 2 && mode != SLEEP_IDLE)
+    {
+      // The update of OCR2A takes up to two TOSC1 cycles, over a Timer 0
+      // overflow: wait for it with interrupts on.  Too late by then,
+      // and it is an idle sleep after all.
+      OCR2A = first + ticks;
+      sei();
+      while (ASSR & (1 << OCR2AUB));
+      cli();
+      TIFR2 = (1 << OCF2A);
+      if ((uint8_t)(first + ticks - TCNT2 - 1) >= ticks)
+        ticks = 0;
+    }
+  }
+#endif
+  if (ticks < 2)
+    mode = SLEEP_IDLE;
+
+  sleepMode(mode);
+  enableSleep();
+  sei();
+  startSleep();
+  disableSleep();
+
+#if defined(TICKLESS_TIMER2)
+  if (active)
+  {
+    // After power save, TCNT2 only reads right once a TOSC1 cycle has
+    // passed: an update of TCCR2A takes one.
+    if (mode != SLEEP_IDLE)
+    {
+      TCCR2A = 0;
+      while (ASSR & (1 << TCR2AUB));
+    }
+
+    cli();
+    now = TCNT2;
+    if (mode != SLEEP_IDLE)
+      timer0CatchUp(now);
+    sei();
+
+    sleepTicks += (uint8_t)(now - first);
+  }
+#endif
+
+  sleepCount++;
+}
+
+
+#if defined(TICKLESS_TIMER2)
+// Timer 0 is stopped in every sleep mode but idle: hand the CPU cycles
+// it missed to millis() and micros(), in whole Timer 0 overflows.  What
+// it missed is the Timer 2 time since the reference point, less what
+// Timer 0 counted itself (awake, before and after the sleep); measuring
+// from one reference point to the next, the rounding to Timer 2 ticks
+// and Timer 0 overflows is carried over, not lost.  Called with
+// interrupts disabled.
+void WTickless::timer0CatchUp(uint8_t now)
+{
+  uint8_t ticks = now - referenceTicks;
+  uint32_t f = fraction + (uint32_t)ticks * (F_CPU & 1023);
+  uint32_t clock = clockCycles();
+  int32_t behind = (int32_t)((uint32_t)ticks * TICK_CYCLES + (f >> 10) - (clock - referenceCycles));
+
+  fraction = f & 1023;
+  if (behind >= (int32_t)TIMER0_OVERFLOW_CYCLES)
+    Wiring_Delay_Timer0_advance(behind / TIMER0_OVERFLOW_CYCLES);
+
+  // as if Timer 0 had been caught up to the cycle
+  referenceTicks = now;
+  referenceCycles = clock + behind;
+}
+#endif
+
+
+// Does anything need clkIO (stopped in every mode but idle)?
+bool WTickless::clkIONeeded(void)
+{
+  // a serial port with bytes left to send
+#if defined(UCSR0B)
+  if (UCSR0B & (1 << UDRIE0))
+    return true;
+#endif
+#if defined(UCSR1B)
+  if (UCSR1B & (1 << UDRIE1))
+    return true;
+#endif
+#if defined(UCSR2B)
+  if (UCSR2B & (1 << UDRIE2))
+    return true;
+#endif
+#if defined(UCSR3B)
+  if (UCSR3B & (1 << UDRIE3))
+    return true;
+#endif
+
+  // a conversion in progress, or free running (AnalogSampler)
+#if defined(ADCSRA)
+  if ((ADCSRA & (1 << ADEN)) && (ADCSRA & ((1 << ADSC) | (1 << ADATE))))
+    return true;
+#endif
+
+  // PWM outputs (COMnx bits), or timer interrupts other than the
+  // Timer 0 overflow (Servo, Tone, HardwareTimer)
+#if defined(TCCR0A) && defined(TIMSK0)
+  if ((TCCR0A & 0xF0) || (TIMSK0 & ~(1 << TOIE0)))
+    return true;
+#endif
+#if defined(TCCR1A) && defined(TIMSK1)
+  if ((TCCR1A & 0xFC) || TIMSK1)
+    return true;
+#endif
+#if defined(TCCR3A) && defined(TIMSK3)
+  if ((TCCR3A & 0xFC) || TIMSK3)
+    return true;
+#endif
+#if defined(TCCR4A) && defined(TIMSK4)
+  if ((TCCR4A & 0xFC) || TIMSK4)
+    return true;
+#endif
+#if defined(TCCR5A) && defined(TIMSK5)
+  if ((TCCR5A & 0xFC) || TIMSK5)
+    return true;
+#endif
+
+  return false;
+}
+
+
+unsigned long WTickless::sleepTime(void)
+{
+  return (sleepTicks >> 10) * 1000 + (((sleepTicks & 1023) * 1000) >> 10);
+}
+
+
+unsigned long WTickless::activeTime(void)
+{
+  unsigned long total = millis() - start;
+  unsigned long asleep = sleepTime();
+
+  return (total > asleep) ? total - asleep : 0;
+}
+
+
+void WTickless::resetStatistics(void)
+{
+  start = millis();
+  sleepTicks = 0;
+  sleepCount = 0;
+}
+
+
+// Preinstantiate Objects
+
+WTickless Tickless;
@@ -0,0 +1,94 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Tickless idle.
+|| |
+|| | Instead of spinning in loop() until the next thing is due, the main
+|| | loop sleeps until then, in the deepest sleep mode that is safe:
+|| |
+|| |   void loop()
+|| |   {
+|| |     scheduler.update();
+|| |     Tickless.sleep(scheduler.idleTime());
+|| |   }
+|| |
+|| | Timer 2 runs from a 32.768 kHz watch crystal on TOSC1/2, at 1024
+|| | ticks per second, and its compare match ends the sleep at the
+|| | deadline.  Any other interrupt ends it early: external interrupts
+|| | (attachInterrupt()), a byte received on a serial port, or pin
+|| | changes (wakeOnPinChange()).  Timer 0 is stopped in power save
+|| | mode, so millis() and micros() are moved on by the time slept.
+|| |
+|| | Power save is used unless a serial port is still transmitting, the
+|| | ADC is converting or one of the 16 bit timers is running (PWM,
+|| | Servo, Tone): those need clkIO, so idle mode is used instead.
+|| |
+|| | Timer 2 belongs to Tickless from begin() to end(): analogWrite()
+|| | must not be used on its PWM pins (TIMER2A and TIMER2B in
+|| | digitalPinToTimer()) meanwhile, and begin() fails while one is in
+|| | use.  Parts without an asynchronous Timer 2 (the ATmega128 of
+|| | Wiring V1, whose asynchronous timer is Timer 0) can't do better
+|| | than idle mode, ended every millisecond: begin() fails there too.
+|| |
+|| | Wiring Core Library
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#ifndef TICKLESS_H
+#define TICKLESS_H
+
+#include <Wiring.h>
+
+// Timer 2 ticks per second
+#define TICKLESS_TICKS_PER_SECOND 1024
+
+class WTickless
+{
+  public:
+    WTickless();
+
+    // False if Timer 2 can't be used: sleep() then only idles.
+    bool begin(void);
+    void end(void);
+    void sleep(unsigned long ms);
+
+    // The deepest sleep mode used: SLEEP_POWER_SAVE (the default),
+    // SLEEP_EXTENDED_STANDBY (faster wake up), or SLEEP_IDLE.
+    void setSleepMode(uint8_t mode) { deepest = mode; }
+
+    // Wake on changes of a pin change interrupt input (PCINTn).
+    void wakeOnPinChange(uint8_t pcint);
+
+    // Time spent asleep and awake since begin() (or resetStatistics()),
+    // in milliseconds, and the number of sleeps.
+    unsigned long sleepTime(void);
+    unsigned long activeTime(void);
+    unsigned long sleeps(void) { return sleepCount; }
+    void resetStatistics(void);
+
+  private:
+    bool active;
+    uint8_t deepest;
+    unsigned long start;
+    unsigned long sleepCount;
+    uint32_t sleepTicks;
+    // The last point where Timer 0 (clockCycles()) was caught up with
+    // Timer 2, and the part of a CPU cycle (in 1/1024) carried over
+    uint8_t referenceTicks;
+    uint32_t referenceCycles;
+    uint16_t fraction;
+
+    bool clkIONeeded(void);
+    void timer0CatchUp(uint8_t now);
+};
+
+extern WTickless Tickless;
+
+#endif
+// TICKLESS_H
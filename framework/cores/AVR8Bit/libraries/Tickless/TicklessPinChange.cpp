@@ -0,0 +1,69 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Tickless idle: pin change wake up.
+|| |
+|| | The pin change interrupts only have to wake the CPU up.  They are
+|| | in a file of their own, so they are only linked in by sketches
+|| | that call wakeOnPinChange(): NewSoftSerial has its own.
+|| |
+|| | Wiring Core Library
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#include "Tickless.h"
+
+#if defined(PCICR)
+
+#if defined(PCINT0_vect)
+EMPTY_INTERRUPT(PCINT0_vect)
+#endif
+#if defined(PCINT1_vect)
+EMPTY_INTERRUPT(PCINT1_vect)
+#endif
+#if defined(PCINT2_vect)
+EMPTY_INTERRUPT(PCINT2_vect)
+#endif
+#if defined(PCINT3_vect)
+EMPTY_INTERRUPT(PCINT3_vect)
+#endif
+
+#if defined(PCINT3_vect)
+#define PCINT_GROUPS 4
+#elif defined(PCINT2_vect)
+#define PCINT_GROUPS 3
+#elif defined(PCINT1_vect)
+#define PCINT_GROUPS 2
+#else
+#define PCINT_GROUPS 1
+#endif
+
+// PCINTn inputs come in groups of 8, one PCMSKn register and PCICR bit
+// per group; the PCMSKn registers follow each other.
+void WTickless::wakeOnPinChange(uint8_t pcint)
+{
+  uint8_t group = pcint >> 3;
+  uint8_t oldSREG = SREG;
+
+  if (group >= PCINT_GROUPS)
+    return;
+
+  cli();
+  (&PCMSK0)[group] |= 1 << (pcint & 0x07);
+  PCICR |= 1 << group;
+  SREG = oldSREG;
+}
+
+#else
+
+void WTickless::wakeOnPinChange(uint8_t pcint)
+{
+}
+
+#endif
@@ -0,0 +1,51 @@
+/**
+ * Sleepy Blink
+ * by Camilo Reyes <creyes@wiring.org.co>
+ *
+ * Flashes the onboard LED for 20 ms every 2 seconds, and reports
+ * how long it slept every minute.  In between, the board sleeps in
+ * power save mode, woken by Timer 2 at the next deadline.
+ *
+ * Needs a 32.768 kHz crystal on TOSC1/TOSC2.
+ */
+
+#include <Scheduler.h>
+#include <Tickless.h>
+
+Scheduler<4> scheduler;
+
+void setup()
+{
+  Serial.begin(9600);
+  pinMode(WLED, OUTPUT);
+
+  Tickless.begin();
+  scheduler.scheduleRepeating(flash, 2000);
+  scheduler.scheduleRepeating(report, 60000);
+}
+
+void loop()
+{
+  scheduler.update();
+  Tickless.sleep(scheduler.idleTime());
+}
+
+void flash()
+{
+  digitalWrite(WLED, HIGH);
+  scheduler.schedule(ledOff, 20);
+}
+
+void ledOff()
+{
+  digitalWrite(WLED, LOW);
+}
+
+void report()
+{
+  Serial.print(Constant("asleep "));
+  Serial.print(Tickless.sleepTime());
+  Serial.print(Constant(" ms, awake "));
+  Serial.print(Tickless.activeTime());
+  Serial.println(Constant(" ms"));
+}
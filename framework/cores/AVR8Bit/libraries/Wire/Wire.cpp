@@ -5,6 +5,7 @@
 || @contribution   Hernando Barragan <b@wiring.org.co>
 || @contribution   Alexander Brevig <abrevig@wiring.org.co>
 || @contribution   Brett Hagman <bhagman@wiring.org.co>
+|| @contribution   Camilo Reyes <creyes@wiring.org.co>
 ||
 || @description
 || | TWI Library.
@@ -32,6 +33,8 @@ uint8_t TwoWire::rxBuffer[BUFFER_LENGTH];
 uint8_t TwoWire::rxBufferIndex = 0;
 uint8_t TwoWire::rxBufferLength = 0;
 
+uint8_t TwoWire::slaveRxBuffer[BUFFER_LENGTH];
+
 uint8_t TwoWire::txAddress = 0;
 uint8_t TwoWire::txBuffer[BUFFER_LENGTH];
 uint8_t TwoWire::txBufferIndex = 0;
@@ -63,6 +66,7 @@ void TwoWire::begin(void)
 void TwoWire::begin(uint8_t address)
 {
   twi_setAddress(address);
+  twi_setSlaveRxBuffer(slaveRxBuffer, BUFFER_LENGTH);
   twi_attachSlaveTxEvent(onRequestService);
   twi_attachSlaveRxEvent(onReceiveService);
   begin();
@@ -136,27 +140,83 @@ uint8_t TwoWire::endTransmission(void)
   return endTransmission(true);
 }
 
+uint32_t TwoWire::setClock(uint32_t frequency)
+{
+  return twi_setFrequency(frequency);
+}
+
+uint8_t TwoWire::transfer(WireTransaction *transaction, uint8_t address,
+                          const uint8_t *writeData, uint16_t writeLength,
+                          uint8_t *readData, uint16_t readLength,
+                          void (*callback)(WireTransaction *), uint8_t flags)
+{
+  transaction->address = address;
+  transaction->writeData = writeData;
+  transaction->writeLength = writeLength;
+  transaction->readData = readData;
+  transaction->readLength = readLength;
+  transaction->callback = callback;
+  transaction->flags = flags;
+  return twi_queue(transaction);
+}
+
+uint8_t TwoWire::queue(WireTransaction *transaction)
+{
+  return twi_queue(transaction);
+}
+
+bool TwoWire::busy(void)
+{
+  return twi_busy();
+}
+
+uint8_t TwoWire::writeTo(uint8_t address, const uint8_t *data, uint16_t length,
+                         uint8_t sendStop)
+{
+  return twi_writeTo(address, data, length, 1, sendStop);
+}
+
+uint16_t TwoWire::readFrom(uint8_t address, uint8_t *data, uint16_t length,
+                           uint8_t sendStop)
+{
+  return twi_readFrom(address, data, length, sendStop);
+}
+
+uint8_t TwoWire::transfer(uint8_t address,
+                          const uint8_t *writeData, uint16_t writeLength,
+                          uint8_t *readData, uint16_t readLength)
+{
+  WireTransaction transaction;
+
+  transfer(&transaction, address, writeData, writeLength, readData, readLength);
+  twi_wait(&transaction);
+  return transaction.status;
+}
+
+void TwoWire::wait(WireTransaction *transaction)
+{
+  twi_wait(transaction);
+}
+
 // must be called in:
 // slave tx event callback
 // or after beginTransmission(address)
 size_t TwoWire::write(uint8_t data)
 {
-  if(transmitting){
-  // in master transmitter mode
-    // don't bother if buffer is full
-    if(txBufferLength >= BUFFER_LENGTH){
-      setWriteError();
-      return 0;
-    }
-    // put byte in tx buffer
-    txBuffer[txBufferIndex] = data;
-    ++txBufferIndex;
-    // update amount in buffer   
-    txBufferLength = txBufferIndex;
-  }else{
+  // don't bother if buffer is full
+  if(txBufferLength >= BUFFER_LENGTH){
+    setWriteError();
+    return 0;
+  }
+  // put byte in tx buffer
+  txBuffer[txBufferIndex] = data;
+  ++txBufferIndex;
+  // update amount in buffer   
+  txBufferLength = txBufferIndex;
+  if(!transmitting){
   // in slave send mode
-    // reply to master
-    twi_transmit(&data, 1);
+    // reply to master, straight from the buffer
+    twi_transmit(txBuffer, txBufferLength);
   }
   return 1;
 }
@@ -166,17 +226,12 @@ size_t TwoWire::write(uint8_t data)
 // or after beginTransmission(address)
 size_t TwoWire::write(const uint8_t *data, size_t quantity)
 {
-  if(transmitting){
-  // in master transmitter mode
-    for(size_t i = 0; i < quantity; ++i){
-      write(data[i]);
-    }
-  }else{
-  // in slave send mode
-    // reply to master
-    twi_transmit(data, quantity);
+  size_t n = 0;
+
+  while(n < quantity && write(data[n])){
+    ++n;
   }
-  return quantity;
+  return n;
 }
 
 // must be called in:
@@ -235,11 +290,9 @@ void TwoWire::onReceiveService(uint8_t* inBytes, int numBytes)
   if(rxBufferIndex < rxBufferLength){
     return;
   }
-  // copy twi rx buffer into local read buffer
-  // this enables new reads to happen in parallel
-  for(uint8_t i = 0; i < numBytes; ++i){
-    rxBuffer[i] = inBytes[i];    
-  }
+  // copy the slave rx buffer (inBytes) into local read buffer
+  // this enables new receptions to happen in parallel
+  memcpy(rxBuffer, inBytes, numBytes);
   // set rx iterator vars
   rxBufferIndex = 0;
   rxBufferLength = numBytes;
@@ -5,6 +5,7 @@
 || @contribution   Hernando Barragan <b@wiring.org.co>
 || @contribution   Alexander Brevig <abrevig@wiring.org.co>
 || @contribution   Brett Hagman <bhagman@wiring.org.co>
+|| @contribution   Camilo Reyes <creyes@wiring.org.co>
 ||
 || @description
 || | TWI Library.
@@ -22,8 +23,15 @@
 #include <inttypes.h>
 #include "Stream.h"
 
+extern "C" {
+  #include "utility/twi.h"
+}
+
 #define BUFFER_LENGTH 32
 
+// A master transaction run from the TWI interrupt (see utility/twi.h)
+typedef twi_transaction_t WireTransaction;
+
 class TwoWire : public Stream
 {
   private:
@@ -31,6 +39,9 @@ class TwoWire : public Stream
     static uint8_t rxBufferIndex;
     static uint8_t rxBufferLength;
 
+    // received into by the slave, from the TWI interrupt
+    static uint8_t slaveRxBuffer[];
+
     static uint8_t txAddress;
     static uint8_t txBuffer[];
     static uint8_t txBufferIndex;
@@ -62,6 +73,40 @@ class TwoWire : public Stream
     virtual void flush(void);
     void onReceive(void (*)(int));
     void onRequest(void (*)(void));
+
+    // SCL frequency of the master (100kHz by default; 400kHz, or up to
+    // 1MHz with devices that can take it)
+    uint32_t setClock(uint32_t);
+
+    // Non-blocking master transactions: queued, and run from the TWI
+    // interrupt straight from and into the given buffers, which must stay
+    // untouched until the transaction's status is no longer TWI_PENDING
+    // (or its callback is called).  transfer() fills the transaction in
+    // and queues it, so it must not be used on one still queued.
+    // Returns 1 if the transaction is already queued.
+    uint8_t transfer(WireTransaction *, uint8_t address,
+                     const uint8_t *writeData, uint16_t writeLength,
+                     uint8_t *readData, uint16_t readLength,
+                     void (*callback)(WireTransaction *) = NULL,
+                     uint8_t flags = 0);
+    uint8_t queue(WireTransaction *);
+    bool busy(void);
+    // Waits for a queued transaction to be done.
+    void wait(WireTransaction *);
+
+    // Blocking master transfers straight from and into the caller's
+    // buffers, without the BUFFER_LENGTH limit of the ones above (e.g.
+    // an EEPROM page with its address in front, or a sensor FIFO in one
+    // read).  writeTo() and transfer() return the endTransmission()
+    // status, readFrom() the number of bytes read.  transfer() writes,
+    // then reads after a repeated start (a register read).
+    uint8_t writeTo(uint8_t address, const uint8_t *data, uint16_t length,
+                    uint8_t sendStop = true);
+    uint16_t readFrom(uint8_t address, uint8_t *data, uint16_t length,
+                      uint8_t sendStop = true);
+    uint8_t transfer(uint8_t address,
+                     const uint8_t *writeData, uint16_t writeLength,
+                     uint8_t *readData, uint16_t readLength);
   
     inline size_t write(unsigned long n) { return write((uint8_t)n); }
     inline size_t write(long n) { return write((uint8_t)n); }
@@ -0,0 +1,70 @@
+/**
+ * Wire Async Sensors
+ * by Camilo Reyes <creyes@wiring.org.co>
+ * 
+ * Polls twenty sensors round-robin without waiting on the bus.
+ * Each sensor is read by a transaction that writes its register
+ * number and reads two bytes back after a repeated start.  The TWI
+ * interrupt runs the transactions; when one is done its callback
+ * stores the reading and queues the next sensor, so the loop only
+ * looks at the latest readings and is free for other work.
+ * Sensors that don't answer are marked as missing.
+ * On Wiring v1 boards the SCL and SDA pins are: 0 and 1
+ * On Wiring S board the SCL and SDA pins are: 8 and 9 
+ */
+
+#include <Wire.h>
+
+#define SENSORS 20
+#define FIRST_ADDRESS 0x40  // sensors at 0x40 to 0x53
+#define REGISTER 0x00       // 16 bit reading, high byte first
+
+const uint8_t reg = REGISTER;
+uint8_t data[2];
+WireTransaction poll;
+uint8_t current = 0;
+
+volatile int readings[SENSORS];
+volatile unsigned long rounds = 0;
+
+void polled(WireTransaction *t)
+{
+  if (t->status == 0)
+    readings[current] = (data[0] << 8) | data[1];
+  else
+    readings[current] = -1;  // missing
+
+  if (++current == SENSORS)
+  {
+    current = 0;
+    rounds++;
+  }
+
+  Wire.transfer(&poll, FIRST_ADDRESS + current, &reg, 1, data, 2, polled);
+}
+
+void setup()
+{
+  Serial.begin(9600);
+  Wire.begin();
+  Wire.setClock(400000);
+
+  Wire.transfer(&poll, FIRST_ADDRESS, &reg, 1, data, 2, polled);
+}
+
+void loop()
+{
+  int value;
+
+  for (uint8_t i = 0; i < SENSORS; i++)
+  {
+    noInterrupts();
+    value = readings[i];
+    interrupts();
+    Serial.print(value);
+    Serial.print(' ');
+  }
+  Serial.println();
+
+  delay(1000);
+}
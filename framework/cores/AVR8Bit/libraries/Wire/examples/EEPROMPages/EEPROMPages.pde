@@ -0,0 +1,52 @@
+/**
+ * Wire EEPROM Pages
+ * by Camilo Reyes <creyes@wiring.org.co>
+ * 
+ * Writes a whole 128 byte page of a 24LC512 serial EEPROM in one
+ * transfer, and reads it back in one, straight from and into the
+ * sketch's own buffers: no splitting into 32 byte pieces.
+ * The page buffer starts with the two byte memory address.
+ * On Wiring v1 boards the SCL and SDA pins are: 0 and 1
+ * On Wiring S board the SCL and SDA pins are: 8 and 9 
+ */
+
+#include <Wire.h>
+
+#define EEPROM_ADDRESS 0x50
+#define PAGE_SIZE 128
+
+uint8_t page[2 + PAGE_SIZE];
+uint8_t readBack[PAGE_SIZE];
+
+void setup()
+{
+  unsigned int address = 3 * PAGE_SIZE;  // the fourth page
+
+  Serial.begin(9600);
+  Wire.begin();
+  Wire.setClock(400000);
+
+  page[0] = address >> 8;
+  page[1] = address & 0xFF;
+  for (int i = 0; i < PAGE_SIZE; i++)
+    page[2 + i] = i;
+
+  Wire.writeTo(EEPROM_ADDRESS, page, sizeof(page));
+
+  // the EEPROM doesn't answer while it writes the page (up to 5 ms)
+  while (Wire.writeTo(EEPROM_ADDRESS, page, 2) != 0)
+    ;
+
+  Wire.transfer(EEPROM_ADDRESS, page, 2, readBack, PAGE_SIZE);
+
+  for (int i = 0; i < PAGE_SIZE; i++)
+  {
+    Serial.print(readBack[i]);
+    Serial.print(' ');
+  }
+  Serial.println();
+}
+
+void loop()
+{
+}
@@ -5,6 +5,7 @@
 || @contribution   Hernando Barragan <b@wiring.org.co>
 || @contribution   Alexander Brevig <abrevig@wiring.org.co>
 || @contribution   Brett Hagman <bhagman@wiring.org.co>
+|| @contribution   Camilo Reyes <creyes@wiring.org.co>
 ||
 || @description
 || | TWI utility library.
@@ -36,24 +37,137 @@
 
 static volatile uint8_t twi_state;
 static volatile uint8_t twi_slarw;
-static volatile uint8_t twi_sendStop;			// should the transaction end with a stop
 static volatile uint8_t twi_inRepStart;			// in the middle of a repeated start
 
 static void (*twi_onSlaveTransmit)(void);
 static void (*twi_onSlaveReceive)(uint8_t*, int);
 
-static uint8_t twi_masterBuffer[TWI_BUFFER_LENGTH];
-static volatile uint8_t twi_masterBufferIndex;
-static volatile uint8_t twi_masterBufferLength;
+// master transaction queue; the head is the one on the bus
+static twi_transaction_t * volatile twi_head;
+static twi_transaction_t * volatile twi_tail;
+static volatile uint16_t twi_masterIndex;		// bytes of the current phase done
 
-static uint8_t twi_txBuffer[TWI_BUFFER_LENGTH];
-static volatile uint8_t twi_txBufferIndex;
-static volatile uint8_t twi_txBufferLength;
+// a twi_writeTo() that doesn't wait
+static twi_transaction_t twi_masterTransaction;
 
-static uint8_t twi_rxBuffer[TWI_BUFFER_LENGTH];
-static volatile uint8_t twi_rxBufferIndex;
+// slave buffers, owned by the caller (see twi_transmit() and
+// twi_setSlaveRxBuffer())
+static const uint8_t twi_txNothing = 0x00;
+static const uint8_t *twi_txBuffer;
+static volatile uint16_t twi_txBufferIndex;
+static volatile uint16_t twi_txBufferLength;
 
-static volatile uint8_t twi_error;
+static uint8_t *twi_rxBuffer;
+static uint16_t twi_rxBufferSize;
+static volatile uint16_t twi_rxBufferIndex;
+
+static void twi_service(void);
+
+/* 
+ * Function twi_load
+ * Desc     sets up the state for the transaction at the head of the
+ *          queue, from its first phase (write, or read if it has
+ *          nothing to write)
+ * Input    none
+ * Output   none
+ */
+static void twi_load(void)
+{
+  twi_transaction_t *t = twi_head;
+
+  twi_masterIndex = 0;
+  if (t->writeLength || !t->readLength) {
+    twi_state = TWI_MTX;
+    twi_slarw = TW_WRITE | (t->address << 1);
+  } else {
+    twi_state = TWI_MRX;
+    twi_slarw = TW_READ | (t->address << 1);
+  }
+}
+
+/* 
+ * Function twi_begin
+ * Desc     starts the transaction at the head of the queue
+ * Input    none
+ * Output   none
+ */
+static void twi_begin(void)
+{
+  twi_load();
+
+  if (true == twi_inRepStart) {
+    // the last transaction kept the bus and sent a repeated start, without
+    // the interrupt; once it is out, send the address from here
+    twi_inRepStart = false;
+    while(!(TWCR & _BV(TWINT))){
+      continue;
+    }
+    TWDR = twi_slarw;
+    TWCR = _BV(TWINT) | _BV(TWEA) | _BV(TWEN) | _BV(TWIE);
+  }
+  else
+    // send start condition
+    TWCR = _BV(TWEN) | _BV(TWIE) | _BV(TWEA) | _BV(TWINT) | _BV(TWSTA);
+}
+
+/* 
+ * Function twi_finish
+ * Desc     completes the transaction at the head of the queue, calls
+ *          its callback and goes on with the next one
+ * Input    status: 0 .. success, 2 .. address NACK, 3 .. data NACK,
+ *          4 .. other twi error
+ * Output   none
+ */
+static void twi_finish(uint8_t status)
+{
+  twi_transaction_t *t = twi_head;
+  uint8_t keepBus = (status == 0) && (t->flags & TWI_REPEATED_START);
+
+  twi_head = t->next;
+  if (!twi_head)
+    twi_tail = NULL;
+
+  // the bus is held (SCL low) meanwhile, so a transaction queued by the
+  // callback follows on without giving it up
+  t->status = status;
+  if (t->callback)
+    t->callback(t);
+
+  if (keepBus) {
+    if (twi_head) {
+      // straight into the next one, through the interrupt
+      twi_load();
+      TWCR = _BV(TWINT) | _BV(TWSTA) | _BV(TWEN) | _BV(TWIE);
+    } else {
+      twi_inRepStart = true;	// we're gonna send the START
+      // don't enable the interrupt. We'll generate the start, but we
+      // avoid handling the interrupt until we're in the next transaction,
+      // at the point where we would normally issue the start.
+      TWCR = _BV(TWINT) | _BV(TWSTA)| _BV(TWEN) ;
+      twi_state = TWI_READY;
+    }
+  } else {
+    twi_stop();
+    if (twi_head)
+      twi_begin();
+  }
+}
+
+/* 
+ * Function twi_wait
+ * Desc     waits for a transaction to be done; with interrupts disabled
+ *          (e.g. called from an ISR) services the TWI from here instead
+ *          of blocking forever
+ * Input    t: the transaction
+ * Output   none
+ */
+void twi_wait(twi_transaction_t *t)
+{
+  while(TWI_PENDING == t->status){
+    if (!(SREG & _BV(SREG_I)) && (TWCR & _BV(TWINT)))
+      twi_service();
+  }
+}
 
 /* 
  * Function twi_init
@@ -65,8 +179,8 @@ void twi_init(void)
 {
   // initialize state
   twi_state = TWI_READY;
-  twi_sendStop = true;		// default value
   twi_inRepStart = false;
+  twi_head = twi_tail = NULL;
   
   // TODO let's consider not activate internal pullups for Wire
   pinMode(SDA, INPUT);
@@ -90,19 +204,94 @@ void twi_init(void)
   #endif
 */
   // initialize twi prescaler and bit rate
-  cbi(TWSR, TWPS0);
-  cbi(TWSR, TWPS1);
-  TWBR = ((F_CPU / TWI_FREQ) - 16) / 2;
-
-  /* twi bit rate formula from atmega128 manual pg 204
-  SCL Frequency = CPU Clock Frequency / (16 + (2 * TWBR))
-  note: TWBR should be 10 or higher for master mode
-  It is 72 for a 16mhz Wiring board with 100kHz TWI */
+  twi_setFrequency(TWI_FREQ);
 
   // enable twi module, acks, and twi interrupt
   TWCR = _BV(TWEN) | _BV(TWIE) | _BV(TWEA);
 }
 
+/* 
+ * Function twi_setFrequency
+ * Desc     sets the SCL frequency of the master, with the smallest
+ *          prescaler that fits the bit rate register
+ * Input    frequency: in Hz (e.g. 100000, 400000 or 1000000)
+ * Output   the frequency set, the nearest one at or below the one asked
+ *          for if possible
+ */
+uint32_t twi_setFrequency(uint32_t frequency)
+{
+  /* twi bit rate formula from atmega128 manual pg 204
+  SCL Frequency = CPU Clock Frequency / (16 + (2 * TWBR * 4^TWPS))
+  note: the TWI is specified up to 400kHz; faster (1MHz is TWBR = 0 at
+  16MHz) works with the devices that can take it, on a short bus with
+  strong pull-ups */
+  uint32_t cycles = (F_CPU + frequency - 1) / frequency;
+  uint32_t twbr = cycles > 16 ? (cycles - 16 + 1) / 2 : 0;
+  uint8_t twps = 0;
+
+  while(twbr > 255 && twps < 3){
+    twps++;
+    twbr = (twbr + 3) / 4;
+  }
+  if(twbr > 255){
+    twbr = 255;
+  }
+
+  TWSR = (TWSR & ~(_BV(TWPS0) | _BV(TWPS1))) | twps;
+  TWBR = twbr;
+
+  return F_CPU / (16 + 2 * twbr * (1UL << (2 * twps)));
+}
+
+/* 
+ * Function twi_queue
+ * Desc     queues a master transaction, starting it if the bus is idle
+ * Input    t: the transaction (address, data, lengths, flags and
+ *          callback filled in)
+ * Output   0 .. queued
+ *          1 .. already queued and not done
+ */
+uint8_t twi_queue(twi_transaction_t *t)
+{
+  twi_transaction_t *q;
+  uint8_t oldSREG = SREG;
+
+  cli();
+  for(q = twi_head; q; q = q->next){
+    if(q == t){
+      SREG = oldSREG;
+      return 1;
+    }
+  }
+
+  t->status = TWI_PENDING;
+  t->next = NULL;
+  if (twi_tail)
+    twi_tail->next = t;
+  else
+    twi_head = t;
+  twi_tail = t;
+
+  // if the bus is busy, the ISR gets to it after the ones before
+  if (twi_head == t && TWI_READY == twi_state)
+    twi_begin();
+  SREG = oldSREG;
+
+  return 0;
+}
+
+/* 
+ * Function twi_busy
+ * Desc     tells whether master transactions are queued or in progress
+ * Input    none
+ * Output   1 .. busy
+ *          0 .. idle
+ */
+uint8_t twi_busy(void)
+{
+  return twi_head != NULL;
+}
+
 /* 
  * Function twi_slaveInit
  * Desc     sets slave address and enables interrupt
@@ -122,68 +311,26 @@ void twi_setAddress(uint8_t address)
  * Input    address: 7bit i2c device address
  *          data: pointer to byte array
  *          length: number of bytes to read into array
+ *          sendStop: boolean indicating to release the bus or not
  * Output   number of bytes read
  */
-uint8_t twi_readFrom(uint8_t address, uint8_t* data, uint8_t length, uint8_t sendStop)
+uint16_t twi_readFrom(uint8_t address, uint8_t* data, uint16_t length, uint8_t sendStop)
 {
-  uint8_t i;
-
-  // ensure data will fit into buffer
-  if(TWI_BUFFER_LENGTH < length){
-    return 0;
-  }
-
-  // wait until twi is ready, become master receiver
-  while(TWI_READY != twi_state){
-    continue;
-  }
-  twi_state = TWI_MRX;
-  twi_sendStop = sendStop;
-  // reset error state (0xFF.. no error occured)
-  twi_error = 0xFF;
-
-  // initialize buffer iteration vars
-  twi_masterBufferIndex = 0;
-  twi_masterBufferLength = length-1;  // This is not intuitive, read on...
-  // On receive, the previously configured ACK/NACK setting is transmitted in
-  // response to the received byte before the interrupt is signalled. 
-  // Therefor we must actually set NACK when the _next_ to last byte is
-  // received, causing that NACK to be sent in response to receiving the last
-  // expected byte of data.
-
-  // build sla+w, slave device address + w bit
-  twi_slarw = TW_READ;
-  twi_slarw |= address << 1;
-
-  if (true == twi_inRepStart) {
-    // if we're in the repeated start state, then we've already sent the start,
-    // (@@@ we hope), and the TWI statemachine is just waiting for the address byte.
-    // We need to remove ourselves from the repeated start state before we enable interrupts,
-    // since the ISR is ASYNC, and we could get confused if we hit the ISR before cleaning
-    // up. Also, don't enable the START interrupt. There may be one pending from the
-    // repeated start that we sent outselves, and that would really confuse things.
-    twi_inRepStart = false;			// remember, we're dealing with an ASYNC ISR
-    TWDR = twi_slarw;
-    TWCR = _BV(TWINT) | _BV(TWEA) | _BV(TWEN) | _BV(TWIE);	// enable INTs, but not START
-  }
-  else
-    // send start condition
-    TWCR = _BV(TWEN) | _BV(TWIE) | _BV(TWEA) | _BV(TWINT) | _BV(TWSTA);
+  twi_transaction_t t;
 
-  // wait for read operation to complete
-  while(TWI_MRX == twi_state){
-    continue;
-  }
+  t.address = address;
+  t.writeData = NULL;
+  t.writeLength = 0;
+  t.readData = data;
+  t.readLength = length;
+  t.flags = sendStop ? 0 : TWI_REPEATED_START;
+  t.status = 0;
+  t.callback = NULL;
 
-  if (twi_masterBufferIndex < length)
-    length = twi_masterBufferIndex;
+  twi_queue(&t);
+  twi_wait(&t);
 
-  // copy twi buffer to data
-  for(i = 0; i < length; ++i){
-    data[i] = twi_masterBuffer[i];
-  }
-	
-  return length;
+  return t.status ? 0 : length;
 }
 
 /* 
@@ -191,112 +338,87 @@ uint8_t twi_readFrom(uint8_t address, uint8_t* data, uint8_t length, uint8_t sen
  * Desc     attempts to become twi bus master and write a
  *          series of bytes to a device on the bus
  * Input    address: 7bit i2c device address
- *          data: pointer to byte array
+ *          data: pointer to byte array, which must stay untouched
+ *                until twi_busy() is false if not waiting
  *          length: number of bytes in array
  *          wait: boolean indicating to wait for write or not
- * Output   0 .. success
- *          1 .. length to long for buffer
+ *          sendStop: boolean indicating to release the bus or not
+ * Output   0 .. success (or queued, if not waiting)
  *          2 .. address send, NACK received
  *          3 .. data send, NACK received
  *          4 .. other twi error (lost bus arbitration, bus error, ..)
  */
-uint8_t twi_writeTo(uint8_t address, uint8_t* data, uint8_t length, uint8_t wait, uint8_t sendStop)
+uint8_t twi_writeTo(uint8_t address, const uint8_t* data, uint16_t length, uint8_t wait, uint8_t sendStop)
 {
-  uint8_t i;
+  twi_transaction_t t;
+  twi_transaction_t *p = &t;
 
-  // ensure data will fit into buffer
-  if(TWI_BUFFER_LENGTH < length){
-    return 1;
+  if (!wait) {
+    // the last one that didn't wait must be done
+    twi_wait(&twi_masterTransaction);
+    p = &twi_masterTransaction;
   }
 
-  // wait until twi is ready, become master transmitter
-  while(TWI_READY != twi_state){
-    continue;
-  }
-  twi_state = TWI_MTX;
-  twi_sendStop = sendStop;
-  // reset error state (0xFF.. no error occured)
-  twi_error = 0xFF;
-
-  // initialize buffer iteration vars
-  twi_masterBufferIndex = 0;
-  twi_masterBufferLength = length;
-  
-  // copy data to twi buffer
-  for(i = 0; i < length; ++i){
-    twi_masterBuffer[i] = data[i];
-  }
-  
-  // build sla+w, slave device address + w bit
-  twi_slarw = TW_WRITE;
-  twi_slarw |= address << 1;
+  p->address = address;
+  p->writeData = data;
+  p->writeLength = length;
+  p->readData = NULL;
+  p->readLength = 0;
+  p->flags = sendStop ? 0 : TWI_REPEATED_START;
+  p->status = 0;
+  p->callback = NULL;
+
+  twi_queue(p);
+  if (!wait)
+    return 0;
 
-  // if we're in a repeated start, then we've already sent the START
-  // in the ISR. Don't do it again.
-  //
-  if (true == twi_inRepStart) {
-    // if we're in the repeated start state, then we've already sent the start,
-    // (@@@ we hope), and the TWI statemachine is just waiting for the address byte.
-    // We need to remove ourselves from the repeated start state before we enable interrupts,
-    // since the ISR is ASYNC, and we could get confused if we hit the ISR before cleaning
-    // up. Also, don't enable the START interrupt. There may be one pending from the
-    // repeated start that we sent outselves, and that would really confuse things.
-    twi_inRepStart = false;			// remember, we're dealing with an ASYNC ISR
-    TWDR = twi_slarw;
-    TWCR = _BV(TWINT) | _BV(TWEA) | _BV(TWEN) | _BV(TWIE);	// enable INTs, but not START
-  }
-  else
-    // send start condition
-    TWCR = _BV(TWEN) | _BV(TWIE) | _BV(TWEA) | _BV(TWINT) | _BV(TWSTA);
+  twi_wait(p);
 
-  // wait for write operation to complete
-  while(wait && (TWI_MTX == twi_state)){
-    continue;
-  }
-  
-  if (twi_error == 0xFF)
-    return 0;	// success
-  else if (twi_error == TW_MT_SLA_NACK)
-    return 2;	// error: address send, nack received
-  else if (twi_error == TW_MT_DATA_NACK)
-    return 3;	// error: data send, nack received
-  else
-    return 4;	// other twi error
+  return p->status;
 }
 
 /* 
  * Function twi_transmit
- * Desc     fills slave tx buffer with data
+ * Desc     sets the data of a slave transmission, sent straight from
+ *          the array, which must stay untouched until it is sent
  *          must be called in slave tx event callback
  * Input    data: pointer to byte array
  *          length: number of bytes in array
- * Output   1 length too long for buffer
- *          2 not slave transmitter
+ * Output   2 not slave transmitter
  *          0 ok
  */
-uint8_t twi_transmit(const uint8_t* data, uint8_t length)
+uint8_t twi_transmit(const uint8_t* data, uint16_t length)
 {
-  uint8_t i;
-
-  // ensure data will fit into buffer
-  if(TWI_BUFFER_LENGTH < length){
-    return 1;
-  }
-  
   // ensure we are currently a slave transmitter
   if(TWI_STX != twi_state){
     return 2;
   }
   
-  // set length and copy data into tx buffer
+  // set data and length
+  twi_txBuffer = data;
   twi_txBufferLength = length;
-  for(i = 0; i < length; ++i){
-    twi_txBuffer[i] = data[i];
-  }
   
   return 0;
 }
 
+/* 
+ * Function twi_setSlaveRxBuffer
+ * Desc     sets the array slave receptions are stored in, and passed to
+ *          the slave rx event callback; bytes beyond its size are NACKed
+ * Input    buffer: pointer to byte array
+ *          size: number of bytes in array
+ * Output   none
+ */
+void twi_setSlaveRxBuffer(uint8_t* buffer, uint16_t size)
+{
+  uint8_t oldSREG = SREG;
+
+  cli();
+  twi_rxBuffer = buffer;
+  twi_rxBufferSize = size;
+  SREG = oldSREG;
+}
+
 /* 
  * Function twi_attachSlaveRxEvent
  * Desc     sets function called before a slave read operation
@@ -373,6 +495,15 @@ void twi_releaseBus(void)
 
 SIGNAL(TWI_vect)
 {
+  PROFILE_ENTER();
+  twi_service();
+  PROFILE_EXIT(PROFILE_TWI);
+}
+
+static void twi_service(void)
+{
+  twi_transaction_t *t = twi_head;
+
   switch(TW_STATUS){
     // All Master
     case TW_START:     // sent start condition
@@ -385,44 +516,44 @@ SIGNAL(TWI_vect)
     // Master Transmitter
     case TW_MT_SLA_ACK:  // slave receiver acked address
     case TW_MT_DATA_ACK: // slave receiver acked data
-      // if there is data to send, send it, otherwise stop 
-      if(twi_masterBufferIndex < twi_masterBufferLength){
+      // if there is data to send, send it, otherwise read or finish
+      if(twi_masterIndex < t->writeLength){
         // copy data to output register and ack
-        TWDR = twi_masterBuffer[twi_masterBufferIndex++];
+        TWDR = t->writeData[twi_masterIndex++];
         twi_reply(1);
+      }else if(t->readLength){
+        // repeated start, and read back
+        twi_state = TWI_MRX;
+        twi_slarw = TW_READ | (t->address << 1);
+        twi_masterIndex = 0;
+        TWCR = _BV(TWINT) | _BV(TWSTA) | _BV(TWEN) | _BV(TWIE);
       }else{
-        if (twi_sendStop)
-          twi_stop();
-        else {
-          twi_inRepStart = true;	// we're gonna send the START
-          // don't enable the interrupt. We'll generate the start, but we
-          // avoid handling the interrupt until we're in the next transaction,
-          // at the point where we would normally issue the start.
-          TWCR = _BV(TWINT) | _BV(TWSTA)| _BV(TWEN) ;
-          twi_state = TWI_READY;
-        }
+        twi_finish(0);
       }
       break;
     case TW_MT_SLA_NACK:  // address sent, nack received
-      twi_error = TW_MT_SLA_NACK;
-      twi_stop();
+    case TW_MR_SLA_NACK:  // address sent, nack received
+      twi_finish(2);
       break;
     case TW_MT_DATA_NACK: // data sent, nack received
-      twi_error = TW_MT_DATA_NACK;
-      twi_stop();
+      twi_finish(3);
       break;
     case TW_MT_ARB_LOST: // lost bus arbitration
-      twi_error = TW_MT_ARB_LOST;
-      twi_releaseBus();
+      // TW_MR_ARB_LOST is the same; start over once the bus is free
+      twi_load();
+      TWCR = _BV(TWEN) | _BV(TWIE) | _BV(TWEA) | _BV(TWINT) | _BV(TWSTA);
       break;
 
     // Master Receiver
     case TW_MR_DATA_ACK: // data received, ack sent
       // put byte into buffer
-      twi_masterBuffer[twi_masterBufferIndex++] = TWDR;
+      t->readData[twi_masterIndex++] = TWDR;
     case TW_MR_SLA_ACK:  // address sent, ack received
       // ack if more bytes are expected, otherwise nack
-      if(twi_masterBufferIndex < twi_masterBufferLength){
+      // On receive, the ACK/NACK setting is transmitted in response to the
+      // received byte before the interrupt is signalled, so NACK is set
+      // when the next to last byte is received.
+      if(twi_masterIndex + 1 < t->readLength){
         twi_reply(1);
       }else{
         twi_reply(0);
@@ -430,22 +561,9 @@ SIGNAL(TWI_vect)
       break;
     case TW_MR_DATA_NACK: // data received, nack sent
       // put final byte into buffer
-      twi_masterBuffer[twi_masterBufferIndex++] = TWDR;
-      if (twi_sendStop)
-        twi_stop();
-      else {
-        twi_inRepStart = true;	// we're gonna send the START
-        // don't enable the interrupt. We'll generate the start, but we
-        // avoid handling the interrupt until we're in the next transaction,
-        // at the point where we would normally issue the start.
-        TWCR = _BV(TWINT) | _BV(TWSTA)| _BV(TWEN) ;
-        twi_state = TWI_READY;
-      }
+      t->readData[twi_masterIndex++] = TWDR;
+      twi_finish(0);
       break;
-    case TW_MR_SLA_NACK: // address sent, nack received
-      twi_stop();
-      break;
-    // TW_MR_ARB_LOST handled by TW_MT_ARB_LOST case
 
     // Slave Receiver
     case TW_SR_SLA_ACK:   // addressed, returned ack
@@ -461,7 +579,7 @@ SIGNAL(TWI_vect)
     case TW_SR_DATA_ACK:       // data received, returned ack
     case TW_SR_GCALL_DATA_ACK: // data received generally, returned ack
       // if there is still room in the rx buffer
-      if(twi_rxBufferIndex < TWI_BUFFER_LENGTH){
+      if(twi_rxBufferIndex < twi_rxBufferSize){
         // put byte in buffer and ack
         twi_rxBuffer[twi_rxBufferIndex++] = TWDR;
         twi_reply(1);
@@ -472,17 +590,21 @@ SIGNAL(TWI_vect)
       break;
     case TW_SR_STOP: // stop or repeated start condition received
       // put a null char after data if there's room
-      if(twi_rxBufferIndex < TWI_BUFFER_LENGTH){
+      if(twi_rxBufferIndex < twi_rxBufferSize){
         twi_rxBuffer[twi_rxBufferIndex] = '\0';
       }
       // sends ack and stops interface for clock stretching
       twi_stop();
       // callback to user defined callback
       twi_onSlaveReceive(twi_rxBuffer, twi_rxBufferIndex);
-      // since we submit rx buffer to "wire" library, we can reset it
+      // the rx buffer is the caller's until the next reception
       twi_rxBufferIndex = 0;
       // ack future responses and leave slave receiver state
       twi_releaseBus();
+      // master transactions queued meanwhile
+      if(twi_head){
+        twi_begin();
+      }
       break;
     case TW_SR_DATA_NACK:       // data received, returned nack
     case TW_SR_GCALL_DATA_NACK: // data received generally, returned nack
@@ -505,7 +627,7 @@ SIGNAL(TWI_vect)
       // if they didn't change buffer & length, initialize it
       if(0 == twi_txBufferLength){
         twi_txBufferLength = 1;
-        twi_txBuffer[0] = 0x00;
+        twi_txBuffer = &twi_txNothing;
       }
       // transmit first byte from buffer, fall
     case TW_ST_DATA_ACK: // byte sent, ack returned
@@ -524,14 +646,21 @@ SIGNAL(TWI_vect)
       twi_reply(1);
       // leave slave receiver state
       twi_state = TWI_READY;
+      // master transactions queued meanwhile
+      if(twi_head){
+        twi_begin();
+      }
       break;
 
     // All
     case TW_NO_INFO:   // no state information
       break;
     case TW_BUS_ERROR: // bus error, illegal stop/start
-      twi_error = TW_BUS_ERROR;
-      twi_stop();
+      if(TWI_MTX == twi_state || TWI_MRX == twi_state){
+        twi_finish(4);
+      }else{
+        twi_stop();
+      }
       break;
   }
 }
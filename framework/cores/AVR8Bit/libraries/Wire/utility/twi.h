@@ -5,10 +5,24 @@
 || @contribution   Hernando Barragan <b@wiring.org.co>
 || @contribution   Alexander Brevig <abrevig@wiring.org.co>
 || @contribution   Brett Hagman <bhagman@wiring.org.co>
+|| @contribution   Camilo Reyes <creyes@wiring.org.co>
 ||
 || @description
 || | TWI utility library.
 || |
+|| | The master is driven by the TWI interrupt from a queue of
+|| | transactions: each one writes writeLength bytes from writeData, then
+|| | (after a repeated start) reads readLength bytes into readData, going
+|| | straight to and from the caller's buffers, of any length.  The slave
+|| | too receives into and transmits from buffers the caller gives it
+|| | (twi_setSlaveRxBuffer(), twi_transmit()); there are no buffers
+|| | here.  twi_queue() returns at once; the transaction's status is
+|| | TWI_PENDING until it is done, then 0 (success), 2 (address NACKed)
+|| | or 3 (data NACKed), and its callback (if any) is called from the
+|| | interrupt.  The queued transaction and its buffers must stay
+|| | untouched until then.  Callbacks may queue transactions (the usual
+|| | way to keep polling), but not call the blocking functions.
+|| |
 || | Wiring Core Library
 || #
 ||
@@ -27,21 +41,41 @@
   #define TWI_FREQ 100000L
   #endif
 
-  #ifndef TWI_BUFFER_LENGTH
-  #define TWI_BUFFER_LENGTH 32
-  #endif
-
   #define TWI_READY 0
   #define TWI_MRX   1
   #define TWI_MTX   2
   #define TWI_SRX   3
   #define TWI_STX   4
-  
+
+  // status of a queued transaction until it is done
+  #define TWI_PENDING 0xFF
+
+  // transaction flags
+  #define TWI_REPEATED_START 0x01  // end without a STOP, keeping the bus
+
+  typedef struct twi_transaction
+  {
+    uint8_t address;                 // 7 bit
+    const uint8_t *writeData;
+    uint16_t writeLength;
+    uint8_t *readData;
+    uint16_t readLength;
+    uint8_t flags;
+    volatile uint8_t status;
+    void (*callback)(struct twi_transaction *);
+    struct twi_transaction *next;    // used by the queue
+  } twi_transaction_t;
+
   void twi_init(void);
+  uint32_t twi_setFrequency(uint32_t);
+  uint8_t twi_queue(twi_transaction_t*);
+  uint8_t twi_busy(void);
+  void twi_wait(twi_transaction_t*);
   void twi_setAddress(uint8_t);
-  uint8_t twi_readFrom(uint8_t, uint8_t*, uint8_t, uint8_t);
-  uint8_t twi_writeTo(uint8_t, uint8_t*, uint8_t, uint8_t, uint8_t);
-  uint8_t twi_transmit(const uint8_t*, uint8_t);
+  uint16_t twi_readFrom(uint8_t, uint8_t*, uint16_t, uint8_t);
+  uint8_t twi_writeTo(uint8_t, const uint8_t*, uint16_t, uint8_t, uint8_t);
+  uint8_t twi_transmit(const uint8_t*, uint16_t);
+  void twi_setSlaveRxBuffer(uint8_t*, uint16_t);
   void twi_attachSlaveRxEvent( void (*)(uint8_t*, int) );
   void twi_attachSlaveTxEvent( void (*)(void) );
   void twi_reply(uint8_t);
@@ -5,6 +5,7 @@
 || @contribution   Nicholas Zambetti
 || @contribution   Brett Hagman <bhagman@wiring.org.co>
 || @contribution   Alexander Brevig <abrevig@wiring.org.co>
+|| @contribution   Camilo Reyes <creyes@wiring.org.co>
 ||
 || @description
 || | Print library.
@@ -20,6 +21,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
+#include <avr/pgmspace.h>
 #include "Print.h"
 
 
@@ -228,90 +230,176 @@ size_t Print::println(const __ConstantStringHelper *cs)
 
 // private methods
 
-size_t Print::printNumber(unsigned long n, uint8_t base)
+// Digits are put together backwards, from the end of a buffer, and
+// written in one go.  Base 10 divides by 10 with shifts and adds, and by
+// 100 with a 16 bit multiply once the number fits in 16 bits, taking two
+// digits at a time from a table; powers of two only shift.  No 32 bit
+// division, which costs hundreds of cycles on an AVR.
+
+static const char digitPairs[201] PROGMEM =
+  "0001020304050607080910111213141516171819"
+  "2021222324252627282930313233343536373839"
+  "4041424344454647484950515253545556575859"
+  "6061626364656667686970717273747576777879"
+  "8081828384858687888990919293949596979899";
+
+
+// n / 10 (Hacker's Delight, divu10), the remainder in r.
+static inline uint32_t divideBy10(uint32_t n, uint8_t &r)
+{
+  uint32_t q = (n >> 1) + (n >> 2);
+
+  q += q >> 4;
+  q += q >> 8;
+  q += q >> 16;
+  q >>= 3;
+  r = n - ((q << 3) + (q << 1));    // 0 to 19: the low byte will do
+  if (r > 9)
+  {
+    q++;
+    r -= 10;
+  }
+  return q;
+}
+
+
+static char *decimalDigits(char *str, uint32_t n)
 {
-  /* BH: new version to be implemented
-    uint8_t buf[sizeof(char) * sizeof(int32_t)];
-    uint32_t i = 0;
+  uint16_t m;
+  uint16_t q;
+  uint8_t r;
 
-    if (n == 0)
-    {
-      write('0');
-      return;
-    }
+  while (n > 0xFFFF)
+  {
+    n = divideBy10(n, r);
+    *--str = '0' + r;
+  }
 
-    while (n > 0)
+  m = n;
+  while (m >= 100)
+  {
+    q = ((uint32_t)(m >> 2) * 0x147B) >> 17;   // m / 100
+    r = m - q * 100;
+    str -= 2;
+    str[0] = pgm_read_byte(&digitPairs[2 * r]);
+    str[1] = pgm_read_byte(&digitPairs[2 * r + 1]);
+    m = q;
+  }
+  if (m >= 10)
+  {
+    str -= 2;
+    str[0] = pgm_read_byte(&digitPairs[2 * m]);
+    str[1] = pgm_read_byte(&digitPairs[2 * m + 1]);
+  }
+  else
+    *--str = '0' + m;
+
+  return str;
+}
+
+
+static char *numberDigits(char *str, unsigned long n, uint8_t base)
+{
+  uint8_t shift;
+  uint8_t c;
+
+  // (longs are wider than 32 bits on the Host core)
+  if (base == 10 && n <= 0xFFFFFFFFUL)
+    return decimalDigits(str, n);
+
+  if ((base & (base - 1)) == 0)
+  {
+    for (shift = 0; (1 << shift) < base; shift++);
+    do
     {
-      buf[i++] = n % base;
-      n /= base;
-    }
+      c = n & (base - 1);
+      *--str = c < 10 ? c + '0' : c + 'A' - 10;
+      n >>= shift;
+    } while (n);
+    return str;
+  }
 
-    for (; i > 0; i--)
-      write((buf[i - 1] < 10 ?
-            '0' + buf[i - 1] :
-            'A' + buf[i - 1] - 10));
-  */
-
-  char buf[8 * sizeof(long) + 1]; // Assumes 8-bit chars plus zero byte.
-  char *str = &buf[sizeof(buf) - 1];
-  
-  *str = '\0';
-  
-  // prevent crash if called with base == 1
-  if (base < 2) base = 10;
-  
-  do {
+  do
+  {
     unsigned long m = n;
     n /= base;
-    char c = m - base * n;
+    c = m - base * n;
     *--str = c < 10 ? c + '0' : c + 'A' - 10;
-  } while(n);
-  
-  return write(str);
+  } while (n);
+
+  return str;
+}
+
+
+size_t Print::printNumber(unsigned long n, uint8_t base)
+{
+  char buf[8 * sizeof(long)]; // Assumes 8-bit chars
+  char *end = buf + sizeof(buf);
+  char *str;
+
+  // prevent crash if called with base == 1
+  if (base < 2) base = 10;
+
+  str = numberDigits(end, n, base);
+  return write(str, end - str);
 }
 
+
+// Fixed point: the fraction is scaled to an integer with one multiply,
+// rounded, and printed with the integer part.  Digits past the ninth (32
+// bits) are beyond the precision of a float anyway, and print as 0.
 size_t Print::printFloat(double number, uint8_t digits)
 {
-  size_t n = 0;
-  
+  static const uint32_t scales[10] PROGMEM =
+  {
+    1, 10, 100, 1000, 10000, 100000,
+    1000000, 10000000, 100000000, 1000000000
+  };
+  char buf[1 + 10 + 1 + 9];
+  char *end = buf + sizeof(buf);
+  char *str;
+  uint8_t fractionDigits = digits > 9 ? 9 : digits;
+  uint32_t scale = pgm_read_dword(&scales[fractionDigits]);
+  uint32_t integer;
+  uint32_t fraction;
+  uint8_t negative = 0;
+  size_t n;
+
   if (isnan(number)) return print("nan");
   if (isinf(number)) return print("inf");
   if (number > 4294967040.0) return print ("ovf");  // constant determined empirically
   if (number <-4294967040.0) return print ("ovf");  // constant determined empirically
-  
-  // Handle negative numbers
+
   if (number < 0.0)
   {
-    n += print('-');
+    negative = 1;
     number = -number;
   }
-  
+
   // Round correctly so that print(1.999, 2) prints as "2.00"
-  double rounding = 0.5;
-  for (uint8_t i=0; i<digits; ++i)
-  rounding /= 10.0;
-  
-  number += rounding;
-  
-  // Extract the integer part of the number and print it
-  unsigned long int_part = (unsigned long)number;
-  double remainder = number - (double)int_part;
-  n += print(int_part);
-  
-  // Print the decimal point, but only if there are digits beyond
-  if (digits > 0) {
-    n += print(".");
+  integer = (uint32_t)number;
+  fraction = (uint32_t)((number - (double)integer) * scale + 0.5);
+  if (fraction >= scale)
+  {
+    fraction -= scale;
+    integer++;
   }
-  
-  // Extract digits from the remainder one at a time
-  while (digits-- > 0)
+
+  str = end;
+  if (fractionDigits)
   {
-    remainder *= 10.0;
-    int toPrint = int(remainder);
-    n += print(toPrint);
-    remainder -= toPrint;
+    str = decimalDigits(str, fraction);
+    while (str > end - fractionDigits)
+      *--str = '0';
+    *--str = '.';
   }
-  
+  str = decimalDigits(str, integer);
+  if (negative)
+    *--str = '-';
+
+  n = write(str, end - str);
+  while (digits-- > fractionDigits)
+    n += print('0');
+
   return n;
 }
-
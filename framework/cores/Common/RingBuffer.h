@@ -0,0 +1,183 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Lock-free single producer / single consumer ring buffer.
+|| |
+|| | Meant for passing data between an interrupt handler and the main
+|| | program (e.g. the HardwareSerial receive and transmit buffers): one
+|| | side only ever calls enqueue(), the other only dequeue()/peek()/
+|| | flush(), and neither needs to disable interrupts.
+|| |
+|| | The head index is written only by the producer and the tail index
+|| | only by the consumer.  Both are free running 8 bit counters (a single
+|| | load or store on an 8 bit AVR), masked to the buffer size, which must
+|| | be a power of two no larger than 128.
+|| |
+|| | enqueue() of a single element into a full buffer drops it and counts
+|| | an overflow.  The bulk enqueue() adds what fits and returns how many
+|| | elements that was, leaving the rest to the caller.
+|| |
+|| | Wiring Common API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <stdint.h>
+
+// Compiler barrier: element accesses may not be moved across the index
+// update that publishes them to the other side.
+#define RINGBUFFER_BARRIER() __asm__ __volatile__ ("" ::: "memory")
+
+template<typename T, uint8_t rawSize>
+class RingBuffer
+{
+  public:
+    RingBuffer();
+
+    // Producer side
+    bool enqueue(T element);                       // add an element
+    uint8_t enqueue(const T *elements, uint8_t n); // add up to n, returns number added
+    uint8_t room() const;                          // free space
+
+    // Consumer side
+    bool dequeue(T &element);                      // get next element, false if empty
+    uint8_t dequeue(T *elements, uint8_t n);       // get up to n, returns number read
+    T peek() const;                                // next element, without removing it
+    void flush();                                  // discard all elements
+
+    // Either side
+    uint8_t count() const;
+    bool isEmpty() const { return head == tail; }
+    bool isFull() const { return count() >= rawSize; }
+
+    // Elements dropped because the buffer was full.  16 bits, written by
+    // the producer: read with interrupts disabled on an 8 bit AVR.
+    uint16_t overflows() const { return overflowCount; }
+    void clearOverflows() { overflowCount = 0; }
+
+  private:
+    enum { mask = rawSize - 1 };
+
+    // rawSize must be a power of two, and at most 128.
+    typedef char sizeCheck[((rawSize & mask) == 0 && rawSize <= 128) ? 1 : -1];
+
+    volatile uint8_t head;
+    volatile uint8_t tail;
+    volatile uint16_t overflowCount;
+    T raw[rawSize];
+};
+
+template<typename T, uint8_t rawSize>
+RingBuffer<T, rawSize>::RingBuffer()
+{
+  head = tail = 0;
+  overflowCount = 0;
+}
+
+template<typename T, uint8_t rawSize>
+uint8_t RingBuffer<T, rawSize>::count() const
+{
+  return (uint8_t)(head - tail);
+}
+
+template<typename T, uint8_t rawSize>
+uint8_t RingBuffer<T, rawSize>::room() const
+{
+  return rawSize - count();
+}
+
+template<typename T, uint8_t rawSize>
+bool RingBuffer<T, rawSize>::enqueue(T element)
+{
+  uint8_t h = head;
+
+  if ((uint8_t)(h - tail) >= rawSize)
+  {
+    overflowCount++;
+    return false;
+  }
+
+  raw[h & mask] = element;
+  RINGBUFFER_BARRIER();
+  head = h + 1;
+
+  return true;
+}
+
+template<typename T, uint8_t rawSize>
+uint8_t RingBuffer<T, rawSize>::enqueue(const T *elements, uint8_t n)
+{
+  uint8_t h = head;
+  uint8_t space = rawSize - (uint8_t)(h - tail);
+  uint8_t i;
+
+  if (n > space)
+    n = space;
+
+  for (i = 0; i < n; i++)
+    raw[(uint8_t)(h + i) & mask] = elements[i];
+
+  RINGBUFFER_BARRIER();
+  head = h + n;
+
+  return n;
+}
+
+template<typename T, uint8_t rawSize>
+bool RingBuffer<T, rawSize>::dequeue(T &element)
+{
+  uint8_t t = tail;
+
+  if (t == head)
+    return false;
+
+  RINGBUFFER_BARRIER();
+  element = raw[t & mask];
+  RINGBUFFER_BARRIER();
+  tail = t + 1;
+
+  return true;
+}
+
+template<typename T, uint8_t rawSize>
+uint8_t RingBuffer<T, rawSize>::dequeue(T *elements, uint8_t n)
+{
+  uint8_t t = tail;
+  uint8_t available = (uint8_t)(head - t);
+  uint8_t i;
+
+  if (n > available)
+    n = available;
+
+  RINGBUFFER_BARRIER();
+  for (i = 0; i < n; i++)
+    elements[i] = raw[(uint8_t)(t + i) & mask];
+
+  RINGBUFFER_BARRIER();
+  tail = t + n;
+
+  return n;
+}
+
+template<typename T, uint8_t rawSize>
+T RingBuffer<T, rawSize>::peek() const
+{
+  return raw[tail & mask];
+}
+
+template<typename T, uint8_t rawSize>
+void RingBuffer<T, rawSize>::flush()
+{
+  tail = head;
+}
+
+#endif
+// RINGBUFFER_H
@@ -3,6 +3,7 @@
 || @author         David A. Mellis
 || @url            http://wiring.org.co/
 || @contribution   parsing functions based on TextFinder library by Michael Margolis
+|| @contribution   Camilo Reyes <creyes@wiring.org.co>
 ||
 || @description
 || | Base class for streams.
@@ -23,9 +24,9 @@
 
 #include "Wiring.h"
 #include "Stream.h"
+#include "StreamParser.h"
 
 #define PARSE_TIMEOUT 1000  // default number of milli-seconds to wait
-#define NO_SKIP_CHAR  1  // a magic char not found in a valid ASCII numeric field
 
 // private method to read stream with timeout
 int Stream::timedRead()
@@ -99,28 +100,29 @@ bool Stream::findUntil(char *target, size_t targetLen, char *terminator, size_t
 {
   size_t index = 0;  // maximum target string length is 64k bytes!
   size_t termIndex = 0;
+  uint8_t targetFailure[STREAM_MATCH_LENGTH];
+  uint8_t termFailure[STREAM_MATCH_LENGTH];
   int c;
   
   if( *target == 0)
   return true;   // return true if target is a null string
-  while( (c = timedRead()) > 0){
-    
-    if(c != target[index])
-    index = 0; // reset index if any char does not match
-    
-    if( c == target[index]){
-      //////Serial.print("found "); Serial.write(c); Serial.print("index now"); Serial.println(index+1);
-      if(++index >= targetLen){ // return true if all chars in the target match
-        return true;
-      }
-    }
+
+  // a mismatch falls back to the part of the target still matching
+  // (KMP), so "aab" is found in "aaab"
+  streamFailure(target, targetLen < STREAM_MATCH_LENGTH ? targetLen : STREAM_MATCH_LENGTH, targetFailure);
+  if(termLen > 0)
+  streamFailure(terminator, termLen < STREAM_MATCH_LENGTH ? termLen : STREAM_MATCH_LENGTH, termFailure);
+
+  while( (c = timedRead()) >= 0){
+    index = streamMatch(target, targetFailure, STREAM_MATCH_LENGTH, index, c);
+    if(index >= targetLen) // return true if all chars in the target match
+    return true;
     
-    if(termLen > 0 && c == terminator[termIndex]){
-      if(++termIndex >= termLen)
+    if(termLen > 0){
+      termIndex = streamMatch(terminator, termFailure, STREAM_MATCH_LENGTH, termIndex, c);
+      if(termIndex >= termLen)
       return false;       // return false if terminate string found before target string
     }
-    else
-    termIndex = 0;
   }
   return false;
 }
@@ -138,30 +140,14 @@ long Stream::parseInt()
 // this allows format characters (typically commas) in values to be ignored
 long Stream::parseInt(char skipChar)
 {
-  boolean isNegative = false;
-  long value = 0;
+  NumberParser number(false, skipChar);
   int c;
   
-  c = peekNextDigit();
-  // ignore non numeric leading characters
-  if(c < 0)
-  return 0; // zero returned if timeout
-  
-  do{
-    if(c == skipChar)
-    ; // ignore this charactor
-    else if(c == '-')
-    isNegative = true;
-    else if(c >= '0' && c <= '9')        // is c a digit?
-    value = value * 10 + c - '0';
-    read();  // consume the character we got with peek
-    c = timedPeek();
-  }
-  while( (c >= '0' && c <= '9') || c == skipChar );
+  // the character ending the number is left in the stream
+  while((c = timedPeek()) >= 0 && !number.parse(c))
+  read();
   
-  if(isNegative)
-  value = -value;
-  return value;
+  return number.toInt(); // zero returned if timeout before a digit
 }
 
 
@@ -173,41 +159,15 @@ float Stream::parseFloat()
 
 // as above but the given skipChar is ignored
 // this allows format characters (typically commas) in values to be ignored
-float Stream::parseFloat(char skipChar){
-  boolean isNegative = false;
-  boolean isFraction = false;
-  long value = 0;
-  char c;
-  float fraction = 1.0;
-  
-  c = peekNextDigit();
-  // ignore non numeric leading characters
-  if(c < 0)
-  return 0; // zero returned if timeout
+float Stream::parseFloat(char skipChar)
+{
+  NumberParser number(true, skipChar);
+  int c;
   
-  do{
-    if(c == skipChar)
-    ; // ignore
-    else if(c == '-')
-    isNegative = true;
-    else if (c == '.')
-    isFraction = true;
-    else if(c >= '0' && c <= '9')  {      // is c a digit?
-      value = value * 10 + c - '0';
-      if(isFraction)
-      fraction *= 0.1;
-    }
-    read();  // consume the character we got with peek
-    c = timedPeek();
-  }
-  while( (c >= '0' && c <= '9')  || c == '.' || c == skipChar );
+  while((c = timedPeek()) >= 0 && !number.parse(c))
+  read();
   
-  if(isNegative)
-  value = -value;
-  if(isFraction)
-  return value * fraction;
-  else
-  return value;
+  return number.toFloat();
 }
 
 // read characters from stream into buffer
@@ -0,0 +1,209 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Parsers that take a stream's characters as they come.
+|| |
+|| | Wiring Common API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#include <string.h>
+#include "StreamParser.h"
+
+// NumberParser states
+#define NUMBER_SKIPPING 0  // before the number
+#define NUMBER_STARTED  1
+#define NUMBER_FRACTION 2  // after the point
+#define NUMBER_DONE     3
+
+#define NUMBER_NEGATIVE 0x80
+#define NUMBER_DECIMALS 0x40  // a point is part of the number
+#define NUMBER_STATE    0x03
+
+
+// The longest part of the first n characters of target that they end
+// with, shorter than n, worked out from the target itself: for matches
+// longer than the failure table.
+static size_t border(const char *target, size_t n)
+{
+  size_t k;
+
+  for (k = n - 1; k > 0; k--)
+    if (memcmp(target, target + n - k, k) == 0)
+      return k;
+  return 0;
+}
+
+
+void streamFailure(const char *target, uint8_t length, uint8_t *failure)
+{
+  uint8_t k = 0;
+  uint8_t i;
+
+  if (length == 0)
+    return;
+
+  failure[0] = 0;
+  for (i = 1; i < length; i++)
+  {
+    while (k > 0 && target[i] != target[k])
+      k = failure[k - 1];
+    if (target[i] == target[k])
+      k++;
+    failure[i] = k;
+  }
+}
+
+
+size_t streamMatch(const char *target, const uint8_t *failure, uint8_t tableLength,
+                   size_t matched, char c)
+{
+  while (matched > 0 && target[matched] != c)
+    matched = (matched <= tableLength) ? failure[matched - 1] : border(target, matched);
+
+  return target[matched] == c ? matched + 1 : 0;
+}
+
+
+/************ NumberParser ***********************/
+
+NumberParser::NumberParser(bool decimalPoint, char skipChar) : skipChar(skipChar)
+{
+  state = decimalPoint ? NUMBER_DECIMALS : 0;
+  reset();
+}
+
+
+void NumberParser::reset(void)
+{
+  value = 0;
+  decimals = 0;
+  state &= NUMBER_DECIMALS;
+}
+
+
+bool NumberParser::parse(char c)
+{
+  bool digit = (c >= '0' && c <= '9');
+
+  if ((state & NUMBER_STATE) == NUMBER_DONE)
+    reset();
+
+  if ((state & NUMBER_STATE) == NUMBER_SKIPPING)
+  {
+    if (c == '-')
+      state |= NUMBER_NEGATIVE;
+    else if (!digit)
+      return false;
+    state |= NUMBER_STARTED;
+  }
+  else if (c == '.' && (state & NUMBER_DECIMALS))
+  {
+    state = (state & ~NUMBER_STATE) | NUMBER_FRACTION;
+    return false;
+  }
+  else if (!digit && c != skipChar)
+  {
+    state = (state & ~NUMBER_STATE) | NUMBER_DONE;
+    return true;
+  }
+
+  if (digit)
+  {
+    value = value * 10 + c - '0';
+    if ((state & NUMBER_STATE) == NUMBER_FRACTION)
+      decimals++;
+  }
+
+  return false;
+}
+
+
+bool NumberParser::poll(Stream &stream)
+{
+  int c;
+
+  while ((c = stream.peek()) >= 0)
+  {
+    if (parse(c))
+      return true;
+    stream.read();
+  }
+  return false;
+}
+
+
+long NumberParser::toInt(void)
+{
+  return (state & NUMBER_NEGATIVE) ? -value : value;
+}
+
+
+float NumberParser::toFloat(void)
+{
+  float number = value;
+  uint8_t i;
+
+  for (i = 0; i < decimals; i++)
+    number /= 10;
+  return (state & NUMBER_NEGATIVE) ? -number : number;
+}
+
+
+/************ LineReader ***********************/
+
+LineReader::LineReader(char *buffer, size_t size, char terminator)
+  : buffer(buffer), size(size), terminator(terminator)
+{
+  reset();
+}
+
+
+void LineReader::reset(void)
+{
+  count = 0;
+  overflow = false;
+  done = false;
+  if (size)
+    buffer[0] = 0;
+}
+
+
+bool LineReader::parse(char c)
+{
+  if (done)
+    reset();
+
+  if (c == terminator)
+  {
+    done = true;
+    return true;
+  }
+
+  if (count + 1 < size)
+  {
+    buffer[count++] = c;
+    buffer[count] = 0;
+  }
+  else
+    overflow = true;
+
+  return false;
+}
+
+
+bool LineReader::poll(Stream &stream)
+{
+  int c;
+
+  while ((c = stream.read()) >= 0)
+    if (parse(c))
+      return true;
+  return false;
+}
@@ -0,0 +1,187 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Parsers that take a stream's characters as they come.
+|| |
+|| | Stream's parseInt(), find() and readBytesUntil() wait for the
+|| | characters they need (up to the timeout).  These take what there
+|| | is and keep their place: poll() reads the characters available and
+|| | returns true once the item is complete, false for "more needed",
+|| | never waiting.  loop() goes on while a command comes in:
+|| |
+|| |   char line[40];
+|| |   LineReader command(line, sizeof(line));
+|| |   NumberParser speed;
+|| |   const char *keys[] = { "START", "STOP" };
+|| |   StreamFinder<2> keyword(keys);
+|| |
+|| |   if (command.poll(Serial)) ...    // a line in line[]
+|| |   if (speed.poll(Serial))
+|| |     setSpeed(speed.toInt());
+|| |   switch (keyword.poll(Serial)) { case 0: ... }
+|| |
+|| | Each also takes characters one at a time with parse(), from any
+|| | source.  After a complete item the next call starts on the next one.
+|| | Nothing is allocated.
+|| |
+|| | Wiring Common API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#ifndef STREAMPARSER_H
+#define STREAMPARSER_H
+
+#ifdef __cplusplus
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "Stream.h"
+
+#define NO_SKIP_CHAR  1  // a magic char not found in a valid ASCII numeric field
+
+// Characters of a target with a failure table (one byte each): find()
+// keeps two on the stack, StreamFinder one per target.
+#ifndef STREAM_MATCH_LENGTH
+#define STREAM_MATCH_LENGTH 16
+#endif
+
+// The KMP failure table of the first length characters of target: for
+// each prefix, the longest shorter one it ends with.
+void streamFailure(const char *target, uint8_t length, uint8_t *failure);
+
+// The characters of target matched after c, when matched were before
+// (less than its length).  A mismatch falls back through the failure
+// table of the first tableLength characters, so over a stream each
+// character costs constant time on average; past the table, the
+// fallback is worked out from the target itself.
+size_t streamMatch(const char *target, const uint8_t *failure, uint8_t tableLength,
+                   size_t matched, char c);
+
+
+// A number, as Stream::parseInt() and parseFloat() read it: characters
+// before a digit or '-' are skipped, and the first character not part
+// of the number ends it (poll() leaves that one in the stream).
+class NumberParser
+{
+  public:
+    NumberParser(bool decimalPoint = false, char skipChar = NO_SKIP_CHAR);
+
+    // True when c ends the number; c is not part of it.
+    bool parse(char c);
+    bool poll(Stream &stream);
+    void reset(void);
+
+    // The number so far (0 before any digit)
+    long toInt(void);
+    float toFloat(void);
+
+  private:
+    long value;
+    uint8_t decimals;   // digits after the point
+    uint8_t state;
+    char skipChar;
+};
+
+
+// A line (or any text ending in terminator) into a buffer.  The
+// terminator is taken from the stream but not kept; the text is 0
+// terminated, and what doesn't fit in the buffer is dropped.
+class LineReader
+{
+  public:
+    LineReader(char *buffer, size_t size, char terminator = '\n');
+
+    bool parse(char c);
+    bool poll(Stream &stream);
+    void reset(void);
+
+    const char *c_str(void) { return buffer; }
+    size_t length(void) { return count; }
+    // Characters were dropped
+    bool overflowed(void) { return overflow; }
+
+  private:
+    char *buffer;
+    size_t size;
+    size_t count;
+    char terminator;
+    bool overflow;
+    bool done;
+};
+
+
+// Looks for any of N strings in the characters going by.  parse() and
+// poll() return the index of the target found, or -1.  Matching is
+// KMP: no character is read twice, and a partial match that fails
+// falls back to the longest part still matching, through a failure
+// table of the first L characters of each target (N x L bytes, made
+// once by the constructor); targets longer than that are still found,
+// without the guarantee.  The targets are not copied.
+template<uint8_t N, uint8_t L = STREAM_MATCH_LENGTH>
+class StreamFinder
+{
+  public:
+    StreamFinder(const char * const *targets) : targets(targets)
+    {
+      uint8_t i;
+      size_t length;
+
+      for (i = 0; i < N; i++)
+      {
+        length = strlen(targets[i]);
+        streamFailure(targets[i], length < L ? length : L, failure[i]);
+      }
+      reset();
+    }
+
+    int parse(char c)
+    {
+      uint8_t i;
+
+      for (i = 0; i < N; i++)
+      {
+        matched[i] = streamMatch(targets[i], failure[i], L, matched[i], c);
+        if (targets[i][matched[i]] == 0)
+        {
+          reset();
+          return i;
+        }
+      }
+      return -1;
+    }
+
+    int poll(Stream &stream)
+    {
+      int c;
+      int found;
+
+      while ((c = stream.read()) >= 0)
+        if ((found = parse(c)) >= 0)
+          return found;
+      return -1;
+    }
+
+    void reset(void)
+    {
+      uint8_t i;
+
+      for (i = 0; i < N; i++)
+        matched[i] = 0;
+    }
+
+  private:
+    const char * const *targets;
+    uint8_t failure[N][L];
+    size_t matched[N];
+};
+
+#endif  // __cplusplus
+#endif
+// STREAMPARSER_H
@@ -0,0 +1,141 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Fixed capacity string to print into.
+|| |
+|| | StringBuilder<N> holds up to N characters in the object itself.  It
+|| | is a Print, so every print() and println() formats straight into it,
+|| | and it is a String, so it compares, searches and prints like one:
+|| |
+|| |   StringBuilder<40> line;
+|| |   line.print("T=");
+|| |   line.print(temperature, 1);
+|| |   line += " at ";
+|| |   line += millis();
+|| |   if (line.startsWith("T=-")) ...
+|| |   Serial.println(line);
+|| |
+|| | Appending never allocates: what does not fit is dropped, and
+|| | getWriteError() reports it until clear().  Each append costs only
+|| | the characters added.  (Through a String reference it is a plain
+|| | String, and String operations that grow it past N move it to the
+|| | heap, as for a String given its own storage.)
+|| |
+|| | SRAM: N + 1 bytes for the characters, on top of a String and a
+|| | Print.  The String's inline buffer (STRING_INLINE_LENGTH + 1, 12
+|| | bytes by default) goes unused, since the characters are always in
+|| | the builder's own storage; a StringBuilder of up to 11 characters
+|| | is no smaller than a String holding them inline.
+|| |
+|| | Wiring Common API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#ifndef STRINGBUILDER_H
+#define STRINGBUILDER_H
+
+#ifdef __cplusplus
+
+#include <string.h>
+#include "Print.h"
+#include "WString.h"
+
+// N characters in storage, besides the String's unused inline buffer
+// (STRING_INLINE_LENGTH + 1 bytes).
+template<unsigned int N>
+class StringBuilder : public Print, public String
+{
+  public:
+    StringBuilder() : String(storage, N + 1) {}
+    StringBuilder(const char *cstr) : String(storage, N + 1)
+    {
+      print(cstr);
+    }
+    StringBuilder(const StringBuilder &other) : Print(), String(storage, N + 1)
+    {
+      print(other);
+    }
+
+    StringBuilder & operator = (const StringBuilder &rhs)
+    {
+      if (this != &rhs)
+      {
+        clear();
+        print(rhs);
+      }
+      return *this;
+    }
+    StringBuilder & operator = (const String &rhs)
+    {
+      clear();
+      print(rhs);
+      return *this;
+    }
+    StringBuilder & operator = (const char *cstr)
+    {
+      clear();
+      print(cstr);
+      return *this;
+    }
+
+    // Appends anything print() takes.
+    template<typename T>
+    StringBuilder & operator += (const T &value)
+    {
+      print(value);
+      return *this;
+    }
+
+    void clear(void)
+    {
+      len = 0;
+      if (buffer)
+        buffer[0] = 0;
+      clearWriteError();
+    }
+
+    virtual size_t write(uint8_t c)
+    {
+      if (!buffer || len >= capacity)
+      {
+        setWriteError();
+        return 0;
+      }
+      buffer[len++] = c;
+      buffer[len] = 0;
+      return 1;
+    }
+
+    virtual size_t write(const uint8_t *data, size_t size)
+    {
+      size_t room = buffer ? capacity - len : 0;
+
+      if (size > room)
+      {
+        size = room;
+        setWriteError();
+      }
+      if (size)
+      {
+        memcpy(buffer + len, data, size);
+        len += size;
+        buffer[len] = 0;
+      }
+      return size;
+    }
+
+    using Print::write;
+
+  private:
+    char storage[N + 1];
+};
+
+#endif  // __cplusplus
+#endif
+// STRINGBUILDER_H
@@ -4,6 +4,7 @@
 || @url            http://wiring.org.co/
 || @contribution   Brett Hagman <bhagman@wiring.org.co>
 || @contribution   Alexander Brevig <abrevig@wiring.org.co>
+|| @contribution   Camilo Reyes <creyes@wiring.org.co>
 ||
 || @description
 || | Bit shifting methods.
@@ -19,17 +20,19 @@
 
 uint16_t shiftIn(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t count, uint8_t delayTime)
 {
+  DigitalPin data(dataPin);
+  DigitalPin clock(clockPin);
   uint16_t value = 0;
 
   for (uint8_t i = 0; i < count; ++i)
   {
-    digitalWrite(clockPin, HIGH);
+    clock.high();
     delayMicroseconds(delayTime);
     if (bitOrder == LSBFIRST)
-      value |= digitalRead(dataPin) << i;
+      value |= data.read() << i;
     else
-      value |= digitalRead(dataPin) << ((count - 1) - i);
-    digitalWrite(clockPin, LOW);
+      value |= data.read() << ((count - 1) - i);
+    clock.low();
     delayMicroseconds(delayTime);
   }
   return value;
@@ -38,18 +41,20 @@ uint16_t shiftIn(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t co
 
 void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint16_t val, uint8_t count, uint8_t delayTime)
 {
+  DigitalPin data(dataPin);
+  DigitalPin clock(clockPin);
   int i;
 
   for (i = 0; i < count; ++i)
   {
     if (bitOrder == LSBFIRST)
-      digitalWrite(dataPin, !!(val & (1 << i)));
+      data.write(!!(val & (1 << i)));
     else
-      digitalWrite(dataPin, !!(val & (1 << ((count - 1) - i))));
+      data.write(!!(val & (1 << ((count - 1) - i))));
 
-    digitalWrite(clockPin, HIGH);
+    clock.high();
     delayMicroseconds(delayTime);
-    digitalWrite(clockPin, LOW);
+    clock.low();
     delayMicroseconds(delayTime);
   }
 }
@@ -5,6 +5,7 @@
 || @contribution   Hernando Barragan <b@wiring.org.co>
 || @contribution   Brett Hagman <bhagman@wiring.org.co>
 || @contribution   Alexander Brevig <abrevig@wiring.org.co>
+|| @contribution   Camilo Reyes <creyes@wiring.org.co>
 ||
 || @description
 || | String class.
@@ -32,6 +33,18 @@ String::String(const char *cstr)
   if (cstr) copy(cstr, strlen(cstr));
 }
 
+String::String(char *storage, unsigned int size, const char *cstr)
+{
+  init();
+  if (storage && size)
+  {
+    buffer = storage;
+    capacity = size - 1;
+    buffer[0] = 0;
+  }
+  if (cstr) copy(cstr, strlen(cstr));
+}
+
 String::String(const String &value)
 {
   init();
@@ -116,7 +129,7 @@ String::String(double value, unsigned char decimalPlaces)
 
 String::~String()
 {
-  free(buffer);
+  if (flags & STRING_HEAP) free(buffer);
 }
 
 /*********************************************/
@@ -125,17 +138,19 @@ String::~String()
 
 inline void String::init(void)
 {
-  buffer = NULL;
-  capacity = 0;
+  buffer = inlineBuffer;
+  capacity = STRING_INLINE_LENGTH;
   len = 0;
   flags = 0;
+  inlineBuffer[0] = 0;
 }
 
 void String::invalidate(void)
 {
-  if (buffer) free(buffer);
+  if (flags & STRING_HEAP) free(buffer);
   buffer = NULL;
   capacity = len = 0;
+  flags &= ~STRING_HEAP;
 }
 
 unsigned char String::reserve(unsigned int size)
@@ -149,13 +164,43 @@ unsigned char String::reserve(unsigned int size)
   return 0;
 }
 
+// Grows the buffer to hold at least maxStrLen characters, keeping its
+// contents.  An invalid string that fits goes back in the object; on the
+// heap, the capacity at least doubles (or takes just what is asked, if
+// there is not enough memory for that).
 unsigned char String::changeBuffer(unsigned int maxStrLen)
 {
-  char *newbuffer = (char *)realloc(buffer, maxStrLen + 1);
+  unsigned int size = maxStrLen;
+  char *newbuffer;
+
+  if (!buffer && maxStrLen <= STRING_INLINE_LENGTH)
+  {
+    buffer = inlineBuffer;
+    capacity = STRING_INLINE_LENGTH;
+    return 1;
+  }
+
+  if (size < 2 * capacity) size = 2 * capacity;
+
+  if (flags & STRING_HEAP)
+  {
+    newbuffer = (char *)realloc(buffer, size + 1);
+    if (!newbuffer && size > maxStrLen)
+      newbuffer = (char *)realloc(buffer, (size = maxStrLen) + 1);
+  }
+  else
+  {
+    newbuffer = (char *)malloc(size + 1);
+    if (!newbuffer && size > maxStrLen)
+      newbuffer = (char *)malloc((size = maxStrLen) + 1);
+    if (newbuffer && buffer) memcpy(newbuffer, buffer, len + 1);
+  }
+
   if (newbuffer)
   {
     buffer = newbuffer;
-    capacity = maxStrLen;
+    capacity = size;
+    flags |= STRING_HEAP;
     return 1;
   }
   return 0;
@@ -178,28 +223,28 @@ String & String::copy(const char *cstr, unsigned int length)
 }
 
 #ifdef __GXX_EXPERIMENTAL_CXX0X__
+// Takes over the heap buffer of rhs, unless this string has room for it
+// already; inline and caller owned buffers are copied.
 void String::move(String &rhs)
 {
-  if (buffer)
+  if (!rhs.buffer)
   {
-    if (capacity >= rhs.len)
-    {
-      strcpy(buffer, rhs.buffer);
-      len = rhs.len;
-      rhs.len = 0;
-      return;
-    }
-    else
-    {
-      free(buffer);
-    }
+    invalidate();
+    return;
+  }
+  if ((buffer && capacity >= rhs.len) || !(rhs.flags & STRING_HEAP))
+  {
+    copy(rhs.buffer, rhs.len);
+    rhs.len = 0;
+    rhs.buffer[0] = 0;
+    return;
   }
+  if (flags & STRING_HEAP) free(buffer);
   buffer = rhs.buffer;
   capacity = rhs.capacity;
   len = rhs.len;
-  rhs.buffer = NULL;
-  rhs.capacity = 0;
-  rhs.len = 0;
+  flags |= STRING_HEAP;
+  rhs.init();
 }
 #endif
 
@@ -5,10 +5,20 @@
 || @contribution   Hernando Barragan <b@wiring.org.co>
 || @contribution   Brett Hagman <bhagman@wiring.org.co>
 || @contribution   Alexander Brevig <abrevig@wiring.org.co>
+|| @contribution   Camilo Reyes <creyes@wiring.org.co>
 ||
 || @description
 || | String class.
 || |
+|| | Strings of up to STRING_INLINE_LENGTH characters are kept in the
+|| | object itself, without touching the heap: short literals, numbers
+|| | and characters.  Longer ones go to the heap, where the buffer grows
+|| | by doubling, so a string built up piece by piece is reallocated only
+|| | a few times, and a string reused for the same job settles at a size
+|| | and stops allocating.  A string can also be given its own storage
+|| | (a buffer on the stack, or a slice of a larger arena): it is used as
+|| | long as the string fits, and the heap only beyond that.
+|| |
 || | Wiring Common API
 || #
 ||
@@ -28,6 +38,15 @@
 #include "WVector.h"
 //#include "Printable.h"
 
+// Characters kept in the object (the longest long, "-2147483648", fits).
+// Each String takes this many bytes more, plus one.
+#ifndef STRING_INLINE_LENGTH
+#define STRING_INLINE_LENGTH 11
+#endif
+
+// String flags
+#define STRING_HEAP 0x01  // the buffer was allocated (and is freed)
+
 // When compiling programs with this class, the following gcc parameters
 // dramatically increase performance and memory (RAM) efficiency, typically
 // with little or no increase in code size.
@@ -54,6 +73,9 @@ class String
     // fails, the string will be marked as invalid (i.e. "if (s)" will
     // be false).
     String(const char *cstr = "");
+    // With storage of size bytes (the string's capacity is size - 1)
+    // owned by the caller, which must outlive the string.
+    String(char *storage, unsigned int size, const char *cstr = "");
     String(const String &str);
 #ifdef __GXX_EXPERIMENTAL_CXX0X__
     String(String && rval);
@@ -249,7 +271,8 @@ class String
     char *buffer;	        // the actual char array
     unsigned int capacity;  // the array length minus one (for the '\0')
     unsigned int len;       // the String length (not counting the '\0')
-    unsigned char flags;    // unused, for future features
+    unsigned char flags;    // STRING_HEAP
+    char inlineBuffer[STRING_INLINE_LENGTH + 1];
   protected:
     void init(void);
     void invalidate(void);
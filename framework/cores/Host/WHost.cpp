@@ -0,0 +1,1838 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Host core simulator: register file, clock, interrupt dispatch and
+|| | peripheral models for the simulated ATmega1281.  See WHost.h.
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <Wiring.h>
+#include <compat/twi.h>
+#include "WHost.h"
+
+
+/*************************************************************
+ * Register file
+ *************************************************************/
+
+volatile uint8_t _hostRegisterFile[HOST_REGISTER_FILE_SIZE];
+
+// Raw register access for the simulator itself (no service point).
+#define REG(address) (_hostRegisterFile[address])
+
+#define REG_PIN(port)  (0x20 + (port) * 3)
+#define REG_DDR(port)  (0x21 + (port) * 3)
+#define REG_PORT(port) (0x22 + (port) * 3)
+#define HOST_PORTS     7
+
+#define REG_EIFR    0x3C
+#define REG_EIMSK   0x3D
+#define REG_SPCR    0x4C
+#define REG_SPSR    0x4D
+#define REG_SPDR    0x4E
+#define REG_SMCR    0x53
+#define REG_SREG    0x5F
+#define REG_PRR0    0x64
+#define REG_PRR1    0x65
+#define REG_EICRA   0x69
+#define REG_EICRB   0x6A
+#define REG_ADCL    0x78
+#define REG_ADCH    0x79
+#define REG_ADCSRA  0x7A
+#define REG_ADCSRB  0x7B
+#define REG_ADMUX   0x7C
+#define REG_ASSR    0xB6
+#define REG_TWBR    0xB8
+#define REG_TWSR    0xB9
+#define REG_TWDR    0xBB
+#define REG_TWCR    0xBC
+
+#define SREG_I_MASK 0x80
+
+// Sleep modes (SMCR SM2:0)
+#define SLEEP_IDLE_MODE    0
+#define SLEEP_ADC_MODE     1
+#define SLEEP_SAVE_MODE    3
+#define SLEEP_EXT_STANDBY  7
+
+#define NO_EVENT UINT64_MAX
+
+
+static inline uint64_t earliest(uint64_t a, uint64_t b)
+{
+  return (a < b) ? a : b;
+}
+
+
+/*************************************************************
+ * Clock
+ *************************************************************/
+
+static uint64_t now;            // simulated cycles since reset
+static uint8_t clockMode;
+static uint32_t cyclesPerStep;
+static uint64_t realtimeBase;   // host cycles at reset
+static uint64_t realtimeOffset; // cycles added by hostClockAdvance()
+
+static uint8_t sleeping;
+static uint8_t sleepingMode;
+static uint64_t sleepCycles;
+
+
+static uint64_t hostMonotonicCycles(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (uint64_t)ts.tv_sec * F_CPU + ((uint64_t)ts.tv_nsec * F_CPU) / 1000000000UL;
+}
+
+
+/*************************************************************
+ * Timers
+ *************************************************************/
+
+// TIFRn / TIMSKn bits
+#define TIMER_TOV 0x01
+#define TIMER_OCFA 0x02
+#define TIMER_ICF 0x20
+
+typedef struct
+{
+  uint16_t tccra;
+  uint16_t tccrb;
+  uint16_t tcnt;
+  uint16_t ocr[3];
+  uint16_t icr;
+  uint16_t tifr;
+  uint16_t prr;
+  uint8_t prrBit;
+  uint8_t wide;
+  uint8_t channels;
+  uint8_t async;
+} HostTimerDef;
+
+typedef struct
+{
+  uint32_t position;   // position in the counting period (see timerShape())
+  uint32_t count;      // last value written to TCNTn by the simulator
+  uint32_t prescaled;  // cycles counted toward the next timer clock
+} HostTimerState;
+
+static const HostTimerDef timerDefs[] =
+{
+  { 0x44, 0x45, 0x46, { 0x47, 0x48, 0 }, 0, 0x35, REG_PRR0, PRTIM0, 0, 2, 0 },
+  { 0x80, 0x81, 0x84, { 0x88, 0x8A, 0x8C }, 0x86, 0x36, REG_PRR0, PRTIM1, 1, 3, 0 },
+  { 0xB0, 0xB1, 0xB2, { 0xB3, 0xB4, 0 }, 0, 0x37, REG_PRR0, PRTIM2, 0, 2, 1 },
+  { 0x90, 0x91, 0x94, { 0x98, 0x9A, 0x9C }, 0x96, 0x38, REG_PRR1, PRTIM3, 1, 3, 0 },
+  { 0xA0, 0xA1, 0xA4, { 0xA8, 0xAA, 0xAC }, 0xA6, 0x39, REG_PRR1, PRTIM4, 1, 3, 0 },
+  { 0x120, 0x121, 0x124, { 0x128, 0x12A, 0x12C }, 0x126, 0x3A, REG_PRR1, PRTIM5, 1, 3, 0 }
+};
+
+#define HOST_TIMERS (sizeof(timerDefs) / sizeof(timerDefs[0]))
+
+static HostTimerState timers[HOST_TIMERS];
+
+static const uint16_t syncPrescale[8] = { 0, 1, 8, 64, 256, 1024, 0, 0 };
+static const uint16_t asyncPrescale[8] = { 0, 1, 8, 32, 64, 128, 256, 1024 };
+
+// Timer 2 asynchronous clock (Hz)
+#define HOST_CRYSTAL 32768UL
+
+
+static uint16_t reg16(uint16_t address)
+{
+  return REG(address) | (REG(address + 1) << 8);
+}
+
+
+static uint32_t timerRead(const HostTimerDef *def, uint16_t address)
+{
+  return def->wide ? reg16(address) : REG(address);
+}
+
+
+// CPU cycles per timer clock.  With AS2 set, Timer 2 is clocked from a
+// 32.768 kHz watch crystal on TOSC1/2, asleep or not.
+static uint32_t timerPrescale(uint8_t t)
+{
+  const HostTimerDef *def = &timerDefs[t];
+  uint8_t cs = REG(def->tccrb) & 0x07;
+
+  if (REG(def->prr) & _BV(def->prrBit))
+    return 0;
+
+  // While asleep, clkIO is halted in every mode but idle.  The
+  // asynchronous timer keeps running in power save and extended standby.
+  if (sleeping && sleepingMode != SLEEP_IDLE_MODE)
+  {
+    if (!def->async || !(REG(REG_ASSR) & _BV(AS2)))
+      return 0;
+    if (sleepingMode != SLEEP_ADC_MODE && sleepingMode != SLEEP_SAVE_MODE && sleepingMode != SLEEP_EXT_STANDBY)
+      return 0;
+  }
+
+  if (def->async && (REG(REG_ASSR) & _BV(AS2)))
+    return (uint32_t)(((uint64_t)asyncPrescale[cs] * F_CPU + HOST_CRYSTAL / 2) / HOST_CRYSTAL);
+
+  return def->async ? asyncPrescale[cs] : syncPrescale[cs];
+}
+
+
+// Determine TOP and the counting shape for the current waveform mode.
+// A period is mapped onto positions 0..period-1: single slope counters
+// count position 0..TOP, dual slope counters count up on 0..TOP and down
+// on TOP+1..2*TOP-1.
+static void timerShape(uint8_t t, uint32_t *top, uint8_t *dual, uint8_t *tov, uint8_t *icfAtTop)
+{
+  const HostTimerDef *def = &timerDefs[t];
+  uint8_t a = REG(def->tccra) & 0x03;
+  uint8_t b = REG(def->tccrb);
+  uint32_t max = def->wide ? 0xFFFF : 0xFF;
+
+  *dual = 0;
+  *tov = 1;
+  *icfAtTop = 0;
+  *top = max;
+
+  if (!def->wide)
+  {
+    switch (((b >> 1) & 0x04) | a)
+    {
+      case 1: *dual = 1; break;
+      case 2: *top = REG(def->ocr[0]); *tov = (*top == max); break;
+      case 5: *dual = 1; *top = REG(def->ocr[0]); break;
+      case 7: *top = REG(def->ocr[0]); break;
+      default: break;
+    }
+    return;
+  }
+
+  switch (((b >> 1) & 0x0C) | a)
+  {
+    case 1: *dual = 1; *top = 0xFF; break;
+    case 2: *dual = 1; *top = 0x1FF; break;
+    case 3: *dual = 1; *top = 0x3FF; break;
+    case 4: *top = reg16(def->ocr[0]); *tov = (*top == max); break;
+    case 5: *top = 0xFF; break;
+    case 6: *top = 0x1FF; break;
+    case 7: *top = 0x3FF; break;
+    case 8:
+    case 10: *dual = 1; *top = reg16(def->icr); *icfAtTop = 1; break;
+    case 9:
+    case 11: *dual = 1; *top = reg16(def->ocr[0]); break;
+    case 12: *top = reg16(def->icr); *tov = (*top == max); *icfAtTop = 1; break;
+    case 14: *top = reg16(def->icr); *icfAtTop = 1; break;
+    case 15: *top = reg16(def->ocr[0]); break;
+    default: break;
+  }
+}
+
+
+static uint32_t timerPeriod(uint32_t top, uint8_t dual)
+{
+  if (dual)
+    return top ? top * 2 : 1;
+
+  return top + 1;
+}
+
+
+static uint32_t timerDistance(uint32_t from, uint32_t to, uint32_t period)
+{
+  uint32_t d = (to + period - from) % period;
+
+  return d ? d : period;
+}
+
+
+// Pick up a TCNTn written by software, and keep the position inside
+// the current period.
+static void timerSync(uint8_t t, uint32_t period)
+{
+  const HostTimerDef *def = &timerDefs[t];
+  HostTimerState *s = &timers[t];
+  uint32_t count = timerRead(def, def->tcnt);
+
+  if (count != s->count)
+  {
+    s->position = count;
+    s->count = count;
+  }
+
+  if (s->position >= period)
+    s->position %= period;
+}
+
+
+// Timer clocks until the next event (wrap, compare match or TOP).
+static uint32_t timerTicksToEvent(uint8_t t)
+{
+  const HostTimerDef *def = &timerDefs[t];
+  HostTimerState *s = &timers[t];
+  uint32_t top;
+  uint8_t dual, tov, icfAtTop;
+  uint32_t period, ticks;
+  uint8_t c;
+
+  timerShape(t, &top, &dual, &tov, &icfAtTop);
+  period = timerPeriod(top, dual);
+  timerSync(t, period);
+
+  ticks = timerDistance(s->position, 0, period);
+  if (icfAtTop && top)
+    ticks = (uint32_t)earliest(ticks, timerDistance(s->position, top, period));
+
+  for (c = 0; c < def->channels; c++)
+  {
+    uint32_t ocr = timerRead(def, def->ocr[c]);
+
+    if (ocr > top)
+      continue;
+    ticks = (uint32_t)earliest(ticks, timerDistance(s->position, ocr, period));
+    if (dual && ocr > 0 && ocr < top)
+      ticks = (uint32_t)earliest(ticks, timerDistance(s->position, 2 * top - ocr, period));
+  }
+
+  return ticks;
+}
+
+
+static uint64_t timerCyclesToEvent(uint8_t t)
+{
+  uint32_t prescale = timerPrescale(t);
+
+  if (prescale == 0)
+    return NO_EVENT;
+
+  return (uint64_t)timerTicksToEvent(t) * prescale - timers[t].prescaled;
+}
+
+
+// Advance a timer by a number of cycles, which must not pass its next
+// event (see timerCyclesToEvent()).
+static void timerAdvance(uint8_t t, uint64_t cycles)
+{
+  const HostTimerDef *def = &timerDefs[t];
+  HostTimerState *s = &timers[t];
+  uint32_t prescale = timerPrescale(t);
+  uint32_t top, period, ticks, count;
+  uint8_t dual, tov, icfAtTop;
+  uint8_t flags = 0;
+  uint8_t c;
+
+  if (prescale == 0)
+    return;
+
+  ticks = (uint32_t)((s->prescaled + cycles) / prescale);
+  s->prescaled = (uint32_t)((s->prescaled + cycles) % prescale);
+  if (ticks == 0)
+    return;
+
+  timerShape(t, &top, &dual, &tov, &icfAtTop);
+  period = timerPeriod(top, dual);
+  timerSync(t, period);
+
+  s->position = (s->position + ticks) % period;
+  count = (dual && s->position > top) ? 2 * top - s->position : s->position;
+
+  if (s->position == 0 && tov)
+    flags |= TIMER_TOV;
+  if (icfAtTop && s->position == top)
+    flags |= TIMER_ICF;
+  for (c = 0; c < def->channels; c++)
+    if (timerRead(def, def->ocr[c]) == count)
+      flags |= TIMER_OCFA << c;
+
+  REG(def->tifr) |= flags;
+
+  s->count = count;
+  REG(def->tcnt) = count;
+  if (def->wide)
+    REG(def->tcnt + 1) = count >> 8;
+}
+
+
+/*************************************************************
+ * ADC
+ *************************************************************/
+
+static uint16_t analogInputs[16];
+static uint8_t adcConverting;
+static uint8_t adcFirst;
+static uint64_t adcDone;
+static uint8_t adcMux;
+
+
+static uint8_t adcClocked(void)
+{
+  if (REG(REG_PRR0) & _BV(PRADC))
+    return 0;
+
+  return !sleeping || sleepingMode == SLEEP_IDLE_MODE || sleepingMode == SLEEP_ADC_MODE;
+}
+
+
+static void adcStart(void)
+{
+  static const uint8_t prescale[8] = { 2, 2, 4, 8, 16, 32, 64, 128 };
+
+  // the channel is latched when the conversion starts
+  adcMux = (REG(REG_ADMUX) & 0x1F) | ((REG(REG_ADCSRB) & _BV(MUX5)) ? 0x20 : 0);
+  adcConverting = 1;
+  adcDone = now + (uint32_t)(adcFirst ? 25 : 13) * prescale[REG(REG_ADCSRA) & 0x07];
+  adcFirst = 0;
+}
+
+
+static void adcUpdate(void)
+{
+  uint8_t adcsra = REG(REG_ADCSRA);
+
+  if (!(adcsra & _BV(ADEN)))
+  {
+    adcConverting = 0;
+    adcFirst = 1;
+    REG(REG_ADCSRA) &= ~_BV(ADSC);
+    return;
+  }
+
+  if (!adcConverting && (adcsra & _BV(ADSC)) && adcClocked())
+    adcStart();
+
+  // ADSC reads as one for as long as a conversion is in progress;
+  // writing a zero to it has no effect.
+  if (adcConverting)
+    REG(REG_ADCSRA) |= _BV(ADSC);
+}
+
+
+static void adcComplete(void)
+{
+  uint8_t mux = adcMux;
+  uint16_t result;
+
+  if (mux < 8)
+    result = analogInputs[mux];
+  else if (mux >= 0x20 && mux < 0x28)
+    result = analogInputs[mux - 0x18];
+  else if (mux == 0x1E)
+    result = 225;  // 1.1V bandgap against a 5V reference
+  else
+    result = 0;
+
+  if (REG(REG_ADMUX) & _BV(ADLAR))
+    result <<= 6;
+
+  REG(REG_ADCL) = result;
+  REG(REG_ADCH) = result >> 8;
+  REG(REG_ADCSRA) |= _BV(ADIF);
+
+  adcConverting = 0;
+  if ((REG(REG_ADCSRA) & _BV(ADATE)) && (REG(REG_ADCSRB) & 0x07) == 0)
+    adcStart();  // free running
+  else
+    REG(REG_ADCSRA) &= ~_BV(ADSC);
+}
+
+
+/*************************************************************
+ * USARTs
+ *************************************************************/
+
+#define HOST_SERIAL_BUFFER 65536
+
+typedef struct
+{
+  uint16_t ucsra;
+  uint16_t ucsrb;
+  uint16_t ucsrc;
+  uint16_t ubrr;
+  uint16_t udr;
+  uint8_t prr;
+  uint8_t prrBit;
+} HostSerialDef;
+
+typedef struct
+{
+  uint8_t buffer[HOST_SERIAL_BUFFER];
+  size_t head;
+  size_t count;
+} HostSerialBuffer;
+
+static const HostSerialDef serialDefs[HOST_SERIAL_PORTS] =
+{
+  { 0xC0, 0xC1, 0xC2, 0xC4, 0xC6, REG_PRR0, PRUSART0 },
+  { 0xC8, 0xC9, 0xCA, 0xCC, 0xCE, REG_PRR1, PRUSART1 }
+};
+
+static HostSerialBuffer serialRx[HOST_SERIAL_PORTS];
+static HostSerialBuffer serialTx[HOST_SERIAL_PORTS];
+static uint64_t serialRxNext[HOST_SERIAL_PORTS];
+static FILE *serialEcho[HOST_SERIAL_PORTS];
+static uint8_t serialRxData[HOST_SERIAL_PORTS];  // what UDRn reads
+
+
+static void bufferPut(HostSerialBuffer *b, uint8_t data)
+{
+  b->buffer[(b->head + b->count) % HOST_SERIAL_BUFFER] = data;
+  if (b->count < HOST_SERIAL_BUFFER)
+    b->count++;
+  else
+    b->head = (b->head + 1) % HOST_SERIAL_BUFFER;  // drop the oldest
+}
+
+
+static uint8_t bufferGet(HostSerialBuffer *b)
+{
+  uint8_t data = b->buffer[b->head];
+
+  b->head = (b->head + 1) % HOST_SERIAL_BUFFER;
+  b->count--;
+
+  return data;
+}
+
+
+// Cycles taken by one frame at the programmed baud rate and format.
+static uint32_t serialFrameCycles(uint8_t port)
+{
+  const HostSerialDef *def = &serialDefs[port];
+  uint8_t ucsrc = REG(def->ucsrc);
+  uint32_t bits = 1 + 5 + ((ucsrc >> 1) & 0x03) + 1;
+
+  if (REG(def->ucsrb) & _BV(UCSZ02))
+    bits = 1 + 9 + 1;
+  if (ucsrc & _BV(UPM01))
+    bits++;
+  if (ucsrc & _BV(USBS0))
+    bits++;
+
+  return bits * ((reg16(def->ubrr) & 0x0FFF) + 1) * ((REG(def->ucsra) & _BV(U2X0)) ? 8 : 16);
+}
+
+
+// Master SPI mode (UMSELn = 3), handled apart from the frames below.
+static uint8_t serialSpiMode(uint8_t port)
+{
+  const HostSerialDef *def = &serialDefs[port];
+
+  return (REG(def->ucsrc) & (_BV(UMSEL01) | _BV(UMSEL00))) == (_BV(UMSEL01) | _BV(UMSEL00)) &&
+         !(REG(def->prr) & _BV(def->prrBit));
+}
+
+
+static uint8_t serialReceiving(uint8_t port)
+{
+  const HostSerialDef *def = &serialDefs[port];
+
+  if (REG(def->prr) & _BV(def->prrBit))
+    return 0;
+  if (sleeping && sleepingMode != SLEEP_IDLE_MODE)
+    return 0;
+  if (serialSpiMode(port))
+    return 0;
+
+  return serialRx[port].count && (REG(def->ucsrb) & _BV(RXEN0));
+}
+
+
+static void serialDeliver(uint8_t port)
+{
+  const HostSerialDef *def = &serialDefs[port];
+
+  if (REG(def->ucsra) & _BV(RXC0))
+    REG(def->ucsra) |= _BV(DOR0);  // previous character was not read in time
+
+  serialRxData[port] = bufferGet(&serialRx[port]);
+  REG(def->udr) = serialRxData[port];
+  REG(def->ucsra) |= _BV(RXC0);
+  serialRxNext[port] = now + serialFrameCycles(port);
+}
+
+
+// A write to UDRn.  UDRn reads the receive buffer again.
+static void serialWritten(uint8_t port)
+{
+  const HostSerialDef *def = &serialDefs[port];
+  uint8_t data = REG(def->udr);
+
+  REG(def->udr) = serialRxData[port];
+
+  if (REG(def->ucsrb) & _BV(TXEN0))
+  {
+    bufferPut(&serialTx[port], data);
+
+    if (serialEcho[port])
+      fputc(data, serialEcho[port]);
+  }
+}
+
+
+// UDREn reads as set: characters are transmitted as soon as they are
+// written, so the transmit buffer is always empty.
+static void serialUpdate(void)
+{
+  uint8_t port;
+
+  for (port = 0; port < HOST_SERIAL_PORTS; port++)
+  {
+    if (serialSpiMode(port))
+      continue;
+    REG(serialDefs[port].ucsra) |= _BV(UDRE0);
+  }
+}
+
+
+/*************************************************************
+ * USARTs in master SPI mode
+ *************************************************************/
+
+// Transmit is double buffered (a byte waits in UDRn while one shifts),
+// receive holds two bytes.
+typedef struct
+{
+  uint8_t (*device)(uint8_t data);
+  uint8_t shifting;
+  uint8_t out;
+  uint64_t done;
+  uint8_t buffered;
+  uint8_t next;
+  uint8_t received[2];
+  uint8_t receivedCount;
+} HostSerialSpi;
+
+static HostSerialSpi serialSpi[HOST_SERIAL_PORTS];
+
+
+static void serialSpiShift(uint8_t port, uint8_t data)
+{
+  HostSerialSpi *s = &serialSpi[port];
+
+  s->shifting = 1;
+  s->out = data;
+  s->done = now + 16 * (uint32_t)((reg16(serialDefs[port].ubrr) & 0x0FFF) + 1);
+}
+
+
+static void serialSpiWritten(uint8_t port, uint8_t data)
+{
+  const HostSerialDef *def = &serialDefs[port];
+  HostSerialSpi *s = &serialSpi[port];
+
+  // UDRn reads the receive buffer
+  REG(def->udr) = s->received[0];
+
+  if (!serialSpiMode(port) || !(REG(def->ucsrb) & _BV(TXEN0)))
+    return;
+
+  REG(def->ucsra) &= ~_BV(TXC0);
+  if (!s->shifting)
+    serialSpiShift(port, data);
+  else if (!s->buffered)
+  {
+    s->buffered = 1;
+    s->next = data;
+    REG(def->ucsra) &= ~_BV(UDRE0);
+  }
+  // else written while UDREn was clear: lost
+}
+
+
+static void serialSpiComplete(uint8_t port)
+{
+  const HostSerialDef *def = &serialDefs[port];
+  HostSerialSpi *s = &serialSpi[port];
+  uint8_t in = s->device ? s->device(s->out) : 0xFF;
+
+  s->shifting = 0;
+
+  if (REG(def->ucsrb) & _BV(RXEN0))
+  {
+    if (s->receivedCount < 2)
+    {
+      s->received[s->receivedCount++] = in;
+      REG(def->udr) = s->received[0];
+      REG(def->ucsra) |= _BV(RXC0);
+    }
+    else
+      REG(def->ucsra) |= _BV(DOR0);
+  }
+
+  if (s->buffered)
+  {
+    s->buffered = 0;
+    serialSpiShift(port, s->next);
+    REG(def->ucsra) |= _BV(UDRE0);
+  }
+  else
+    REG(def->ucsra) |= _BV(TXC0);
+}
+
+
+// A read of UDRn takes the byte out of the receive buffer.
+static void serialSpiRead(uint8_t port)
+{
+  const HostSerialDef *def = &serialDefs[port];
+  HostSerialSpi *s = &serialSpi[port];
+
+  if (!serialSpiMode(port) || s->receivedCount == 0)
+    return;
+
+  s->received[0] = s->received[1];
+  if (--s->receivedCount)
+  {
+    REG(def->udr) = s->received[0];
+    REG(def->ucsra) |= _BV(RXC0);
+  }
+  else
+    REG(def->ucsra) &= ~_BV(RXC0);
+}
+
+
+/*************************************************************
+ * SPI (master)
+ *************************************************************/
+
+static uint8_t (*spiDevice)(uint8_t data);
+static uint8_t spiShifting;   // a byte is on its way
+static uint8_t spiOut;
+static uint8_t spiIn;         // receive buffer
+static uint64_t spiDone;
+
+
+static uint32_t spiByteCycles(void)
+{
+  static const uint8_t dividers[] = { 4, 16, 64, 128 };
+  uint32_t divider = dividers[REG(REG_SPCR) & 0x03];
+
+  if (REG(REG_SPSR) & _BV(SPI2X))
+    divider /= 2;
+
+  return 8 * divider;
+}
+
+
+static uint8_t spiEnabled(void)
+{
+  return (REG(REG_SPCR) & (_BV(SPE) | _BV(MSTR))) == (_BV(SPE) | _BV(MSTR)) &&
+         !(REG(REG_PRR0) & _BV(PRSPI));
+}
+
+
+// A write to SPDR.  Writing while a byte is shifting is a write
+// collision: the byte is dropped and WCOL set.
+static void spiWritten(uint8_t data)
+{
+  // writes go to the shift register; SPDR reads the receive buffer
+  REG(REG_SPDR) = spiIn;
+
+  if (!spiEnabled())
+    return;
+
+  if (spiShifting)
+  {
+    REG(REG_SPSR) |= _BV(WCOL);
+    return;
+  }
+
+  // SPIF and WCOL are cleared by accessing SPDR after reading SPSR
+  REG(REG_SPSR) &= ~(_BV(SPIF) | _BV(WCOL));
+  spiOut = data;
+  spiShifting = 1;
+  spiDone = now + spiByteCycles();
+}
+
+
+static void spiComplete(void)
+{
+  spiShifting = 0;
+  spiIn = spiDevice ? spiDevice(spiOut) : 0xFF;
+  REG(REG_SPDR) = spiIn;
+  REG(REG_SPSR) |= _BV(SPIF);
+}
+
+
+/*************************************************************
+ * TWI (master)
+ *************************************************************/
+
+// Reserved bit of TWCR, set by the model along with TWINT.  Any write to
+// TWCR clears it, which tells a write of TWINT (clearing the flag and
+// starting the next operation) from the flag still standing.
+#define TWCR_FLAGGED 0x02
+
+// Master operations
+#define TWI_OP_NONE    0
+#define TWI_OP_START   1
+#define TWI_OP_ADDRESS 2
+#define TWI_OP_WRITE   3
+#define TWI_OP_READ    4
+#define TWI_OP_STOP    5
+
+// Where the master is in a transfer
+#define TWI_PHASE_IDLE     0
+#define TWI_PHASE_STARTED  1  // START sent, SLA+R/W next
+#define TWI_PHASE_TRANSMIT 2
+#define TWI_PHASE_RECEIVE  3
+#define TWI_PHASE_NACKED   4  // only STOP or START next
+
+typedef struct
+{
+  uint8_t address;
+  uint8_t *memory;
+  size_t size;
+  size_t pointer;
+  uint8_t pointerSet;  // the first byte written in a transfer sets pointer
+} HostTwiDevice;
+
+static HostTwiDevice twiDevices[HOST_TWI_DEVICES];
+static HostTwiDevice *twiSlave;  // addressed device
+static uint8_t twiFlag;          // TWINT set by the model, not yet cleared
+static uint8_t twiOp;            // operation in progress
+static uint8_t twiOpAck;         // TWEA with the read in progress
+static uint8_t twiStartAfterStop;
+static uint8_t twiPhase;
+static uint8_t twiOwned;         // bus held since our START
+static uint64_t twiDone;         // when the operation in progress completes
+
+
+static uint32_t twiBitCycles(void)
+{
+  uint8_t twps = REG(REG_TWSR) & 0x03;
+
+  return 16 + 2 * (uint32_t)REG(REG_TWBR) * (1 << (2 * twps));
+}
+
+
+static HostTwiDevice *twiDevice(uint8_t address)
+{
+  uint8_t i;
+
+  for (i = 0; i < HOST_TWI_DEVICES; i++)
+    if (twiDevices[i].memory && twiDevices[i].address == address)
+      return &twiDevices[i];
+
+  return NULL;
+}
+
+
+static void twiBegin(uint8_t op, uint32_t bits)
+{
+  twiOp = op;
+  twiDone = now + bits * twiBitCycles();
+}
+
+
+// A write to TWCR with TWINT set: the next operation.
+static void twiCommand(uint8_t twcr)
+{
+  if (twcr & _BV(TWSTO))
+  {
+    twiStartAfterStop = (twcr & _BV(TWSTA)) != 0;
+    twiBegin(TWI_OP_STOP, 1);
+    return;
+  }
+
+  if (twcr & _BV(TWSTA))
+  {
+    twiBegin(TWI_OP_START, 1);
+    return;
+  }
+
+  switch (twiPhase)
+  {
+    case TWI_PHASE_STARTED:
+      twiBegin(TWI_OP_ADDRESS, 9);
+      break;
+    case TWI_PHASE_TRANSMIT:
+      twiBegin(TWI_OP_WRITE, 9);
+      break;
+    case TWI_PHASE_RECEIVE:
+      twiOpAck = (twcr & _BV(TWEA)) != 0;
+      twiBegin(TWI_OP_READ, 9);
+      break;
+  }
+}
+
+
+static void twiRaise(uint8_t status)
+{
+  REG(REG_TWSR) = (REG(REG_TWSR) & 0x03) | status;
+  REG(REG_TWCR) |= _BV(TWINT) | TWCR_FLAGGED;
+  twiFlag = 1;
+}
+
+
+static void twiComplete(void)
+{
+  uint8_t op = twiOp;
+  uint8_t data = REG(REG_TWDR);
+
+  twiOp = TWI_OP_NONE;
+
+  switch (op)
+  {
+    case TWI_OP_START:
+      twiRaise(twiOwned ? TW_REP_START : TW_START);
+      twiOwned = 1;
+      twiPhase = TWI_PHASE_STARTED;
+      break;
+
+    case TWI_OP_ADDRESS:
+      twiSlave = twiDevice(data >> 1);
+      if (data & TW_READ)
+      {
+        twiRaise(twiSlave ? TW_MR_SLA_ACK : TW_MR_SLA_NACK);
+        twiPhase = twiSlave ? TWI_PHASE_RECEIVE : TWI_PHASE_NACKED;
+      }
+      else
+      {
+        twiRaise(twiSlave ? TW_MT_SLA_ACK : TW_MT_SLA_NACK);
+        twiPhase = twiSlave ? TWI_PHASE_TRANSMIT : TWI_PHASE_NACKED;
+        if (twiSlave)
+          twiSlave->pointerSet = 0;
+      }
+      break;
+
+    case TWI_OP_WRITE:
+      if (!twiSlave)
+      {
+        twiRaise(TW_MT_DATA_NACK);
+        twiPhase = TWI_PHASE_NACKED;
+        break;
+      }
+      if (!twiSlave->pointerSet)
+      {
+        twiSlave->pointer = data;
+        twiSlave->pointerSet = 1;
+      }
+      else if (twiSlave->pointer < twiSlave->size)
+        twiSlave->memory[twiSlave->pointer++] = data;
+      else
+      {
+        twiRaise(TW_MT_DATA_NACK);
+        twiPhase = TWI_PHASE_NACKED;
+        break;
+      }
+      twiRaise(TW_MT_DATA_ACK);
+      break;
+
+    case TWI_OP_READ:
+      if (twiSlave && twiSlave->pointer < twiSlave->size)
+        REG(REG_TWDR) = twiSlave->memory[twiSlave->pointer++];
+      else
+        REG(REG_TWDR) = 0xFF;  // nothing driving SDA
+      twiRaise(twiOpAck ? TW_MR_DATA_ACK : TW_MR_DATA_NACK);
+      if (!twiOpAck)
+        twiPhase = TWI_PHASE_NACKED;
+      break;
+
+    case TWI_OP_STOP:
+      REG(REG_TWCR) &= ~_BV(TWSTO);
+      REG(REG_TWSR) = (REG(REG_TWSR) & 0x03) | TW_NO_INFO;
+      twiOwned = 0;
+      twiPhase = TWI_PHASE_IDLE;
+      if (twiStartAfterStop)
+        twiBegin(TWI_OP_START, 1);
+      break;
+  }
+}
+
+
+// Picks up writes to TWCR.  Writing TWINT clears the flag and starts the
+// next operation; writing without it leaves the flag standing.
+static void twiUpdate(void)
+{
+  uint8_t twcr = REG(REG_TWCR);
+
+  if (!(twcr & _BV(TWEN)) || (REG(REG_PRR0) & _BV(PRTWI)))
+  {
+    twiFlag = 0;
+    twiOp = TWI_OP_NONE;
+    twiOwned = 0;
+    twiPhase = TWI_PHASE_IDLE;
+    REG(REG_TWCR) &= ~(_BV(TWINT) | TWCR_FLAGGED);
+    return;
+  }
+
+  if (twiFlag && (twcr & TWCR_FLAGGED))
+    return;
+
+  if (twcr & _BV(TWINT))
+  {
+    twiFlag = 0;
+    REG(REG_TWCR) &= ~_BV(TWINT);
+    if (twiOp == TWI_OP_NONE)
+      twiCommand(twcr);
+  }
+  else if (twiFlag)
+    REG(REG_TWCR) |= _BV(TWINT) | TWCR_FLAGGED;
+}
+
+
+/*************************************************************
+ * Digital inputs and external interrupts
+ *************************************************************/
+
+static uint8_t pinDriven[HOST_PORTS];
+static uint8_t pinLevel[HOST_PORTS];
+static uint8_t pinLast[HOST_PORTS];
+
+
+static void pinsUpdate(void)
+{
+  uint8_t port, n;
+
+  for (port = 0; port < HOST_PORTS; port++)
+  {
+    uint8_t external = ~REG(REG_DDR(port)) & pinDriven[port];
+
+    // Outputs and undriven inputs read back PORTx (an undriven input
+    // with the pull up enabled reads high).
+    REG(REG_PIN(port)) = (REG(REG_PORT(port)) & ~external) | (pinLevel[port] & external);
+  }
+
+  // INT3:0 are on PD3:0, INT7:4 on PE7:4
+  for (n = 0; n < 8; n++)
+  {
+    uint8_t port = (n < 4) ? 3 : 4;
+    uint8_t mask = _BV(n);
+    uint8_t level = REG(REG_PIN(port)) & mask;
+    uint8_t last = pinLast[port] & mask;
+    uint8_t sense = ((n < 4) ? (REG(REG_EICRA) >> (2 * n)) : (REG(REG_EICRB) >> (2 * (n - 4)))) & 0x03;
+
+    // A low level interrupt has no flag of its own: it is asserted for as
+    // long as the pin is held low (modelled through INTFn while enabled).
+    if (sense == 0)
+    {
+      if (!level && (REG(REG_EIMSK) & mask))
+        REG(REG_EIFR) |= mask;
+      else
+        REG(REG_EIFR) &= ~mask;
+    }
+    else if ((sense == 1 && level != last) ||
+             (sense == 2 && last && !level) ||
+             (sense == 3 && !last && level))
+      REG(REG_EIFR) |= mask;
+  }
+
+  for (port = 0; port < HOST_PORTS; port++)
+    pinLast[port] = REG(REG_PIN(port));
+}
+
+
+/*************************************************************
+ * Register access
+ *************************************************************/
+
+// The sources that touch registers are built with -fsanitize=thread for
+// its callbacks alone (see the makefile; no ThreadSanitizer runtime is
+// linked): the compiler calls one of these before every volatile
+// access, through a pointer as well as through the register macros.  An access to the register file is a
+// service point.  The access itself happens after the callback, so an
+// access with a side effect (a data register, a write to PINx) is held
+// here and handed to its peripheral at the next callback, service
+// point or return from an interrupt handler.
+
+static volatile uint8_t *accessRegister;  // held, or NULL
+static uint8_t accessWrite;
+
+
+static int8_t serialDataPort(uint16_t address)
+{
+  uint8_t port;
+
+  for (port = 0; port < HOST_SERIAL_PORTS; port++)
+    if (address == serialDefs[port].udr)
+      return port;
+  return -1;
+}
+
+
+// The port whose PINx is at address, or -1.
+static int8_t pinPort(uint16_t address)
+{
+  if (address < REG_PIN(0) || address >= REG_PIN(HOST_PORTS) ||
+      (address - REG_PIN(0)) % 3)
+    return -1;
+  return (address - REG_PIN(0)) / 3;
+}
+
+
+static void accessDone(void)
+{
+  uint16_t address;
+  int8_t port;
+
+  if (!accessRegister)
+    return;
+  address = _hostRegisterAddress(accessRegister);
+  accessRegister = NULL;
+
+  if (address == REG_SPDR)
+  {
+    if (accessWrite)
+      spiWritten(REG(REG_SPDR));
+  }
+  else if ((port = serialDataPort(address)) >= 0)
+  {
+    if (serialSpiMode(port))
+    {
+      if (accessWrite)
+        serialSpiWritten(port, REG(address));
+      else
+        serialSpiRead(port);
+    }
+    else if (accessWrite)
+      serialWritten(port);
+  }
+  else if ((port = pinPort(address)) >= 0 && accessWrite)
+  {
+    // ones written to PINx toggle PORTx
+    REG(REG_PORT(port)) ^= REG(address);
+    pinsUpdate();
+  }
+}
+
+
+static void access(void *p, uint8_t size, uint8_t write)
+{
+  volatile uint8_t *reg = (volatile uint8_t *)p;
+
+  accessDone();
+
+  if (reg < _hostRegisterFile || reg >= _hostRegisterFile + HOST_REGISTER_FILE_SIZE)
+    return;
+
+  _hostService();
+
+  if (size == 1)
+  {
+    uint16_t address = _hostRegisterAddress(reg);
+
+    if (address == REG_SPDR || serialDataPort(address) >= 0 ||
+        (write && pinPort(address) >= 0))
+    {
+      accessRegister = reg;
+      accessWrite = write;
+    }
+  }
+}
+
+
+#define HOST_ACCESS(N) \
+  extern "C" void __tsan_volatile_read##N(void *p) { access(p, N, 0); } \
+  extern "C" void __tsan_volatile_write##N(void *p) { access(p, N, 1); } \
+  extern "C" void __tsan_read##N(void *p) { } \
+  extern "C" void __tsan_write##N(void *p) { }
+
+HOST_ACCESS(1)
+HOST_ACCESS(2)
+HOST_ACCESS(4)
+HOST_ACCESS(8)
+HOST_ACCESS(16)
+
+// 16 bit registers, their alignment unknown to the compiler, come as
+// ranges.
+extern "C" void __tsan_read_range(void *p, size_t size) { access(p, size, 0); }
+extern "C" void __tsan_write_range(void *p, size_t size) { access(p, size, 1); }
+
+extern "C" void __tsan_init(void) { }
+extern "C" void __tsan_vptr_update(void **p, void *value) { }
+
+
+/*************************************************************
+ * Interrupts
+ *************************************************************/
+
+extern "C" void __host_bad_interrupt(void)
+{
+}
+
+#define HOST_VECTOR(N) \
+  extern "C" void __vector_ ## N(void) __attribute__((weak, alias("__host_bad_interrupt")));
+
+HOST_VECTOR(1) HOST_VECTOR(2) HOST_VECTOR(3) HOST_VECTOR(4) HOST_VECTOR(5)
+HOST_VECTOR(6) HOST_VECTOR(7) HOST_VECTOR(8) HOST_VECTOR(9) HOST_VECTOR(10)
+HOST_VECTOR(11) HOST_VECTOR(12) HOST_VECTOR(13) HOST_VECTOR(14) HOST_VECTOR(15)
+HOST_VECTOR(16) HOST_VECTOR(17) HOST_VECTOR(18) HOST_VECTOR(19) HOST_VECTOR(20)
+HOST_VECTOR(21) HOST_VECTOR(22) HOST_VECTOR(23) HOST_VECTOR(24) HOST_VECTOR(25)
+HOST_VECTOR(26) HOST_VECTOR(27) HOST_VECTOR(28) HOST_VECTOR(29) HOST_VECTOR(30)
+HOST_VECTOR(31) HOST_VECTOR(32) HOST_VECTOR(33) HOST_VECTOR(34) HOST_VECTOR(35)
+HOST_VECTOR(36) HOST_VECTOR(37) HOST_VECTOR(38) HOST_VECTOR(39) HOST_VECTOR(40)
+HOST_VECTOR(41) HOST_VECTOR(42) HOST_VECTOR(43) HOST_VECTOR(44) HOST_VECTOR(45)
+HOST_VECTOR(46) HOST_VECTOR(47) HOST_VECTOR(48) HOST_VECTOR(49) HOST_VECTOR(50)
+HOST_VECTOR(51) HOST_VECTOR(52) HOST_VECTOR(53) HOST_VECTOR(54) HOST_VECTOR(55)
+HOST_VECTOR(56)
+
+static void (* const vectors[HOST_VECTORS])(void) =
+{
+  __host_bad_interrupt,
+  __vector_1, __vector_2, __vector_3, __vector_4, __vector_5,
+  __vector_6, __vector_7, __vector_8, __vector_9, __vector_10,
+  __vector_11, __vector_12, __vector_13, __vector_14, __vector_15,
+  __vector_16, __vector_17, __vector_18, __vector_19, __vector_20,
+  __vector_21, __vector_22, __vector_23, __vector_24, __vector_25,
+  __vector_26, __vector_27, __vector_28, __vector_29, __vector_30,
+  __vector_31, __vector_32, __vector_33, __vector_34, __vector_35,
+  __vector_36, __vector_37, __vector_38, __vector_39, __vector_40,
+  __vector_41, __vector_42, __vector_43, __vector_44, __vector_45,
+  __vector_46, __vector_47, __vector_48, __vector_49, __vector_50,
+  __vector_51, __vector_52, __vector_53, __vector_54, __vector_55,
+  __vector_56
+};
+
+// Interrupt sources of the modelled peripherals, in priority order.
+// An interrupt is asserted while its flag and enable bits are both set.
+typedef struct
+{
+  uint8_t vector;
+  uint16_t flag;
+  uint8_t flagMask;
+  uint16_t enable;
+  uint8_t enableMask;
+  uint8_t clear;  // flag is cleared by hardware when the vector executes
+} HostInterruptSource;
+
+#define TIMER_SOURCES(CAPT, COMPA, TIFR, TIMSK) \
+  { CAPT, TIFR, 0x20, TIMSK, 0x20, 1 }, \
+  { COMPA, TIFR, 0x02, TIMSK, 0x02, 1 }, \
+  { COMPA + 1, TIFR, 0x04, TIMSK, 0x04, 1 }, \
+  { COMPA + 2, TIFR, 0x08, TIMSK, 0x08, 1 }, \
+  { COMPA + 3, TIFR, 0x01, TIMSK, 0x01, 1 }
+
+static const HostInterruptSource sources[] =
+{
+  { INT0_vect_num, REG_EIFR, 0x01, REG_EIMSK, 0x01, 1 },
+  { INT1_vect_num, REG_EIFR, 0x02, REG_EIMSK, 0x02, 1 },
+  { INT2_vect_num, REG_EIFR, 0x04, REG_EIMSK, 0x04, 1 },
+  { INT3_vect_num, REG_EIFR, 0x08, REG_EIMSK, 0x08, 1 },
+  { INT4_vect_num, REG_EIFR, 0x10, REG_EIMSK, 0x10, 1 },
+  { INT5_vect_num, REG_EIFR, 0x20, REG_EIMSK, 0x20, 1 },
+  { INT6_vect_num, REG_EIFR, 0x40, REG_EIMSK, 0x40, 1 },
+  { INT7_vect_num, REG_EIFR, 0x80, REG_EIMSK, 0x80, 1 },
+  { TIMER2_COMPA_vect_num, 0x37, 0x02, 0x70, 0x02, 1 },
+  { TIMER2_COMPB_vect_num, 0x37, 0x04, 0x70, 0x04, 1 },
+  { TIMER2_OVF_vect_num, 0x37, 0x01, 0x70, 0x01, 1 },
+  TIMER_SOURCES(TIMER1_CAPT_vect_num, TIMER1_COMPA_vect_num, 0x36, 0x6F),
+  { TIMER0_COMPA_vect_num, 0x35, 0x02, 0x6E, 0x02, 1 },
+  { TIMER0_COMPB_vect_num, 0x35, 0x04, 0x6E, 0x04, 1 },
+  { TIMER0_OVF_vect_num, 0x35, 0x01, 0x6E, 0x01, 1 },
+  { SPI_STC_vect_num, REG_SPSR, 0x80, REG_SPCR, 0x80, 1 },
+  { USART0_RX_vect_num, 0xC0, 0x80, 0xC1, 0x80, 1 },
+  { USART0_UDRE_vect_num, 0xC0, 0x20, 0xC1, 0x20, 0 },
+  { ADC_vect_num, REG_ADCSRA, 0x10, REG_ADCSRA, 0x08, 1 },
+  TIMER_SOURCES(TIMER3_CAPT_vect_num, TIMER3_COMPA_vect_num, 0x38, 0x71),
+  { USART1_RX_vect_num, 0xC8, 0x80, 0xC9, 0x80, 1 },
+  { USART1_UDRE_vect_num, 0xC8, 0x20, 0xC9, 0x20, 0 },
+  { TWI_vect_num, REG_TWCR, 0x80, REG_TWCR, 0x01, 0 },
+  TIMER_SOURCES(TIMER4_CAPT_vect_num, TIMER4_COMPA_vect_num, 0x39, 0x72),
+  TIMER_SOURCES(TIMER5_CAPT_vect_num, TIMER5_COMPA_vect_num, 0x3A, 0x73)
+};
+
+#define HOST_SOURCES (sizeof(sources) / sizeof(sources[0]))
+
+static uint64_t pending;  // raised by hostInterrupt()
+static uint32_t interruptCounts[HOST_VECTORS];
+
+
+// Highest priority asserted interrupt, or 0 if none.
+static uint8_t interruptAsserted(const HostInterruptSource **source)
+{
+  uint8_t best = 0;
+  uint8_t i;
+
+  *source = NULL;
+
+  for (i = 0; i < HOST_SOURCES; i++)
+  {
+    const HostInterruptSource *s = &sources[i];
+
+    if ((REG(s->flag) & s->flagMask) && (REG(s->enable) & s->enableMask))
+    {
+      *source = s;
+      best = s->vector;
+      break;
+    }
+  }
+
+  if (pending)
+  {
+    uint8_t v = __builtin_ctzll(pending);
+
+    if (!best || v < best)
+    {
+      *source = NULL;
+      best = v;
+    }
+  }
+
+  return best;
+}
+
+
+static void interruptCall(uint8_t v)
+{
+  if (vectors[v] == __host_bad_interrupt)
+  {
+    fprintf(stderr, "host: interrupt %d has no handler (__bad_interrupt)\n", v);
+    abort();
+  }
+
+  vectors[v]();
+  accessDone();
+
+  if (v == TWI_vect_num)
+    twiUpdate();
+}
+
+
+static void interruptDispatch(void)
+{
+  const HostInterruptSource *source;
+  uint8_t v;
+
+  while ((REG(REG_SREG) & SREG_I_MASK) && (v = interruptAsserted(&source)))
+  {
+    if (source)
+    {
+      if (source->clear)
+        REG(source->flag) &= ~source->flagMask;
+    }
+    else
+      pending &= ~(1ULL << v);
+
+    if (v == USART0_RX_vect_num)
+      REG(serialDefs[0].ucsra) &= ~_BV(RXC0);
+    else if (v == USART1_RX_vect_num)
+      REG(serialDefs[1].ucsra) &= ~_BV(RXC0);
+
+    interruptCounts[v]++;
+
+    // The I flag is cleared while the handler runs, and set by RETI.
+    REG(REG_SREG) &= ~SREG_I_MASK;
+    interruptCall(v);
+    REG(REG_SREG) |= SREG_I_MASK;
+  }
+}
+
+
+/*************************************************************
+ * Simulation
+ *************************************************************/
+
+static uint64_t nextEvent(void)
+{
+  uint64_t next = NO_EVENT;
+  uint8_t i;
+
+  for (i = 0; i < HOST_TIMERS; i++)
+    next = earliest(next, timerCyclesToEvent(i));
+
+  if (adcConverting && adcClocked())
+    next = earliest(next, adcDone > now ? adcDone - now : 1);
+
+  for (i = 0; i < HOST_SERIAL_PORTS; i++)
+    if (serialReceiving(i))
+      next = earliest(next, serialRxNext[i] > now ? serialRxNext[i] - now : 1);
+
+  for (i = 0; i < HOST_SERIAL_PORTS; i++)
+    if (serialSpi[i].shifting)
+      next = earliest(next, serialSpi[i].done > now ? serialSpi[i].done - now : 1);
+
+  if (spiShifting)
+    next = earliest(next, spiDone > now ? spiDone - now : 1);
+
+  if (twiOp != TWI_OP_NONE)
+    next = earliest(next, twiDone > now ? twiDone - now : 1);
+
+  return next;
+}
+
+
+static void advance(uint64_t cycles)
+{
+  uint8_t i;
+
+  for (i = 0; i < HOST_TIMERS; i++)
+    timerAdvance(i, cycles);
+
+  now += cycles;
+  if (sleeping)
+    sleepCycles += cycles;
+
+  if (adcConverting && adcClocked())
+  {
+    if (now >= adcDone)
+      adcComplete();
+  }
+  else if (adcConverting)
+    adcDone += cycles;  // conversion is suspended
+
+  for (i = 0; i < HOST_SERIAL_PORTS; i++)
+  {
+    if (!serialReceiving(i))
+      serialRxNext[i] = now + serialFrameCycles(i);
+    else if (now >= serialRxNext[i])
+      serialDeliver(i);
+  }
+
+  for (i = 0; i < HOST_SERIAL_PORTS; i++)
+    if (serialSpi[i].shifting && now >= serialSpi[i].done)
+      serialSpiComplete(i);
+
+  if (spiShifting && now >= spiDone)
+    spiComplete();
+
+  if (twiOp != TWI_OP_NONE && now >= twiDone)
+    twiComplete();
+}
+
+
+static void wakeCheck(void)
+{
+  const HostInterruptSource *source;
+
+  if (sleeping && interruptAsserted(&source))
+    sleeping = 0;
+}
+
+
+// Run the simulation up to the given cycle, dispatching interrupts as
+// they occur.  Handlers may re-enter through their own register
+// accesses, which advances the clock further.
+static void advanceTo(uint64_t target)
+{
+  accessDone();
+  pinsUpdate();
+  serialUpdate();
+  adcUpdate();
+  twiUpdate();
+  wakeCheck();
+  interruptDispatch();
+
+  while (now < target)
+  {
+    uint64_t step = earliest(target - now, nextEvent());
+
+    advance(step);
+    adcUpdate();
+    wakeCheck();
+    interruptDispatch();
+  }
+}
+
+
+void _hostService(void)
+{
+  if (clockMode == HOST_CLOCK_STEPPED)
+    advanceTo(now + cyclesPerStep);
+  else
+    advanceTo(hostMonotonicCycles() - realtimeBase + realtimeOffset);
+}
+
+
+void _hostCli(void)
+{
+  _hostService();
+  REG(REG_SREG) &= ~SREG_I_MASK;
+}
+
+
+void _hostSei(void)
+{
+  REG(REG_SREG) |= SREG_I_MASK;
+  _hostService();
+}
+
+
+void _hostSleep(void)
+{
+  const HostInterruptSource *source;
+
+  if (!(REG(REG_SMCR) & _BV(SE)))
+    return;
+
+  sleepingMode = (REG(REG_SMCR) >> 1) & 0x07;
+  sleeping = 1;
+
+  // Entering ADC noise reduction mode starts a conversion.
+  if (sleepingMode == SLEEP_ADC_MODE && (REG(REG_ADCSRA) & _BV(ADEN)) && !adcConverting)
+    adcStart();
+
+  while (sleeping)
+  {
+    uint64_t next = nextEvent();
+
+    // Nothing left that could ever wake the part up.
+    if (next == NO_EVENT && !interruptAsserted(&source))
+    {
+      sleeping = 0;
+      break;
+    }
+
+    if (clockMode == HOST_CLOCK_STEPPED)
+      advanceTo(now + (next == NO_EVENT ? 1 : next));
+    else
+      _hostService();
+  }
+}
+
+
+void _hostDelayCycles(uint32_t cycles)
+{
+  uint64_t end = now + cycles;
+
+  if (clockMode == HOST_CLOCK_STEPPED)
+    advanceTo(end);
+  else
+    while (now < end)
+      _hostService();
+}
+
+
+/*************************************************************
+ * avr-libc <stdlib.h> and <string.h> extensions
+ *************************************************************/
+
+char *ultoa(unsigned long value, char *s, int radix)
+{
+  char buffer[8 * sizeof(unsigned long) + 1];
+  char *p = &buffer[sizeof(buffer) - 1];
+
+  *p = '\0';
+  do
+  {
+    uint8_t digit = value % radix;
+
+    *--p = (digit < 10) ? '0' + digit : 'a' + digit - 10;
+    value /= radix;
+  } while (value);
+
+  return strcpy(s, p);
+}
+
+
+char *ltoa(long value, char *s, int radix)
+{
+  if (value < 0 && radix == 10)
+  {
+    s[0] = '-';
+    ultoa(-(unsigned long)value, s + 1, radix);
+    return s;
+  }
+
+  return ultoa((unsigned long)value, s, radix);
+}
+
+
+char *utoa(unsigned int value, char *s, int radix)
+{
+  return ultoa(value, s, radix);
+}
+
+
+char *itoa(int value, char *s, int radix)
+{
+  // int is 16 bits on the AVR: negative values print as such in any radix
+  if (value < 0 && radix != 10)
+    return ultoa((uint16_t)value, s, radix);
+
+  return ltoa(value, s, radix);
+}
+
+
+char *dtostrf(double value, signed char width, unsigned char precision, char *s)
+{
+  sprintf(s, "%*.*f", width, precision, value);
+
+  return s;
+}
+
+
+#if defined(HOST_STRLCPY)
+size_t strlcpy(char *dst, const char *src, size_t size)
+{
+  size_t length = strlen(src);
+
+  if (size)
+  {
+    size_t n = (length < size - 1) ? length : size - 1;
+
+    memcpy(dst, src, n);
+    dst[n] = '\0';
+  }
+
+  return length;
+}
+
+
+size_t strlcat(char *dst, const char *src, size_t size)
+{
+  size_t used = strnlen(dst, size);
+
+  if (used == size)
+    return size + strlen(src);
+
+  return used + strlcpy(dst + used, src, size - used);
+}
+#endif
+
+
+/*************************************************************
+ * Host API
+ *************************************************************/
+
+static uint8_t eeprom[E2END + 1];
+
+
+__attribute__((constructor(101)))
+void hostReset(void)
+{
+  uint8_t i;
+
+  memset((void *)_hostRegisterFile, 0, sizeof(_hostRegisterFile));
+  REG(serialDefs[0].ucsra) = _BV(UDRE0);
+  REG(serialDefs[1].ucsra) = _BV(UDRE0);
+  REG(REG_TWSR) = 0xF8;
+
+  now = 0;
+  realtimeBase = hostMonotonicCycles();
+  realtimeOffset = 0;
+  sleeping = 0;
+  sleepCycles = 0;
+
+  memset(timers, 0, sizeof(timers));
+  memset(analogInputs, 0, sizeof(analogInputs));
+  adcConverting = 0;
+  adcFirst = 1;
+
+  for (i = 0; i < HOST_SERIAL_PORTS; i++)
+  {
+    serialRx[i].head = serialRx[i].count = 0;
+    serialTx[i].head = serialTx[i].count = 0;
+    serialRxNext[i] = 0;
+    serialRxData[i] = 0;
+  }
+  memset(serialSpi, 0, sizeof(serialSpi));
+
+  memset(pinDriven, 0, sizeof(pinDriven));
+  memset(pinLevel, 0, sizeof(pinLevel));
+  memset(pinLast, 0, sizeof(pinLast));
+
+  pending = 0;
+  memset(interruptCounts, 0, sizeof(interruptCounts));
+
+  memset(eeprom, 0xFF, sizeof(eeprom));
+
+  spiDevice = NULL;
+  spiShifting = 0;
+  spiIn = 0;
+
+  memset(twiDevices, 0, sizeof(twiDevices));
+  twiSlave = NULL;
+  twiFlag = 0;
+  twiOp = TWI_OP_NONE;
+  twiOwned = 0;
+  twiPhase = TWI_PHASE_IDLE;
+}
+
+
+void hostClockMode(uint8_t mode, uint32_t step)
+{
+  clockMode = mode;
+  cyclesPerStep = step ? step : 1;
+
+  // Continue real time from the current simulated time.
+  realtimeBase = hostMonotonicCycles();
+  realtimeOffset = now;
+}
+
+
+void hostClockAdvance(uint32_t cycles)
+{
+  realtimeOffset += cycles;
+  advanceTo(now + cycles);
+}
+
+
+uint64_t hostClockCycles(void)
+{
+  return now;
+}
+
+
+uint64_t hostSleepCycles(void)
+{
+  return sleepCycles;
+}
+
+
+void hostInterrupt(uint8_t vectorNumber)
+{
+  if (vectorNumber == 0 || vectorNumber >= HOST_VECTORS)
+    return;
+
+  pending |= 1ULL << vectorNumber;
+  advanceTo(now);
+}
+
+
+uint32_t hostInterruptCount(uint8_t vectorNumber)
+{
+  return (vectorNumber < HOST_VECTORS) ? interruptCounts[vectorNumber] : 0;
+}
+
+
+static int8_t hostPort(uint8_t pin, uint8_t *mask)
+{
+  volatile uint8_t *reg;
+
+  if (pin >= TOTAL_PINS)
+    return -1;
+
+  reg = portInputRegister(digitalPinToPort(pin));
+  *mask = digitalPinToBitMask(pin);
+
+  return (_hostRegisterAddress(reg) - REG_PIN(0)) / 3;
+}
+
+
+void hostPinInput(uint8_t pin, uint8_t level)
+{
+  uint8_t mask;
+  int8_t port = hostPort(pin, &mask);
+
+  if (port < 0)
+    return;
+
+  pinDriven[port] |= mask;
+  if (level)
+    pinLevel[port] |= mask;
+  else
+    pinLevel[port] &= ~mask;
+
+  advanceTo(now);
+}
+
+
+void hostPinRelease(uint8_t pin)
+{
+  uint8_t mask;
+  int8_t port = hostPort(pin, &mask);
+
+  if (port < 0)
+    return;
+
+  pinDriven[port] &= ~mask;
+  advanceTo(now);
+}
+
+
+void hostAnalogInput(uint8_t channel, uint16_t value)
+{
+  if (channel < 16)
+    analogInputs[channel] = value & 0x3FF;
+}
+
+
+void hostSerialReceive(uint8_t port, const uint8_t *data, size_t length)
+{
+  if (port >= HOST_SERIAL_PORTS)
+    return;
+
+  while (length--)
+    bufferPut(&serialRx[port], *data++);
+}
+
+
+size_t hostSerialPending(uint8_t port)
+{
+  return (port < HOST_SERIAL_PORTS) ? serialRx[port].count : 0;
+}
+
+
+size_t hostSerialTransmitted(uint8_t port, uint8_t *data, size_t length)
+{
+  size_t n = 0;
+
+  if (port >= HOST_SERIAL_PORTS)
+    return 0;
+
+  advanceTo(now);
+
+  if (data == NULL)
+    return serialTx[port].count;
+
+  while (n < length && serialTx[port].count)
+    data[n++] = bufferGet(&serialTx[port]);
+
+  return n;
+}
+
+
+void hostSerialEcho(uint8_t port, FILE *stream)
+{
+  if (port < HOST_SERIAL_PORTS)
+    serialEcho[port] = stream;
+}
+
+
+uint8_t *hostEEPROM(void)
+{
+  return eeprom;
+}
+
+
+void hostSpiDevice(uint8_t (*exchange)(uint8_t data))
+{
+  spiDevice = exchange;
+}
+
+
+void hostSerialSpiDevice(uint8_t port, uint8_t (*exchange)(uint8_t data))
+{
+  if (port < HOST_SERIAL_PORTS)
+    serialSpi[port].device = exchange;
+}
+
+
+void hostTwiDevice(uint8_t address, uint8_t *memory, size_t size)
+{
+  HostTwiDevice *device = twiDevice(address);
+  uint8_t i;
+
+  if (!device)
+  {
+    for (i = 0; i < HOST_TWI_DEVICES && !device; i++)
+      if (!twiDevices[i].memory)
+        device = &twiDevices[i];
+    if (!device)
+    {
+      fprintf(stderr, "host: no room for TWI device 0x%02X\n", address);
+      abort();
+    }
+  }
+
+  if (device == twiSlave && !memory)
+    twiSlave = NULL;
+
+  device->address = address;
+  device->memory = memory;
+  device->size = memory ? size : 0;
+  device->pointer = 0;
+  device->pointerSet = 0;
+}
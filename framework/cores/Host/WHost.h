@@ -0,0 +1,165 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Host core: a simulated ATmega1281 for running the Wiring core and
+|| | libraries natively (x86-64 Linux), for unit tests, fuzzing and
+|| | benchmarks.
+|| |
+|| | The AVR8Bit core sources are compiled as they are against a set of
+|| | simulated avr-libc headers (cores/Host/avr, cores/Host/util).  Every
+|| | special function register lives in a host side register file, and
+|| | every register access (through a pointer too: the sources that touch
+|| | registers are built with the compiler's volatile access callbacks)
+|| | is a service point at which the simulator advances time, updates the
+|| | peripheral models and dispatches pending interrupts (only while the
+|| | I flag in SREG is set, one at a time, with I cleared during the
+|| | handler, like the hardware does).
+|| |
+|| | Modelled: Timers 0-5 (all waveform generation modes, compare match
+|| | and overflow flags and interrupts; Timer 2 from a 32.768 kHz crystal
+|| | when AS2 is set), USART0/1 (receive paced at the programmed baud
+|| | rate, transmit captured into a host buffer; or in master SPI mode
+|| | with a simulated device, hostSerialSpiDevice()), the ADC (single
+|| | conversion and free running), external interrupts INT0-7, digital
+|| | port inputs (and PINx writes toggling PORTx), the EEPROM and sleep,
+|| | the SPI as master with a simulated device (hostSpiDevice()), and the
+|| | TWI as a single master on a bus of simulated register file slaves
+|| | (hostTwiDevice()), both paced at the programmed clock rate.
+|| |
+|| | Not modelled: SPI and TWI slave modes, TWI arbitration, pin change
+|| | interrupts and the watchdog.  Their registers are plain storage.
+|| |
+|| | The simulated clock can run in real time (simulated cycles follow
+|| | the host monotonic clock, scaled to F_CPU), or stepped (each service
+|| | point advances a fixed number of cycles), which gives fully
+|| | reproducible runs for tests.  hostClockAdvance() moves the clock
+|| | forward explicitly in either mode.
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#ifndef WHOST_H
+#define WHOST_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// Identifies the Host core build of the AVR8Bit sources.
+#define WIRING_HOST
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Size of the register file; covers all I/O and extended I/O registers.
+#define HOST_REGISTER_FILE_SIZE 0x200
+
+// Clock modes
+#define HOST_CLOCK_REALTIME 0
+#define HOST_CLOCK_STEPPED  1
+
+// Simulated serial ports
+#define HOST_SERIAL_PORTS 2
+
+// Simulated TWI slaves
+#define HOST_TWI_DEVICES 32
+
+
+/*************************************************************
+ * Simulator internals (used by the simulated avr-libc headers)
+ *************************************************************/
+
+extern volatile uint8_t _hostRegisterFile[HOST_REGISTER_FILE_SIZE];
+
+void _hostService(void);
+void _hostCli(void);
+void _hostSei(void);
+void _hostSleep(void);
+void _hostDelayCycles(uint32_t cycles);
+
+static inline uint16_t _hostRegisterAddress(volatile void *reg)
+{
+  return (uint16_t)((volatile uint8_t *)reg - _hostRegisterFile);
+}
+
+
+/*************************************************************
+ * avr-libc <stdlib.h> and <string.h> extensions
+ *************************************************************/
+
+char *itoa(int value, char *s, int radix);
+char *utoa(unsigned int value, char *s, int radix);
+char *ltoa(long value, char *s, int radix);
+char *ultoa(unsigned long value, char *s, int radix);
+char *dtostrf(double value, signed char width, unsigned char precision, char *s);
+
+#if !defined(__GLIBC__) || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38)
+size_t strlcpy(char *dst, const char *src, size_t size);
+size_t strlcat(char *dst, const char *src, size_t size);
+#define HOST_STRLCPY
+#endif
+
+
+/*************************************************************
+ * Host API
+ *************************************************************/
+
+// Reset the simulated part: registers, clock, peripherals, EEPROM.
+// Called automatically before main().
+void hostReset(void);
+
+// Clock
+void hostClockMode(uint8_t mode, uint32_t cyclesPerStep);
+void hostClockAdvance(uint32_t cycles);
+uint64_t hostClockCycles(void);
+uint64_t hostSleepCycles(void);
+
+// Interrupts
+void hostInterrupt(uint8_t vectorNumber);
+uint32_t hostInterruptCount(uint8_t vectorNumber);
+
+// Digital inputs (Wiring pin numbers) and external interrupts
+void hostPinInput(uint8_t pin, uint8_t level);
+void hostPinRelease(uint8_t pin);
+
+// Analog inputs (ADC channel 0-15, 10 bit value)
+void hostAnalogInput(uint8_t channel, uint16_t value);
+
+// Serial ports
+void hostSerialReceive(uint8_t port, const uint8_t *data, size_t length);
+size_t hostSerialPending(uint8_t port);
+size_t hostSerialTransmitted(uint8_t port, uint8_t *data, size_t length);
+void hostSerialEcho(uint8_t port, FILE *stream);
+
+// EEPROM
+uint8_t *hostEEPROM(void);
+
+// SPI device: called with each byte the master sends, returns the byte
+// it answers with.  With none, the master reads 0xFF.
+void hostSpiDevice(uint8_t (*exchange)(uint8_t data));
+
+// The same for a USART in master SPI mode (port 0 or 1).
+void hostSerialSpiDevice(uint8_t port, uint8_t (*exchange)(uint8_t data));
+
+// TWI slaves: a device at the 7 bit address with a register file of
+// size bytes.  The first byte written in a transfer sets its register
+// pointer, further bytes are stored from there, and reads return bytes
+// from there on (0xFF past the end); the pointer increments with each
+// byte.  Writes past the end are NACKed, and so is an address with no
+// device.  A NULL memory removes the device.
+void hostTwiDevice(uint8_t address, uint8_t *memory, size_t size);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
+// WHOST_H
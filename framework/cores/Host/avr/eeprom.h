@@ -0,0 +1,97 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Simulated <avr/eeprom.h> for the Host core.
+|| |
+|| | The EEPROM is a host side array of E2END + 1 bytes (erased to 0xFF at
+|| | reset), see hostEEPROM().
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#ifndef _AVR_EEPROM_H_
+#define _AVR_EEPROM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <avr/io.h>
+
+#define EEMEM
+
+#define eeprom_is_ready() 1
+#define eeprom_busy_wait() do { } while (0)
+
+#define _EEPROM_ADDRESS(p) (hostEEPROM() + ((uintptr_t)(p) & E2END))
+
+static inline uint8_t eeprom_read_byte(const uint8_t *p)
+{
+  return *_EEPROM_ADDRESS(p);
+}
+
+static inline uint16_t eeprom_read_word(const uint16_t *p)
+{
+  uint16_t v;
+  memcpy(&v, _EEPROM_ADDRESS(p), sizeof(v));
+  return v;
+}
+
+static inline uint32_t eeprom_read_dword(const uint32_t *p)
+{
+  uint32_t v;
+  memcpy(&v, _EEPROM_ADDRESS(p), sizeof(v));
+  return v;
+}
+
+static inline float eeprom_read_float(const float *p)
+{
+  float v;
+  memcpy(&v, _EEPROM_ADDRESS(p), sizeof(v));
+  return v;
+}
+
+static inline void eeprom_read_block(void *dst, const void *src, size_t n)
+{
+  memcpy(dst, _EEPROM_ADDRESS(src), n);
+}
+
+static inline void eeprom_write_byte(uint8_t *p, uint8_t value)
+{
+  *_EEPROM_ADDRESS(p) = value;
+}
+
+static inline void eeprom_write_word(uint16_t *p, uint16_t value)
+{
+  memcpy(_EEPROM_ADDRESS(p), &value, sizeof(value));
+}
+
+static inline void eeprom_write_dword(uint32_t *p, uint32_t value)
+{
+  memcpy(_EEPROM_ADDRESS(p), &value, sizeof(value));
+}
+
+static inline void eeprom_write_float(float *p, float value)
+{
+  memcpy(_EEPROM_ADDRESS(p), &value, sizeof(value));
+}
+
+static inline void eeprom_write_block(const void *src, void *dst, size_t n)
+{
+  memcpy(_EEPROM_ADDRESS(dst), src, n);
+}
+
+#define eeprom_update_byte eeprom_write_byte
+#define eeprom_update_word eeprom_write_word
+#define eeprom_update_dword eeprom_write_dword
+#define eeprom_update_float eeprom_write_float
+#define eeprom_update_block eeprom_write_block
+
+#endif
+// _AVR_EEPROM_H_
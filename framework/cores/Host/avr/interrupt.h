@@ -0,0 +1,56 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Simulated <avr/interrupt.h> for the Host core.
+|| |
+|| | ISR() defines the vector function __vector_N, which overrides the weak
+|| | default in WHost.cpp.  Interrupts are dispatched by the simulator
+|| | whenever the I flag in SREG is set (see hostInterrupt()).
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#ifndef _AVR_INTERRUPT_H_
+#define _AVR_INTERRUPT_H_
+
+#include <avr/io.h>
+
+#define sei() _hostSei()
+#define cli() _hostCli()
+#define reti() return
+
+#define _VECTOR(N) __vector_ ## N
+
+#define ISR_BLOCK
+#define ISR_NOBLOCK
+#define ISR_NAKED
+#define ISR_ALIASOF(v)
+
+// The attributes are kept for weak handlers; the ISR_ ones are empty.
+#ifdef __cplusplus
+#define ISR(vector, ...) \
+  extern "C" void vector(void) __VA_ARGS__; \
+  void vector(void)
+#else
+#define ISR(vector, ...) \
+  void vector(void) __VA_ARGS__; \
+  void vector(void)
+#endif
+
+#define SIGNAL(vector) ISR(vector)
+
+#define EMPTY_INTERRUPT(vector) ISR(vector) { }
+
+#define ISR_ALIAS(vector, target_vector) ISR(vector) { target_vector(); }
+
+#define BADISR_vect __vector_default
+
+#endif
+// _AVR_INTERRUPT_H_
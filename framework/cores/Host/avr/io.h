@@ -0,0 +1,787 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Simulated <avr/io.h> for the Host core.
+|| |
+|| | Register and bit names follow avr-libc (iomxx0_1.h) for the
+|| | ATmega1281, which is the part simulated by the Host core.  Every
+|| | register lives in a host side register file (see WHost.h), at the
+|| | same data memory address as on the real part, so &PORTD, 16 bit
+|| | register access and the BoardDefs.h mapping macros all work as is.
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#ifndef _AVR_IO_H_
+#define _AVR_IO_H_
+
+#include <avr/sfr_defs.h>
+#include <WHost.h>
+
+#define _AVR_IOXXX_H_ "iom1281.h"
+
+/*************************************************************
+ * I/O registers
+ *************************************************************/
+
+#define PINA    _SFR_IO8(0x00)
+#define DDRA    _SFR_IO8(0x01)
+#define PORTA   _SFR_IO8(0x02)
+#define PINB    _SFR_IO8(0x03)
+#define DDRB    _SFR_IO8(0x04)
+#define PORTB   _SFR_IO8(0x05)
+#define PINC    _SFR_IO8(0x06)
+#define DDRC    _SFR_IO8(0x07)
+#define PORTC   _SFR_IO8(0x08)
+#define PIND    _SFR_IO8(0x09)
+#define DDRD    _SFR_IO8(0x0A)
+#define PORTD   _SFR_IO8(0x0B)
+#define PINE    _SFR_IO8(0x0C)
+#define DDRE    _SFR_IO8(0x0D)
+#define PORTE   _SFR_IO8(0x0E)
+#define PINF    _SFR_IO8(0x0F)
+#define DDRF    _SFR_IO8(0x10)
+#define PORTF   _SFR_IO8(0x11)
+#define PING    _SFR_IO8(0x12)
+#define DDRG    _SFR_IO8(0x13)
+#define PORTG   _SFR_IO8(0x14)
+
+#define TIFR0   _SFR_IO8(0x15)
+#define TIFR1   _SFR_IO8(0x16)
+#define TIFR2   _SFR_IO8(0x17)
+#define TIFR3   _SFR_IO8(0x18)
+#define TIFR4   _SFR_IO8(0x19)
+#define TIFR5   _SFR_IO8(0x1A)
+#define PCIFR   _SFR_IO8(0x1B)
+#define EIFR    _SFR_IO8(0x1C)
+#define EIMSK   _SFR_IO8(0x1D)
+#define GPIOR0  _SFR_IO8(0x1E)
+#define EECR    _SFR_IO8(0x1F)
+#define EEDR    _SFR_IO8(0x20)
+#define EEAR    _SFR_IO16(0x21)
+#define EEARL   _SFR_IO8(0x21)
+#define EEARH   _SFR_IO8(0x22)
+#define GTCCR   _SFR_IO8(0x23)
+#define TCCR0A  _SFR_IO8(0x24)
+#define TCCR0B  _SFR_IO8(0x25)
+#define TCNT0   _SFR_IO8(0x26)
+#define OCR0A   _SFR_IO8(0x27)
+#define OCR0B   _SFR_IO8(0x28)
+#define GPIOR1  _SFR_IO8(0x2A)
+#define GPIOR2  _SFR_IO8(0x2B)
+#define SPCR    _SFR_IO8(0x2C)
+#define SPSR    _SFR_IO8(0x2D)
+#define SPDR    _SFR_IO8(0x2E)
+#define ACSR    _SFR_IO8(0x30)
+#define OCDR    _SFR_IO8(0x31)
+#define SMCR    _SFR_IO8(0x33)
+#define MCUSR   _SFR_IO8(0x34)
+#define MCUCR   _SFR_IO8(0x35)
+#define SPMCSR  _SFR_IO8(0x37)
+#define RAMPZ   _SFR_IO8(0x3B)
+#define EIND    _SFR_IO8(0x3C)
+#define SPL     _SFR_IO8(0x3D)
+#define SPH     _SFR_IO8(0x3E)
+#define SREG    _SFR_IO8(0x3F)
+
+/*************************************************************
+ * Extended I/O registers
+ *************************************************************/
+
+#define WDTCSR  _SFR_MEM8(0x60)
+#define CLKPR   _SFR_MEM8(0x61)
+#define PRR0    _SFR_MEM8(0x64)
+#define PRR1    _SFR_MEM8(0x65)
+#define OSCCAL  _SFR_MEM8(0x66)
+#define PCICR   _SFR_MEM8(0x68)
+#define EICRA   _SFR_MEM8(0x69)
+#define EICRB   _SFR_MEM8(0x6A)
+#define PCMSK0  _SFR_MEM8(0x6B)
+#define PCMSK1  _SFR_MEM8(0x6C)
+#define PCMSK2  _SFR_MEM8(0x6D)
+#define TIMSK0  _SFR_MEM8(0x6E)
+#define TIMSK1  _SFR_MEM8(0x6F)
+#define TIMSK2  _SFR_MEM8(0x70)
+#define TIMSK3  _SFR_MEM8(0x71)
+#define TIMSK4  _SFR_MEM8(0x72)
+#define TIMSK5  _SFR_MEM8(0x73)
+#define XMCRA   _SFR_MEM8(0x74)
+#define XMCRB   _SFR_MEM8(0x75)
+
+#define ADC     _SFR_MEM16(0x78)
+#define ADCW    _SFR_MEM16(0x78)
+#define ADCL    _SFR_MEM8(0x78)
+#define ADCH    _SFR_MEM8(0x79)
+#define ADCSRA  _SFR_MEM8(0x7A)
+#define ADCSRB  _SFR_MEM8(0x7B)
+#define ADMUX   _SFR_MEM8(0x7C)
+#define DIDR2   _SFR_MEM8(0x7D)
+#define DIDR0   _SFR_MEM8(0x7E)
+#define DIDR1   _SFR_MEM8(0x7F)
+
+#define TCCR1A  _SFR_MEM8(0x80)
+#define TCCR1B  _SFR_MEM8(0x81)
+#define TCCR1C  _SFR_MEM8(0x82)
+#define TCNT1   _SFR_MEM16(0x84)
+#define TCNT1L  _SFR_MEM8(0x84)
+#define TCNT1H  _SFR_MEM8(0x85)
+#define ICR1    _SFR_MEM16(0x86)
+#define ICR1L   _SFR_MEM8(0x86)
+#define ICR1H   _SFR_MEM8(0x87)
+#define OCR1A   _SFR_MEM16(0x88)
+#define OCR1AL  _SFR_MEM8(0x88)
+#define OCR1AH  _SFR_MEM8(0x89)
+#define OCR1B   _SFR_MEM16(0x8A)
+#define OCR1BL  _SFR_MEM8(0x8A)
+#define OCR1BH  _SFR_MEM8(0x8B)
+#define OCR1C   _SFR_MEM16(0x8C)
+#define OCR1CL  _SFR_MEM8(0x8C)
+#define OCR1CH  _SFR_MEM8(0x8D)
+
+#define TCCR3A  _SFR_MEM8(0x90)
+#define TCCR3B  _SFR_MEM8(0x91)
+#define TCCR3C  _SFR_MEM8(0x92)
+#define TCNT3   _SFR_MEM16(0x94)
+#define TCNT3L  _SFR_MEM8(0x94)
+#define TCNT3H  _SFR_MEM8(0x95)
+#define ICR3    _SFR_MEM16(0x96)
+#define ICR3L   _SFR_MEM8(0x96)
+#define ICR3H   _SFR_MEM8(0x97)
+#define OCR3A   _SFR_MEM16(0x98)
+#define OCR3AL  _SFR_MEM8(0x98)
+#define OCR3AH  _SFR_MEM8(0x99)
+#define OCR3B   _SFR_MEM16(0x9A)
+#define OCR3BL  _SFR_MEM8(0x9A)
+#define OCR3BH  _SFR_MEM8(0x9B)
+#define OCR3C   _SFR_MEM16(0x9C)
+#define OCR3CL  _SFR_MEM8(0x9C)
+#define OCR3CH  _SFR_MEM8(0x9D)
+
+#define TCCR4A  _SFR_MEM8(0xA0)
+#define TCCR4B  _SFR_MEM8(0xA1)
+#define TCCR4C  _SFR_MEM8(0xA2)
+#define TCNT4   _SFR_MEM16(0xA4)
+#define TCNT4L  _SFR_MEM8(0xA4)
+#define TCNT4H  _SFR_MEM8(0xA5)
+#define ICR4    _SFR_MEM16(0xA6)
+#define ICR4L   _SFR_MEM8(0xA6)
+#define ICR4H   _SFR_MEM8(0xA7)
+#define OCR4A   _SFR_MEM16(0xA8)
+#define OCR4AL  _SFR_MEM8(0xA8)
+#define OCR4AH  _SFR_MEM8(0xA9)
+#define OCR4B   _SFR_MEM16(0xAA)
+#define OCR4BL  _SFR_MEM8(0xAA)
+#define OCR4BH  _SFR_MEM8(0xAB)
+#define OCR4C   _SFR_MEM16(0xAC)
+#define OCR4CL  _SFR_MEM8(0xAC)
+#define OCR4CH  _SFR_MEM8(0xAD)
+
+#define TCCR2A  _SFR_MEM8(0xB0)
+#define TCCR2B  _SFR_MEM8(0xB1)
+#define TCNT2   _SFR_MEM8(0xB2)
+#define OCR2A   _SFR_MEM8(0xB3)
+#define OCR2B   _SFR_MEM8(0xB4)
+#define ASSR    _SFR_MEM8(0xB6)
+
+#define TWBR    _SFR_MEM8(0xB8)
+#define TWSR    _SFR_MEM8(0xB9)
+#define TWAR    _SFR_MEM8(0xBA)
+#define TWDR    _SFR_MEM8(0xBB)
+#define TWCR    _SFR_MEM8(0xBC)
+#define TWAMR   _SFR_MEM8(0xBD)
+
+#define UCSR0A  _SFR_MEM8(0xC0)
+#define UCSR0B  _SFR_MEM8(0xC1)
+#define UCSR0C  _SFR_MEM8(0xC2)
+#define UBRR0   _SFR_MEM16(0xC4)
+#define UBRR0L  _SFR_MEM8(0xC4)
+#define UBRR0H  _SFR_MEM8(0xC5)
+#define UDR0    _SFR_MEM8(0xC6)
+
+#define UCSR1A  _SFR_MEM8(0xC8)
+#define UCSR1B  _SFR_MEM8(0xC9)
+#define UCSR1C  _SFR_MEM8(0xCA)
+#define UBRR1   _SFR_MEM16(0xCC)
+#define UBRR1L  _SFR_MEM8(0xCC)
+#define UBRR1H  _SFR_MEM8(0xCD)
+#define UDR1    _SFR_MEM8(0xCE)
+
+#define TCCR5A  _SFR_MEM8(0x120)
+#define TCCR5B  _SFR_MEM8(0x121)
+#define TCCR5C  _SFR_MEM8(0x122)
+#define TCNT5   _SFR_MEM16(0x124)
+#define TCNT5L  _SFR_MEM8(0x124)
+#define TCNT5H  _SFR_MEM8(0x125)
+#define ICR5    _SFR_MEM16(0x126)
+#define ICR5L   _SFR_MEM8(0x126)
+#define ICR5H   _SFR_MEM8(0x127)
+#define OCR5A   _SFR_MEM16(0x128)
+#define OCR5AL  _SFR_MEM8(0x128)
+#define OCR5AH  _SFR_MEM8(0x129)
+#define OCR5B   _SFR_MEM16(0x12A)
+#define OCR5BL  _SFR_MEM8(0x12A)
+#define OCR5BH  _SFR_MEM8(0x12B)
+#define OCR5C   _SFR_MEM16(0x12C)
+#define OCR5CL  _SFR_MEM8(0x12C)
+#define OCR5CH  _SFR_MEM8(0x12D)
+
+/*************************************************************
+ * Register bits
+ *************************************************************/
+
+// SREG
+#define SREG_C  0
+#define SREG_Z  1
+#define SREG_N  2
+#define SREG_V  3
+#define SREG_S  4
+#define SREG_H  5
+#define SREG_T  6
+#define SREG_I  7
+
+// Port pins (PORTxn, DDxn and PINxn share the same numbering)
+#define PA0 0
+#define PA1 1
+#define PA2 2
+#define PA3 3
+#define PA4 4
+#define PA5 5
+#define PA6 6
+#define PA7 7
+#define PB0 0
+#define PB1 1
+#define PB2 2
+#define PB3 3
+#define PB4 4
+#define PB5 5
+#define PB6 6
+#define PB7 7
+#define PC0 0
+#define PC1 1
+#define PC2 2
+#define PC3 3
+#define PC4 4
+#define PC5 5
+#define PC6 6
+#define PC7 7
+#define PD0 0
+#define PD1 1
+#define PD2 2
+#define PD3 3
+#define PD4 4
+#define PD5 5
+#define PD6 6
+#define PD7 7
+#define PE0 0
+#define PE1 1
+#define PE2 2
+#define PE3 3
+#define PE4 4
+#define PE5 5
+#define PE6 6
+#define PE7 7
+#define PF0 0
+#define PF1 1
+#define PF2 2
+#define PF3 3
+#define PF4 4
+#define PF5 5
+#define PF6 6
+#define PF7 7
+#define PG0 0
+#define PG1 1
+#define PG2 2
+#define PG3 3
+#define PG4 4
+#define PG5 5
+
+// TIFRn
+#define TOV0    0
+#define OCF0A   1
+#define OCF0B   2
+#define TOV1    0
+#define OCF1A   1
+#define OCF1B   2
+#define OCF1C   3
+#define ICF1    5
+#define TOV2    0
+#define OCF2A   1
+#define OCF2B   2
+#define TOV3    0
+#define OCF3A   1
+#define OCF3B   2
+#define OCF3C   3
+#define ICF3    5
+#define TOV4    0
+#define OCF4A   1
+#define OCF4B   2
+#define OCF4C   3
+#define ICF4    5
+#define TOV5    0
+#define OCF5A   1
+#define OCF5B   2
+#define OCF5C   3
+#define ICF5    5
+
+// TIMSKn
+#define TOIE0   0
+#define OCIE0A  1
+#define OCIE0B  2
+#define TOIE1   0
+#define OCIE1A  1
+#define OCIE1B  2
+#define OCIE1C  3
+#define ICIE1   5
+#define TOIE2   0
+#define OCIE2A  1
+#define OCIE2B  2
+#define TOIE3   0
+#define OCIE3A  1
+#define OCIE3B  2
+#define OCIE3C  3
+#define ICIE3   5
+#define TOIE4   0
+#define OCIE4A  1
+#define OCIE4B  2
+#define OCIE4C  3
+#define ICIE4   5
+#define TOIE5   0
+#define OCIE5A  1
+#define OCIE5B  2
+#define OCIE5C  3
+#define ICIE5   5
+
+// TCCRnA / TCCRnB / TCCRnC (timer 1, 3, 4, 5 share the layout)
+#define WGM00   0
+#define WGM01   1
+#define COM0B0  4
+#define COM0B1  5
+#define COM0A0  6
+#define COM0A1  7
+#define CS00    0
+#define CS01    1
+#define CS02    2
+#define WGM02   3
+#define FOC0B   6
+#define FOC0A   7
+
+#define WGM10   0
+#define WGM11   1
+#define COM1C0  2
+#define COM1C1  3
+#define COM1B0  4
+#define COM1B1  5
+#define COM1A0  6
+#define COM1A1  7
+#define CS10    0
+#define CS11    1
+#define CS12    2
+#define WGM12   3
+#define WGM13   4
+#define ICES1   6
+#define ICNC1   7
+
+#define WGM20   0
+#define WGM21   1
+#define COM2B0  4
+#define COM2B1  5
+#define COM2A0  6
+#define COM2A1  7
+#define CS20    0
+#define CS21    1
+#define CS22    2
+#define WGM22   3
+
+#define WGM30   0
+#define WGM31   1
+#define COM3C0  2
+#define COM3C1  3
+#define COM3B0  4
+#define COM3B1  5
+#define COM3A0  6
+#define COM3A1  7
+#define CS30    0
+#define CS31    1
+#define CS32    2
+#define WGM32   3
+#define WGM33   4
+
+#define WGM40   0
+#define WGM41   1
+#define COM4C0  2
+#define COM4C1  3
+#define COM4B0  4
+#define COM4B1  5
+#define COM4A0  6
+#define COM4A1  7
+#define CS40    0
+#define CS41    1
+#define CS42    2
+#define WGM42   3
+#define WGM43   4
+
+#define WGM50   0
+#define WGM51   1
+#define COM5C0  2
+#define COM5C1  3
+#define COM5B0  4
+#define COM5B1  5
+#define COM5A0  6
+#define COM5A1  7
+#define CS50    0
+#define CS51    1
+#define CS52    2
+#define WGM52   3
+#define WGM53   4
+
+// GTCCR
+#define PSRSYNC 0
+#define PSRASY  1
+#define TSM     7
+
+// ASSR
+#define TCR2BUB 0
+#define TCR2AUB 1
+#define OCR2BUB 2
+#define OCR2AUB 3
+#define TCN2UB  4
+#define AS2     5
+#define EXCLK   6
+
+// External interrupts
+#define INT0    0
+#define INT1    1
+#define INT2    2
+#define INT3    3
+#define INT4    4
+#define INT5    5
+#define INT6    6
+#define INT7    7
+#define INTF0   0
+#define INTF1   1
+#define INTF2   2
+#define INTF3   3
+#define INTF4   4
+#define INTF5   5
+#define INTF6   6
+#define INTF7   7
+#define ISC00   0
+#define ISC01   1
+#define ISC10   2
+#define ISC11   3
+#define ISC20   4
+#define ISC21   5
+#define ISC30   6
+#define ISC31   7
+#define ISC40   0
+#define ISC41   1
+#define ISC50   2
+#define ISC51   3
+#define ISC60   4
+#define ISC61   5
+#define ISC70   6
+#define ISC71   7
+
+// Pin change interrupts
+#define PCIE0   0
+#define PCIE1   1
+#define PCIE2   2
+#define PCIF0   0
+#define PCIF1   1
+#define PCIF2   2
+
+// EECR
+#define EERE    0
+#define EEPE    1
+#define EEMPE   2
+#define EERIE   3
+#define EEPM0   4
+#define EEPM1   5
+
+// SPCR / SPSR
+#define SPR0    0
+#define SPR1    1
+#define CPHA    2
+#define CPOL    3
+#define MSTR    4
+#define DORD    5
+#define SPE     6
+#define SPIE    7
+#define SPI2X   0
+#define WCOL    6
+#define SPIF    7
+
+// ACSR
+#define ACIS0   0
+#define ACIS1   1
+#define ACIC    2
+#define ACIE    3
+#define ACI     4
+#define ACO     5
+#define ACBG    6
+#define ACD     7
+
+// SMCR
+#define SE      0
+#define SM0     1
+#define SM1     2
+#define SM2     3
+
+// MCUSR / MCUCR
+#define PORF    0
+#define EXTRF   1
+#define BORF    2
+#define WDRF    3
+#define JTRF    4
+#define IVCE    0
+#define IVSEL   1
+#define PUD     4
+#define JTD     7
+
+// WDTCSR
+#define WDP0    0
+#define WDP1    1
+#define WDP2    2
+#define WDE     3
+#define WDCE    4
+#define WDP3    5
+#define WDIE    6
+#define WDIF    7
+
+// PRR0 / PRR1
+#define PRADC    0
+#define PRUSART0 1
+#define PRSPI    2
+#define PRTIM1   3
+#define PRTIM0   5
+#define PRTIM2   6
+#define PRTWI    7
+#define PRUSART1 0
+#define PRTIM3   3
+#define PRTIM4   4
+#define PRTIM5   5
+
+// ADC
+#define MUX0    0
+#define MUX1    1
+#define MUX2    2
+#define MUX3    3
+#define MUX4    4
+#define ADLAR   5
+#define REFS0   6
+#define REFS1   7
+#define ADPS0   0
+#define ADPS1   1
+#define ADPS2   2
+#define ADIE    3
+#define ADIF    4
+#define ADATE   5
+#define ADSC    6
+#define ADEN    7
+#define ADTS0   0
+#define ADTS1   1
+#define ADTS2   2
+#define MUX5    3
+#define ACME    6
+
+// TWI
+#define TWPS0   0
+#define TWPS1   1
+#define TWS3    3
+#define TWS4    4
+#define TWS5    5
+#define TWS6    6
+#define TWS7    7
+#define TWGCE   0
+#define TWIE    0
+#define TWEN    2
+#define TWWC    3
+#define TWSTO   4
+#define TWSTA   5
+#define TWEA    6
+#define TWINT   7
+
+// USART (UCSRnA / UCSRnB / UCSRnC)
+#define MPCM0   0
+#define U2X0    1
+#define UPE0    2
+#define DOR0    3
+#define FE0     4
+#define UDRE0   5
+#define TXC0    6
+#define RXC0    7
+#define TXB80   0
+#define RXB80   1
+#define UCSZ02  2
+#define TXEN0   3
+#define RXEN0   4
+#define UDRIE0  5
+#define TXCIE0  6
+#define RXCIE0  7
+#define UCPOL0  0
+#define UCSZ00  1
+#define UCSZ01  2
+#define USBS0   3
+#define UPM00   4
+#define UPM01   5
+#define UMSEL00 6
+#define UMSEL01 7
+#define UCPHA0  1   // master SPI mode
+#define UDORD0  2
+
+#define MPCM1   0
+#define U2X1    1
+#define UPE1    2
+#define DOR1    3
+#define FE1     4
+#define UDRE1   5
+#define TXC1    6
+#define RXC1    7
+#define TXB81   0
+#define RXB81   1
+#define UCSZ12  2
+#define TXEN1   3
+#define RXEN1   4
+#define UDRIE1  5
+#define TXCIE1  6
+#define RXCIE1  7
+#define UCPOL1  0
+#define UCSZ10  1
+#define UCSZ11  2
+#define USBS1   3
+#define UPM10   4
+#define UPM11   5
+#define UMSEL10 6
+#define UMSEL11 7
+#define UCPHA1  1
+#define UDORD1  2
+
+/*************************************************************
+ * Interrupt vectors
+ *************************************************************/
+
+#define INT0_vect_num           1
+#define INT0_vect               _VECTOR(1)
+#define INT1_vect_num           2
+#define INT1_vect               _VECTOR(2)
+#define INT2_vect_num           3
+#define INT2_vect               _VECTOR(3)
+#define INT3_vect_num           4
+#define INT3_vect               _VECTOR(4)
+#define INT4_vect_num           5
+#define INT4_vect               _VECTOR(5)
+#define INT5_vect_num           6
+#define INT5_vect               _VECTOR(6)
+#define INT6_vect_num           7
+#define INT6_vect               _VECTOR(7)
+#define INT7_vect_num           8
+#define INT7_vect               _VECTOR(8)
+#define PCINT0_vect_num         9
+#define PCINT0_vect             _VECTOR(9)
+#define PCINT1_vect_num         10
+#define PCINT1_vect             _VECTOR(10)
+#define PCINT2_vect_num         11
+#define PCINT2_vect             _VECTOR(11)
+#define WDT_vect_num            12
+#define WDT_vect                _VECTOR(12)
+#define TIMER2_COMPA_vect_num   13
+#define TIMER2_COMPA_vect       _VECTOR(13)
+#define TIMER2_COMPB_vect_num   14
+#define TIMER2_COMPB_vect       _VECTOR(14)
+#define TIMER2_OVF_vect_num     15
+#define TIMER2_OVF_vect         _VECTOR(15)
+#define TIMER1_CAPT_vect_num    16
+#define TIMER1_CAPT_vect        _VECTOR(16)
+#define TIMER1_COMPA_vect_num   17
+#define TIMER1_COMPA_vect       _VECTOR(17)
+#define TIMER1_COMPB_vect_num   18
+#define TIMER1_COMPB_vect       _VECTOR(18)
+#define TIMER1_COMPC_vect_num   19
+#define TIMER1_COMPC_vect       _VECTOR(19)
+#define TIMER1_OVF_vect_num     20
+#define TIMER1_OVF_vect         _VECTOR(20)
+#define TIMER0_COMPA_vect_num   21
+#define TIMER0_COMPA_vect       _VECTOR(21)
+#define TIMER0_COMPB_vect_num   22
+#define TIMER0_COMPB_vect       _VECTOR(22)
+#define TIMER0_OVF_vect_num     23
+#define TIMER0_OVF_vect         _VECTOR(23)
+#define SPI_STC_vect_num        24
+#define SPI_STC_vect            _VECTOR(24)
+#define USART0_RX_vect_num      25
+#define USART0_RX_vect          _VECTOR(25)
+#define USART0_UDRE_vect_num    26
+#define USART0_UDRE_vect        _VECTOR(26)
+#define USART0_TX_vect_num      27
+#define USART0_TX_vect          _VECTOR(27)
+#define ANALOG_COMP_vect_num    28
+#define ANALOG_COMP_vect        _VECTOR(28)
+#define ADC_vect_num            29
+#define ADC_vect                _VECTOR(29)
+#define EE_READY_vect_num       30
+#define EE_READY_vect           _VECTOR(30)
+#define TIMER3_CAPT_vect_num    31
+#define TIMER3_CAPT_vect        _VECTOR(31)
+#define TIMER3_COMPA_vect_num   32
+#define TIMER3_COMPA_vect       _VECTOR(32)
+#define TIMER3_COMPB_vect_num   33
+#define TIMER3_COMPB_vect       _VECTOR(33)
+#define TIMER3_COMPC_vect_num   34
+#define TIMER3_COMPC_vect       _VECTOR(34)
+#define TIMER3_OVF_vect_num     35
+#define TIMER3_OVF_vect         _VECTOR(35)
+#define USART1_RX_vect_num      36
+#define USART1_RX_vect          _VECTOR(36)
+#define USART1_UDRE_vect_num    37
+#define USART1_UDRE_vect        _VECTOR(37)
+#define USART1_TX_vect_num      38
+#define USART1_TX_vect          _VECTOR(38)
+#define TWI_vect_num            39
+#define TWI_vect                _VECTOR(39)
+#define SPM_READY_vect_num      40
+#define SPM_READY_vect          _VECTOR(40)
+#define TIMER4_CAPT_vect_num    41
+#define TIMER4_CAPT_vect        _VECTOR(41)
+#define TIMER4_COMPA_vect_num   42
+#define TIMER4_COMPA_vect       _VECTOR(42)
+#define TIMER4_COMPB_vect_num   43
+#define TIMER4_COMPB_vect       _VECTOR(43)
+#define TIMER4_COMPC_vect_num   44
+#define TIMER4_COMPC_vect       _VECTOR(44)
+#define TIMER4_OVF_vect_num     45
+#define TIMER4_OVF_vect         _VECTOR(45)
+#define TIMER5_CAPT_vect_num    46
+#define TIMER5_CAPT_vect        _VECTOR(46)
+#define TIMER5_COMPA_vect_num   47
+#define TIMER5_COMPA_vect       _VECTOR(47)
+#define TIMER5_COMPB_vect_num   48
+#define TIMER5_COMPB_vect       _VECTOR(48)
+#define TIMER5_COMPC_vect_num   49
+#define TIMER5_COMPC_vect       _VECTOR(49)
+#define TIMER5_OVF_vect_num     50
+#define TIMER5_OVF_vect         _VECTOR(50)
+
+#define _VECTORS_SIZE           (57 * 4)
+#define HOST_VECTORS            57
+
+/*************************************************************
+ * Memory
+ *************************************************************/
+
+#define SPM_PAGESIZE 256
+#define RAMSTART     0x200
+#define RAMEND       0x21FF
+#define XRAMEND      0xFFFF
+#define E2END        0xFFF
+#define E2PAGESIZE   8
+#define FLASHEND     0x1FFFF
+
+#endif
+// _AVR_IO_H_
@@ -0,0 +1,82 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Simulated <avr/pgmspace.h> for the Host core.
+|| |
+|| | The host has a single address space, so program memory data is
+|| | ordinary (read only) data, and the _P functions map onto the
+|| | standard C library.
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#ifndef _AVR_PGMSPACE_H_
+#define _AVR_PGMSPACE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#define PROGMEM
+
+#define PSTR(s) (__extension__({static const char __c[] = (s); &__c[0];}))
+
+typedef void prog_void;
+typedef char prog_char;
+typedef unsigned char prog_uchar;
+typedef int8_t prog_int8_t;
+typedef uint8_t prog_uint8_t;
+typedef int16_t prog_int16_t;
+typedef uint16_t prog_uint16_t;
+typedef int32_t prog_int32_t;
+typedef uint32_t prog_uint32_t;
+typedef int64_t prog_int64_t;
+typedef uint64_t prog_uint64_t;
+
+#define PGM_P const char *
+#define PGM_VOID_P const void *
+
+#define pgm_read_byte_near(address) (*(const uint8_t *)(address))
+#define pgm_read_word_near(address) (*(const uint16_t *)(address))
+#define pgm_read_dword_near(address) (*(const uint32_t *)(address))
+#define pgm_read_float_near(address) (*(const float *)(address))
+
+#define pgm_read_byte_far(address) pgm_read_byte_near(address)
+#define pgm_read_word_far(address) pgm_read_word_near(address)
+#define pgm_read_dword_far(address) pgm_read_dword_near(address)
+#define pgm_read_float_far(address) pgm_read_float_near(address)
+
+#define pgm_read_byte(address) pgm_read_byte_near(address)
+#define pgm_read_word(address) pgm_read_word_near(address)
+#define pgm_read_dword(address) pgm_read_dword_near(address)
+#define pgm_read_float(address) pgm_read_float_near(address)
+
+#define memchr_P memchr
+#define memcmp_P memcmp
+#define memcpy_P memcpy
+#define strcat_P strcat
+#define strchr_P strchr
+#define strcmp_P strcmp
+#define strcpy_P strcpy
+#define strcasecmp_P strcasecmp
+#define strlen_P strlen
+#define strncat_P strncat
+#define strncmp_P strncmp
+#define strncpy_P strncpy
+#define strncasecmp_P strncasecmp
+#define strnlen_P strnlen
+#define strstr_P strstr
+#define printf_P printf
+#define sprintf_P sprintf
+#define snprintf_P snprintf
+
+#endif
+// _AVR_PGMSPACE_H_
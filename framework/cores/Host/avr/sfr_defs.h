@@ -0,0 +1,53 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Simulated <avr/sfr_defs.h> for the Host core.
+|| |
+|| | Special function registers are plain locations in the host register
+|| | file.  The simulator sees each access to them, through these macros
+|| | or through a pointer, from the compiler's volatile access callbacks
+|| | (see "Register access" in WHost.cpp).
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#ifndef _AVR_SFR_DEFS_H_
+#define _AVR_SFR_DEFS_H_
+
+#include <stdint.h>
+
+#define __SFR_OFFSET 0x20
+
+#define _MMIO_BYTE(mem_addr) (_hostRegisterFile[mem_addr])
+#define _MMIO_WORD(mem_addr) (*(volatile uint16_t *)&_hostRegisterFile[mem_addr])
+#define _MMIO_DWORD(mem_addr) (*(volatile uint32_t *)&_hostRegisterFile[mem_addr])
+
+#define _SFR_MEM8(mem_addr) _MMIO_BYTE(mem_addr)
+#define _SFR_MEM16(mem_addr) _MMIO_WORD(mem_addr)
+#define _SFR_MEM32(mem_addr) _MMIO_DWORD(mem_addr)
+#define _SFR_IO8(io_addr) _MMIO_BYTE((io_addr) + __SFR_OFFSET)
+#define _SFR_IO16(io_addr) _MMIO_WORD((io_addr) + __SFR_OFFSET)
+
+#define _SFR_MEM_ADDR(sfr) _hostRegisterAddress(&(sfr))
+#define _SFR_IO_ADDR(sfr) (_SFR_MEM_ADDR(sfr) - __SFR_OFFSET)
+#define _SFR_IO_REG_P(sfr) (_SFR_MEM_ADDR(sfr) < 0x40 + __SFR_OFFSET)
+#define _SFR_ADDR(sfr) _SFR_MEM_ADDR(sfr)
+#define _SFR_BYTE(sfr) _MMIO_BYTE(_SFR_ADDR(sfr))
+#define _SFR_WORD(sfr) _MMIO_WORD(_SFR_ADDR(sfr))
+
+#define _BV(bit) (1 << (bit))
+
+#define bit_is_set(sfr, bit) (_SFR_BYTE(sfr) & _BV(bit))
+#define bit_is_clear(sfr, bit) (!(_SFR_BYTE(sfr) & _BV(bit)))
+#define loop_until_bit_is_set(sfr, bit) do { } while (bit_is_clear(sfr, bit))
+#define loop_until_bit_is_clear(sfr, bit) do { } while (bit_is_set(sfr, bit))
+
+#endif
+// _AVR_SFR_DEFS_H_
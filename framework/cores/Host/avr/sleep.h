@@ -0,0 +1,44 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Simulated <avr/sleep.h> for the Host core.
+|| |
+|| | sleep_cpu() hands control to the simulator, which advances time until
+|| | an interrupt wakes the part up (see _hostSleep()).
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#ifndef _AVR_SLEEP_H_
+#define _AVR_SLEEP_H_
+
+#include <avr/io.h>
+
+#define SLEEP_MODE_IDLE         (0)
+#define SLEEP_MODE_ADC          _BV(SM0)
+#define SLEEP_MODE_PWR_DOWN     _BV(SM1)
+#define SLEEP_MODE_PWR_SAVE     (_BV(SM0) | _BV(SM1))
+#define SLEEP_MODE_STANDBY      (_BV(SM1) | _BV(SM2))
+#define SLEEP_MODE_EXT_STANDBY  (_BV(SM0) | _BV(SM1) | _BV(SM2))
+
+#define set_sleep_mode(mode) \
+  do { SMCR = (SMCR & ~(_BV(SM0) | _BV(SM1) | _BV(SM2))) | (mode); } while (0)
+
+#define sleep_enable() do { SMCR |= (uint8_t)_BV(SE); } while (0)
+#define sleep_disable() do { SMCR &= (uint8_t)~_BV(SE); } while (0)
+#define sleep_cpu() _hostSleep()
+
+#define sleep_mode() \
+  do { sleep_enable(); sleep_cpu(); sleep_disable(); } while (0)
+
+#define sleep_bod_disable()
+
+#endif
+// _AVR_SLEEP_H_
@@ -0,0 +1,67 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Interrupt latency benchmark: external interrupt, timer callback and
+|| | serial receive latencies (Latency library), without and with a
+|| | background interrupt load, printed as histograms.
+|| |
+|| | Runs on the stepped clock, so the numbers only change when the code
+|| | does.  The same measurements run on a board with the
+|| | Latency/examples/InterruptLatency sketch.
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#include <Wiring.h>
+#include <Latency.h>
+
+// Received bytes arrive one frame after they are injected, like a
+// looped back port on a board.
+void inject(uint8_t c)
+{
+  hostSerialReceive(1, &c, 1);
+}
+
+
+void run(void)
+{
+  LatencyHistogram interrupt, timer, serial;
+
+  Latency.externalInterrupt(0, interrupt);
+  Latency.timer(timer);
+  Latency.serial(Serial1, 115200, serial, LATENCY_SAMPLES, inject);
+
+  interrupt.print(Serial, Constant("INT0 to attachInterrupt() function"));
+  timer.print(Serial, Constant("Timer 1 compare match to Timer1 function"));
+  serial.print(Serial, Constant("Serial1 stop bit to read()"));
+  Serial.println();
+}
+
+
+int main(void)
+{
+  hostClockMode(HOST_CLOCK_STEPPED, 4);
+  boardInit();
+  hostSerialEcho(0, stdout);
+
+  Serial.begin(115200);
+  Serial1.begin(115200);
+  Latency.begin();
+
+  Serial.println(Constant("Interrupt latency, no load"));
+  run();
+
+  Serial.println(Constant("Interrupt latency, 2000 interrupts/s of 400 cycles on Timer 2"));
+  Latency.setLoad(2000, 400);
+  run();
+
+  Latency.end();
+  exit(0);
+}
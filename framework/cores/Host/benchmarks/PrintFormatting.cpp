@@ -0,0 +1,253 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Number formatting benchmark: Print's integer and float formatting
+|| | against the previous implementation (a division per digit, a float
+|| | multiply per decimal), kept here for comparison, and a line of CSV
+|| | telemetry.  Prints the time per call in nanoseconds.
+|| |
+|| | The times are the host's, not an AVR's: the simulated clock only
+|| | runs for register accesses.  On an AVR, where a 32 bit division is
+|| | a library call of several hundred cycles and the float operations
+|| | are in software, the difference is larger.
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#include <Wiring.h>
+#include <time.h>
+
+// Counts the characters, keeps nothing.
+class NullPrint : public Print
+{
+  public:
+    unsigned long count;
+
+    virtual size_t write(uint8_t c)
+    {
+      count++;
+      return 1;
+    }
+    virtual size_t write(const uint8_t *buffer, size_t size)
+    {
+      count += size;
+      return size;
+    }
+    using Print::write;
+};
+
+NullPrint sink;
+
+
+/************ the previous implementation ***********************/
+
+size_t oldPrintNumber(Print &p, unsigned long n, uint8_t base)
+{
+  char buf[8 * sizeof(long) + 1];
+  char *str = &buf[sizeof(buf) - 1];
+
+  *str = '\0';
+  if (base < 2) base = 10;
+
+  do {
+    unsigned long m = n;
+    n /= base;
+    char c = m - base * n;
+    *--str = c < 10 ? c + '0' : c + 'A' - 10;
+  } while(n);
+
+  return p.write(str);
+}
+
+
+size_t oldPrintFloat(Print &p, double number, uint8_t digits)
+{
+  size_t n = 0;
+
+  if (isnan(number)) return p.print("nan");
+  if (isinf(number)) return p.print("inf");
+  if (number > 4294967040.0) return p.print ("ovf");
+  if (number <-4294967040.0) return p.print ("ovf");
+
+  if (number < 0.0)
+  {
+    n += p.print('-');
+    number = -number;
+  }
+
+  double rounding = 0.5;
+  for (uint8_t i=0; i<digits; ++i)
+  rounding /= 10.0;
+
+  number += rounding;
+
+  unsigned long int_part = (unsigned long)number;
+  double remainder = number - (double)int_part;
+  n += oldPrintNumber(p, int_part, 10);
+
+  if (digits > 0) {
+    n += p.print(".");
+  }
+
+  while (digits-- > 0)
+  {
+    remainder *= 10.0;
+    int toPrint = int(remainder);
+    n += oldPrintNumber(p, toPrint, 10);
+    remainder -= toPrint;
+  }
+
+  return n;
+}
+
+/****************************************************************/
+
+
+#define CALLS 200000L
+
+// The values formatted: spread over the range of each case
+volatile unsigned long values[256];
+volatile float readings[256];
+
+double nanoseconds(void)
+{
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+
+void report(const char *name, double oldTime, double newTime)
+{
+  char line[100];
+
+  snprintf(line, sizeof(line), "%-28s %8.1f %8.1f  %5.1fx",
+           name, oldTime / CALLS, newTime / CALLS, oldTime / newTime);
+  Serial.println(line);
+}
+
+
+void integers(const char *name, unsigned long mask, uint8_t base)
+{
+  double start;
+  double oldTime;
+  double newTime;
+  long i;
+
+  start = nanoseconds();
+  for (i = 0; i < CALLS; i++)
+    oldPrintNumber(sink, values[i & 0xFF] & mask, base);
+  oldTime = nanoseconds() - start;
+
+  start = nanoseconds();
+  for (i = 0; i < CALLS; i++)
+    sink.print(values[i & 0xFF] & mask, base);
+  newTime = nanoseconds() - start;
+
+  report(name, oldTime, newTime);
+}
+
+
+void floats(const char *name, uint8_t digits)
+{
+  double start;
+  double oldTime;
+  double newTime;
+  long i;
+
+  start = nanoseconds();
+  for (i = 0; i < CALLS; i++)
+    oldPrintFloat(sink, readings[i & 0xFF], digits);
+  oldTime = nanoseconds() - start;
+
+  start = nanoseconds();
+  for (i = 0; i < CALLS; i++)
+    sink.print(readings[i & 0xFF], digits);
+  newTime = nanoseconds() - start;
+
+  report(name, oldTime, newTime);
+}
+
+
+// time, three readings and a counter, as the telemetry sends them
+void telemetry(void)
+{
+  double start;
+  double oldTime;
+  double newTime;
+  long i;
+
+  start = nanoseconds();
+  for (i = 0; i < CALLS; i++)
+  {
+    oldPrintNumber(sink, values[i & 0xFF], 10);
+    sink.print(',');
+    oldPrintFloat(sink, readings[i & 0xFF], 2);
+    sink.print(',');
+    oldPrintFloat(sink, readings[(i + 1) & 0xFF], 2);
+    sink.print(',');
+    oldPrintFloat(sink, readings[(i + 2) & 0xFF], 3);
+    sink.print(',');
+    oldPrintNumber(sink, i & 0xFFFF, 10);
+    sink.println();
+  }
+  oldTime = nanoseconds() - start;
+
+  start = nanoseconds();
+  for (i = 0; i < CALLS; i++)
+  {
+    sink.print(values[i & 0xFF]);
+    sink.print(',');
+    sink.print(readings[i & 0xFF], 2);
+    sink.print(',');
+    sink.print(readings[(i + 1) & 0xFF], 2);
+    sink.print(',');
+    sink.print(readings[(i + 2) & 0xFF], 3);
+    sink.print(',');
+    sink.print((unsigned long)(i & 0xFFFF));
+    sink.println();
+  }
+  newTime = nanoseconds() - start;
+
+  report("CSV telemetry line", oldTime, newTime);
+}
+
+
+int main(void)
+{
+  uint16_t i;
+  uint32_t seed = 1;
+
+  hostClockMode(HOST_CLOCK_STEPPED, 4);
+  boardInit();
+  hostSerialEcho(0, stdout);
+  Serial.begin(115200);
+
+  for (i = 0; i < 256; i++)
+  {
+    seed = seed * 1664525UL + 1013904223UL;
+    values[i] = seed >> (i % 32);
+    readings[i] = (float)(int32_t)seed / (1L << (8 + i % 16));
+  }
+
+  Serial.println("Number formatting, ns per call");
+  Serial.println("                                  old      new");
+  integers("print(byte)", 0xFF, DEC);
+  integers("print(unsigned int)", 0xFFFF, DEC);
+  integers("print(unsigned long)", 0xFFFFFFFF, DEC);
+  integers("print(unsigned long, HEX)", 0xFFFFFFFF, HEX);
+  integers("print(unsigned long, BIN)", 0xFFFFFFFF, BIN);
+  floats("print(float, 2)", 2);
+  floats("print(float, 4)", 4);
+  telemetry();
+
+  exit(0);
+}
@@ -0,0 +1,175 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Telemetry benchmark: a record (the time, three readings and a
+|| | counter) sent as a line of CSV with print() and as a Telemetry
+|| | frame, and the frames decoded again.  Prints the bytes a record,
+|| | the time a record in nanoseconds, and how many records a second
+|| | fit through a serial port at 115200 baud.
+|| |
+|| | The times are the host's, not an AVR's (see PrintFormatting): the
+|| | frame's advantage there is larger still, the float formatting being
+|| | in software.
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#include <Wiring.h>
+#include <Telemetry.h>
+#include <time.h>
+
+// Keeps the last 256 bytes written, counts them all.
+class Sink : public Print
+{
+  public:
+    uint8_t data[256];
+    unsigned long count;
+
+    virtual size_t write(uint8_t c)
+    {
+      data[count++ & 0xFF] = c;
+      return 1;
+    }
+    virtual size_t write(const uint8_t *buffer, size_t size)
+    {
+      size_t i;
+
+      for (i = 0; i < size; i++)
+        data[count++ & 0xFF] = buffer[i];
+      return size;
+    }
+    using Print::write;
+};
+
+Sink sink;
+Telemetry telemetry(sink);
+
+#define RECORDS 200000L
+
+volatile unsigned long times[256];
+volatile float readings[256];
+
+double nanoseconds(void)
+{
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+
+void report(const char *name, unsigned long bytes, double time)
+{
+  char line[100];
+  double perRecord = (double)bytes / RECORDS;
+
+  snprintf(line, sizeof(line), "%-20s %8.1f %8.1f %10.0f",
+           name, perRecord, time / RECORDS, 11520.0 / perRecord);
+  Serial.println(line);
+}
+
+
+void csv(void)
+{
+  double start;
+  long i;
+
+  sink.count = 0;
+  start = nanoseconds();
+  for (i = 0; i < RECORDS; i++)
+  {
+    sink.print(times[i & 0xFF]);
+    sink.print(',');
+    sink.print(readings[i & 0xFF], 2);
+    sink.print(',');
+    sink.print(readings[(i + 1) & 0xFF], 2);
+    sink.print(',');
+    sink.print(readings[(i + 2) & 0xFF], 3);
+    sink.print(',');
+    sink.print((unsigned long)(i & 0xFFFF));
+    sink.println();
+  }
+  report("CSV line", sink.count, nanoseconds() - start);
+}
+
+
+void frames(void)
+{
+  double start;
+  long i;
+
+  sink.count = 0;
+  start = nanoseconds();
+  for (i = 0; i < RECORDS; i++)
+    telemetry.begin(1)
+             .addUnsignedLong(times[i & 0xFF])
+             .addFloat(readings[i & 0xFF])
+             .addFloat(readings[(i + 1) & 0xFF])
+             .addFloat(readings[(i + 2) & 0xFF])
+             .addUnsignedInt(i & 0xFFFF)
+             .end();
+  report("Telemetry frame", sink.count, nanoseconds() - start);
+}
+
+
+void decoding(void)
+{
+  uint8_t buffer[TELEMETRY_BUFFER_SIZE];
+  TelemetryDecoder decoder(buffer, sizeof(buffer));
+  TelemetryField field;
+  uint8_t frame[32];
+  uint8_t length;
+  volatile uint32_t sum = 0;
+  double start;
+  long i;
+  uint8_t k;
+
+  // one frame, decoded over and over
+  sink.count = 0;
+  telemetry.begin(1).addUnsignedLong(123456).addFloat(1.5).addFloat(-20.25)
+           .addFloat(1013.2).addUnsignedInt(42).end();
+  length = sink.count;
+  memcpy(frame, sink.data, length);
+
+  start = nanoseconds();
+  for (i = 0; i < RECORDS; i++)
+    for (k = 0; k < length; k++)
+      if (decoder.decode(frame[k]))
+        while (decoder.nextField(field))
+          sum += field.value.u;
+  report("decoded", (unsigned long)length * RECORDS, nanoseconds() - start);
+}
+
+
+int main(void)
+{
+  uint16_t i;
+  uint32_t seed = 1;
+
+  hostClockMode(HOST_CLOCK_STEPPED, 4);
+  boardInit();
+  hostSerialEcho(0, stdout);
+  Serial.begin(115200);
+
+  for (i = 0; i < 256; i++)
+  {
+    seed = seed * 1664525UL + 1013904223UL;
+    times[i] = seed >> (i % 32);
+    readings[i] = (float)(int32_t)seed / (1L << (8 + i % 16));
+  }
+
+  Serial.println("Telemetry record: bytes, ns, records a second at 115200");
+  Serial.println("                        bytes       ns  records/s");
+  csv();
+  frames();
+  decoding();
+
+  exit(0);
+}
@@ -0,0 +1,68 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Analog input libraries test: Potentiometer values and sectors,
+|| | converted fast only once asked to, and a sketch replacing the
+|| | core's ADC interrupt handler (ADC_ISR()).
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#include <Wiring.h>
+#include <Potentiometer.h>
+#include "HostTest.h"
+
+volatile uint8_t adcInterrupts;
+
+// Replaces the core's handler; ADC_QUIET conversions wake through it.
+ADC_ISR()
+{
+  adcInterrupts++;
+}
+
+
+void testPotentiometer()
+{
+  Potentiometer pot(1, 4);
+
+  hostAnalogInput(1, 1023);
+  CHECK(pot.getValue() == 1023);
+  CHECK(pot.getSector() == 3);
+
+  hostAnalogInput(1, 300);
+  CHECK(pot.getValue() == 300);
+  CHECK(pot.getSector() == 1);
+
+  pot.setProfile(ADC_FAST);
+  CHECK(pot.getValue() == 300);
+
+  // a sector per step: 10 bits unless the fast profile is asked for
+  pot.setProfile(ADC_STANDARD);
+  pot.setSectors(1000);
+  hostAnalogInput(1, 301);
+  CHECK(pot.getSector() == 301);
+  pot.setProfile(ADC_FAST);
+  CHECK(pot.getSector() == 300);
+
+  pot.setProfile(ADC_QUIET);
+  CHECK(pot.getValue() == 301);
+  CHECK(adcInterrupts > 0);
+}
+
+
+int main(void)
+{
+  hostClockMode(HOST_CLOCK_STEPPED, 4);
+  boardInit();
+
+  testPotentiometer();
+
+  exit(hostTestResult());
+}
@@ -0,0 +1,81 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | AnalogSampler test: scans several channels in the background and
+|| | checks every sample lands in the ring of its own channel, at the
+|| | free running rate.
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#include <Wiring.h>
+#include <AnalogSampler.h>
+#include "HostTest.h"
+
+
+void testScan()
+{
+  const uint8_t channels[] = { 0, 3, 5, 7 };
+  const uint16_t values[] = { 100, 300, 500, 700 };
+  uint16_t block[16];
+  uint8_t i;
+  uint8_t n;
+
+  for (i = 0; i < 4; i++)
+    hostAnalogInput(channels[i], values[i]);
+
+  // a leftover completed conversion must not be taken for a sample
+  hostAnalogInput(1, 1000);
+  CHECK(analogRead(1) == 1000);
+
+  AnalogSampler.begin(channels, 4, 64);
+  CHECK(AnalogSampler.running());
+
+  // 64 * 13 cycles per conversion, 52 us: 4 rounds of the scan in 1 ms
+  delayMicroseconds(1000);
+
+  for (i = 0; i < 4; i++)
+  {
+    CHECK(AnalogSampler.latest(i) == values[i]);
+    CHECK(AnalogSampler.available(i) >= 3);
+    n = AnalogSampler.read(i, block, 16);
+    while (n--)
+      CHECK(block[n] == values[i]);
+  }
+
+  // the ring of a channel fills up, and counts what it drops
+  delay(10);
+  CHECK(AnalogSampler.available(1) == ANALOGSAMPLER_BUFFER_SIZE);
+  CHECK(AnalogSampler.overflows(1) > 0);
+
+  hostAnalogInput(3, 333);
+  delay(1);
+  CHECK(AnalogSampler.latest(1) == 333);
+  CHECK(AnalogSampler.read(1) == 300);
+
+  CHECK(AnalogSampler.latest(4) == -1);
+  CHECK(AnalogSampler.read(4) == -1);
+
+  AnalogSampler.end();
+  CHECK(!AnalogSampler.running());
+  CHECK(analogRead(5) == 500);
+  CHECK(analogRead(0) == 100);
+}
+
+
+int main(void)
+{
+  hostClockMode(HOST_CLOCK_STEPPED, 4);
+  boardInit();
+
+  testScan();
+
+  exit(hostTestResult());
+}
@@ -0,0 +1,56 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | ADC vector test: a sketch with its own ISR(ADC_vect) still links
+|| | and reads with analogRead(), as long as it uses neither
+|| | attachInterruptADC() nor ADC_QUIET.
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#include <Wiring.h>
+#include "HostTest.h"
+
+volatile uint8_t adcInterrupts;
+
+ISR(ADC_vect)
+{
+  adcInterrupts++;
+}
+
+
+void testAnalogRead()
+{
+  hostAnalogInput(3, 700);
+  CHECK(analogRead(3) == 700);
+  CHECK(analogReadProfile(3, ADC_FAST) == (700 & ~3));
+  CHECK(analogReadOversampled(3, 12) == 700 * 4);
+}
+
+void testOwnVector()
+{
+  hostAnalogInput(3, 200);
+  ADCSRA |= (1 << ADIE);
+  CHECK(analogRead(3) == 200);
+  ADCSRA &= ~(1 << ADIE);
+  CHECK(adcInterrupts > 0);
+}
+
+
+int main()
+{
+  hostClockMode(HOST_CLOCK_STEPPED, 4);
+  boardInit();
+
+  testAnalogRead();
+  testOwnVector();
+
+  exit(hostTestResult());
+}
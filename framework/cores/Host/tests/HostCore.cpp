@@ -0,0 +1,333 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Host core self test: runs the Wiring core on the simulated part and
+|| | checks the clock, serial, ADC, digital I/O, external interrupt and
+|| | EEPROM models.
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#include <Wiring.h>
+#include <EEPROM.h>
+#include "HostTest.h"
+
+extern "C" volatile uint32_t timer0_micros;
+
+volatile uint8_t interrupts0;
+volatile uint8_t sendsDone;
+
+void countInterrupt()
+{
+  interrupts0++;
+}
+
+void countSend()
+{
+  sendsDone++;
+}
+
+
+void testClock()
+{
+  unsigned long start = millis();
+  unsigned long startMicros = micros();
+
+  delay(25);
+  CHECK(millis() - start >= 25);
+  CHECK(millis() - start <= 27);
+  CHECK(micros() - startMicros >= 25000);
+
+  start = micros();
+  delayMicroseconds(500);
+  CHECK(micros() - start >= 490);
+  CHECK(micros() - start <= 600);
+}
+
+
+void testMicros()
+{
+  uint64_t startCycles = hostClockCycles();
+  unsigned long start = micros();
+  uint32_t startClock = clockCycles();
+  unsigned long last = start;
+  unsigned long now;
+  uint64_t elapsed;
+  uint64_t wide;
+  bool monotonic = true;
+  uint8_t oldSREG;
+
+  // read on every step of the clock, across many overflows
+  while (micros() - start < 5000)
+  {
+    now = micros();
+    if ((long)(now - last) < 0)
+      monotonic = false;
+    last = now;
+  }
+  CHECK(monotonic);
+
+  // within a Timer 0 tick of the simulated clock
+  now = micros() - start;
+  elapsed = (hostClockCycles() - startCycles) * 1000000 / F_CPU;
+  CHECK(now <= elapsed + 1);
+  CHECK(now + TIMER0PRESCALEFACTOR * 1000000UL / F_CPU + 1 >= elapsed);
+  elapsed = hostClockCycles() - startCycles;
+  CHECK(clockCycles() - startClock <= elapsed + TIMER0PRESCALEFACTOR);
+  CHECK(clockCycles() - startClock + 2 * TIMER0PRESCALEFACTOR >= elapsed);
+
+  // the 64 bit clock carries on where micros() wraps around
+  wide = micros64();
+  CHECK(micros() - (uint32_t)wide <= 5);
+  oldSREG = SREG;
+  cli();
+  timer0_micros = 0xFFFFF000UL;
+  SREG = oldSREG;
+  start = micros();
+  CHECK(micros64() >> 32 == 0);
+  delay(5);
+  CHECK(micros() - start >= 5000);
+  CHECK(micros() < start);
+  CHECK(micros64() >> 32 == 1);
+  wide = micros64();
+  CHECK(micros() - (uint32_t)wide <= 5);
+}
+
+
+void testSerial()
+{
+  uint8_t buffer[128];
+  size_t n;
+
+  Serial.begin(115200);
+  Serial.print("Hello ");
+  Serial.println(1234);
+
+  n = hostSerialTransmitted(0, buffer, sizeof(buffer));
+  CHECK(n == 12);
+  CHECK(memcmp(buffer, "Hello 1234\r\n", 12) == 0);
+
+  // a frame larger than the transmit buffer goes out in order
+  uint8_t frame[100];
+  for (n = 0; n < sizeof(frame); n++)
+    frame[n] = n * 7;
+  CHECK(Serial.write(frame, sizeof(frame)) == sizeof(frame));
+  delay(10);
+  n = hostSerialTransmitted(0, buffer, sizeof(buffer));
+  CHECK(n == sizeof(frame));
+  CHECK(memcmp(buffer, frame, sizeof(frame)) == 0);
+
+  // zero copy sends keep their place between buffered writes
+  static const uint8_t record[] = "0123456789abcdef0123456789abcdef";
+  SerialSegment tail = { (const uint8_t *)"!", 1, 0 };
+  SerialSegment empty = { 0, 0, &tail };
+  SerialSegment head = { record, 32, &empty };
+  Serial.print("<");
+  CHECK(Serial.send(record, 20, countSend));
+  CHECK(!Serial.send(record, 20));
+  Serial.print(">");
+  while (Serial.sending());
+  CHECK(sendsDone == 1);
+  CHECK(Serial.send(&head, countSend));
+  while (Serial.sending());
+  CHECK(sendsDone == 2);
+  delay(5);
+  n = hostSerialTransmitted(0, buffer, sizeof(buffer));
+  CHECK(n == 55);
+  CHECK(memcmp(buffer, "<0123456789abcdef0123>", 22) == 0);
+  CHECK(memcmp(buffer + 22, record, 32) == 0);
+  CHECK(buffer[54] == '!');
+
+  // and work with interrupts disabled, by polling sending()
+  noInterrupts();
+  CHECK(Serial.send(record, 10));
+  while (Serial.sending());
+  Serial.print("xyz");
+  interrupts();
+  delay(5);
+  n = hostSerialTransmitted(0, buffer, sizeof(buffer));
+  CHECK(n == 13);
+  CHECK(memcmp(buffer, "0123456789xyz", 13) == 0);
+
+  // each write to UDRn is a character, the same one again too
+  noInterrupts();
+  Serial.write((const uint8_t *)"\0\0aa", 4);
+  interrupts();
+  delay(5);
+  n = hostSerialTransmitted(0, buffer, sizeof(buffer));
+  CHECK(n == 4);
+  CHECK(memcmp(buffer, "\0\0aa", 4) == 0);
+
+  hostSerialReceive(0, (const uint8_t *)"abc", 3);
+  CHECK(Serial.available() == 0);
+  delay(1);
+  CHECK(Serial.available() == 3);
+  CHECK(Serial.read() == 'a');
+  CHECK(Serial.read() == 'b');
+  CHECK(Serial.read() == 'c');
+  CHECK(Serial.read() == -1);
+}
+
+
+void testAnalog()
+{
+  hostAnalogInput(3, 512);
+  hostAnalogInput(10, 1000);
+  CHECK(analogRead(3) == 512);
+  CHECK(analogRead(10) == 1000);
+}
+
+
+void testAnalogProfiles()
+{
+  uint64_t start;
+  uint64_t sleepStart;
+
+  hostAnalogInput(2, 513);
+
+  // 13 ADC clocks of ck/128, or of ck/16 in the fast profile
+  start = hostClockCycles();
+  CHECK(analogRead(2) == 513);
+  CHECK(hostClockCycles() - start >= 13 * 128);
+
+  start = hostClockCycles();
+  CHECK(analogReadProfile(2, ADC_FAST) == 512);
+  CHECK(hostClockCycles() - start < 13 * 128 / 4);
+  CHECK(analogRead(2) == 513);
+
+  analogProfile(ADC_FAST);
+  CHECK(analogRead(2) == 512);
+  analogProfile(ADC_STANDARD);
+
+  // the CPU sleeps through the conversion, and wakes when it is done
+  sleepStart = hostSleepCycles();
+  CHECK(analogReadProfile(2, ADC_QUIET) == 513);
+  CHECK(hostSleepCycles() - sleepStart >= 13 * 128 - 16);
+  CHECK(!(ADCSRA & _BV(ADIE)));
+  CHECK(!(SMCR & _BV(SE)));
+
+  CHECK(analogReadOversampled(2, 10) == 513);
+  CHECK(analogReadOversampled(2, 11) == 1026);
+  CHECK(analogReadOversampled(2, 12) == 2052);
+}
+
+
+void testDigital()
+{
+  pinMode(48, OUTPUT);
+  digitalWrite(48, HIGH);
+  CHECK(digitalRead(48) == HIGH);
+  digitalWrite(48, LOW);
+  CHECK(digitalRead(48) == LOW);
+
+  Pin<48> led;
+  led.mode(OUTPUT);
+  led.high();
+  CHECK(digitalRead(48) == HIGH);
+  led.write(LOW);
+  CHECK(led.read() == LOW);
+
+  DigitalPin pin(49);
+  pin.mode(OUTPUT);
+  pin.high();
+  CHECK(digitalRead(49) == HIGH);
+  pin.write(LOW);
+  CHECK(pin.read() == LOW);
+
+  // a bus on port A (pins 16-23), and one spread over ports D and C
+  const uint8_t bus[] = { 16, 17, 18, 19, 20, 21, 22, 23 };
+  const uint8_t mixed[] = { 9, 2, 8 };
+  PinGroup data(bus, 8);
+  PinGroup control(mixed, 3);
+  data.mode(OUTPUT);
+  control.mode(OUTPUT);
+  pinMode(10, OUTPUT);
+  digitalWrite(10, HIGH);
+  data.write(0xA5);
+  CHECK(PORTA == 0xA5);
+  CHECK(data.read() == 0xA5);
+  data.toggle(0x0F);
+  CHECK(PORTA == 0xAA);
+  control.write(0x05);
+  CHECK(digitalRead(9) == HIGH && digitalRead(2) == LOW && digitalRead(8) == HIGH);
+  CHECK(digitalRead(10) == HIGH);
+  CHECK(control.read() == 0x05);
+  control.toggle(0x07);
+  CHECK(control.read() == 0x02);
+  portWriteMasked(1, 0x00, 0x01);
+  CHECK(PORTC == 0x04);
+
+  // toggles by writing PINx, through the inline calls and the core
+  uint8_t port = 1;
+  portToggle(1, 0x05);
+  CHECK(PORTC == 0x01);
+  portToggle(port, 0x05);
+  CHECK(PORTC == 0x04);
+  portWriteMasked(port, 0x03, 0x03);
+  CHECK(PORTC == 0x07);
+  PINC = 0x04;
+  CHECK(PORTC == 0x03 && (PINC & 0x07) == 0x03);
+  portModeMasked(1, OUTPUT, 0x30);
+  CHECK((DDRC & 0x30) == 0x30);
+  portModeMasked(1, INPUT, 0x10);
+  CHECK((DDRC & 0x30) == 0x20);
+
+  DigitalPin none(200);
+  none.mode(OUTPUT);
+  none.high();
+
+  pinMode(20, INPUT);
+  hostPinInput(20, HIGH);
+  CHECK(digitalRead(20) == HIGH);
+  hostPinInput(20, LOW);
+  CHECK(digitalRead(20) == LOW);
+
+  // INT0 is on PD0 (pin 0)
+  pinMode(0, INPUT);
+  hostPinInput(0, LOW);
+  attachInterrupt(EXTERNAL_INTERRUPT_0, countInterrupt, RISING);
+  hostPinInput(0, HIGH);
+  hostPinInput(0, LOW);
+  hostPinInput(0, HIGH);
+  CHECK(interrupts0 == 2);
+
+  noInterrupts();
+  hostPinInput(0, LOW);
+  hostPinInput(0, HIGH);
+  CHECK(interrupts0 == 2);
+  interrupts();
+  CHECK(interrupts0 == 3);
+  detachInterrupt(EXTERNAL_INTERRUPT_0);
+}
+
+
+void testEEPROM()
+{
+  CHECK(EEPROM.read(100) == 0xFF);
+  EEPROM.write(100, 42);
+  CHECK(EEPROM.read(100) == 42);
+}
+
+
+int main(void)
+{
+  hostClockMode(HOST_CLOCK_STEPPED, 4);
+  boardInit();
+
+  testClock();
+  testMicros();
+  testSerial();
+  testAnalog();
+  testAnalogProfiles();
+  testDigital();
+  testEEPROM();
+
+  exit(hostTestResult());
+}
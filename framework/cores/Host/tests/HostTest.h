@@ -0,0 +1,42 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Minimal check macros for the Host core tests.
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#ifndef HOSTTEST_H
+#define HOSTTEST_H
+
+#include <stdio.h>
+
+static int hostTestFailures = 0;
+
+#define CHECK(condition) \
+  do \
+  { \
+    if (!(condition)) \
+    { \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+      hostTestFailures++; \
+    } \
+  } while (0)
+
+static inline int hostTestResult(void)
+{
+  if (hostTestFailures)
+    fprintf(stderr, "%d check(s) failed\n", hostTestFailures);
+
+  return hostTestFailures ? 1 : 0;
+}
+
+#endif
+// HOSTTEST_H
@@ -0,0 +1,124 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Latency test: the histogram statistics, and the external interrupt,
+|| | timer and serial benchmarks measuring sane, repeatable latencies
+|| | that grow under an interrupt load.
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#include <Wiring.h>
+#include <Latency.h>
+#include "HostTest.h"
+
+
+void testHistogram()
+{
+  LatencyHistogram h(4);
+  uint16_t i;
+
+  CHECK(h.samples() == 0);
+  CHECK(h.mean() == 0);
+  CHECK(h.percentile(50) == 0);
+
+  // 100 samples: 88 of 10-13, 11 of 20, one far out
+  for (i = 0; i < 88; i++)
+    h.add(10 + i % 4);
+  for (i = 0; i < 11; i++)
+    h.add(20);
+  h.add(1000);
+
+  CHECK(h.samples() == 100);
+  CHECK(h.minimum() == 10);
+  CHECK(h.maximum() == 1000);
+  CHECK(h.jitter() == 990);
+  CHECK(h.mean() == 22);
+
+  // the range starts at the smallest early sample, on a bin boundary
+  CHECK(h.binStart(0) == 8);
+  CHECK(h.binCount(0) == 44);
+  CHECK(h.binCount(1) == 44);
+  CHECK(h.binCount(2) == 0);
+  CHECK(h.binCount(3) == 11);
+  CHECK(h.binCount(LATENCY_BINS - 1) == 1);
+
+  CHECK(h.percentile(50) == 15);
+  CHECK(h.percentile(88) == 15);
+  CHECK(h.percentile(90) == 23);
+  CHECK(h.percentile(99) == 23);
+  CHECK(h.percentile(100) == 1000);
+
+  h.clear();
+  h.setRange(0, 10);
+  h.add(5);
+  h.add(15);
+  h.add(15);
+  CHECK(h.binCount(0) == 1);
+  CHECK(h.binCount(1) == 2);
+  CHECK(h.mean() == 12);
+}
+
+
+void inject(uint8_t c)
+{
+  hostSerialReceive(1, &c, 1);
+}
+
+
+void testBenchmarks()
+{
+  LatencyHistogram interrupt, timer, serial;
+  LatencyHistogram interruptLoaded, timerLoaded, serialLoaded;
+
+  Serial1.begin(115200);
+  Latency.begin();
+
+  CHECK(Latency.externalInterrupt(0, interrupt, 64));
+  CHECK(Latency.timer(timer, 64));
+  CHECK(Latency.serial(Serial1, 115200, serial, 64, inject));
+
+  Latency.setLoad(2000, 400);
+  CHECK(Latency.externalInterrupt(0, interruptLoaded, 64));
+  CHECK(Latency.timer(timerLoaded, 64));
+  CHECK(Latency.serial(Serial1, 115200, serialLoaded, 64, inject));
+  Latency.setLoad(0, 0);
+
+  // every sample taken, each a plausible handful of cycles, unloaded
+  CHECK(interrupt.samples() == 64);
+  CHECK(interrupt.minimum() > 0 && interrupt.maximum() < 100);
+  CHECK(timer.samples() == 64);
+  CHECK(timer.minimum() > 0 && timer.maximum() < 100);
+  CHECK(serial.samples() == 64);
+  CHECK(serial.minimum() > 0 && serial.maximum() < 200);
+
+  // a load handler running in between adds its whole length
+  CHECK(timerLoaded.maximum() > 400);
+  CHECK(serialLoaded.maximum() > serial.maximum());
+  CHECK(serialLoaded.mean() > serial.mean());
+
+  // no interrupt on the pin, and nothing looped back on the host
+  CHECK(!Latency.externalInterrupt(6, interrupt, 1));
+  CHECK(!Latency.serial(Serial1, 115200, serial, 1));
+
+  Latency.end();
+}
+
+
+int main(void)
+{
+  hostClockMode(HOST_CLOCK_STEPPED, 4);
+  boardInit();
+
+  testHistogram();
+  testBenchmarks();
+
+  exit(hostTestResult());
+}
@@ -0,0 +1,162 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Print test: integers in base 10 (across the 16 and 32 bit ranges),
+|| | in the powers of two and in other bases, and floats (rounding,
+|| | carries into the integer part, signs, many digits, the special
+|| | values), checked against the C library.
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#include <Wiring.h>
+#include "HostTest.h"
+
+StringBuilder<80> out;
+char expected[80];
+
+uint32_t seed = 12345;
+
+uint32_t random32()
+{
+  seed = seed * 1664525UL + 1013904223UL;
+  return seed;
+}
+
+
+// The digits of n in any base, the long way.
+void inBase(uint32_t n, uint8_t base)
+{
+  char digits[33];
+  uint8_t i = 0;
+  uint8_t j = 0;
+
+  do
+  {
+    uint8_t c = n % base;
+    digits[i++] = c < 10 ? '0' + c : 'A' + c - 10;
+    n /= base;
+  } while (n);
+
+  while (i)
+    expected[j++] = digits[--i];
+  expected[j] = 0;
+}
+
+
+bool printsAs(uint32_t n, uint8_t base)
+{
+  out.clear();
+  out.print((unsigned long)n, base);
+  inBase(n, base);
+  return out == expected;
+}
+
+
+void testIntegers()
+{
+  static const uint32_t edges[] =
+  {
+    0, 1, 9, 10, 11, 99, 100, 101, 999, 1000, 9999, 10000, 65535, 65536,
+    99999, 100000, 655359, 655360, 999999999, 1000000000, 4294967295UL
+  };
+  static const uint8_t bases[] = { 2, 3, 7, 8, 10, 16, 36 };
+  uint32_t n;
+  uint8_t i;
+  uint8_t b;
+  bool ok = true;
+
+  for (i = 0; i < sizeof(edges) / sizeof(edges[0]); i++)
+    for (b = 0; b < sizeof(bases); b++)
+      ok = ok && printsAs(edges[i], bases[b]);
+  CHECK(ok);
+
+  // every 16 bit number, and a spread of 32 bit ones
+  for (n = 0; n <= 0xFFFF && ok; n++)
+    ok = printsAs(n, 10);
+  CHECK(ok);
+  for (i = 0; i < 200 && ok; i++)
+  {
+    n = random32() >> (i % 32);
+    for (b = 0; b < sizeof(bases); b++)
+      ok = ok && printsAs(n, bases[b]);
+  }
+  CHECK(ok);
+
+  out.clear();
+  out.print(-2147483647L - 1);
+  out.print(' ');
+  out.print(-1);
+  out.print(' ');
+  out.print((unsigned char)200);
+  out.print(' ');
+  out.print(0xBEEF, HEX);
+  CHECK(out == "-2147483648 -1 200 BEEF");
+}
+
+
+bool floatPrintsAs(double x, int digits, const char *text)
+{
+  out.clear();
+  out.print(x, digits);
+  return out == text;
+}
+
+
+void testFloats()
+{
+  uint8_t i;
+  uint8_t digits;
+  double x;
+  double scaled;
+  bool ok = true;
+
+  CHECK(floatPrintsAs(1.999, 2, "2.00"));
+  CHECK(floatPrintsAs(3.14159, 3, "3.142"));
+  CHECK(floatPrintsAs(-3.14159, 3, "-3.142"));
+  CHECK(floatPrintsAs(0.001, 2, "0.00"));
+  CHECK(floatPrintsAs(0.005001, 2, "0.01"));
+  CHECK(floatPrintsAs(9.96, 1, "10.0"));
+  CHECK(floatPrintsAs(99.5, 0, "100"));
+  CHECK(floatPrintsAs(-0.04, 1, "-0.0"));
+  CHECK(floatPrintsAs(12.0, 0, "12"));
+  CHECK(floatPrintsAs(1.05, 4, "1.0500"));
+  CHECK(floatPrintsAs(0.5, 12, "0.500000000000"));
+  CHECK(floatPrintsAs(4294967040.0, 0, "4294967040"));
+  CHECK(floatPrintsAs(4294967296.0, 2, "ovf"));
+  CHECK(floatPrintsAs(-4294967296.0, 2, "ovf"));
+  CHECK(floatPrintsAs(NAN, 2, "nan"));
+  CHECK(floatPrintsAs(INFINITY, 2, "inf"));
+
+  // against printf, away from halfway cases
+  for (i = 0; i < 200; i++)
+  {
+    x = (double)(int32_t)random32() / (1 << (i % 24));
+    digits = i % 7;
+    scaled = fabs(x) * pow(10, digits);
+    if (fabs(scaled - floor(scaled) - 0.5) < 0.001)
+      continue;
+    snprintf(expected, sizeof(expected), "%.*f", digits, x);
+    ok = ok && floatPrintsAs(x, digits, expected);
+  }
+  CHECK(ok);
+}
+
+
+int main(void)
+{
+  hostClockMode(HOST_CLOCK_STEPPED, 4);
+  boardInit();
+
+  testIntegers();
+  testFloats();
+
+  exit(hostTestResult());
+}
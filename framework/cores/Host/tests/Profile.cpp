@@ -0,0 +1,107 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Profiling test: times the core interrupt handlers and a sketch
+|| | section, and checks the binary dump written to the serial port.
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#include <Wiring.h>
+#include "HostTest.h"
+
+
+uint32_t dumpValue(const uint8_t *p, uint8_t size)
+{
+  uint32_t v = 0;
+
+  while (size--)
+    v = (v << 8) | p[size];
+
+  return v;
+}
+
+
+void testProfile()
+{
+  profile_entry entry;
+  uint8_t dump[512];
+  uint8_t sum = 0;
+  size_t length;
+  size_t i;
+  bool sawOverflow = false;
+  bool sawUser = false;
+
+  profileBegin();
+  Serial.begin(115200);
+
+  delay(20);
+  for (i = 0; i < 4; i++)
+  {
+    PROFILE_SCOPE(PROFILE_USER(1));
+    delayMicroseconds(100);
+  }
+
+  profileRead(PROFILE_TIMER0_OVF, &entry);
+  CHECK(entry.calls >= 19 && entry.calls <= 21);
+  CHECK(entry.max > 0);
+  CHECK(entry.total >= entry.calls * entry.max / 2);
+
+  profileRead(PROFILE_USER(1), &entry);
+  CHECK(entry.calls == 4);
+  CHECK(entry.total >= 4 * 1600UL && entry.total < 4 * 1800UL);
+  CHECK(entry.max >= 1600 && entry.max < 1800);
+
+  profileRead(PROFILE_INT0, &entry);
+  CHECK(entry.calls == 0);
+
+  // dump, and wait for the bytes to go out
+  hostSerialTransmitted(0, NULL, 0);
+  profileDump(Serial);
+  Serial.flush();
+  length = hostSerialTransmitted(0, dump, sizeof(dump));
+
+  CHECK(length >= 14);
+  CHECK(dump[0] == 'W' && dump[1] == 'P' && dump[2] == PROFILE_VERSION);
+  CHECK(dump[3] == PROFILE_ENTRIES);
+  CHECK(dumpValue(dump + 4, 4) == F_CPU);
+  CHECK(dumpValue(dump + 8, 4) >= 20);
+  for (i = 12; i < length && dump[i] != PROFILE_END; i += 11)
+  {
+    if (dump[i] == PROFILE_TIMER0_OVF)
+      sawOverflow = true;
+    if (dump[i] == PROFILE_USER(1))
+    {
+      sawUser = true;
+      CHECK(dumpValue(dump + i + 1, 4) == 4);
+    }
+    CHECK(dumpValue(dump + i + 1, 4) > 0);
+  }
+  CHECK(sawOverflow && sawUser);
+  CHECK(i + 2 == length);
+  for (i = 0; i < length; i++)
+    sum += dump[i];
+  CHECK(sum == 0);
+
+  profileReset();
+  profileRead(PROFILE_USER(1), &entry);
+  CHECK(entry.calls == 0 && entry.total == 0 && entry.max == 0);
+}
+
+
+int main(void)
+{
+  hostClockMode(HOST_CLOCK_STEPPED, 4);
+  boardInit();
+
+  testProfile();
+
+  exit(hostTestResult());
+}
@@ -0,0 +1,159 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | RingBuffer test: single threaded checks of the full / empty and
+|| | overflow behaviour, then a stress test with a producer thread and a
+|| | consumer thread (mixing single and bulk operations) that checks every
+|| | element arrives once, in order.
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#include <Wiring.h>
+#include <RingBuffer.h>
+#include <pthread.h>
+#include <sched.h>
+#include "HostTest.h"
+
+#define STRESS_ELEMENTS 2000000UL
+
+RingBuffer<uint32_t, 64> ring;
+uint32_t consumerErrors;
+
+
+void testSingle()
+{
+  RingBuffer<uint8_t, 8> r;
+  uint8_t in[12] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+  uint8_t out[12];
+  uint8_t c;
+  uint8_t i;
+
+  CHECK(r.isEmpty());
+  CHECK(r.room() == 8);
+  CHECK(!r.dequeue(c));
+
+  for (i = 0; i < 8; i++)
+    CHECK(r.enqueue(i));
+  CHECK(r.isFull());
+  CHECK(!r.enqueue(99));
+  CHECK(r.overflows() == 1);
+  CHECK(r.peek() == 0);
+
+  CHECK(r.dequeue(out, 5) == 5);
+  CHECK(out[0] == 0 && out[4] == 4);
+  CHECK(r.count() == 3);
+
+  // bulk enqueue across the wrap, truncated to the free space
+  CHECK(r.enqueue(in + 8, 4) == 4);
+  CHECK(r.enqueue(in, 4) == 1);
+  CHECK(r.overflows() == 1);
+  CHECK(r.count() == 8);
+
+  CHECK(r.dequeue(out, 12) == 8);
+  CHECK(out[0] == 5 && out[2] == 7 && out[3] == 8 && out[6] == 11 && out[7] == 0);
+  CHECK(r.isEmpty());
+
+  r.clearOverflows();
+  CHECK(r.overflows() == 0);
+
+  r.enqueue(1);
+  r.flush();
+  CHECK(r.isEmpty());
+}
+
+
+void *producer(void *arg)
+{
+  uint32_t next = 0;
+  uint32_t block[13];
+  uint8_t n;
+  uint8_t i;
+
+  while (next < STRESS_ELEMENTS)
+  {
+    if (next & 1)
+    {
+      if (!ring.isFull() && ring.enqueue(next))
+        next++;
+      else
+        sched_yield();
+    }
+    else
+    {
+      n = next % 13 + 1;
+      for (i = 0; i < n; i++)
+        block[i] = next + i;
+      if (ring.isFull())
+        sched_yield();
+      else
+        next += ring.enqueue(block, n);
+    }
+  }
+
+  return NULL;
+}
+
+
+void *consumer(void *arg)
+{
+  uint32_t expected = 0;
+  uint32_t block[17];
+  uint32_t value;
+  uint8_t n;
+  uint8_t i;
+
+  while (expected < STRESS_ELEMENTS)
+  {
+    if (expected & 1)
+    {
+      n = ring.dequeue(block, expected % 17 + 1);
+      if (n == 0)
+        sched_yield();
+      for (i = 0; i < n; i++)
+        if (block[i] != expected++)
+          consumerErrors++;
+    }
+    else if (ring.dequeue(value))
+    {
+      if (value != expected++)
+        consumerErrors++;
+    }
+    else
+      sched_yield();
+  }
+
+  return NULL;
+}
+
+
+void testStress()
+{
+  pthread_t producerThread;
+  pthread_t consumerThread;
+
+  pthread_create(&consumerThread, NULL, consumer, NULL);
+  pthread_create(&producerThread, NULL, producer, NULL);
+  pthread_join(producerThread, NULL);
+  pthread_join(consumerThread, NULL);
+
+  CHECK(consumerErrors == 0);
+  CHECK(ring.isEmpty());
+  CHECK(ring.overflows() == 0);
+}
+
+
+int main(void)
+{
+  testSingle();
+  testStress();
+
+  exit(hostTestResult());
+}
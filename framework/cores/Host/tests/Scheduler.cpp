@@ -0,0 +1,183 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Scheduler test: single and repeating calls across every level of
+|| | the timing wheel, cancellation, update() catching up, and a call
+|| | added after a long time without update().
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#include <Wiring.h>
+#include <Scheduler.h>
+#include "HostTest.h"
+
+Scheduler<60> scheduler;
+
+unsigned long calledAt[60];
+uint8_t calls[60];
+schedule_handle selfCancel;
+
+#define CALL(N) void call ## N() { calledAt[N] = millis(); calls[N]++; }
+CALL(0) CALL(1) CALL(2) CALL(3) CALL(4) CALL(5)
+
+void cancelItself()
+{
+  calls[6]++;
+  scheduler.cancel(selfCancel);
+}
+
+void many()
+{
+  calls[7]++;
+}
+
+void runFor(unsigned long ms)
+{
+  unsigned long start = millis();
+
+  while (millis() - start < ms)
+  {
+    scheduler.update();
+    delayMicroseconds(250);
+  }
+}
+
+
+void testSingle()
+{
+  unsigned long start = millis();
+  schedule_handle cancelled;
+
+  // one per level of the wheel, and one past it
+  scheduler.schedule(call0, 5);
+  scheduler.schedule(call1, 100);
+  scheduler.schedule(call2, 1000);
+  scheduler.schedule(call3, 5000);
+  cancelled = scheduler.schedule(call4, 50);
+  CHECK(scheduler.size() == 5);
+
+  CHECK(scheduler.cancel(cancelled));
+  CHECK(!scheduler.cancel(cancelled));
+  CHECK(!scheduler.scheduled(cancelled));
+
+  runFor(5100);
+
+  CHECK(calls[0] == 1 && calledAt[0] - start == 5);
+  CHECK(calls[1] == 1 && calledAt[1] - start == 100);
+  CHECK(calls[2] == 1 && calledAt[2] - start == 1000);
+  CHECK(calls[3] == 1 && calledAt[3] - start == 5000);
+  CHECK(calls[4] == 0);
+  CHECK(scheduler.size() == 0);
+}
+
+
+void testRepeating()
+{
+  schedule_handle h;
+  uint8_t i;
+
+  calls[5] = 0;
+  h = scheduler.scheduleRepeating(call5, 10);
+  runFor(105);
+  CHECK(calls[5] == 10);
+
+  // update() 95 ms late: the missed calls are skipped, not made in a burst
+  delay(95);
+  scheduler.update();
+  CHECK(calls[5] == 11);
+  runFor(20);
+  CHECK(calls[5] == 13);
+
+  CHECK(scheduler.cancel(h));
+  runFor(30);
+  CHECK(calls[5] == 13);
+
+  selfCancel = scheduler.scheduleRepeating(cancelItself, 3);
+  runFor(20);
+  CHECK(calls[6] == 1);
+  CHECK(!scheduler.scheduled(selfCancel));
+
+  // a full scheduler refuses more
+  for (i = 0; i < 60; i++)
+    CHECK(scheduler.scheduleRepeating(many, 7 + i * 37) != 0);
+  CHECK(scheduler.schedule(call0, 1) == 0);
+  runFor(1000);
+  CHECK(calls[7] > 60);
+  CHECK(scheduler.size() == 60);
+}
+
+
+// Nothing scheduled and update() not called for seconds: the next call
+// is counted from now, not from the last update().
+void testIdle()
+{
+  Scheduler<4> idle;
+  unsigned long start;
+
+  delay(3000);
+  start = millis();
+  calls[0] = 0;
+  idle.schedule(call0, 10);
+  CHECK(idle.idleTime() == 10);
+
+  while (millis() - start < 20)
+  {
+    idle.update();
+    delayMicroseconds(250);
+  }
+  CHECK(calls[0] == 1 && calledAt[0] - start == 10);
+}
+
+
+// Entries freed by cancel() and by expiring calls are handed out again,
+// and the old handles do not reach the new calls.
+void testReuse()
+{
+  Scheduler<4> small;
+  schedule_handle h[4];
+  unsigned long start = millis();
+  uint8_t i;
+
+  for (i = 0; i < 4; i++)
+    h[i] = small.schedule(call1, 50 + i);
+  CHECK(small.schedule(call1, 1) == 0);
+
+  CHECK(small.cancel(h[3]));
+  CHECK(small.cancel(h[1]));
+  while (millis() - start <= 50)
+  {
+    small.update();
+    delayMicroseconds(250);
+  }
+  CHECK(!small.scheduled(h[0]));
+  CHECK(small.size() == 1);
+
+  for (i = 0; i < 3; i++)
+    CHECK(small.schedule(call2, 100) != 0);
+  CHECK(small.schedule(call2, 100) == 0);
+  CHECK(small.size() == 4);
+  CHECK(!small.cancel(h[0]) && !small.cancel(h[1]) && !small.cancel(h[3]));
+  CHECK(small.scheduled(h[2]));
+}
+
+
+int main(void)
+{
+  hostClockMode(HOST_CLOCK_STEPPED, 4);
+  boardInit();
+
+  testSingle();
+  testRepeating();
+  testIdle();
+  testReuse();
+
+  exit(hostTestResult());
+}
@@ -0,0 +1,223 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | SerialSPI test: USART1 in Master SPI Mode set up as asked (format,
+|| | clock, XCK1 an output), single bytes, blocking buffer transfers
+|| | going out back to back, background transfers from the receive
+|| | interrupt, one buffer following the other without a gap, and the
+|| | USART a serial port again after end().
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#include <Wiring.h>
+#include <SerialSPI.h>
+#include "HostTest.h"
+
+WSerialSPI SPI1(Serial1);
+
+// The device answers each byte with the one before it, inverted.
+uint8_t last;
+uint8_t received[512];
+uint16_t receivedCount;
+
+uint8_t device(uint8_t data)
+{
+  uint8_t answer = ~last;
+
+  last = data;
+  if (receivedCount < sizeof(received))
+    received[receivedCount] = data;
+  receivedCount++;
+
+  return answer;
+}
+
+
+uint8_t doneOrder[3];
+uint8_t doneCount;
+
+void doneA()
+{
+  doneOrder[doneCount++] = 'A';
+}
+
+
+void doneB()
+{
+  doneOrder[doneCount++] = 'B';
+}
+
+
+void reset()
+{
+  last = 0;
+  receivedCount = 0;
+}
+
+
+void testSetup()
+{
+  SPI1.begin(LSBFIRST, SPI_MODE3, SPI_CLOCK_DIV16);
+  CHECK((UCSR1C & 0xC7) == (0xC0 | _BV(UDORD1) | _BV(UCPHA1) | _BV(UCPOL1)));
+  CHECK(UBRR1 == 7);
+  CHECK((UCSR1B & (_BV(RXEN1) | _BV(TXEN1))) == (_BV(RXEN1) | _BV(TXEN1)));
+  CHECK(DDRD & _BV(PD5));
+
+  CHECK(SPI1.setClock(1000000) == 1000000 && UBRR1 == 7);
+  CHECK(SPI1.setClock(3000000) == 2666666 && UBRR1 == 2);
+  CHECK(SPI1.setClock(100) == F_CPU / 2 / 4096 && UBRR1 == 0x0FFF);
+
+  SPI1.begin();
+  CHECK((UCSR1C & 0xC7) == 0xC0);
+  CHECK(UBRR1 == 0);
+}
+
+
+void testBytes()
+{
+  reset();
+  CHECK(SPI1.transfer(0x12) == 0xFF);
+  CHECK(SPI1.transfer(0x34) == (uint8_t)~0x12);
+  CHECK(receivedCount == 2);
+}
+
+
+void testBlocking()
+{
+  uint8_t buffer[100];
+  uint8_t tx[100];
+  uint8_t rx[100];
+  uint16_t i;
+  unsigned long start;
+  unsigned long took;
+
+  for (i = 0; i < sizeof(tx); i++)
+    tx[i] = buffer[i] = i * 7;
+
+  // in place
+  reset();
+  start = micros();
+  SPI1.transfer(buffer, sizeof(buffer));
+  took = micros() - start;
+  CHECK(receivedCount == sizeof(buffer));
+  CHECK(memcmp(received, tx, sizeof(tx)) == 0);
+  CHECK(buffer[0] == 0xFF);
+  for (i = 1; i < sizeof(buffer) && buffer[i] == (uint8_t)~tx[i - 1]; i++);
+  CHECK(i == sizeof(buffer));
+  CHECK(!(UCSR1A & _BV(DOR1)));
+
+  // 1 us a byte at F_CPU / 2, back to back
+  CHECK(took >= 100 && took < 105);
+
+  // separate buffers
+  reset();
+  SPI1.transfer(tx, rx, sizeof(tx));
+  CHECK(receivedCount == sizeof(tx));
+  CHECK(memcmp(received, tx, sizeof(tx)) == 0);
+  for (i = 1; i < sizeof(rx) && rx[i] == (uint8_t)~tx[i - 1]; i++);
+  CHECK(i == sizeof(rx));
+
+  // nothing to send, or nothing to keep
+  reset();
+  SPI1.transfer(NULL, rx, 10);
+  for (i = 0; i < 10 && received[i] == 0xFF; i++);
+  CHECK(i == 10 && receivedCount == 10);
+  reset();
+  SPI1.transfer(tx, NULL, 10);
+  CHECK(memcmp(received, tx, 10) == 0 && receivedCount == 10);
+  CHECK(!(UCSR1A & _BV(DOR1)));
+}
+
+
+void testBackground()
+{
+  uint8_t a[64];
+  uint8_t b[32];
+  uint8_t c[8];
+  uint8_t rxA[64];
+  uint16_t i;
+  unsigned long start;
+  unsigned long took;
+
+  for (i = 0; i < sizeof(a); i++)
+    a[i] = i;
+  for (i = 0; i < sizeof(b); i++)
+    b[i] = 0x80 + i;
+
+  // at DIV16, 8 us a byte
+  SPI1.setClockDivider(SPI_CLOCK_DIV16);
+  reset();
+  doneCount = 0;
+  start = micros();
+  CHECK(SPI1.transferAsync(a, rxA, sizeof(a), doneA));
+  CHECK(SPI1.transferAsync(b, NULL, sizeof(b), doneB));
+  CHECK(!SPI1.transferAsync(c, NULL, sizeof(c)));   // two are waiting
+  CHECK(SPI1.busy());
+  CHECK(receivedCount <= 1);
+
+  while (SPI1.busy() && micros() - start < 10000);
+  took = micros() - start;
+  CHECK(!SPI1.busy());
+  CHECK(!(UCSR1B & _BV(RXCIE1)));
+  CHECK(doneCount == 2 && doneOrder[0] == 'A' && doneOrder[1] == 'B');
+
+  // one after the other, nothing lost, and no gaps
+  CHECK(receivedCount == sizeof(a) + sizeof(b));
+  CHECK(memcmp(received, a, sizeof(a)) == 0);
+  CHECK(memcmp(received + sizeof(a), b, sizeof(b)) == 0);
+  CHECK(rxA[0] == 0xFF);
+  for (i = 1; i < sizeof(rxA) && rxA[i] == (uint8_t)~a[i - 1]; i++);
+  CHECK(i == sizeof(rxA));
+  CHECK(!(UCSR1A & _BV(DOR1)));
+  CHECK(took >= 768 && took < 790);
+
+  // and the blocking ones carry on
+  CHECK(SPI1.transfer(0x55) == (uint8_t)~b[sizeof(b) - 1]);
+  SPI1.setClockDivider(SPI_CLOCK_DIV2);
+}
+
+
+void testSerialAgain()
+{
+  uint8_t out[3];
+
+  SPI1.end();
+  CHECK((UCSR1C & 0xC0) == 0);
+
+  Serial1.begin(115200);
+  Serial1.write('o');
+  Serial1.write('k');
+  delay(2);
+  CHECK(hostSerialTransmitted(1, out, sizeof(out)) == 2);
+  CHECK(out[0] == 'o' && out[1] == 'k');
+
+  // and received characters are buffered again
+  hostSerialReceive(1, (const uint8_t *)"x", 1);
+  delay(2);
+  CHECK(Serial1.read() == 'x');
+}
+
+
+int main(void)
+{
+  hostClockMode(HOST_CLOCK_STEPPED, 4);
+  boardInit();
+
+  hostSerialSpiDevice(1, device);
+
+  testSetup();
+  testBytes();
+  testBlocking();
+  testBackground();
+  testSerialAgain();
+
+  exit(hostTestResult());
+}
@@ -0,0 +1,153 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Servo test: several servos pulsed in turn from the interrupt, with a
+|| | detached one skipped, and servos on the output compare pins of a
+|| | timer in hardware mode, which a timer pulsing servos from its
+|| | interrupt can't share.
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#include <Wiring.h>
+#include <Servo.h>
+#include "HostTest.h"
+
+// Servos 0 to 11 are on Timer 5, 12 to 23 on Timer 1
+Servo onTimer5[SERVOS_PER_TIMER];
+Servo onTimer1[2];
+
+
+// Waits for the pin to go to the level, returning the time it did.
+unsigned long edge(uint8_t pin, uint8_t level)
+{
+  while (pinRead(pin) != level);
+
+  return micros();
+}
+
+
+// Width of the next pulse on the pin, in microseconds
+unsigned long pulseWidth(uint8_t pin)
+{
+  unsigned long start;
+
+  edge(pin, LOW);
+  start = edge(pin, HIGH);
+
+  return edge(pin, LOW) - start;
+}
+
+
+void testMultiplexed()
+{
+  unsigned long fall;
+  unsigned long gap;
+
+  onTimer5[0].attach(20);
+  onTimer5[1].attach(21);
+  onTimer5[2].attach(22);
+  onTimer5[0].writeMicroseconds(1000);
+  onTimer5[1].writeMicroseconds(1500);
+  onTimer5[2].writeMicroseconds(2000);
+
+  CHECK(abs((long)pulseWidth(20) - 1000) <= 10);
+  CHECK(abs((long)pulseWidth(21) - 1500) <= 10);
+  CHECK(abs((long)pulseWidth(22) - 2000) <= 10);
+
+  // each pulse starts as the one before ends
+  edge(21, HIGH);
+  fall = edge(21, LOW);
+  gap = edge(22, HIGH) - fall;
+  CHECK(gap <= 10);
+
+  // a detached servo is skipped, not waited out
+  onTimer5[1].detach();
+  CHECK(!onTimer5[1].attached());
+  CHECK(pinRead(21) == LOW);
+  edge(20, HIGH);
+  fall = edge(20, LOW);
+  gap = edge(22, HIGH) - fall;
+  CHECK(gap <= 10);
+  CHECK(abs((long)pulseWidth(22) - 2000) <= 10);
+  CHECK(pinRead(21) == LOW);
+
+  onTimer5[0].detach();
+  onTimer5[2].detach();
+}
+
+
+void testHardware()
+{
+  Servo *a = &onTimer1[0];
+  Servo *b = &onTimer1[1];
+
+  // only output compare pins of the 16 bit timers
+  CHECK(a->attachHardware(20) == INVALID_SERVO);
+  CHECK(a->attachHardware(34) == INVALID_SERVO);   // Timer 2
+
+  CHECK(a->attachHardware(29) == SERVOS_PER_TIMER);
+  CHECK(a->attached());
+  CHECK(b->attachHardware(29) == INVALID_SERVO);  // the pin is taken
+
+  // fast PWM, TOP = ICR1 at 20 ms, OC1A set at BOTTOM
+  CHECK((TCCR1A & 0x03) == 0x02 && (TCCR1B & 0x18) == 0x18);
+  CHECK((TCCR1B & 0x07) == CLOCK_PRESCALE_8);
+  CHECK((TCCR1A & 0xC0) == 0x80);
+  CHECK(ICR1 == 39999);
+  CHECK(OCR1A == 2999);
+  CHECK(a->readMicroseconds() == DEFAULT_PULSE_WIDTH);
+
+  a->writeMicroseconds(1000);
+  CHECK(OCR1A == 1999);
+  CHECK(a->readMicroseconds() == 1000);
+  a->write(180);
+  CHECK(a->read() == 180);
+  CHECK(OCR1A == 2 * a->readMicroseconds() - 1);
+
+  CHECK(b->attachHardware(30) == SERVOS_PER_TIMER + 1);
+  b->writeMicroseconds(2000);
+  CHECK((TCCR1A & 0x30) == 0x20);
+  CHECK(OCR1B == 3999);
+  CHECK(OCR1A == 2 * a->readMicroseconds() - 1);
+
+  // the timer can't pulse servos from its interrupt meanwhile
+  b->detach();
+  CHECK((TCCR1A & 0x30) == 0);
+  CHECK(b->attach(21) == INVALID_SERVO);
+  CHECK(!b->attached());
+
+  // and the other way around
+  a->detach();
+  CHECK((TCCR1A & 0xC0) == 0);
+  CHECK((TCCR1B & 0x07) == 0);
+  CHECK(b->attach(21) == SERVOS_PER_TIMER + 1);
+  CHECK(a->attachHardware(29) == INVALID_SERVO);
+  b->writeMicroseconds(1200);
+  CHECK(abs((long)pulseWidth(21) - 1200) <= 10);
+  b->detach();
+
+  // free again
+  CHECK(a->attachHardware(31) == SERVOS_PER_TIMER);
+  CHECK((TCCR1A & 0x0C) == 0x08);
+  a->detach();
+}
+
+
+int main(void)
+{
+  hostClockMode(HOST_CLOCK_STEPPED, 4);
+  boardInit();
+
+  testMultiplexed();
+  testHardware();
+
+  exit(hostTestResult());
+}
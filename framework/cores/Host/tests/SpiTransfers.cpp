@@ -0,0 +1,177 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | SPI test: single bytes, blocking buffer transfers (in place, with
+|| | separate and missing buffers) keeping up with the bus without a
+|| | write collision, and background transfers from the interrupt, one
+|| | buffer following the other.
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#include <Wiring.h>
+#include <SPI.h>
+#include "HostTest.h"
+
+// The device answers each byte with the one before it, inverted.
+uint8_t last;
+uint8_t received[512];
+uint16_t receivedCount;
+
+uint8_t device(uint8_t data)
+{
+  uint8_t answer = ~last;
+
+  last = data;
+  if (receivedCount < sizeof(received))
+    received[receivedCount] = data;
+  receivedCount++;
+
+  return answer;
+}
+
+
+uint8_t doneOrder[3];
+uint8_t doneCount;
+
+void doneA()
+{
+  doneOrder[doneCount++] = 'A';
+}
+
+
+void doneB()
+{
+  doneOrder[doneCount++] = 'B';
+}
+
+
+void reset()
+{
+  last = 0;
+  receivedCount = 0;
+}
+
+
+void testBytes()
+{
+  reset();
+  CHECK(SPI.transfer(0x12) == 0xFF);
+  CHECK(SPI.transfer(0x34) == (uint8_t)~0x12);
+  CHECK(receivedCount == 2);
+}
+
+
+void testBlocking()
+{
+  uint8_t buffer[100];
+  uint8_t tx[100];
+  uint8_t rx[100];
+  uint16_t i;
+  unsigned long start;
+  unsigned long took;
+
+  for (i = 0; i < sizeof(tx); i++)
+    tx[i] = buffer[i] = i * 7;
+
+  // in place
+  reset();
+  start = micros();
+  SPI.transfer(buffer, sizeof(buffer));
+  took = micros() - start;
+  CHECK(receivedCount == sizeof(buffer));
+  CHECK(memcmp(received, tx, sizeof(tx)) == 0);
+  CHECK(buffer[0] == 0xFF);
+  for (i = 1; i < sizeof(buffer) && buffer[i] == (uint8_t)~tx[i - 1]; i++);
+  CHECK(i == sizeof(buffer));
+  CHECK(!(SPSR & _BV(WCOL)));
+
+  // 1 us a byte at SPI_CLOCK_DIV2, and little more in between
+  CHECK(took >= 100 && took < 200);
+
+  // separate buffers
+  reset();
+  SPI.transfer(tx, rx, sizeof(tx));
+  CHECK(receivedCount == sizeof(tx));
+  CHECK(memcmp(received, tx, sizeof(tx)) == 0);
+  for (i = 1; i < sizeof(rx) && rx[i] == (uint8_t)~tx[i - 1]; i++);
+  CHECK(i == sizeof(rx));
+
+  // nothing to send, or nothing to keep
+  reset();
+  SPI.transfer(NULL, rx, 10);
+  for (i = 0; i < 10 && received[i] == 0xFF; i++);
+  CHECK(i == 10 && receivedCount == 10);
+  reset();
+  SPI.transfer(tx, NULL, 10);
+  CHECK(memcmp(received, tx, 10) == 0 && receivedCount == 10);
+  CHECK(!(SPSR & _BV(WCOL)));
+}
+
+
+void testBackground()
+{
+  uint8_t a[64];
+  uint8_t b[32];
+  uint8_t c[8];
+  uint8_t rxA[64];
+  uint16_t i;
+  unsigned long start;
+
+  for (i = 0; i < sizeof(a); i++)
+    a[i] = i;
+  for (i = 0; i < sizeof(b); i++)
+    b[i] = 0x80 + i;
+
+  // at DIV16, 8 us a byte
+  SPI.setClockDivider(SPI_CLOCK_DIV16);
+  reset();
+  doneCount = 0;
+  CHECK(SPI.transferAsync(a, rxA, sizeof(a), doneA));
+  CHECK(SPI.transferAsync(b, NULL, sizeof(b), doneB));
+  CHECK(!SPI.transferAsync(c, NULL, sizeof(c)));    // two are waiting
+  CHECK(SPI.busy());
+  CHECK(receivedCount <= 1);
+
+  start = millis();
+  while (SPI.busy() && millis() - start < 10);
+  CHECK(!SPI.busy());
+  CHECK(!(SPCR & _BV(SPIE)));
+  CHECK(doneCount == 2 && doneOrder[0] == 'A' && doneOrder[1] == 'B');
+
+  // one after the other, nothing lost
+  CHECK(receivedCount == sizeof(a) + sizeof(b));
+  CHECK(memcmp(received, a, sizeof(a)) == 0);
+  CHECK(memcmp(received + sizeof(a), b, sizeof(b)) == 0);
+  CHECK(rxA[0] == 0xFF);
+  for (i = 1; i < sizeof(rxA) && rxA[i] == (uint8_t)~a[i - 1]; i++);
+  CHECK(i == sizeof(rxA));
+  CHECK(!(SPSR & _BV(WCOL)));
+
+  // and the blocking ones carry on
+  CHECK(SPI.transfer(0x55) == (uint8_t)~b[sizeof(b) - 1]);
+  SPI.setClockDivider(SPI_CLOCK_DIV2);
+}
+
+
+int main(void)
+{
+  hostClockMode(HOST_CLOCK_STEPPED, 4);
+  boardInit();
+
+  hostSpiDevice(device);
+  SPI.begin(SPI_MASTER, MSBFIRST, SPI_MODE0, SPI_CLOCK_DIV2);
+
+  testBytes();
+  testBlocking();
+  testBackground();
+
+  exit(hostTestResult());
+}
@@ -0,0 +1,325 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Stream parser test: numbers, lines and keywords taken a character
+|| | at a time and from Serial as the characters arrive, poll() never
+|| | waiting, find() falling back on a partial match through a failure
+|| | table instead of starting over, parseInt() and parseFloat() as
+|| | before, and no heap used.
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#include <Wiring.h>
+#include "HostTest.h"
+
+// Heap calls, counted around the glibc allocator.
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_realloc(void *p, size_t size);
+
+unsigned long allocations;
+
+extern "C" void *malloc(size_t size) throw()
+{
+  allocations++;
+  return __libc_malloc(size);
+}
+
+extern "C" void *realloc(void *p, size_t size) throw()
+{
+  allocations++;
+  return __libc_realloc(p, size);
+}
+
+
+void receive(const char *text)
+{
+  hostSerialReceive(0, (const uint8_t *)text, strlen(text));
+}
+
+
+// Feeds text; the number of items completed.
+template<class P>
+uint8_t feed(P &parser, const char *text)
+{
+  uint8_t done = 0;
+
+  while (*text)
+    if (parser.parse(*text++))
+      done++;
+  return done;
+}
+
+
+// The characters of target matched after c, with the failure table of
+// its first tableLength characters.
+size_t match(const char *target, uint8_t tableLength, size_t matched, char c)
+{
+  uint8_t failure[STREAM_MATCH_LENGTH];
+  size_t length = strlen(target);
+
+  streamFailure(target, length < tableLength ? length : tableLength, failure);
+  return streamMatch(target, failure, tableLength, matched, c);
+}
+
+
+void testMatch()
+{
+  const char *targets[] = { "aab", "abab", "ababc", "abacabab", "aaaa" };
+  const char *text = "abacababcaabaaaab";
+  uint8_t failure[8];
+  size_t table, worked;
+  uint8_t i, j;
+
+  streamFailure("ababc", 5, failure);
+  CHECK(failure[0] == 0 && failure[1] == 0 && failure[2] == 1 && failure[3] == 2 && failure[4] == 0);
+  streamFailure("abacabab", 8, failure);
+  CHECK(failure[6] == 3 && failure[7] == 2);
+
+  CHECK(match("aab", 3, 2, 'a') == 2);   // "aa" + 'a': "aa" still
+  CHECK(match("aab", 3, 2, 'b') == 3);
+  CHECK(match("abab", 4, 3, 'a') == 1);  // "abaa": "a"
+  CHECK(match("ababc", 5, 4, 'a') == 3);
+  CHECK(match("abc", 3, 2, 'x') == 0);
+
+  // past the table, the same as with it
+  for (i = 0; i < sizeof(targets) / sizeof(targets[0]); i++)
+  {
+    table = 0;
+    worked = 0;
+    for (j = 0; text[j]; j++)
+    {
+      table = match(targets[i], STREAM_MATCH_LENGTH, table, text[j]);
+      worked = match(targets[i], 1, worked, text[j]);
+      CHECK(table == worked);
+      if (table == strlen(targets[i]))
+        table = worked = 0;
+    }
+  }
+}
+
+
+void testNumbers()
+{
+  NumberParser number;
+  NumberParser grouped(false, ',');
+  NumberParser decimal(true);
+  char c;
+
+  CHECK(feed(number, "abc-123") == 0);
+  CHECK(number.toInt() == -123);
+  CHECK(number.parse(';'));
+  CHECK(number.toInt() == -123);
+
+  // after the end, the next number
+  CHECK(feed(number, " 10 20 30\n") == 3);
+  CHECK(number.toInt() == 30);
+
+  CHECK(feed(grouped, "x1,234,567;") == 1);
+  CHECK(grouped.toInt() == 1234567L);
+
+  CHECK(feed(decimal, "T=-12.625C") == 1);
+  CHECK(decimal.toFloat() == -12.625f);
+  CHECK(feed(decimal, "7.") == 0);
+  CHECK(decimal.parse(' ') && decimal.toFloat() == 7.0f);
+
+  // without a point, the point ends an integer
+  number.reset();
+  CHECK(feed(number, "3.5") == 1);
+  CHECK(number.toInt() == 5);
+
+  // nothing yet
+  decimal.reset();
+  for (c = 'a'; c <= 'z'; c++)
+    CHECK(!decimal.parse(c));
+  CHECK(decimal.toInt() == 0);
+}
+
+
+void testLines()
+{
+  char buffer[8];
+  LineReader line(buffer, sizeof(buffer));
+
+  CHECK(feed(line, "GO 1") == 0);
+  CHECK(line.length() == 4 && strcmp(line.c_str(), "GO 1") == 0);
+  CHECK(feed(line, "0\nSTOP\n") == 2);
+  CHECK(strcmp(line.c_str(), "STOP") == 0);
+
+  CHECK(feed(line, "0123456789\n") == 1);
+  CHECK(line.overflowed());
+  CHECK(line.length() == 7 && strcmp(line.c_str(), "0123456") == 0);
+
+  CHECK(feed(line, "\n") == 1);
+  CHECK(line.length() == 0 && !line.overflowed());
+}
+
+
+void testFinder()
+{
+  const char *keys[] = { "STOP", "START", "STATUS" };
+  StreamFinder<3> keyword(keys);
+  const char *text = "xxSTASTOPyySTARSTATUSSTART";
+  int found[4];
+  uint8_t n = 0;
+  int k;
+
+  while (*text)
+    if ((k = keyword.parse(*text++)) >= 0)
+      found[n++] = k;
+  CHECK(n == 3);
+  CHECK(found[0] == 0 && found[1] == 2 && found[2] == 1);
+
+  // a failed match that is the start of the next one
+  const char *repeat[] = { "abac" };
+  StreamFinder<1> finder(repeat);
+
+  text = "ababac";
+  while (*text && finder.parse(*text++) < 0);
+  CHECK(*text == 0 && text[-1] == 'c');
+
+  // longer than its failure table
+  const char *longer[] = { "abcabcabd" };
+  StreamFinder<1, 4> shortTable(longer);
+
+  text = "abcabcabcabd";
+  while (*text && shortTable.parse(*text++) < 0);
+  CHECK(*text == 0 && text[-1] == 'd');
+}
+
+
+// Characters arrive one every 87 us at 115200 baud.
+void testPolling()
+{
+  NumberParser number;
+  unsigned long start;
+
+  Serial.begin(115200);
+
+  // nothing there: returns at once
+  start = micros();
+  CHECK(!number.poll(Serial));
+  CHECK(micros() - start < 100);
+
+  receive("speed 12");
+  delay(2);
+  start = micros();
+  CHECK(!number.poll(Serial));
+  CHECK(micros() - start < 100);
+  CHECK(number.toInt() == 12);
+  CHECK(Serial.available() == 0);
+
+  receive("3\n");
+  delay(1);
+  CHECK(number.poll(Serial));
+  CHECK(number.toInt() == 123);
+  CHECK(Serial.peek() == '\n');
+  CHECK(!number.poll(Serial));
+}
+
+
+void testPollingLines()
+{
+  char buffer[16];
+  LineReader line(buffer, sizeof(buffer));
+  const char *keys[] = { "OK\r\n", "ERROR" };
+  StreamFinder<2> reply(keys);
+  unsigned long start;
+  uint8_t lines = 0;
+  int found = -1;
+
+  // more than the receive buffer holds, taken as it comes
+  receive("first line\nsecond line\nthird\n");
+  start = millis();
+  while (lines < 3 && millis() - start < 10)
+    if (line.poll(Serial))
+      lines++;
+  CHECK(lines == 3);
+  CHECK(strcmp(line.c_str(), "third") == 0);
+
+  receive("AT+X\r\nOKAY\r\nOK\r\n");
+  start = millis();
+  while (found < 0 && millis() - start < 10)
+    found = reply.poll(Serial);
+  CHECK(found == 0);
+  CHECK(Serial.available() == 0);
+}
+
+
+// The next character, waiting for it as the blocking calls do.
+int next()
+{
+  char c;
+
+  return Serial.readBytes(&c, 1) ? c : -1;
+}
+
+
+// The blocking calls, as before; find() now finds "aab" in "aaab".
+void testBlocking()
+{
+  Serial.setTimeout(5);
+
+  receive("xaaab;");
+  CHECK(Serial.find((char *)"aab"));
+  CHECK(next() == ';');
+
+  receive("ababc!");
+  CHECK(Serial.find((char *)"abc"));
+  CHECK(next() == '!');
+
+  receive("no target here.END more");
+  CHECK(!Serial.findUntil((char *)"target!", (char *)"END"));
+  CHECK(next() == ' ');
+  while (next() >= 0);
+
+  receive("  -42x 3.25;");
+  CHECK(Serial.parseInt() == -42);
+  CHECK(next() == 'x');
+  CHECK(Serial.parseFloat() == 3.25f);
+  CHECK(next() == ';');
+
+  // timeout with nothing
+  CHECK(Serial.parseInt() == 0);
+}
+
+
+void testNoHeap()
+{
+  char buffer[16];
+  LineReader line(buffer, sizeof(buffer));
+  NumberParser number(true);
+  const char *keys[] = { "GO" };
+  StreamFinder<1> go(keys);
+  unsigned long before = allocations;
+
+  feed(line, "a line\n");
+  feed(number, "-1.5 ");
+  while (go.parse('x') < 0 && go.parse('G') < 0 && go.parse('O') < 0);
+  CHECK(allocations == before);
+}
+
+
+int main(void)
+{
+  hostClockMode(HOST_CLOCK_STEPPED, 4);
+  boardInit();
+
+  testMatch();
+  testNumbers();
+  testLines();
+  testFinder();
+  testPolling();
+  testPollingLines();
+  testBlocking();
+  testNoHeap();
+
+  exit(hostTestResult());
+}
@@ -0,0 +1,255 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | String test: short strings and numbers kept in the object, growth
+|| | by doubling, strings in caller owned storage, moves and copies
+|| | between the kinds of buffer, invalid strings, and a formatting loop
+|| | that stops allocating once it has warmed up.
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#include <Wiring.h>
+#include "HostTest.h"
+
+// Heap calls and the blocks in use, counted around the glibc allocator.
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_realloc(void *p, size_t size);
+extern "C" void __libc_free(void *p);
+
+unsigned long allocations;
+long blocks;
+
+extern "C" void *malloc(size_t size) throw()
+{
+  allocations++;
+  blocks++;
+  return __libc_malloc(size);
+}
+
+extern "C" void *realloc(void *p, size_t size) throw()
+{
+  allocations++;
+  if (!p)
+    blocks++;
+  return __libc_realloc(p, size);
+}
+
+extern "C" void free(void *p) throw()
+{
+  if (p)
+    blocks--;
+  __libc_free(p);
+}
+
+
+void testInline()
+{
+  unsigned long before = allocations;
+  long inUse = blocks;
+
+  {
+    String empty;
+    String greeting("hello world");      // 11 characters
+    String lowest(-2147483647L - 1);
+    String hex(0xBEEFUL, HEX);
+    String c('x');
+    String pi(3.14159, 3);
+
+    CHECK(empty.length() == 0 && empty == "");
+    CHECK(greeting == "hello world");
+    CHECK(lowest == "-2147483648");
+    CHECK(hex == "beef");
+    CHECK(c == "x" && pi == "3.142");
+
+    greeting += '!';                     // 12: to the heap
+    CHECK(greeting == "hello world!");
+  }
+  CHECK(allocations - before == 1);
+  CHECK(blocks == inUse);
+}
+
+
+void testGrowth()
+{
+  unsigned long before = allocations;
+  long inUse = blocks;
+  uint16_t i;
+
+  {
+    String s;
+
+    // 12, 24, 48, 96, 192, 384
+    for (i = 0; i < 300; i++)
+      s += (char)('a' + i % 26);
+    CHECK(s.length() == 300);
+    CHECK(s[0] == 'a' && s[26] == 'a' && s[299] == 'a' + 299 % 26);
+    CHECK(allocations - before == 5);
+
+    // reserve() asks for no more than that
+    s.reserve(1000);
+    CHECK(allocations - before == 6);
+  }
+  CHECK(blocks == inUse);
+}
+
+
+void testStorage()
+{
+  char storage[32];
+  unsigned long before = allocations;
+  long inUse = blocks;
+  uint8_t i;
+
+  {
+    String s(storage, sizeof(storage), "count:");
+
+    for (i = 0; i < 5; i++)
+    {
+      s += ' ';
+      s += i;
+    }
+    CHECK(s == "count: 0 1 2 3 4");
+    CHECK(s.c_str() == storage);
+    s = "a longer line that no longer fits in there";
+    CHECK(s.c_str() != storage);
+    CHECK(s == "a longer line that no longer fits in there");
+    CHECK(allocations - before == 1);
+  }
+  CHECK(blocks == inUse);
+
+  // copies are strings of their own
+  {
+    String s(storage, sizeof(storage), "shared");
+    String t(s);
+
+    t.setCharAt(0, 'S');
+    CHECK(s == "shared" && t == "Shared");
+    CHECK(t.c_str() != storage);
+  }
+  CHECK(blocks == inUse);
+}
+
+
+String longString(const char *tail)
+{
+  String s("a string for the heap, ");
+
+  s += tail;
+  return s;
+}
+
+
+void testMoves()
+{
+  unsigned long before;
+  long inUse = blocks;
+
+  {
+    String s;
+
+    // the heap buffer is taken over, not copied
+    before = allocations;
+    s = longString("moved");
+    CHECK(s == "a string for the heap, moved");
+    CHECK(allocations - before == 2);
+
+    // inline ones are copied
+    s = String("short");
+    CHECK(s == "short");
+
+    String t = String(42);
+    CHECK(t == "42");
+
+    // and to a string that has the room, nothing new
+    before = allocations;
+    s = longString("again");
+    CHECK(s == "a string for the heap, again");
+    CHECK(allocations - before == 2);
+  }
+  CHECK(blocks == inUse);
+}
+
+
+void testInvalid()
+{
+  String s("abc");
+
+  s = (const char *)NULL;
+  CHECK(!s);
+  CHECK(s.length() == 0);
+  CHECK(s.reserve(0));
+  CHECK(s && s == "");
+  s += "valid again";
+  CHECK(s == "valid again");
+}
+
+
+void testSteadyState()
+{
+  String line;
+  unsigned long before = 0;
+  unsigned long value = 4000000000UL;
+  uint8_t i;
+
+  for (i = 0; i < 100; i++)
+  {
+    if (i == 1)
+      before = allocations;
+
+    line = "reading ";
+    line += i;
+    line += ": ";
+    line += value - i * 12345UL;
+    line += " mV, ";
+    line += String(i * 1.5, 1);
+    line += " C";
+  }
+  CHECK(line == "reading 99: 3998777845 mV, 148.5 C");
+  CHECK(allocations == before);
+}
+
+
+void testReadString()
+{
+  unsigned long before;
+  String s;
+  char text[101];
+  uint8_t i;
+
+  for (i = 0; i < 100; i++)
+    text[i] = '0' + i % 10;
+  text[100] = 0;
+
+  Serial.begin(115200);
+  Serial.setTimeout(5);
+  hostSerialReceive(0, (const uint8_t *)text, 100);
+  before = allocations;
+  s = Serial.readString();
+  CHECK(s == text);
+  CHECK(allocations - before <= 4);
+}
+
+
+int main(void)
+{
+  hostClockMode(HOST_CLOCK_STEPPED, 4);
+  boardInit();
+
+  testInline();
+  testGrowth();
+  testStorage();
+  testMoves();
+  testInvalid();
+  testSteadyState();
+  testReadString();
+
+  exit(hostTestResult());
+}
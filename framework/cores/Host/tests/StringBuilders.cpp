@@ -0,0 +1,148 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | StringBuilder test: formatting with print() and += into the fixed
+|| | buffer, truncation reported as a write error, the String comparison
+|| | and search functions on it, copies, and a log line loop that never
+|| | touches the heap.
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#include <Wiring.h>
+#include "HostTest.h"
+
+// Heap calls, counted around the glibc allocator.
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_realloc(void *p, size_t size);
+
+unsigned long allocations;
+
+extern "C" void *malloc(size_t size) throw()
+{
+  allocations++;
+  return __libc_malloc(size);
+}
+
+extern "C" void *realloc(void *p, size_t size) throw()
+{
+  allocations++;
+  return __libc_realloc(p, size);
+}
+
+
+void testFormatting()
+{
+  StringBuilder<40> line;
+
+  CHECK(line.length() == 0 && line == "");
+  line.print("T=");
+  line.print(-12.345, 1);
+  line.print(' ');
+  line.print(255, HEX);
+  line.print(' ');
+  line.print(1234567890UL);
+  CHECK(line == "T=-12.3 FF 1234567890");
+
+  line = "n:";
+  line += 42;
+  line += ',';
+  line += String("s");
+  line += -7L;
+  CHECK(line == "n:42,s-7");
+  CHECK(line.length() == 8);
+
+  line.clear();
+  line.println("x");
+  CHECK(line == "x\r\n");
+}
+
+
+void testTruncation()
+{
+  StringBuilder<8> small;
+
+  small.print("12345");
+  CHECK(!small.getWriteError());
+  small.print(6789);
+  CHECK(small == "12345678");
+  CHECK(small.getWriteError());
+  CHECK(small.write('!') == 0);
+  CHECK(small.length() == 8);
+
+  small.clear();
+  CHECK(!small.getWriteError() && small == "");
+  CHECK(small.print("abc") == 3);
+}
+
+
+void testStringFunctions()
+{
+  StringBuilder<32> line("GET /index.html HTTP/1.1");
+  String method("GET");
+
+  CHECK(line.startsWith(method));
+  CHECK(line.endsWith("HTTP/1.1"));
+  CHECK(line.indexOf('/') == 4);
+  CHECK(line.indexOf("HTTP") == 16);
+  CHECK(line.lastIndexOf('/') == 20);
+  CHECK(line.substring(4, 15) == "/index.html");
+  CHECK(line.charAt(0) == 'G' && line[1] == 'E');
+  CHECK(method != line);
+  CHECK(String("GET /index.html HTTP/1.1") == line);
+  CHECK(line.equalsIgnoreCase("get /INDEX.html http/1.1"));
+  CHECK(line > method);
+
+  // a String copy, and a copy that keeps its own buffer
+  String copy(line);
+  CHECK(copy == line);
+  StringBuilder<32> other(line);
+  other.setCharAt(0, 'P');
+  CHECK(other.c_str() != line.c_str());
+  CHECK(other.startsWith("PET") && line.startsWith("GET"));
+  other = line;
+  CHECK(other == line);
+}
+
+
+void testNoHeap()
+{
+  StringBuilder<64> line;
+  unsigned long before = allocations;
+  uint16_t i;
+
+  for (i = 0; i < 200; i++)
+  {
+    line.clear();
+    line.print(millis());
+    line.print(" ms: sensor ");
+    line.print(i % 4);
+    line.print(" = ");
+    line.print(i * 0.25, 2);
+    line.print(" V");
+  }
+  CHECK(allocations == before);
+  CHECK(!line.getWriteError());
+  CHECK(line.endsWith("sensor 3 = 49.75 V"));
+}
+
+
+int main(void)
+{
+  hostClockMode(HOST_CLOCK_STEPPED, 4);
+  boardInit();
+
+  testFormatting();
+  testTruncation();
+  testStringFunctions();
+  testNoHeap();
+
+  exit(hostTestResult());
+}
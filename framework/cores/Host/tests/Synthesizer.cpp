@@ -0,0 +1,231 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Synthesizer test: the PWM set up for the sample rate, the mix of
+|| | the voices in the duty cycle (frequency, volume, envelopes), voice
+|| | allocation, voices out of range ignored, the mix scaled to a TOP
+|| | that is not a multiple of 256, and the overflow handlers of the
+|| | other timers still calling their attached functions.
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#include <Wiring.h>
+#include <Synth.h>
+#include "HostTest.h"
+
+#define SYNTH_PIN 29                      // OC1A
+
+// Duty cycle of silence at 31.25 kHz (TOP = 511)
+#define MIDDLE 256
+
+uint16_t low, high, crossings;
+
+volatile unsigned long timer3Overflows;
+
+void countTimer3()
+{
+  timer3Overflows++;
+}
+
+
+// The extremes of the output over the time, and how often it went up
+// through the middle.
+void observe(unsigned long ms)
+{
+  unsigned long start = millis();
+  uint16_t last = MIDDLE;
+  uint16_t value;
+
+  low = 0xFFFF;
+  high = 0;
+  crossings = 0;
+
+  while (millis() - start < ms)
+  {
+    cli();
+    value = OCR1A;
+    sei();
+
+    if (value < low)
+      low = value;
+    if (value > high)
+      high = value;
+    if (last < MIDDLE && value >= MIDDLE)
+      crossings++;
+    last = value;
+  }
+}
+
+
+void testSetup()
+{
+  CHECK(!Synth.begin(20));                // not an output compare pin
+  CHECK(!Synth.begin(34));                // Timer 2
+  CHECK(!Synth.begin(SYNTH_PIN, 100));    // TOP over 16 bits
+  CHECK(!Synth.begin(SYNTH_PIN, 65000));  // under 8 bits of PWM
+
+  CHECK(Synth.begin(SYNTH_PIN));
+  CHECK((TCCR1A & 0x03) == 0x02 && (TCCR1B & 0x18) == 0x18);
+  CHECK((TCCR1B & 0x07) == CLOCK_NO_PRESCALE);
+  CHECK((TCCR1A & 0xC0) == 0x80);
+  CHECK(ICR1 == 511);
+  CHECK(TIMSK1 & _BV(TOIE1));
+
+  observe(20);
+  CHECK(low == MIDDLE && high == MIDDLE);
+}
+
+
+void testVoices()
+{
+  Synth.noteOn(0, 1000);
+  observe(100);
+  CHECK(crossings >= 99 && crossings <= 101);
+  CHECK(low <= MIDDLE - 124 && high >= MIDDLE + 124);
+  CHECK(high < 2 * 256);
+
+  // a quarter of the volume
+  Synth.setVolume(0, 64);
+  delay(2);
+  observe(20);
+  CHECK(high >= MIDDLE + 26 && high <= MIDDLE + 34);
+  CHECK(low >= MIDDLE - 34 && low <= MIDDLE - 26);
+  Synth.setVolume(0, 255);
+
+  // a second voice adds to the first
+  Synth.noteOn(1, 1500);
+  delay(2);
+  observe(20);
+  CHECK(high > MIDDLE + 160);
+
+  Synth.noteOff(0);
+  Synth.noteOff(1);
+  delay(2);
+  CHECK(!Synth.playing(0) && !Synth.playing(1));
+  observe(10);
+  CHECK(low == MIDDLE && high == MIDDLE);
+
+  // one voice per note, as long as there are voices
+  CHECK(Synth.play(440) == 0);
+  CHECK(Synth.play(550) == 1);
+  CHECK(Synth.play(660) == 2);
+  CHECK(Synth.play(880) == 3);
+  CHECK(Synth.play(990) == -1);
+  Synth.noteOff(2);
+  CHECK(Synth.play(770) == 2);
+  for (uint8_t i = 0; i < SYNTH_VOICES; i++)
+    Synth.noteOff(i);
+  delay(2);
+}
+
+
+void testEnvelope()
+{
+  Synth.setEnvelope(0, 100, 50, 128, 100);
+  Synth.noteOn(0, 500);
+
+  // still rising after 10 ms
+  observe(10);
+  CHECK(Synth.playing(0));
+  CHECK(high < MIDDLE + 20);
+
+  // at the top of the attack
+  delay(85);
+  observe(10);
+  CHECK(high >= MIDDLE + 110);
+
+  // settled to half
+  delay(60);
+  observe(10);
+  CHECK(high >= MIDDLE + 56 && high <= MIDDLE + 68);
+
+  // and released
+  Synth.noteOff(0);
+  delay(20);
+  CHECK(Synth.playing(0));
+  delay(40);
+  CHECK(!Synth.playing(0));
+  observe(10);
+  CHECK(low == MIDDLE && high == MIDDLE);
+
+  Synth.setEnvelope(0, 0, 0, 255, 0);
+}
+
+
+// Past the last voice: nothing is touched.
+void testVoiceRange()
+{
+  uint8_t i;
+
+  Synth.setEnvelope(SYNTH_VOICES, 1, 1, 1, 1);
+  Synth.noteOn(SYNTH_VOICES, 440);
+  CHECK(!Synth.playing(SYNTH_VOICES));
+  for (i = 0; i < SYNTH_VOICES; i++)
+    CHECK(!Synth.playing(i));
+  observe(5);
+  CHECK(low == MIDDLE && high == MIDDLE);
+}
+
+
+// 20 kHz: TOP = 799, so the low byte of the scale counts too.
+void testScale()
+{
+  CHECK(Synth.begin(SYNTH_PIN, 20000));
+  CHECK(ICR1 == 799);
+  delay(1);
+  CHECK(OCR1A == 400);
+
+  Synth.noteOn(0, 1000);
+  delay(2);
+  cli();
+  CHECK(OCR1A > 400 - 200 && OCR1A < 400 + 200);
+  sei();
+  Synth.noteOff(0);
+  delay(2);
+  CHECK(OCR1A == 400);
+}
+
+
+void testOtherTimers()
+{
+  unsigned long start;
+
+  Timer3.setMode(0);
+  Timer3.attachInterrupt(INTERRUPT_OVERFLOW, countTimer3);
+  Timer3.setClockSource(CLOCK_PRESCALE_8);  // every 32.768 ms
+
+  start = millis();
+  while (millis() - start < 100);
+  CHECK(timer3Overflows >= 2 && timer3Overflows <= 4);
+
+  Timer3.detachInterrupt(INTERRUPT_OVERFLOW);
+  Timer3.stop();
+}
+
+
+int main(void)
+{
+  hostClockMode(HOST_CLOCK_STEPPED, 4);
+  boardInit();
+
+  testSetup();
+  testVoices();
+  testEnvelope();
+  testVoiceRange();
+  testOtherTimers();
+  testScale();
+
+  Synth.end();
+  CHECK((TCCR1A & 0xC0) == 0);
+  CHECK((TCCR1B & 0x07) == 0);
+
+  exit(hostTestResult());
+}
@@ -0,0 +1,424 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Telemetry test: the CRC, frames of every field type encoded and
+|| | decoded again, 16 bit fields from 0x8000 up not sign extended,
+|| | zeros and long runs in the COBS encoding, frames on Serial both
+|| | ways, a decoder starting in the middle of the stream and
+|| | recovering from damaged frames, frames that don't fit, and no heap
+|| | used on either side.
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#include <Wiring.h>
+#include <Telemetry.h>
+#include "HostTest.h"
+
+// Heap calls, counted around the glibc allocator.
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_realloc(void *p, size_t size);
+
+unsigned long allocations;
+
+extern "C" void *malloc(size_t size) throw()
+{
+  allocations++;
+  return __libc_malloc(size);
+}
+
+extern "C" void *realloc(void *p, size_t size) throw()
+{
+  allocations++;
+  return __libc_realloc(p, size);
+}
+
+
+// Keeps what is printed to it.
+class Capture : public Print
+{
+  public:
+    uint8_t data[1024];
+    size_t length;
+    unsigned long writes;
+
+    Capture() : length(0), writes(0) {}
+
+    virtual size_t write(uint8_t c)
+    {
+      return write(&c, 1);
+    }
+    virtual size_t write(const uint8_t *buffer, size_t size)
+    {
+      writes++;
+      if (size > sizeof(data) - length)
+        size = sizeof(data) - length;
+      memcpy(data + length, buffer, size);
+      length += size;
+      return size;
+    }
+    using Print::write;
+
+    void clear(void)
+    {
+      length = 0;
+      writes = 0;
+    }
+};
+
+Capture capture;
+Telemetry telemetry(capture);
+uint8_t buffer[TELEMETRY_BUFFER_SIZE];
+
+
+// Decodes all of it; the number of good frames.
+unsigned decodeAll(TelemetryDecoder &decoder, const uint8_t *data, size_t length)
+{
+  unsigned good = 0;
+
+  while (length--)
+    if (decoder.decode(*data++))
+      good++;
+  return good;
+}
+
+
+void testCrc()
+{
+  const char *check = "123456789";
+  uint16_t crc = 0xFFFF;
+
+  while (*check)
+    crc = telemetryCrc(crc, *check++);
+  CHECK(crc == 0x29B1);
+}
+
+
+void testFields()
+{
+  TelemetryDecoder decoder(buffer, sizeof(buffer));
+  TelemetryField field;
+  size_t i;
+
+  capture.clear();
+  CHECK(telemetry.begin(7)
+                 .addByte(200)
+                 .addInt(-12345)
+                 .addUnsignedInt(65535)
+                 .addLong(-2000000000L)
+                 .addUnsignedLong(4000000000UL)
+                 .addFloat(-1.5e-3)
+                 .addString("abc")
+                 .addString("")
+                 .end());
+  CHECK(telemetry.length() == 1 + 2 + 3 + 3 + 5 + 5 + 5 + 5 + 2);
+
+  // one write, a delimiter at the end and nowhere else
+  CHECK(capture.writes == 1);
+  CHECK(capture.length == telemetry.length() + 4);
+  CHECK(capture.data[capture.length - 1] == 0);
+  for (i = 0; i < capture.length - 1 && capture.data[i]; i++);
+  CHECK(i == capture.length - 1);
+
+  CHECK(decodeAll(decoder, capture.data, capture.length) == 1);
+  CHECK(decoder.type() == 7);
+  CHECK(decoder.length() == telemetry.length() - 1U);
+
+  CHECK(decoder.nextField(field) && field.type == TELEMETRY_BYTE && field.value.u == 200);
+  CHECK(decoder.nextField(field) && field.type == TELEMETRY_INT && field.value.i == -12345);
+  CHECK(decoder.nextField(field) && field.type == TELEMETRY_UNSIGNED_INT && field.value.u == 65535);
+  CHECK(decoder.nextField(field) && field.type == TELEMETRY_LONG && field.value.i == -2000000000L);
+  CHECK(decoder.nextField(field) && field.type == TELEMETRY_UNSIGNED_LONG && field.value.u == 4000000000UL);
+  CHECK(decoder.nextField(field) && field.type == TELEMETRY_FLOAT && field.value.f == -1.5e-3f);
+  CHECK(decoder.nextField(field) && field.type == TELEMETRY_STRING &&
+        field.length == 3 && memcmp(field.text, "abc", 3) == 0);
+  CHECK(decoder.nextField(field) && field.type == TELEMETRY_STRING && field.length == 0);
+  CHECK(!decoder.nextField(field));
+  CHECK(decoder.errors() == 0);
+
+  // sent once
+  CHECK(!telemetry.end());
+}
+
+
+// The top half of the 16 bit fields.  telemetryWord() is 16 bits wide
+// whatever the width of int, so 0xFFFF and 0x8000 never sign extend.
+void testWords()
+{
+  static const uint8_t top[] = { 0xFF, 0xFF };
+  static const uint8_t half[] = { 0x00, 0x80 };
+  TelemetryDecoder decoder(buffer, sizeof(buffer));
+  TelemetryField field;
+
+  CHECK(sizeof(telemetryWord(top)) == 2);
+  CHECK((uint32_t)telemetryWord(top) == 0xFFFFUL);
+  CHECK((uint32_t)telemetryWord(half) == 0x8000UL);
+  CHECK((int32_t)(int16_t)telemetryWord(half) == -32768L);
+
+  capture.clear();
+  CHECK(telemetry.begin(2)
+                 .addUnsignedInt(0xFFFF)
+                 .addUnsignedInt(0x8000)
+                 .addInt(-32768)
+                 .addInt(-1)
+                 .end());
+  CHECK(decodeAll(decoder, capture.data, capture.length) == 1);
+  CHECK(decoder.nextField(field) && field.value.u == 0xFFFFUL);
+  CHECK(decoder.nextField(field) && field.value.u == 0x8000UL);
+  CHECK(decoder.nextField(field) && field.value.i == -32768L);
+  CHECK(decoder.nextField(field) && field.value.i == -1L);
+}
+
+
+// Frames of zeros, of no zeros, and of the largest size.
+void testZeros()
+{
+  TelemetryDecoder decoder(buffer, sizeof(buffer));
+  TelemetryField field;
+  size_t at = 0;
+  uint8_t fields = 0;
+  uint8_t bytes;
+  uint8_t i;
+
+  capture.clear();
+  telemetry.begin(0);
+  while (telemetry.length() + 5 <= TELEMETRY_FRAME_SIZE)
+  {
+    telemetry.addUnsignedLong(0);
+    fields++;
+  }
+  CHECK(telemetry.end());
+
+  telemetry.begin(0xFF);
+  while (telemetry.length() + 2 <= TELEMETRY_FRAME_SIZE)
+    telemetry.addByte(0xFF);
+  bytes = telemetry.length();
+  CHECK(bytes >= TELEMETRY_FRAME_SIZE - 1);
+  CHECK(telemetry.end());
+
+  telemetry.begin(1).addInt(256).addInt(1);
+  CHECK(telemetry.end());
+
+  telemetry.begin(0);
+  CHECK(telemetry.end());
+
+  CHECK(decodeAll(decoder, capture.data, capture.length) == 4);
+  CHECK(decoder.type() == 0 && decoder.length() == 0);
+  CHECK(decoder.errors() == 0);
+
+  // again, one at a time
+  while (!decoder.decode(capture.data[at++]));
+  CHECK(decoder.type() == 0 && decoder.length() == fields * 5U);
+  for (i = 0; decoder.nextField(field) && field.value.u == 0; i++);
+  CHECK(i == fields);
+
+  while (!decoder.decode(capture.data[at++]));
+  CHECK(decoder.type() == 0xFF && decoder.length() == bytes - 1U);
+  for (i = 0; decoder.nextField(field) && field.value.u == 0xFF; i++);
+  CHECK(i == (bytes - 1) / 2);
+
+  while (!decoder.decode(capture.data[at++]));
+  CHECK(decoder.nextField(field) && field.value.i == 256);
+  CHECK(decoder.nextField(field) && field.value.i == 1);
+  CHECK(decoder.frames() == 7);
+}
+
+
+// Encodes as any COBS encoder would, in blocks of up to 254 bytes.
+size_t cobs(const uint8_t *data, size_t length, uint8_t *out)
+{
+  size_t code = 0;
+  size_t n = 1;
+  size_t i;
+
+  out[code] = 1;
+  for (i = 0; i < length; i++)
+  {
+    if (data[i])
+    {
+      out[n++] = data[i];
+      out[code]++;
+    }
+    if (data[i] == 0 || out[code] == 0xFF)
+    {
+      code = n++;
+      out[code] = 1;
+    }
+  }
+  out[n++] = 0;
+  return n;
+}
+
+
+// Longer frames than Telemetry sends, from another sender, in blocks
+// of 254 bytes and more.
+void testLongRuns()
+{
+  static const size_t lengths[] = { 253, 254, 255, 508, 509, 600 };
+  uint8_t big[700];
+  uint8_t frame[620];
+  uint8_t encoded[720];
+  TelemetryDecoder decoder(big, sizeof(big));
+  uint16_t crc;
+  size_t k;
+  size_t i;
+  size_t n;
+
+  for (k = 0; k < sizeof(lengths) / sizeof(lengths[0]); k++)
+  {
+    frame[0] = 9;
+    for (i = 1; i < lengths[k]; i++)
+      frame[i] = (k & 1) && i % 100 == 0 ? 0 : 1 + i % 250;
+    crc = 0xFFFF;
+    for (i = 0; i < lengths[k]; i++)
+      crc = telemetryCrc(crc, frame[i]);
+    frame[i++] = crc;
+    frame[i++] = crc >> 8;
+
+    n = cobs(frame, i, encoded);
+    CHECK(decodeAll(decoder, encoded, n) == 1);
+    CHECK(decoder.type() == 9 && decoder.length() == lengths[k] - 1);
+    CHECK(memcmp(decoder.data(), frame + 1, lengths[k] - 1) == 0);
+  }
+  CHECK(decoder.errors() == 0);
+
+  // and too long for the buffer given
+  decoder = TelemetryDecoder(buffer, sizeof(buffer));
+  CHECK(decodeAll(decoder, encoded, n) == 0);
+  CHECK(decoder.errors() == 1);
+}
+
+
+void testDamage()
+{
+  TelemetryDecoder decoder(buffer, sizeof(buffer));
+  size_t first;
+  size_t second;
+
+  capture.clear();
+  telemetry.begin(1).addUnsignedLong(1000).addInt(-1).end();
+  first = capture.length;
+  telemetry.begin(2).addUnsignedLong(2000).addInt(-2).end();
+  second = capture.length;
+  telemetry.begin(3).addUnsignedLong(3000).addInt(-3).end();
+
+  // starting in the middle of the first frame: it is dropped
+  CHECK(decodeAll(decoder, capture.data + 3, first - 3) == 0);
+  CHECK(decoder.errors() == 1);
+
+  // a bit flipped
+  capture.data[first + 4] ^= 0x10;
+  CHECK(decodeAll(decoder, capture.data + first, second - first) == 0);
+  CHECK(decoder.errors() == 2);
+
+  // bytes lost
+  CHECK(decodeAll(decoder, capture.data + second, 5) == 0);
+  CHECK(decodeAll(decoder, capture.data + second + 7, capture.length - second - 7) == 0);
+  CHECK(decoder.errors() == 3);
+
+  // and the next good one comes through
+  CHECK(decodeAll(decoder, capture.data + second, capture.length - second) == 1);
+  CHECK(decoder.type() == 3);
+  CHECK(decoder.errors() == 3 && decoder.frames() == 1);
+
+  // delimiters alone are not frames
+  CHECK(decoder.decode(0) == false && decoder.decode(0) == false);
+  CHECK(decoder.errors() == 3);
+}
+
+
+void testOverflow()
+{
+  uint8_t i;
+
+  capture.clear();
+  telemetry.begin(1);
+  for (i = 0; i < TELEMETRY_FRAME_SIZE / 5 + 1; i++)
+    telemetry.addLong(i);
+  CHECK(telemetry.overflowed());
+  CHECK(!telemetry.end());
+  CHECK(capture.length == 0);
+
+  // a string that doesn't fit, and the frame after is good again
+  telemetry.begin(1).addString("0123456789012345678901234567890123456789"
+                               "0123456789012345678901234567890123456789");
+  CHECK(!telemetry.end());
+  CHECK(telemetry.begin(1).addString("short").end());
+  CHECK(capture.length > 0);
+}
+
+
+void testSerial()
+{
+  TelemetryDecoder decoder(buffer, sizeof(buffer));
+  TelemetryField field;
+  uint8_t out[256];
+  size_t n;
+  uint8_t i;
+  unsigned long start;
+  Telemetry onSerial(Serial);
+
+  Serial.begin(115200);
+  for (i = 0; i < 5; i++)
+    onSerial.begin(i).addUnsignedInt(i * 1000U).addString("ok").end();
+  delay(20);
+  n = hostSerialTransmitted(0, out, sizeof(out));
+  CHECK(n == 5 * 12);
+
+  // back in as received characters, decoded from the Stream as they
+  // come (more than its receive buffer holds)
+  hostSerialReceive(0, out, n);
+  start = millis();
+  i = 0;
+  while (i < 5 && millis() - start < 20)
+    if (decoder.poll(Serial))
+    {
+      CHECK(decoder.type() == i);
+      CHECK(decoder.nextField(field) && field.value.u == i * 1000U);
+      i++;
+    }
+  CHECK(i == 5);
+  CHECK(!decoder.poll(Serial));
+  CHECK(decoder.errors() == 0);
+}
+
+
+void testNoHeap()
+{
+  uint8_t local[TELEMETRY_BUFFER_SIZE];
+  TelemetryDecoder decoder(local, sizeof(local));
+  unsigned long before = allocations;
+  uint8_t i;
+
+  capture.clear();
+  for (i = 0; i < 20; i++)
+    telemetry.begin(i).addUnsignedLong(millis()).addFloat(i * 0.5).addString("x").end();
+  CHECK(decodeAll(decoder, capture.data, capture.length) == 20);
+  CHECK(allocations == before);
+}
+
+
+int main(void)
+{
+  hostClockMode(HOST_CLOCK_STEPPED, 4);
+  boardInit();
+
+  testCrc();
+  testFields();
+  testWords();
+  testZeros();
+  testLongRuns();
+  testDamage();
+  testOverflow();
+  testSerial();
+  testNoHeap();
+
+  exit(hostTestResult());
+}
@@ -0,0 +1,143 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Tickless test: a scheduler driven loop sleeps in power save between
+|| | deadlines, wakes on time on Timer 2, and millis() keeps up with the
+|| | simulated clock across the sleeps; Timer 2 driving a PWM pin is
+|| | left alone.
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#include <Wiring.h>
+#include <Scheduler.h>
+#include <Tickless.h>
+#include "HostTest.h"
+
+Scheduler<4> scheduler;
+
+unsigned long ticks;
+unsigned long lateness;
+unsigned long lastTick;
+unsigned long onceAt;
+
+void tick()
+{
+  unsigned long now = millis();
+
+  if (ticks > 0 && now - lastTick > 100 + lateness)
+    lateness = now - lastTick - 100;
+  lastTick = now;
+  ticks++;
+}
+
+void once()
+{
+  onceAt = millis();
+}
+
+// millis() against the simulated clock
+long drift(void)
+{
+  return (long)millis() - (long)(hostClockCycles() / (F_CPU / 1000));
+}
+
+
+void testSleep()
+{
+  unsigned long start;
+  uint64_t cyclesStart, sleepStart;
+  long driftStart;
+
+  CHECK(Tickless.begin());
+  start = millis();
+  cyclesStart = hostClockCycles();
+  sleepStart = hostSleepCycles();
+  driftStart = drift();
+
+  scheduler.scheduleRepeating(tick, 100);
+  scheduler.schedule(once, 1234);
+
+  while (millis() - start < 3050)
+  {
+    scheduler.update();
+    Tickless.sleep(scheduler.idleTime());
+  }
+
+  CHECK(ticks == 30);
+  CHECK(lateness <= 2);
+  CHECK(onceAt - start >= 1234 && onceAt - start <= 1236);
+
+  // nearly all of it asleep, and millis() moved on for it
+  CHECK(hostSleepCycles() - sleepStart > (hostClockCycles() - cyclesStart) * 9 / 10);
+  CHECK(Tickless.sleepTime() > 2700);
+  CHECK(Tickless.activeTime() < 300);
+  CHECK(Tickless.sleeps() < 200);
+  CHECK(labs(drift() - driftStart) <= 2);
+}
+
+
+volatile unsigned long timer1Overflows;
+
+void countOverflow()
+{
+  timer1Overflows++;
+}
+
+
+void testIdleWhileTimerInUse()
+{
+  unsigned long start = millis();
+  long driftStart = drift();
+
+  // a timer interrupt in use keeps clkIO running: idle mode, which the
+  // Timer 0 interrupt ends every millisecond
+  Timer1.attachInterrupt(INTERRUPT_OVERFLOW, countOverflow);
+  Tickless.resetStatistics();
+  while (millis() - start < 50)
+    Tickless.sleep(50 - (millis() - start));
+  Timer1.detachInterrupt(INTERRUPT_OVERFLOW);
+
+  CHECK(timer1Overflows > 10);
+  CHECK(Tickless.sleeps() >= 40);
+  CHECK(Tickless.sleepTime() >= 45);
+  CHECK(labs(drift() - driftStart) <= 2);
+}
+
+
+// analogWrite() on a Timer 2 pin: begin() leaves the timer to it, and
+// the sleeps are idle ones.
+void testTimer2Pwm()
+{
+  Tickless.end();
+  analogWrite(34, 128);
+  CHECK(!Tickless.begin());
+  CHECK(ASSR == 0 && OCR2B == 128);
+
+  Tickless.resetStatistics();
+  Tickless.sleep(20);
+  CHECK(Tickless.sleeps() == 1 && Tickless.sleepTime() == 0);
+
+  analogWrite(34, 0);
+  CHECK(Tickless.begin());
+}
+
+
+int main(void)
+{
+  hostClockMode(HOST_CLOCK_STEPPED, 4);
+  boardInit();
+
+  testSleep();
+  testIdleWhileTimerInUse();
+  testTimer2Pwm();
+
+  exit(hostTestResult());
+}
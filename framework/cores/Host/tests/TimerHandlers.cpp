@@ -0,0 +1,102 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Timer handler test: Servo replaces the compare match A handlers of
+|| | its timers (TIMER_ISR()) and pulses from the vector, while the
+|| | attached functions keep working on the timers it leaves alone, and
+|| | on its own once the servos are detached.
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#include <Wiring.h>
+#include <Servo.h>
+#include "HostTest.h"
+
+#define SERVO_PIN 20
+
+volatile unsigned long timer1Matches;
+volatile unsigned long timer5Matches;
+
+void countTimer1()
+{
+  timer1Matches++;
+}
+
+void countTimer5()
+{
+  timer5Matches++;
+}
+
+
+// Width of the next pulse on the pin, in microseconds
+unsigned long pulseWidth(void)
+{
+  unsigned long start;
+
+  while (pinRead(SERVO_PIN) == HIGH);
+  while (pinRead(SERVO_PIN) == LOW);
+  start = micros();
+  while (pinRead(SERVO_PIN) == HIGH);
+
+  return micros() - start;
+}
+
+
+void testServo()
+{
+  Servo servo;
+  unsigned long width;
+  unsigned long start;
+
+  // Timer 1 is free while the first servos run on Timer 5
+  Timer1.setMode(0b0100);                 // CTC
+  Timer1.setOCR(CHANNEL_A, 1999);         // every 1 ms at ck/8
+  Timer1.attachInterrupt(INTERRUPT_COMPARE_MATCH_A, countTimer1);
+  Timer1.setClockSource(CLOCK_PRESCALE_8);
+
+  servo.attach(SERVO_PIN);
+  servo.writeMicroseconds(1500);
+  Timer5.attachInterrupt(INTERRUPT_COMPARE_MATCH_A, countTimer5);
+
+  width = pulseWidth();
+  CHECK(width >= 1490 && width <= 1510);
+  servo.writeMicroseconds(1000);
+  pulseWidth();
+  width = pulseWidth();
+  CHECK(width >= 990 && width <= 1010);
+
+  start = millis();
+  while (millis() - start < 100);
+
+  CHECK(timer1Matches >= 140 && timer1Matches <= 160);
+  CHECK(timer5Matches == 0);
+
+  // back to the attached function once the timer is given up
+  servo.detach();
+  Timer5.attachInterrupt(INTERRUPT_COMPARE_MATCH_A, countTimer5);
+  start = millis();
+  while (millis() - start < 100);
+  CHECK(timer5Matches >= 2);
+
+  Timer1.detachInterrupt(INTERRUPT_COMPARE_MATCH_A);
+  Timer5.detachInterrupt(INTERRUPT_COMPARE_MATCH_A);
+}
+
+
+int main(void)
+{
+  hostClockMode(HOST_CLOCK_STEPPED, 4);
+  boardInit();
+
+  testServo();
+
+  exit(hostTestResult());
+}
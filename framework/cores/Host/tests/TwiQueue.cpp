@@ -0,0 +1,274 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | TWI test: the blocking Wire calls on top of the transaction queue
+|| | (writes, combined register reads, NACKs, with interrupts disabled),
+|| | the bit rate settings, transfers straight from and into the
+|| | caller's buffers beyond the 32 bytes of the Wire buffers, and
+|| | queued transactions run from the interrupt: their callbacks, order,
+|| | repeated starts, and twenty sensors polled round-robin from the
+|| | callbacks.
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#include <Wiring.h>
+#include <Wire.h>
+#include <compat/twi.h>
+#include "HostTest.h"
+
+#define SENSORS 20
+#define FIRST_SENSOR 0x40
+#define MEMORY 0x58
+#define MISSING 0x70
+
+uint8_t sensors[SENSORS][4];
+uint8_t small[2];                // a device at 0x60 with two registers
+uint8_t memory[256];             // and one at 0x58 with 256
+
+const uint8_t reg = 0;
+uint8_t data[2];
+WireTransaction poll;
+uint8_t current;
+volatile unsigned long rounds;
+volatile unsigned long polled;
+volatile uint8_t readingsOK;
+
+uint8_t order[4];
+uint8_t orderCount;
+
+
+void polledSensor(WireTransaction *t)
+{
+  uint8_t *expected = sensors[current];
+
+  polled++;
+  if (t->status != 0 || data[0] != expected[0] || data[1] != expected[1])
+    readingsOK = 0;
+
+  if (++current == SENSORS)
+  {
+    current = 0;
+    rounds++;
+  }
+
+  Wire.transfer(&poll, FIRST_SENSOR + current, &reg, 1, data, 2, polledSensor);
+}
+
+
+void recordOrder(WireTransaction *t)
+{
+  order[orderCount++] = t->address;
+}
+
+
+void testBlocking()
+{
+  uint8_t oldSREG;
+
+  Wire.begin();
+  CHECK(TWBR == 72 && (TWSR & 0x03) == 0);
+
+  // register 2 and 3 of the first sensor
+  Wire.beginTransmission(FIRST_SENSOR);
+  Wire.write(2);
+  Wire.write(0xAA);
+  Wire.write(0xBB);
+  CHECK(Wire.endTransmission() == 0);
+  CHECK(sensors[0][2] == 0xAA && sensors[0][3] == 0xBB);
+
+  // read back from register 2, after a repeated start
+  Wire.beginTransmission(FIRST_SENSOR);
+  Wire.write(2);
+  CHECK(Wire.endTransmission(false) == 0);
+  CHECK(Wire.requestFrom(FIRST_SENSOR, 2) == 2);
+  CHECK(Wire.read() == 0xAA && Wire.read() == 0xBB);
+  CHECK(Wire.read() == -1);
+
+  // nobody there, and a full device
+  Wire.beginTransmission(MISSING);
+  CHECK(Wire.endTransmission() == 2);
+  CHECK(Wire.requestFrom(MISSING, 2) == 0);
+  Wire.beginTransmission(0x60);
+  Wire.write(0);
+  Wire.write(1);
+  Wire.write(2);
+  Wire.write(3);
+  CHECK(Wire.endTransmission() == 3);
+  CHECK(small[0] == 1 && small[1] == 2);
+
+  // with interrupts disabled, served without the interrupt
+  oldSREG = SREG;
+  cli();
+  Wire.beginTransmission(0x60);
+  Wire.write(0);
+  CHECK(Wire.endTransmission(false) == 0);
+  CHECK(Wire.requestFrom(0x60, 2) == 2);
+  CHECK(Wire.read() == 1 && Wire.read() == 2);
+  SREG = oldSREG;
+
+  CHECK(!Wire.busy());
+}
+
+
+void testFrequency()
+{
+  CHECK(Wire.setClock(400000) == 400000);
+  CHECK(TWBR == 12 && (TWSR & 0x03) == 0);
+  CHECK(Wire.setClock(1000000) == 1000000);
+  CHECK(TWBR == 0);
+  CHECK(Wire.setClock(10000) == 10000);
+  CHECK(TWBR == 198 && (TWSR & 0x03) == 1);
+  CHECK(Wire.setClock(100000) == 100000);
+  CHECK(TWBR == 72 && (TWSR & 0x03) == 0);
+}
+
+
+void testZeroCopy()
+{
+  uint8_t page[1 + 200];
+  uint8_t back[200];
+  const uint8_t at = 40;
+  uint16_t i;
+
+  // one write of 200 bytes, the address in front
+  page[0] = at;
+  for (i = 0; i < 200; i++)
+    page[1 + i] = i ^ 0x5A;
+  CHECK(Wire.writeTo(MEMORY, page, sizeof(page)) == 0);
+  for (i = 0; i < 200 && memory[at + i] == (i ^ 0x5A); i++);
+  CHECK(i == 200);
+  CHECK(memory[at - 1] == 0 && memory[at + 200] == 0);
+
+  // and read back in one go, as a register read
+  memset(back, 0, sizeof(back));
+  CHECK(Wire.transfer(MEMORY, &at, 1, back, sizeof(back)) == 0);
+  CHECK(memcmp(back, page + 1, sizeof(back)) == 0);
+
+  // or in two
+  memset(back, 0, sizeof(back));
+  CHECK(Wire.writeTo(MEMORY, &at, 1, false) == 0);
+  CHECK(Wire.readFrom(MEMORY, back, sizeof(back)) == sizeof(back));
+  CHECK(memcmp(back, page + 1, sizeof(back)) == 0);
+
+  CHECK(Wire.writeTo(MISSING, page, sizeof(page)) == 2);
+  CHECK(Wire.readFrom(MISSING, back, sizeof(back)) == 0);
+  CHECK(Wire.transfer(MISSING, &at, 1, back, sizeof(back)) == 2);
+}
+
+
+void testQueue()
+{
+  WireTransaction a, b, c, d;
+  uint8_t aData[2];
+  unsigned long start;
+  unsigned long took;
+
+  // register 1 of the second sensor: 1 + 9 + 9 + 1 + 9 + 18 + 1 bits,
+  // 480 us at 100kHz, and none of it waited for
+  sensors[1][1] = 0x12;
+  sensors[1][2] = 0x34;
+  const uint8_t one = 1;
+  start = micros();
+  CHECK(Wire.transfer(&a, FIRST_SENSOR + 1, &one, 1, aData, 2) == 0);
+  took = micros() - start;
+  CHECK(took < 40);
+  CHECK(Wire.busy() && a.status == TWI_PENDING);
+  CHECK(Wire.queue(&a) == 1);        // already queued
+  Wire.wait(&a);
+  took = micros() - start;
+  CHECK(took >= 470 && took <= 520);
+  CHECK(a.status == 0 && aData[0] == 0x12 && aData[1] == 0x34);
+  CHECK(!Wire.busy());
+
+  // in order, the missing one NACKed
+  orderCount = 0;
+  Wire.transfer(&a, FIRST_SENSOR + 2, &reg, 1, NULL, 0, recordOrder);
+  Wire.transfer(&b, MISSING, &reg, 1, NULL, 0, recordOrder);
+  Wire.transfer(&c, FIRST_SENSOR + 3, NULL, 0, aData, 1, recordOrder);
+  Wire.transfer(&d, FIRST_SENSOR + 4, &reg, 1, NULL, 0, recordOrder);
+  while (Wire.busy())
+    delayMicroseconds(10);
+  CHECK(orderCount == 4);
+  CHECK(order[0] == FIRST_SENSOR + 2 && order[1] == MISSING);
+  CHECK(order[2] == FIRST_SENSOR + 3 && order[3] == FIRST_SENSOR + 4);
+  CHECK(a.status == 0 && b.status == 2 && c.status == 0 && d.status == 0);
+
+  // keeping the bus: the next one starts with a repeated start
+  Wire.transfer(&a, FIRST_SENSOR, &reg, 1, NULL, 0, NULL, TWI_REPEATED_START);
+  while (a.status == TWI_PENDING)
+    delayMicroseconds(10);
+  while (!(TWCR & _BV(TWINT)));
+  CHECK(TW_STATUS == TW_REP_START);
+  Wire.transfer(&b, FIRST_SENSOR, &one, 1, aData, 2);   // register 1
+  while (b.status == TWI_PENDING)
+    delayMicroseconds(10);
+  CHECK(b.status == 0 && aData[0] == 0x20);
+  CHECK(TW_STATUS == TW_NO_INFO);    // stopped
+}
+
+
+void testRoundRobin()
+{
+  unsigned long start;
+  unsigned long spins = 0;
+  unsigned long idleSpins = 0;
+  unsigned long interrupts;
+
+  // how far the loop gets in 100 ms with the bus idle
+  start = millis();
+  while (millis() - start < 100)
+    idleSpins++;
+
+  Wire.setClock(400000);
+  rounds = polled = 0;
+  readingsOK = 1;
+  current = 0;
+  interrupts = hostInterruptCount(TWI_vect_num);
+  Wire.transfer(&poll, FIRST_SENSOR, &reg, 1, data, 2, polledSensor);
+
+  start = millis();
+  while (millis() - start < 100)
+    spins++;
+
+  // 48 bits per sensor, 120 us at 400kHz (and the interrupts between
+  // the bytes): near 40 rounds of 20 in 100 ms, at 7 interrupts per
+  // sensor, leaving the loop most of its time
+  CHECK(readingsOK);
+  CHECK(rounds >= 35 && rounds <= 42);
+  CHECK(hostInterruptCount(TWI_vect_num) - interrupts <= 7 * polled + 7);
+  CHECK(spins > idleSpins * 3 / 4);
+}
+
+
+int main(void)
+{
+  uint8_t i;
+
+  hostClockMode(HOST_CLOCK_STEPPED, 4);
+  boardInit();
+
+  for (i = 0; i < SENSORS; i++)
+  {
+    sensors[i][0] = 0x10 + i;
+    sensors[i][1] = 0x20 + i;
+    hostTwiDevice(FIRST_SENSOR + i, sensors[i], sizeof(sensors[i]));
+  }
+  hostTwiDevice(0x60, small, sizeof(small));
+  hostTwiDevice(MEMORY, memory, sizeof(memory));
+
+  testBlocking();
+  testFrequency();
+  testZeroCopy();
+  testQueue();
+  testRoundRobin();
+
+  exit(hostTestResult());
+}
@@ -0,0 +1,170 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Prints a profile dumped by profileDump() (see WProfile.h), sorted by
+|| | the total time spent in each entry.
+|| |
+|| |   ProfileReport [file]
+|| |
+|| | The dump is read from the file (e.g. a capture of the serial port)
+|| | or from standard input.  Anything around the dump is skipped; with
+|| | several dumps in the capture, the last good one is printed.
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+#include <WProfile.h>
+
+#define PROFILE_NAME(name) #name,
+static const char *coreNames[] = { PROFILE_CORE_ENTRIES(PROFILE_NAME) };
+#undef PROFILE_NAME
+
+struct Entry
+{
+  unsigned id;
+  unsigned long calls;
+  unsigned long total;
+  unsigned max;
+};
+
+struct Profile
+{
+  unsigned long cpu;
+  unsigned long elapsed;
+  std::vector<Entry> entries;
+};
+
+
+static unsigned long value(const unsigned char *p, int size)
+{
+  unsigned long v = 0;
+
+  while (size--)
+    v = (v << 8) | p[size];
+
+  return v;
+}
+
+
+// Decode the dump starting at p, returns its length, 0 if it is not one.
+static size_t decode(const unsigned char *p, size_t length, Profile &profile)
+{
+  unsigned char sum = 0;
+  size_t i = 12;
+  size_t k;
+  Entry e;
+
+  if (length < 14 || p[0] != 'W' || p[1] != 'P' || p[2] != PROFILE_VERSION)
+    return 0;
+
+  profile.cpu = value(p + 4, 4);
+  profile.elapsed = value(p + 8, 4);
+  profile.entries.clear();
+
+  while (i < length && p[i] != PROFILE_END)
+  {
+    if (i + 11 > length || p[i] >= p[3])
+      return 0;
+    e.id = p[i];
+    e.calls = value(p + i + 1, 4);
+    e.total = value(p + i + 5, 4);
+    e.max = value(p + i + 9, 2);
+    profile.entries.push_back(e);
+    i += 11;
+  }
+  if (i + 2 > length)
+    return 0;
+
+  for (k = 0; k < i + 2; k++)
+    sum += p[k];
+
+  return sum == 0 ? i + 2 : 0;
+}
+
+
+static bool byTotal(const Entry &a, const Entry &b)
+{
+  return a.total > b.total;
+}
+
+
+static void print(Profile &profile)
+{
+  double cyclesPerMicrosecond = profile.cpu / 1e6;
+  double elapsed = profile.elapsed * (profile.cpu / 1e3);
+  char name[24];
+  size_t i;
+
+  std::sort(profile.entries.begin(), profile.entries.end(), byTotal);
+
+  printf("F_CPU %lu Hz, %lu ms\n\n", profile.cpu, profile.elapsed);
+  printf("%-14s %10s %12s %8s %8s %10s %6s\n",
+         "entry", "calls", "cycles", "average", "max", "us", "cpu %");
+
+  for (i = 0; i < profile.entries.size(); i++)
+  {
+    Entry &e = profile.entries[i];
+
+    if (e.id < PROFILE_USER_FIRST)
+      snprintf(name, sizeof(name), "%s", coreNames[e.id]);
+    else
+      snprintf(name, sizeof(name), "USER%u", e.id - PROFILE_USER_FIRST);
+
+    printf("%-14s %10lu %12lu %8lu %8u %10.0f %6.2f\n",
+           name, e.calls, e.total, e.total / e.calls, e.max,
+           e.total / cyclesPerMicrosecond,
+           elapsed > 0 ? 100.0 * e.total / elapsed : 0.0);
+  }
+}
+
+
+int main(int argc, char **argv)
+{
+  std::vector<unsigned char> data;
+  unsigned char buffer[4096];
+  Profile profile;
+  Profile found;
+  bool good = false;
+  FILE *in = stdin;
+  size_t n;
+  size_t i;
+
+  if (argc > 1 && (in = fopen(argv[1], "rb")) == NULL)
+  {
+    perror(argv[1]);
+    return 2;
+  }
+
+  while ((n = fread(buffer, 1, sizeof(buffer), in)) > 0)
+    data.insert(data.end(), buffer, buffer + n);
+
+  for (i = 0; i < data.size(); i++)
+    if ((n = decode(&data[i], data.size() - i, profile)) != 0)
+    {
+      found = profile;
+      good = true;
+      i += n - 1;
+    }
+
+  if (!good)
+  {
+    fprintf(stderr, "no profile found\n");
+    return 1;
+  }
+
+  print(found);
+
+  return 0;
+}
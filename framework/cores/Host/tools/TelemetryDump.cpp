@@ -0,0 +1,81 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Prints the frames sent by the Telemetry library, one line each:
+|| | the frame type, then the fields, separated by commas.
+|| |
+|| |   TelemetryDump [file]
+|| |
+|| | The frames are read from the file (e.g. a capture of the serial
+|| | port) or from standard input, as they come, so it can follow a live
+|| | port.  Frames that fail their CRC are dropped; the counts go to
+|| | standard error at the end.
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#include <stdio.h>
+#include <TelemetryDecoder.h>
+
+
+static void print(TelemetryDecoder &decoder)
+{
+  TelemetryField field;
+
+  printf("%u", decoder.type());
+
+  while (decoder.nextField(field))
+  {
+    switch (field.type)
+    {
+      case TELEMETRY_INT:
+      case TELEMETRY_LONG:
+        printf(",%ld", (long)field.value.i);
+        break;
+      case TELEMETRY_FLOAT:
+        printf(",%g", field.value.f);
+        break;
+      case TELEMETRY_STRING:
+        printf(",\"%.*s\"", field.length, field.text);
+        break;
+      default:
+        printf(",%lu", (unsigned long)field.value.u);
+        break;
+    }
+  }
+
+  printf("\n");
+}
+
+
+int main(int argc, char **argv)
+{
+  uint8_t buffer[TELEMETRY_BUFFER_SIZE];
+  TelemetryDecoder decoder(buffer, sizeof(buffer));
+  FILE *in = stdin;
+  int c;
+
+  if (argc > 1 && (in = fopen(argv[1], "rb")) == NULL)
+  {
+    perror(argv[1]);
+    return 2;
+  }
+
+  while ((c = getc(in)) != EOF)
+    if (decoder.decode(c))
+    {
+      print(decoder);
+      fflush(stdout);
+    }
+
+  fprintf(stderr, "%lu frames, %lu errors\n", decoder.frames(), decoder.errors());
+
+  return decoder.frames() ? 0 : 1;
+}
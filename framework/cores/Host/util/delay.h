@@ -0,0 +1,30 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Simulated <util/delay.h> and <util/delay_basic.h> for the Host core.
+|| |
+|| | Delays are counted in simulated CPU cycles (see _hostDelayCycles()).
+|| |
+|| | Wiring Core API
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#ifndef _UTIL_DELAY_H_
+#define _UTIL_DELAY_H_
+
+#include <avr/io.h>
+
+#define _delay_loop_1(count) _hostDelayCycles(3UL * ((count) ? (count) : 256))
+#define _delay_loop_2(count) _hostDelayCycles(4UL * ((count) ? (count) : 65536))
+
+#define _delay_us(us) _hostDelayCycles((uint32_t)((double)(F_CPU) * (us) / 1e6))
+#define _delay_ms(ms) _hostDelayCycles((uint32_t)((double)(F_CPU) * (ms) / 1e3))
+
+#endif
+// _UTIL_DELAY_H_
@@ -2,6 +2,7 @@
 ||
 || @author         Brett Hagman <bhagman@wiring.org.co>
 || @url            http://wiring.org.co/
+|| @contribution   Camilo Reyes <creyes@wiring.org.co>
 ||
 || @description
 || | Board Specific Definitions for:
@@ -63,10 +64,10 @@ const static uint8_t A6 = 6;
 const static uint8_t A7 = 7;
 
 // External Interrupts
-const static uint8_t EI0 = 2;
-const static uint8_t EI1 = 3;
-const static uint8_t EI2 = 4;
-const static uint8_t EI3 = 5;
+const static uint8_t EI0 = 0;
+const static uint8_t EI1 = 1;
+const static uint8_t EI2 = 2;
+const static uint8_t EI3 = 3;
 const static uint8_t EI4 = 36;
 const static uint8_t EI5 = 37;
 const static uint8_t EI6 = 38;
@@ -225,10 +226,10 @@ const static uint8_t TX1 = 3;
 #endif
 
 #define pinToInterrupt(PIN) \
-        ( ((PIN) == 2) ? EXTERNAL_INTERRUPT_0 : \
-        ( ((PIN) == 3) ? EXTERNAL_INTERRUPT_1 : \
-        ( ((PIN) == 4) ? EXTERNAL_INTERRUPT_2 : \
-        ( ((PIN) == 5) ? EXTERNAL_INTERRUPT_3 : \
+        ( ((PIN) == 0) ? EXTERNAL_INTERRUPT_0 : \
+        ( ((PIN) == 1) ? EXTERNAL_INTERRUPT_1 : \
+        ( ((PIN) == 2) ? EXTERNAL_INTERRUPT_2 : \
+        ( ((PIN) == 3) ? EXTERNAL_INTERRUPT_3 : \
         ( ((PIN) == 36) ? EXTERNAL_INTERRUPT_4 : \
         ( ((PIN) == 37) ? EXTERNAL_INTERRUPT_5 : \
         ( ((PIN) == 38) ? EXTERNAL_INTERRUPT_6 : \
@@ -4,6 +4,7 @@
 || @url            http://wiring.org.co/
 || @url            http://alexanderbrevig.com/
 || @contribution   Brett Hagman <bhagman@wiring.org.co>
+|| @contribution   Camilo Reyes <creyes@wiring.org.co>
 ||
 || @description
 || | Hardware Abstraction Library for Potentiometers.
@@ -31,6 +32,7 @@
 Potentiometer::Potentiometer(byte potPin)
 {
   pin = potPin;
+  profile = ADC_STANDARD;
   setSectors(6);
 }
 
@@ -45,6 +47,7 @@ Potentiometer::Potentiometer(byte potPin)
 Potentiometer::Potentiometer(byte potPin, uint16_t sectors)
 {
   pin = potPin;
+  profile = ADC_STANDARD;
   setSectors(sectors);
 }
 
@@ -53,25 +56,28 @@ Potentiometer::Potentiometer(byte potPin, uint16_t sectors)
 || | Get the current value of the Potentiometer
 || | This is a wrapper around the analogRead core call
 || | Why? To make the code that handles Potentiometers easier to read
+|| | The conversion uses the ADC profile of this Potentiometer
 || #
 ||
 || @return The value of the Potentiometer [0,1023]
 */
 uint16_t Potentiometer::getValue()
 {
-  return analogRead(pin);
+  return _analogReadProfile(pin, profile);
 }
 
 /*
 || @description
 || | Get the current sector of the Potentiometer
+|| | Up to 256 sectors, 8 bits are enough: setProfile(ADC_FAST) makes
+|| | this 13 us instead of 104 us at 16 MHz
 || #
 ||
 || @return The current sector of this Potentiometer [0,sectors]
 */
 uint16_t Potentiometer::getSector()
 {
-  return analogRead(pin) / (POTENTIOMETER_ADC_RESOLUTION / sectors);
+  return _analogReadProfile(pin, profile) / (POTENTIOMETER_ADC_RESOLUTION / sectors);
 }
 
 /*
@@ -93,4 +99,3 @@ void Potentiometer::setSectors(uint16_t newSectors)
     sectors = POTENTIOMETER_ADC_RESOLUTION - 1;
   }
 }
-
@@ -4,6 +4,7 @@
 || @url            http://wiring.org.co/
 || @url            http://alexanderbrevig.com/
 || @contribution   Brett Hagman <bhagman@wiring.org.co>
+|| @contribution   Camilo Reyes <creyes@wiring.org.co>
 ||
 || @description
 || | Hardware Abstraction Library for Potentiometers.
@@ -31,11 +32,30 @@ class Potentiometer
     uint16_t getSector();
 
     void setSectors(uint16_t sectors);
+    void setProfile(uint8_t adcProfile);
 
   private:
     byte pin;
+    uint8_t profile;
     uint16_t sectors;
 };
 
+/*
+|| @description
+|| | Set the ADC profile of the conversions of this Potentiometer
+|| | ADC_STANDARD (the default), ADC_FAST (8 bits) or ADC_QUIET
+|| | Inline, so that only a Potentiometer set to ADC_QUIET links the
+|| | ADC vector
+|| #
+||
+|| @parameter adcProfile the ADC profile
+*/
+inline void Potentiometer::setProfile(uint8_t adcProfile)
+{
+  if (adcProfile == ADC_QUIET)
+    adcQuietInit();
+  profile = adcProfile;
+}
+
 #endif
 // POTENTIOMETER_H
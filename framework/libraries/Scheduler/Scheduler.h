@@ -4,10 +4,21 @@
 || @url            http://wiring.org.co/
 || @url            http://alexanderbrevig.com/
 || @contribution   Brett Hagman <bhagman@wiring.org.co>
+|| @contribution   Camilo Reyes <creyes@wiring.org.co>
 ||
 || @description
 || | Provides an easy way of scheduling function calls somewhere in the future.
 || |
+|| | The scheduled calls are kept in a hierarchical timing wheel: three
+|| | levels of 16 slots, of 1 ms, 16 ms and 256 ms.  A call is put in the
+|| | slot its time falls in, and moves down a level each time the level
+|| | below wraps around, so scheduling and cancelling are O(1), and
+|| | update() only ever looks at the calls that are due (or moving down).
+|| | Calls further than 4096 ms away wait in the top level, and are put
+|| | back in it every 4096 ms until they are close enough.
+|| |
+|| | update() reads millis() once, and runs the ticks up to it in order.
+|| |
 || | Wiring Cross-platform Library
 || #
 ||
@@ -23,30 +34,33 @@
 //provide a typedef for a void function pointer
 typedef void (*function)();
 
+//identifies a scheduled call, 0 if it could not be scheduled
+typedef uint16_t schedule_handle;
+
+#define SCHEDULER_SLOT_BITS 4
+#define SCHEDULER_SLOTS (1 << SCHEDULER_SLOT_BITS)
+#define SCHEDULER_LEVELS 3
+#define SCHEDULER_NONE 0xFF
+
 ///internal datatype
 typedef struct schedule_action_s
 {
   function action;
-  unsigned long time;
-  unsigned long delay;
-  //assignment operator
-  schedule_action_s& operator=(const schedule_action_s& rhs)
-  {
-    action = rhs.action;
-    time = rhs.time;
-    delay = rhs.delay;
-    return *this;
-  }
-  //boolean equality
-  bool operator==(const schedule_action_s& rhs) const
-  {
-    return (action == rhs.action && time == rhs.time && delay == rhs.delay);
-  }
+  unsigned long time;      //when it is due
+  unsigned long interval;  //0 for a single call
+  uint8_t next;            //the other calls in the same slot, or the
+                           //next free entry
+  uint8_t prev;
+  uint8_t slot;            //SCHEDULER_NONE when free
+  uint8_t sequence;        //tells the handles of reused entries apart
 } schedule_action;
 
 template<int maxFunctionsToCall>
 class Scheduler
 {
+  private:
+    typedef char sizeCheck[(maxFunctionsToCall > 0 && maxFunctionsToCall < SCHEDULER_NONE) ? 1 : -1];
+
   public:
     /*
     || @constructor
@@ -55,50 +69,55 @@ class Scheduler
     */
     Scheduler()
     {
-      action[0].action = NULL;
-      action[0].delay = 65535;
-      action[0].time = 0;
+      byte i;
+
+      for (i = 0; i < SCHEDULER_LEVELS * SCHEDULER_SLOTS; i++)
+        wheel[i] = SCHEDULER_NONE;
+      for (i = 0; i < maxFunctionsToCall; i++)
+      {
+        action[i].slot = SCHEDULER_NONE;
+        action[i].sequence = 0;
+        action[i].next = i + 1;
+      }
+      action[maxFunctionsToCall - 1].next = SCHEDULER_NONE;
+      freeList = 0;
       currentSize = 0;
+      current = millis();
     }
 
     /*
     || @description
-    || | Check to see if it's time to call any of the functions
+    || | Call the functions that are due
     || #
     */
     void update()
     {
-      //flush/update all
-      for (byte i = 0; i < currentSize; i++)
+      unsigned long now = millis();
+
+      //nothing scheduled, nothing to catch up with
+      if (currentSize == 0)
       {
-        //it is time to call the function associated with action[i]
-        if ((millis() - action[i].time) > action[i].delay)
+        current = now;
+        return;
+      }
+
+      while (current != now)
+      {
+        current++;
+
+        //move the calls of the next slot of a level down when the level
+        //below wraps around
+        if ((current & (SCHEDULER_SLOTS - 1)) == 0)
         {
-          action[i].action(); //call function
-          //this was the last action in queue
-          if (i == 0 && currentSize == 1)
-          {
-            currentSize = 0;
-          }
-          //this is the second action of two possible, only one left
-          else if (i == 1 && currentSize == 2)
-          {
-            currentSize = 1;
-          }
-          //the last action has executed, cut it off
-          else if (i + 1 == currentSize)
-          {
-            currentSize--;
-          }
-          //all other elements
-          else if (i + 1 < currentSize)
-          {
-            action[i] = action[i + 1];
-            defragment(); //get rid of the two copies in memory
-          }
+          if (((current >> SCHEDULER_SLOT_BITS) & (SCHEDULER_SLOTS - 1)) == 0)
+            cascade(2 * SCHEDULER_SLOTS + ((current >> (2 * SCHEDULER_SLOT_BITS)) & (SCHEDULER_SLOTS - 1)));
+          cascade(SCHEDULER_SLOTS + ((current >> SCHEDULER_SLOT_BITS) & (SCHEDULER_SLOTS - 1)));
         }
+
+        expire(current & (SCHEDULER_SLOTS - 1), now);
       }
     }
+
     /*
     || @description
     || | Schedule a functioncall in 'time' milliseconds.
@@ -106,40 +125,249 @@ class Scheduler
     ||
     || @parameter userAction  a function that should be called in time ms
     || @parameter time        the time to wait before calling the userAction
+    ||
+    || @return a handle to cancel the call with, 0 if the scheduler is full
     */
-    void schedule(function userAction, unsigned long time)
+    schedule_handle schedule(function userAction, unsigned long time)
     {
-      if (currentSize < maxFunctionsToCall)
+      return add(userAction, time, 0);
+    }
+
+    /*
+    || @description
+    || | Schedule a functioncall every 'interval' milliseconds, until it
+    || | is cancelled.  Calls that could not be made on time (update()
+    || | was not called for longer than interval) are skipped, not made
+    || | in a burst.
+    || #
+    ||
+    || @parameter userAction  a function that should be called every interval ms
+    || @parameter interval    the time between the calls
+    ||
+    || @return a handle to cancel the calls with, 0 if the scheduler is full
+    */
+    schedule_handle scheduleRepeating(function userAction, unsigned long interval)
+    {
+      return add(userAction, interval, interval ? interval : 1);
+    }
+
+    /*
+    || @description
+    || | Cancel a scheduled call.  A function may cancel its own call.
+    || #
+    ||
+    || @parameter handle  the handle schedule() returned
+    ||
+    || @return true if the call was still scheduled
+    */
+    bool cancel(schedule_handle handle)
+    {
+      byte i = lookup(handle);
+
+      if (i == SCHEDULER_NONE)
+        return false;
+
+      unlink(i);
+      release(i);
+      return true;
+    }
+
+    /*
+    || @description
+    || | Check whether a call is still scheduled
+    || #
+    */
+    bool scheduled(schedule_handle handle)
+    {
+      return lookup(handle) != SCHEDULER_NONE;
+    }
+
+    /*
+    || @description
+    || | The time until update() has something to do: a call is due, or
+    || | calls move down a level of the wheel.  A sketch can sleep that
+    || | long (see the Tickless library) instead of calling update() in a
+    || | busy loop.
+    || #
+    ||
+    || @return milliseconds, 0 if update() is due now, 0xFFFFFFFF if
+    ||         nothing is scheduled
+    */
+    unsigned long idleTime()
+    {
+      unsigned long now = millis();
+      unsigned long next = current + (1UL << (3 * SCHEDULER_SLOT_BITS));
+      unsigned long block;
+      byte level, k;
+
+      if (currentSize == 0)
+        return 0xFFFFFFFF;
+
+      //the first call due in the first level, or the first slot of a
+      //higher level to move down, whichever comes first
+      for (k = 1; k < SCHEDULER_SLOTS; k++)
+        if (wheel[(current + k) & (SCHEDULER_SLOTS - 1)] != SCHEDULER_NONE)
+        {
+          next = current + k;
+          break;
+        }
+      for (level = 1; level < SCHEDULER_LEVELS; level++)
+        for (k = 1; k <= SCHEDULER_SLOTS; k++)
+        {
+          block = (current >> (level * SCHEDULER_SLOT_BITS)) + k;
+          if (wheel[level * SCHEDULER_SLOTS + (block & (SCHEDULER_SLOTS - 1))] != SCHEDULER_NONE)
+          {
+            block <<= level * SCHEDULER_SLOT_BITS;
+            if ((long)(block - next) < 0)
+              next = block;
+            break;
+          }
+        }
+
+      return ((long)(next - now) > 0) ? next - now : 0;
+    }
+
+    /*
+    || @description
+    || | The number of calls scheduled
+    || #
+    */
+    byte size()
+    {
+      return currentSize;
+    }
+
+  private:
+    schedule_handle add(function userAction, unsigned long time, unsigned long interval)
+    {
+      byte i;
+
+      if (currentSize >= maxFunctionsToCall || userAction == NULL)
+        return 0;
+
+      i = freeList;
+      freeList = action[i].next;
+
+      //the wheel may not have been turned since it went empty
+      if (currentSize == 0)
+        current = millis();
+
+      action[i].action = userAction;
+      action[i].interval = interval;
+      //counted from now, even if update() has some catching up to do
+      action[i].time = millis() + time;
+      if ((long)(action[i].time - current) <= 0)
+        action[i].time = current + 1;
+      insert(i);
+      currentSize++;
+
+      return ((schedule_handle)action[i].sequence << 8) | (i + 1);
+    }
+
+    byte lookup(schedule_handle handle)
+    {
+      byte i = (handle & 0xFF) - 1;
+
+      if (i >= maxFunctionsToCall || action[i].slot == SCHEDULER_NONE || action[i].sequence != (handle >> 8))
+        return SCHEDULER_NONE;
+
+      return i;
+    }
+
+    void release(byte i)
+    {
+      action[i].slot = SCHEDULER_NONE;
+      action[i].sequence++;
+      action[i].next = freeList;
+      freeList = i;
+      currentSize--;
+    }
+
+    //Put a call in the slot of the lowest level its time falls in
+    void insert(byte i)
+    {
+      unsigned long time = action[i].time;
+      unsigned long ahead = time - current;
+      byte slot;
+
+      if (ahead < SCHEDULER_SLOTS)
+        slot = time & (SCHEDULER_SLOTS - 1);
+      else if (ahead < (1UL << (2 * SCHEDULER_SLOT_BITS)))
+        slot = SCHEDULER_SLOTS + ((time >> SCHEDULER_SLOT_BITS) & (SCHEDULER_SLOTS - 1));
+      else
       {
-        action[currentSize].action = userAction;
-        action[currentSize].delay = time;
-        action[currentSize].time = millis();
-        currentSize++;
+        //too far away for the wheel: wait in its last slot
+        if (ahead >= (1UL << (3 * SCHEDULER_SLOT_BITS)))
+          time = current + (1UL << (3 * SCHEDULER_SLOT_BITS)) - 1;
+        slot = 2 * SCHEDULER_SLOTS + ((time >> (2 * SCHEDULER_SLOT_BITS)) & (SCHEDULER_SLOTS - 1));
       }
+
+      action[i].slot = slot;
+      action[i].prev = SCHEDULER_NONE;
+      action[i].next = wheel[slot];
+      if (wheel[slot] != SCHEDULER_NONE)
+        action[wheel[slot]].prev = i;
+      wheel[slot] = i;
     }
 
-  private:
-    //Removes all redundant actions from memory
-    void defragment()
+    void unlink(byte i)
     {
-      byte defrag = 0;
-      for (byte i = 0; i < currentSize; i++)
+      if (action[i].prev == SCHEDULER_NONE)
+        wheel[action[i].slot] = action[i].next;
+      else
+        action[action[i].prev].next = action[i].next;
+      if (action[i].next != SCHEDULER_NONE)
+        action[action[i].next].prev = action[i].prev;
+    }
+
+    //Move the calls of a higher level slot to where they belong now
+    void cascade(byte slot)
+    {
+      byte i = wheel[slot];
+      byte next;
+
+      wheel[slot] = SCHEDULER_NONE;
+      while (i != SCHEDULER_NONE)
+      {
+        next = action[i].next;
+        insert(i);
+        i = next;
+      }
+    }
+
+    //Call everything in a slot of the first level: all of it is due
+    void expire(byte slot, unsigned long now)
+    {
+      byte i;
+      function userAction;
+
+      while ((i = wheel[slot]) != SCHEDULER_NONE)
       {
-        if (i + 1 < currentSize && action[i] == action[i + 1])
+        userAction = action[i].action;
+        unlink(i);
+
+        //rescheduled (or freed) before the call, so that the function
+        //may cancel itself, or schedule something new
+        if (action[i].interval)
         {
-          defrag = i + 1;
-          while (defrag + 1 < currentSize)
-          {
-            action[defrag] = action[defrag + 1];
-            defrag++;
-          }
-          currentSize--;
+          //skip the calls update() is already too late for
+          action[i].time += action[i].interval;
+          if ((long)(action[i].time - now) <= 0)
+            action[i].time += ((now - action[i].time) / action[i].interval + 1) * action[i].interval;
+          insert(i);
         }
+        else
+          release(i);
+
+        userAction();
       }
     }
 
     schedule_action action[maxFunctionsToCall];
+    byte wheel[SCHEDULER_LEVELS * SCHEDULER_SLOTS];
+    byte freeList;  //the free entries, linked through next
     byte currentSize;
+    unsigned long current;  //the last tick update() ran
 };
 
 #endif
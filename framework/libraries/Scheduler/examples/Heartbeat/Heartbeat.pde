@@ -0,0 +1,49 @@
+/**
+ * Heartbeat
+ * by Camilo Reyes <creyes@wiring.org.co>
+ *
+ * Blink the onboard LED every 250 milliseconds, print a report
+ * every second, and stop blinking for good when anything is
+ * received on the Serial.
+ */
+
+#include <Scheduler.h>
+
+Scheduler<4> scheduler;               //up to 4 calls scheduled at the time
+
+schedule_handle blinking;             //to cancel the blinking with
+byte ledState = LOW;
+
+void setup()
+{
+  Serial.begin(9600);
+  pinMode(WLED, OUTPUT);
+
+  blinking = scheduler.scheduleRepeating(blink, 250);
+  scheduler.scheduleRepeating(report, 1000);
+}
+
+void loop()
+{
+  scheduler.update();                 //call the functions that are due
+
+  if (Serial.available() && scheduler.scheduled(blinking))
+  {
+    scheduler.cancel(blinking);
+    digitalWrite(WLED, LOW);
+    Serial.flush();
+  }
+}
+
+void blink()
+{
+  ledState = !ledState;
+  digitalWrite(WLED, ledState);
+}
+
+void report()
+{
+  Serial.print(Constant("up for "));
+  Serial.print(millis() / 1000);
+  Serial.println(Constant(" s"));
+}
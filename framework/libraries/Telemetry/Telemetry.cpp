@@ -0,0 +1,167 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Binary framed telemetry on any Print.
+|| |
+|| | Wiring Cross-platform Library
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+|| @notes
+|| | A frame of at most 254 bytes with its CRC is a single COBS block
+|| | (code 1 to 255), so it is encoded in place: frame[0] is kept for
+|| | the first code byte and each 0 becomes the distance to the next one,
+|| | the delimiter last.  No second buffer, and one write() a frame.
+|| #
+*/
+
+#include "Telemetry.h"
+
+
+Telemetry::Telemetry(Print &out) : out(&out)
+{
+  count = 0;
+  overflow = true;              // nothing to send before begin()
+}
+
+
+Telemetry & Telemetry::begin(uint8_t type)
+{
+  frame[1] = type;
+  count = 1;
+  overflow = false;
+  return *this;
+}
+
+
+// Room for a field: its tag is written, the value goes after it.
+uint8_t *Telemetry::field(uint8_t type, unsigned int size)
+{
+  uint8_t *p;
+
+  if (overflow || count + 1 + size > TELEMETRY_FRAME_SIZE)
+  {
+    overflow = true;
+    return NULL;
+  }
+  p = frame + 1 + count;
+  *p++ = type;
+  count += 1 + size;
+  return p;
+}
+
+
+void Telemetry::put(uint8_t type, uint32_t value, uint8_t size)
+{
+  uint8_t *p = field(type, size);
+
+  if (p)
+    while (size--)
+    {
+      *p++ = value;
+      value >>= 8;
+    }
+}
+
+
+Telemetry & Telemetry::addByte(uint8_t value)
+{
+  put(TELEMETRY_BYTE, value, 1);
+  return *this;
+}
+
+
+Telemetry & Telemetry::addInt(int16_t value)
+{
+  put(TELEMETRY_INT, (uint16_t)value, 2);
+  return *this;
+}
+
+
+Telemetry & Telemetry::addUnsignedInt(uint16_t value)
+{
+  put(TELEMETRY_UNSIGNED_INT, value, 2);
+  return *this;
+}
+
+
+Telemetry & Telemetry::addLong(int32_t value)
+{
+  put(TELEMETRY_LONG, (uint32_t)value, 4);
+  return *this;
+}
+
+
+Telemetry & Telemetry::addUnsignedLong(uint32_t value)
+{
+  put(TELEMETRY_UNSIGNED_LONG, value, 4);
+  return *this;
+}
+
+
+Telemetry & Telemetry::addFloat(float value)
+{
+  union
+  {
+    float f;
+    uint32_t u;
+  } bits;
+
+  bits.f = value;
+  put(TELEMETRY_FLOAT, bits.u, 4);
+  return *this;
+}
+
+
+// Strings longer than 255 characters are cut.
+Telemetry & Telemetry::addString(const char *text)
+{
+  size_t n = text ? strlen(text) : 0;
+  uint8_t *p;
+
+  if (n > 255)
+    n = 255;
+  p = field(TELEMETRY_STRING, 1 + n);
+  if (p)
+  {
+    *p++ = n;
+    memcpy(p, text, n);
+  }
+  return *this;
+}
+
+
+bool Telemetry::end(void)
+{
+  uint16_t crc = 0xFFFF;
+  uint8_t n;
+  uint8_t i;
+  uint8_t next;
+
+  if (overflow)
+    return false;
+  overflow = true;              // sent once
+
+  for (i = 1; i <= count; i++)
+    crc = telemetryCrc(crc, frame[i]);
+  frame[count + 1] = crc;
+  frame[count + 2] = crc >> 8;
+  n = count + 3;                // the delimiter's place
+
+  // from the end, each 0 (and the code byte) to the distance to the next
+  frame[n] = 0;
+  next = n;
+  for (i = n - 1; i > 0; i--)
+    if (frame[i] == 0)
+    {
+      frame[i] = next - i;
+      next = i;
+    }
+  frame[0] = next;
+
+  return out->write(frame, n + 1) == (size_t)(n + 1);
+}
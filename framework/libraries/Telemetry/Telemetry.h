@@ -0,0 +1,83 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Binary framed telemetry on any Print (Serial, a StringBuilder, ...).
+|| |
+|| | A frame is a type byte and typed fields, added in turn and sent by
+|| | end():
+|| |
+|| |   Telemetry telemetry(Serial);
+|| |
+|| |   telemetry.begin(1)
+|| |            .addUnsignedLong(millis())
+|| |            .addInt(analogRead(0))
+|| |            .addFloat(temperature)
+|| |            .end();
+|| |
+|| | Each field is its tag (TELEMETRY_INT, ...) and the value, little
+|| | endian; a string is its length and the characters.  end() appends a
+|| | CRC-16 of the frame, COBS encodes it and sends it with a 0 after it:
+|| | there is no 0 inside a frame, so the receiver finds the start of the
+|| | next one wherever it starts listening.  See TelemetryDecoder.h for
+|| | the other end, on the board or on a PC (and the TelemetryDump tool
+|| | of the Host core).
+|| |
+|| | The frame is built in the object (TELEMETRY_FRAME_SIZE bytes), so
+|| | nothing is allocated, and sent with a single write().  A frame the
+|| | fields don't fit in is not sent.
+|| |
+|| | Wiring Cross-platform Library
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Wiring.h>
+#include "TelemetryDecoder.h"
+
+#if TELEMETRY_FRAME_SIZE > 252
+#error TELEMETRY_FRAME_SIZE must be at most 252
+#endif
+
+class Telemetry
+{
+  public:
+    Telemetry(Print &out);
+
+    Telemetry & begin(uint8_t type);
+
+    Telemetry & addByte(uint8_t value);
+    Telemetry & addInt(int16_t value);
+    Telemetry & addUnsignedInt(uint16_t value);
+    Telemetry & addLong(int32_t value);
+    Telemetry & addUnsignedLong(uint32_t value);
+    Telemetry & addFloat(float value);
+    Telemetry & addString(const char *text);
+
+    // Sends the frame; false if it overflowed or was not all written.
+    bool end(void);
+
+    // Bytes of the frame so far (type and fields)
+    uint8_t length(void) { return count; }
+    bool overflowed(void) { return overflow; }
+
+  private:
+    Print *out;
+    // COBS code, type and fields, CRC, delimiter
+    uint8_t frame[TELEMETRY_FRAME_SIZE + 4];
+    uint8_t count;
+    bool overflow;
+
+    uint8_t *field(uint8_t type, unsigned int size);
+    void put(uint8_t type, uint32_t value, uint8_t size);
+};
+
+#endif
+// TELEMETRY_H
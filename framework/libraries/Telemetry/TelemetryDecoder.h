@@ -0,0 +1,252 @@
+/* $Id$
+||
+|| @author         Camilo Reyes <creyes@wiring.org.co>
+|| @url            http://wiring.org.co/
+||
+|| @description
+|| | Decoder for Telemetry frames.
+|| |
+|| | Takes the received bytes one at a time, undoes the COBS encoding
+|| | into a buffer given by the caller, and checks the CRC when the frame
+|| | delimiter comes.  Bad frames (CRC, encoding, too long for the
+|| | buffer) are counted and dropped; the next delimiter starts over, so
+|| | the decoder picks up a stream in the middle.  The fields of a good
+|| | frame are read back with nextField().
+|| |
+|| | Plain C++ without the Wiring core: the same header decodes on the
+|| | board (from a Stream, see poll()) and on a PC.
+|| |
+|| | Wiring Cross-platform Library
+|| #
+||
+|| @license Please see cores/Common/License.txt.
+||
+*/
+
+#ifndef TELEMETRYDECODER_H
+#define TELEMETRYDECODER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Largest frame: the type and the fields (with the CRC and the COBS code
+// byte, it must stay a single COBS block: at most 252).
+#ifndef TELEMETRY_FRAME_SIZE
+#define TELEMETRY_FRAME_SIZE 64
+#endif
+
+// Decoder buffer for the largest frame, its CRC included
+#define TELEMETRY_BUFFER_SIZE (TELEMETRY_FRAME_SIZE + 2)
+
+// Field types: the tag byte in front of each field
+#define TELEMETRY_BYTE          1  // uint8_t
+#define TELEMETRY_INT           2  // int16_t
+#define TELEMETRY_UNSIGNED_INT  3  // uint16_t
+#define TELEMETRY_LONG          4  // int32_t
+#define TELEMETRY_UNSIGNED_LONG 5  // uint32_t
+#define TELEMETRY_FLOAT         6  // IEEE 754 single
+#define TELEMETRY_STRING        7  // length byte, then the characters
+
+// Bytes of a field after its tag (strings: 1, the length)
+#define TELEMETRY_FIELD_SIZE(type) \
+  ((type) == TELEMETRY_BYTE || (type) == TELEMETRY_STRING ? 1 : \
+   (type) <= TELEMETRY_UNSIGNED_INT ? 2 : 4)
+
+// CRC-16/CCITT-FALSE (polynomial 0x1021, from 0xFFFF), a byte at a time
+// without a table.
+static inline uint16_t telemetryCrc(uint16_t crc, uint8_t data)
+{
+  uint8_t x = (crc >> 8) ^ data;
+
+  x ^= x >> 4;
+  return (crc << 8) ^ ((uint16_t)x << 12) ^ ((uint16_t)x << 5) ^ x;
+}
+
+// The 16 bit field at p, low byte first.  Where int is 16 bits, p[1] << 8
+// shifts into the sign bit, and values from 0x8000 sign extend on the way
+// to 32 bits: the byte is shifted as a uint16_t (unsigned there), and the
+// result is cut to 16 bits.
+static inline uint16_t telemetryWord(const uint8_t *p)
+{
+  return (uint16_t)(p[0] | ((uint16_t)p[1] << 8));
+}
+
+
+struct TelemetryField
+{
+  uint8_t type;
+  union
+  {
+    uint32_t u;      // unsigned types
+    int32_t i;       // signed types
+    float f;
+  } value;
+  const char *text;  // strings, not terminated
+  uint8_t length;
+};
+
+
+class TelemetryDecoder
+{
+  public:
+    TelemetryDecoder(uint8_t *buffer, size_t size) : frame(buffer), size(size)
+    {
+      errorCount = 0;
+      received = 0;
+      reset();
+    }
+
+    // Returns true when the byte completes a good frame.  Its type,
+    // length and fields are valid until the next call.
+    bool decode(uint8_t c)
+    {
+      bool good;
+
+      if (c == 0)
+      {
+        good = started && remaining == 0 && !overflow && used >= 3 &&
+               crcGood();
+        if (started && !good)
+          errorCount++;
+        fieldsLength = good ? used - 2 : 0;
+        reset();
+        if (good)
+          received++;
+        return good;
+      }
+
+      started = true;
+      if (remaining == 0)
+      {
+        // a code byte: the zero the last block ended with, then a block
+        if (zeroPending)
+          store(0);
+        code = c;
+        remaining = c - 1;
+      }
+      else
+      {
+        store(c);
+        remaining--;
+      }
+      zeroPending = (remaining == 0 && code != 0xFF);
+
+      return false;
+    }
+
+    // Decodes what the stream has, up to the end of a good frame.
+    template<class S>
+    bool poll(S &in)
+    {
+      int c;
+
+      while ((c = in.read()) >= 0)
+        if (decode(c))
+          return true;
+      return false;
+    }
+
+    uint8_t type(void) const { return frame[0]; }
+    // The bytes of the fields, after the type
+    const uint8_t *data(void) const { return frame + 1; }
+    size_t length(void) const { return fieldsLength ? fieldsLength - 1 : 0; }
+
+    // Reads the fields of the last good frame in turn; false at the end
+    // (or at a malformed field).
+    bool nextField(TelemetryField &field)
+    {
+      const uint8_t *p;
+      uint8_t n;
+
+      if (next + 1 > fieldsLength)
+        return false;
+      field.type = frame[next];
+      if (field.type < TELEMETRY_BYTE || field.type > TELEMETRY_STRING)
+        return false;
+      n = TELEMETRY_FIELD_SIZE(field.type);
+      if (next + 1 + n > fieldsLength)
+        return false;
+      p = frame + next + 1;
+
+      field.value.u = 0;
+      field.text = NULL;
+      field.length = 0;
+      switch (field.type)
+      {
+        case TELEMETRY_BYTE:
+          field.value.u = p[0];
+          break;
+        case TELEMETRY_INT:
+          field.value.i = (int16_t)telemetryWord(p);
+          break;
+        case TELEMETRY_UNSIGNED_INT:
+          field.value.u = telemetryWord(p);
+          break;
+        case TELEMETRY_STRING:
+          field.length = p[0];
+          if (next + 2 + field.length > fieldsLength)
+            return false;
+          field.text = (const char *)p + 1;
+          n += field.length;
+          break;
+        default:
+          field.value.u = p[0] | ((uint32_t)p[1] << 8) |
+                          ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+          break;
+      }
+      next += 1 + n;
+      return true;
+    }
+
+    // Frames dropped, and frames received
+    unsigned long errors(void) const { return errorCount; }
+    unsigned long frames(void) const { return received; }
+
+  private:
+    uint8_t *frame;
+    size_t size;
+    size_t used;            // decoded so far
+    size_t fieldsLength;    // type and fields of the last good frame
+    size_t next;            // nextField() position
+    uint8_t code;
+    uint8_t remaining;      // data bytes left in the block
+    bool zeroPending;
+    bool started;
+    bool overflow;
+    unsigned long errorCount;
+    unsigned long received;
+
+    void reset(void)
+    {
+      used = 0;
+      next = 1;
+      remaining = 0;
+      zeroPending = false;
+      started = false;
+      overflow = false;
+    }
+
+    void store(uint8_t c)
+    {
+      if (used < size)
+        frame[used++] = c;
+      else
+        overflow = true;
+    }
+
+    // The CRC of the type and fields against the one after them (low
+    // byte first).
+    bool crcGood(void)
+    {
+      uint16_t crc = 0xFFFF;
+      size_t i;
+
+      for (i = 0; i < used - 2; i++)
+        crc = telemetryCrc(crc, frame[i]);
+      return frame[i] == (uint8_t)crc && frame[i + 1] == crc >> 8;
+    }
+};
+
+#endif
+// TELEMETRYDECODER_H
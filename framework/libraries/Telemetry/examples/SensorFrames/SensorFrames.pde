@@ -0,0 +1,35 @@
+/**
+ * Telemetry Sensor Frames
+ * by Camilo Reyes <creyes@wiring.org.co>
+ * 
+ * Sends the time, two analog inputs and a temperature ten times a
+ * second as binary frames on Serial: about 20 bytes a record instead
+ * of a line of text, and each frame checked by its CRC on the way.
+ * Read them on the PC with the TelemetryDump tool of the Host core,
+ * or with TelemetryDecoder.h in a program of your own.
+ */
+
+#include <Telemetry.h>
+
+#define SENSOR_FRAME 1
+
+Telemetry telemetry(Serial);
+
+void setup()
+{
+  Serial.begin(115200);
+}
+
+void loop()
+{
+  float temperature = analogRead(2) * 0.488;
+
+  telemetry.begin(SENSOR_FRAME)
+           .addUnsignedLong(millis())
+           .addInt(analogRead(0))
+           .addInt(analogRead(1))
+           .addFloat(temperature)
+           .end();
+
+  delay(100);
+}
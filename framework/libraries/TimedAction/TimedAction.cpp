@@ -4,6 +4,7 @@
 || @url            http://wiring.org.co/
 || @url            http://alexanderbrevig.com/
 || @contribution   Brett Hagman <bhagman@wiring.org.co>
+|| @contribution   Camilo Reyes <creyes@wiring.org.co>
 ||
 || @description
 || | Provides an easy way of triggering functions at a set interval.
@@ -87,9 +88,22 @@ void TimedAction::enable()
 */
 void TimedAction::check()
 {
-  if (active && (millis() - previous >= interval))
+  check(millis());
+}
+
+/*
+|| @description
+|| | Check if it is time for this TimedAction to call the function,
+|| | with a millis() reading shared by several TimedActions
+|| #
+||
+|| @parameter now the current millis()
+*/
+void TimedAction::check(unsigned long now)
+{
+  if (active && (now - previous >= interval))
   {
-    previous = millis();
+    previous = now;
     execute();
   }
 }
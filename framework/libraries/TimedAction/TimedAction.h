@@ -4,9 +4,13 @@
 || @url            http://wiring.org.co/
 || @url            http://alexanderbrevig.com/
 || @contribution   Brett Hagman <bhagman@wiring.org.co>
+|| @contribution   Camilo Reyes <creyes@wiring.org.co>
 ||
 || @description
 || | Provides an easy way of triggering functions at a set interval.
+|| | For many actions, check(now) with one millis() reading for all of
+|| | them, or Scheduler::scheduleRepeating(), which only looks at the
+|| | actions that are due.
 || |
 || | Wiring Cross-platform Library
 || #
@@ -32,6 +36,7 @@ class TimedAction
     void disable();
     void enable();
     void check();
+    void check(unsigned long now);
 
     void setInterval(unsigned long interval);
 